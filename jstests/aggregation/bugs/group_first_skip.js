@@ -0,0 +1,67 @@
+// A $group taking only the $first (or only the $last) of each value of an indexed field, after
+// a $sort on that field, only reads the first (or last) document of each value.  Check it groups
+// the same as without the index.
+
+t = db.jstests_aggregation_group_first_skip;
+t.drop();
+
+for ( i = 0; i < 500; ++i ) {
+    t.save( { a:i % 7, b:i } );
+}
+t.save( { a:null, b:-1 } );
+t.save( { b:-2 } );
+
+function groupFirst( dir ) {
+    return t.aggregate( { $sort:{ a:dir, b:dir } },
+                        { $group:{ _id:'$a', b:{ $first:'$b' } } },
+                        { $sort:{ _id:1 } } ).result;
+}
+
+function groupLast( dir ) {
+    return t.aggregate( { $sort:{ a:dir, b:dir } },
+                        { $group:{ _id:'$a', b:{ $last:'$b' } } },
+                        { $sort:{ _id:1 } } ).result;
+}
+
+function groupFirstAndLast() {
+    return t.aggregate( { $sort:{ a:1, b:1 } },
+                        { $group:{ _id:'$a', first:{ $first:'$b' }, last:{ $last:'$b' } } },
+                        { $sort:{ _id:1 } } ).result;
+}
+
+function groupMax() {
+    return t.aggregate( { $sort:{ a:1, b:1 } },
+                        { $group:{ _id:'$a', b:{ $max:'$b' } } },
+                        { $sort:{ _id:1 } } ).result;
+}
+
+function groupFirstAndCount() {
+    return t.aggregate( { $sort:{ a:1, b:1 } },
+                        { $group:{ _id:'$a', b:{ $first:'$b' }, n:{ $sum:1 } } },
+                        { $sort:{ _id:1 } } ).result;
+}
+
+expectedAsc = groupFirst( 1 );
+expectedDesc = groupFirst( -1 );
+expectedLastAsc = groupLast( 1 );
+expectedLastDesc = groupLast( -1 );
+expectedFirstAndLast = groupFirstAndLast();
+expectedMax = groupMax();
+expectedCount = groupFirstAndCount();
+assert.eq( 8, expectedAsc.length );
+assert.eq( { _id:null, b:-2 }, expectedAsc[ 0 ] );
+assert.eq( { _id:0, b:0 }, expectedAsc[ 1 ] );
+assert.eq( { _id:6, b:496 }, expectedDesc[ 7 ] );
+assert.eq( { _id:0, b:497 }, expectedLastAsc[ 1 ] );
+assert.eq( { _id:6, b:6 }, expectedLastDesc[ 7 ] );
+
+t.ensureIndex( { a:1, b:1 } );
+assert.eq( expectedAsc, groupFirst( 1 ) );
+assert.eq( expectedDesc, groupFirst( -1 ) );
+assert.eq( expectedLastAsc, groupLast( 1 ) );
+assert.eq( expectedLastDesc, groupLast( -1 ) );
+// Needs both ends of each group.
+assert.eq( expectedFirstAndLast, groupFirstAndLast() );
+assert.eq( expectedMax, groupMax() );
+// $sum needs every document of a group.
+assert.eq( expectedCount, groupFirstAndCount() );
@@ -0,0 +1,38 @@
+// With maxOpenCollections set, idle collections get closed in the background and
+// transparently reopened on their next use.
+
+var baseName = "jstests_disk_idle_collections";
+
+var m = startMongod( "--port", "27018", "--dbpath", "/data/db/" + baseName,
+                     "--setParameter", "maxOpenCollections=10" );
+var d = m.getDB( baseName );
+
+var n = 50;
+for ( var i = 0; i < n; i++ ) {
+    d["c" + i].ensureIndex( { a: 1 } );
+    d["c" + i].insert( { _id: i, a: i } );
+}
+assert.eq( null, d.getLastError() );
+
+var metrics = function() {
+    return d.serverStatus().metrics.collections;
+}
+assert.soon( function() { return metrics().evicted >= n / 2; },
+             "idle collections weren't closed", 30000 );
+printjson( metrics() );
+
+for ( var i = 0; i < n; i++ ) {
+    assert.eq( 1, d["c" + i].find( { a: i } ).itcount() );
+}
+assert.gt( metrics().reopened.num, 0 );
+
+// Turning the limit off at runtime stops the evictions.
+assert.commandWorked( d.adminCommand( { setParameter: 1, maxOpenCollections: 0 } ) );
+var evicted = metrics().evicted;
+for ( var i = 0; i < n; i++ ) {
+    d["c" + i].findOne();
+}
+sleep( 3000 );
+assert.eq( evicted, metrics().evicted );
+
+stopMongod( 27018 );
@@ -34,10 +34,13 @@ assert.eq( 1000 , x.stats.nscannedObjects , "AC3" )
 
 t.ensureIndex( { a : 1 } )
 
+// The index leads with the key, so only the first key of each value is read.
 x = d( "a" );
-assert.eq( 1000 , x.stats.n , "BA1" )
-assert.eq( 1000 , x.stats.nscanned , "BA2" )
+assert.eq( 10 , x.stats.n , "BA1" )
+assert.eq( 10 , x.stats.nscanned , "BA2" )
 assert.eq( 0 , x.stats.nscannedObjects , "BA3" )
+assert.eq( "IndexCursor a_1 skip" , x.stats.cursor , "BA4" )
+assert.eq( [ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 ] , x.values.sort() , "BA5" )
 
 x = d( "a" , { a : { $gt : 5 } } );
 assert.eq( 398 , x.stats.n , "BB1" )
@@ -0,0 +1,42 @@
+// Hashed indexes with hashVersion 1 (MurmurHash3).
+
+var t = db.hashindex2;
+t.drop();
+
+// unknown hash versions are refused
+t.ensureIndex( { a : "hashed" } , { hashVersion : 2 } );
+assert( db.getLastError() , "hashVersion 2 shouldn't be allowed" );
+assert.eq( 1 , t.getIndexes().length );
+
+t.ensureIndex( { a : "hashed" } , { hashVersion : 1 } );
+assert.eq( null , db.getLastError() );
+assert.eq( 2 , t.getIndexes().length );
+assert.eq( 1 , t.getIndexes()[1].hashVersion );
+
+for ( var i = 0; i < 100; i++ ) {
+    t.insert( { a : i } );
+}
+t.insert( { a : 3.1 } );
+t.insert( { a : { b : 4 } } );
+t.insert( { b : 1 } );
+
+// numbers squash to the same key, so the matcher tells 3 and 3.1 apart
+assert.eq( 1 , t.find( { a : 3 } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( 3.1 , t.find( { a : 3.1 } ).hint( { a : "hashed" } ).next().a );
+assert.eq( 1 , t.find( { a : { b : 4 } } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( 1 , t.find( { a : null } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( 3 , t.find( { a : { $in : [ 5 , 6 , 7 ] } } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( "IndexCursor a_hashed" , t.find( { a : 1 } ).explain().cursor );
+
+// the keys differ from a version 0 index's, and match _hashBSONElement's
+var md5 = db.runCommand( { _hashBSONElement : 42 , seed : 0 } );
+var murmur = db.runCommand( { _hashBSONElement : 42 , seed : 0 , hashVersion : 1 } );
+assert.commandWorked( murmur );
+assert.neq( md5.out , murmur.out );
+assert.eq( 1 , t.find( { a : 42 } ).hint( { a : "hashed" } ).itcount() );
+assert.commandFailed( db.runCommand( { _hashBSONElement : 42 , hashVersion : 7 } ) );
+
+// rebuilding the index gives the same answers
+t.reIndex();
+assert.eq( 1 , t.find( { a : 42 } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( 104 , t.find().hint( { a : "hashed" } ).itcount() );
@@ -0,0 +1,44 @@
+// With queryIndexIntersection set, a query on fields of two indexes races a plan that scans one
+// of them and skips the documents outside the other's range.
+
+t = db.jstests_index_intersection;
+t.drop();
+
+var old = db.adminCommand( { getParameter: 1, queryIndexIntersection: 1 } ).queryIndexIntersection;
+assert.commandWorked( db.adminCommand( { setParameter: 1, queryIndexIntersection: true } ) );
+
+t.ensureIndex( { a: 1 } );
+t.ensureIndex( { b: 1 } );
+// Each field matches about half the documents, both match only 100 of them.
+for ( var i = 0; i < 3000; i++ ) {
+    t.insert( { _id: i, a: i < 1500 ? 1 : 0, b: i >= 1400 ? 1 : 0 } );
+}
+assert.eq( null, db.getLastError() );
+
+var query = { a: 1, b: 1 };
+var checkResults = function() {
+    var ids = t.find( query ).toArray().map( function( o ) { return o._id; } ).sort( function( x, y ) { return x - y; } );
+    assert.eq( 100, ids.length );
+    assert.eq( 1400, ids[ 0 ] );
+    assert.eq( 1499, ids[ 99 ] );
+}
+checkResults();
+
+var explain = t.find( query ).explain( true );
+assert( /intersect/.test( explain.cursor ), tojson( explain ) );
+assert.eq( 100, explain.n );
+// The filter scans b's 1600 keys a batch per advance, and until it is done the documents of a's
+// scan are fetched as is, so a few more than the matches are.
+assert.gt( 150, explain.nscannedObjects, tojson( explain ) );
+assert( explain.intersect.filtering, tojson( explain ) );
+
+// The recorded plan is used again.
+checkResults();
+
+// And neither raced nor reused when turned off.
+assert.commandWorked( db.adminCommand( { setParameter: 1, queryIndexIntersection: false } ) );
+explain = t.find( query ).explain( true );
+assert( !/intersect/.test( explain.cursor ), tojson( explain ) );
+checkResults();
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, queryIndexIntersection: old } ) );
@@ -0,0 +1,22 @@
+// Insert throughput into a hashed index, with each hash version.
+
+var n = 200000;
+var versions = [ 0 , 1 ];
+var pad = new Array( 20 ).join( "x" );
+
+for ( var v = 0; v < versions.length; v++ ) {
+    var t = db.perf.hashed_insert;
+    t.drop();
+    t.ensureIndex( { a : "hashed" } , { hashVersion : versions[v] } );
+    assert.eq( null , db.getLastError() );
+
+    var ms = Date.timeFunc( function() {
+        for ( var i = 0; i < n; i++ ) {
+            t.insert( { a : "key" + i + pad , b : i } );
+        }
+        db.getLastError();
+    } );
+    assert.eq( n , t.count() );
+    print( "hashVersion " + versions[v] + ": " + n + " inserts in " + ms + "ms, " +
+           Math.round( n * 1000 / ms ) + "/s" );
+}
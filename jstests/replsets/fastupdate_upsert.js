@@ -0,0 +1,48 @@
+// Test that upserts and multi updates done with fastupdates, without reading the
+// documents on the primary, replicate.
+
+var replTest = new ReplSetTest({ name: 'fastupdate_upsert', nodes: 2 });
+var nodes = replTest.nodeList();
+
+var conns = replTest.startSet();
+var r = replTest.initiate({ "_id": "fastupdate_upsert",
+                            "members": [
+                                { "_id": 0, "host": nodes[0], priority:10 },
+                                { "_id": 1, "host": nodes[1] }
+                            ]});
+
+var primary = replTest.getMaster();
+conns[1].setSlaveOk();
+
+var primarydb = primary.getDB('db');
+var secondarydb = conns[1].getDB('db');
+
+// Only the primary key, so upserts by _id don't read the document first.
+primarydb.upserts.drop();
+for (i = 0; i < 1000; i++) {
+    // Leave a gap every third doc. The upserts below will need to fill them in.
+    if (i % 3 != 0) {
+        primarydb.upserts.insert({ _id: i, c: 0 });
+    }
+}
+assert.commandWorked(primarydb.adminCommand({ setParameter: 1, fastupdates: true }));
+// Without this, a replica set primary reads the document first so the upsert can be rolled back.
+assert.commandWorked(primarydb.adminCommand({ setParameter: 1, fastupdatesReplicatedUpserts: true }));
+for (i = 0; i < 1000; i++) {
+    primarydb.upserts.update({ _id: i }, { $inc: { c: 1 }, $setOnInsert: { new: true } }, { upsert: true });
+}
+primarydb.upserts.update({ c: 1 }, { $inc: { d: 1 } }, { multi: true });
+assert.eq(null, primarydb.getLastError());
+// Mods that don't apply fail on the primary, which read the document, and don't replicate.
+primarydb.upserts.insert({ _id: 's', s: 'x' });
+primarydb.upserts.update({ _id: 's' }, { $inc: { s: 1 } });
+assert.neq(null, primarydb.getLastError());
+assert.commandWorked(primarydb.adminCommand({ setParameter: 1, fastupdatesReplicatedUpserts: false }));
+assert.commandWorked(primarydb.adminCommand({ setParameter: 1, fastupdates: false }));
+
+assert.eq(1000, primarydb.upserts.count({ c: 1, d: 1 }));
+assert.eq(334, primarydb.upserts.count({ new: true }));
+replTest.awaitReplication();
+assert.eq(primarydb.upserts.find().sort({ _id: 1 }).toArray(),
+          secondarydb.upserts.find().sort({ _id: 1 }).toArray());
+replTest.stopSet();
@@ -0,0 +1,27 @@
+// Members started with --netCompression compress the oplog they tail, and report it in
+// serverStatus.network.compression.
+
+var replTest = new ReplSetTest( {name: 'netCompression', nodes: 2, nodeOptions: {netCompression: ""}} );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var pad = new Array( 1000 ).join( "x" );
+for ( var i = 0; i < 2000; i++ ) {
+    primary.getDB( "test" ).foo.insert( { _id : i , a : "some value" , pad : pad } );
+}
+primary.getDB( "test" ).getLastError( 2 );
+replTest.awaitReplication();
+
+var secondary = replTest.liveNodes.slaves[0];
+assert.eq( 2000 , secondary.getDB( "test" ).foo.count() );
+
+var ps = primary.getDB( "test" ).serverStatus().network.compression.lzblock;
+var ss = secondary.getDB( "test" ).serverStatus().network.compression.lzblock;
+printjson( ps );
+printjson( ss );
+assert.gt( ps.messagesOut , 0 , "primary didn't compress the oplog" );
+assert.gt( ss.messagesIn , 0 , "secondary didn't receive compressed messages" );
+assert.lt( ss.bytesIn * 2 , ss.bytesInUncompressed , "oplog didn't compress" );
+
+replTest.stopSet();
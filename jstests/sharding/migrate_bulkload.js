@@ -0,0 +1,50 @@
+// A chunk moved to a shard that doesn't have the collection yet is bulk loaded there, over
+// several connections, and later chunks are cloned in parallel into the existing collection.
+
+s = new ShardingTest( "migrate_bulkload" , 2 , 0 , 1 , { chunksize : 64 } );
+s.config.settings.update( { _id: "balancer" }, { $set : { stopped : true } } , true );
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+
+db = s.getDB( "test" );
+db.foo.ensureIndex( { a : 1 } );
+db.foo.ensureIndex( { b : 1 , a : -1 } , { unique : true } );
+
+var pad = new Array( 2000 ).join( "x" );
+for ( var i = 0; i < 40000; i++ ) {
+    db.foo.insert( { x : i , a : i % 100 , b : i , pad : pad } );
+}
+assert.eq( null , db.getLastError() );
+
+s.adminCommand( { split : "test.foo" , middle : { x : 20000 } } );
+s.adminCommand( { split : "test.foo" , middle : { x : 30000 } } );
+
+var from = s.getServer( "test" );
+var to = s.getOther( from );
+
+function checkShard( shard , n , msg ) {
+    var d = shard.getDB( "test" );
+    assert.eq( n , d.foo.find().itcount() , msg + ": count" );
+    assert.eq( n / 100 , d.foo.find( { a : 7 } ).hint( { a : 1 } ).itcount() , msg + ": index a" );
+    assert.eq( n , d.foo.find().hint( { b : 1 , a : -1 } ).itcount() , msg + ": index b" );
+}
+
+// the first chunk creates test.foo on the other shard, in a bulk load
+assert.commandWorked( s.adminCommand( { movechunk : "test.foo" , find : { x : 20000 } , to : to.name ,
+                                        _waitForDelete : true } ) );
+checkShard( to , 10000 , "after bulk loaded chunk" );
+checkShard( from , 30000 , "donor after bulk loaded chunk" );
+
+// the second goes into the collection the first one created
+assert.commandWorked( s.adminCommand( { movechunk : "test.foo" , find : { x : 35000 } , to : to.name ,
+                                        _waitForDelete : true } ) );
+checkShard( to , 20000 , "after second chunk" );
+checkShard( from , 20000 , "donor after second chunk" );
+
+// the unique index came over
+to.getDB( "test" ).foo.insert( { x : 25000.5 , a : 0 , b : 25000 } );
+assert( to.getDB( "test" ).getLastError() , "unique index on b wasn't enforced" );
+
+assert.eq( 40000 , db.foo.find().itcount() );
+
+s.stop();
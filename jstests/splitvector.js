@@ -54,6 +54,7 @@ var assertFieldNamesMatch = function( splitPoint , keyPattern ){
 f = db.jstests_splitvector;
 
 // run everything once with clustering indexes, and then again without clustering indexes
+// (with exact: true, estimates for secondary indexes are checked in Case 10)
 for (var cl = 1; cl >= 0; --cl) {
 
 f.drop();
@@ -98,7 +99,7 @@ var case4 = function() {
         f.save( { x: i, y: filler } );
     }
     db.getLastError();
-    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 } );
+    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 , exact: !cl } );
 
     // splitVector aims at getting half-full chunks after split
     factor = 0.5;
@@ -184,7 +185,7 @@ var case7 = function() {
         f.save( { x: 2, y: filler } );
     }
     db.getLastError();
-    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 } );
+    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 , exact: !cl } );
 
     assert.eq( true , res.ok , "7a" );
     assert.eq( 2 , res.splitKeys[0].x, "7b");
@@ -216,7 +217,7 @@ var case8 = function() {
     }
 
     db.getLastError();
-    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 } );
+    res = db.runCommand( { splitVector: db.getName() + ".jstests_splitvector" , keyPattern: {x:1} , maxChunkSize: 1 , exact: !cl } );
 
     assert.eq( true , res.ok , "8a" );
     assert.eq( 2 , res.splitKeys.length , "8b" );
@@ -323,4 +324,27 @@ for (var n = 3; n < 16; ++n) {
 
 }
 
+// -------------------------
+// Case 10: split points of a secondary index are estimated from the index's size
+
+f.drop();
+f.ensureIndex( { x: 1 } );
+filler = "";
+while( filler.length < 500 ) filler += "a";
+numDocs = 50000;
+for( i=0; i<numDocs; i++ ){
+    f.save( { x: i, y: filler } );
+}
+db.getLastError();
+exactRes = db.runCommand( { splitVector: f.getFullName() , keyPattern: {x:1} , maxChunkSize: 1 , exact: true } );
+res = db.runCommand( { splitVector: f.getFullName() , keyPattern: {x:1} , maxChunkSize: 1 } );
+assert.eq( true , exactRes.ok , "10a" );
+assert.eq( true , res.ok , "10b" );
+assert.gt( res.splitKeys.length , exactRes.splitKeys.length * 3 / 4 , "10c" );
+assert.lt( res.splitKeys.length , exactRes.splitKeys.length * 5 / 4 , "10d" );
+for( i=1; i < res.splitKeys.length; i++ ){
+    assert.lt( res.splitKeys[i-1].x , res.splitKeys[i].x , "10e" );
+    assertFieldNamesMatch( res.splitKeys[i] , {x : 1} );
+}
+
 print("PASSED");
@@ -0,0 +1,46 @@
+// dumprestore12.js
+// Restores many collections at once, with batches larger than one insert message.
+
+t = new ToolTest( "dumprestore12" );
+
+var db = t.startDB( "foo" ).getDB();
+var numColls = 20;
+var bigColl = db.big;
+
+for ( var i = 0; i < numColls; i++ ) {
+    var c = db.getCollection( "c" + i );
+    for ( var j = 0; j <= i; j++ ) {
+        c.insert( { _id : j , coll : i } );
+    }
+    c.ensureIndex( { coll : 1 } );
+}
+for ( var i = 0; i < 5000; i++ ) {
+    bigColl.insert( { _id : i , x : "abcdefghijklmnopqrstuvwxyz" } );
+}
+db.getLastError();
+
+t.runTool( "dump" , "--out" , t.ext );
+
+var check = function( what ) {
+    for ( var i = 0; i < numColls; i++ ) {
+        var c = db.getCollection( "c" + i );
+        assert.eq( i + 1 , c.count() , what + ": count of c" + i );
+        assert.eq( i + 1 , c.find( { coll : i } ).hint( { coll : 1 } ).itcount() , what + ": index on c" + i );
+    }
+    assert.eq( 5000 , bigColl.count() , what + ": count of big" );
+    assert.eq( 4999 , bigColl.find().sort( { _id : -1 } ).limit( 1 ).next()._id , what + ": last of big" );
+}
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext , "--numParallelCollections" , "4" );
+check( "parallel" );
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext , "--numParallelCollections" , "1" , "--batchesInFlight" , "0" );
+check( "serial" );
+
+// without the loader, and restoring over existing data with --drop
+t.runTool( "restore" , "--dir" , t.ext , "--drop" , "--noLoader" , "--numParallelCollections" , "8" );
+check( "noLoader" );
+
+t.stop();
@@ -0,0 +1,48 @@
+// dumprestore13.js
+// Compressed dumps, and collections dumped in several ranges at once.
+
+t = new ToolTest( "dumprestore13" );
+
+var db = t.startDB( "foo" ).getDB();
+var big = db.big;
+var pad = new Array( 1000 ).join( "x" );
+
+for ( var i = 0; i < 20000; i++ ) {
+    big.insert( { _id : i , pad : pad } );
+}
+for ( var i = 0; i < 10; i++ ) {
+    db.small.insert( { _id : i } );
+}
+big.ensureIndex( { pad : 1 , _id : 1 } );
+db.getLastError();
+
+var check = function( what ) {
+    assert.eq( 20000 , big.count() , what + ": count of big" );
+    assert.eq( 20000 , big.find().hint( { pad : 1 , _id : 1 } ).itcount() , what + ": index on big" );
+    assert.eq( 19999 , big.find().sort( { _id : -1 } ).limit( 1 ).next()._id , what + ": last of big" );
+    assert.eq( 10 , db.small.count() , what + ": count of small" );
+}
+
+var dumpAndRestore = function( what , dumpArgs ) {
+    resetDbpath( t.ext );
+    t.runTool.apply( t , [ "dump" , "--out" , t.ext ].concat( dumpArgs ) );
+    db.dropDatabase();
+    t.runTool( "restore" , "--dir" , t.ext );
+    check( what );
+}
+
+// ~20MB split into 1MB ranges
+dumpAndRestore( "compressed" , [ "--compress" , "--numThreads" , "4" , "--rangeSizeMB" , "1" ] );
+assert( listFiles( t.ext + "/foo" ).some( function( f ) { return /big\.bsonz$/.test( f.name ); } ) ,
+        "no .bsonz file" );
+dumpAndRestore( "ranges" , [ "--numThreads" , "4" , "--rangeSizeMB" , "1" ] );
+dumpAndRestore( "serial" , [ "--compress" , "--numThreads" , "1" ] );
+
+// a single compressed collection
+resetDbpath( t.ext );
+t.runTool( "dump" , "--out" , t.ext , "--compress" , "-d" , "foo" , "-c" , "small" );
+db.small.drop();
+t.runTool( "restore" , "--dir" , t.ext + "/foo/small.bsonz" , "-d" , "foo" , "-c" , "small" );
+assert.eq( 10 , db.small.count() , "single compressed collection" );
+
+t.stop();
@@ -0,0 +1,33 @@
+// dumprestore14.js
+// A compressed dump restores to the same documents, and bsondump reads it.
+
+t = new ToolTest( "dumprestore14" );
+
+var db = t.startDB( "foo" ).getDB();
+var c = db.c;
+
+// Sizes from a few bytes to most of a block, so the dump has several blocks.
+for ( var i = 0; i < 300; i++ ) {
+    c.insert( { _id : i , s : new Array( ( i * 37 ) % 20000 ).join( "y" ) , n : i * 1.5 ,
+                a : [ i , { b : "" + i } ] } );
+}
+db.empty.insert( { _id : 0 } );
+db.empty.remove();
+db.getLastError();
+
+var expected = c.find().sort( { _id : 1 } ).toArray();
+
+t.runTool( "dump" , "--out" , t.ext , "--compress" );
+assert.eq( 0 , runMongoProgram( "bsondump" , t.ext + "/foo/c.bsonz" ) , "bsondump" );
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext );
+
+var restored = c.find().sort( { _id : 1 } ).toArray();
+assert.eq( expected.length , restored.length , "count" );
+for ( var i = 0; i < expected.length; i++ ) {
+    assert.eq( expected[ i ] , restored[ i ] , "document " + i );
+}
+assert.eq( 0 , db.empty.count() , "empty collection" );
+
+t.stop();
@@ -0,0 +1,34 @@
+// dumprestore15.js
+// Inserts that fail during a parallel restore are reported and not counted as restored,
+// and the rest of their batch still goes in.
+
+t = new ToolTest( "dumprestore15" );
+
+var db = t.startDB( "foo" ).getDB();
+
+for ( var i = 0; i < 2000; i++ ) {
+    db.a.insert( { _id : i } );
+    db.b.insert( { _id : i } );
+}
+db.getLastError();
+
+t.runTool( "dump" , "--out" , t.ext );
+db.dropDatabase();
+
+// Every tenth document of a is already there, so those inserts fail on _id.
+for ( var i = 0; i < 2000; i += 10 ) {
+    db.a.insert( { _id : i , old : true } );
+}
+db.getLastError();
+
+clearRawMongoProgramOutput();
+t.runTool( "restore" , "--dir" , t.ext , "--noLoader" , "--numParallelCollections" , "2" );
+
+assert.eq( 2000 , db.a.count() , "count of a" );
+assert.eq( 200 , db.a.count( { old : true } ) , "existing documents of a" );
+assert.eq( 2000 , db.b.count() , "count of b" );
+var out = rawMongoProgramOutput();
+assert( /E11000/.test( out ) , "duplicate key errors not reported" );
+assert( /restored 3800 objects/.test( out ) , "failed inserts counted as restored" );
+
+t.stop();
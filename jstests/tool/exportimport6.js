@@ -0,0 +1,39 @@
+// exportimport6.js
+// Imports enough documents to span several insert batches, with and without the parse pipeline.
+
+t = new ToolTest( "exportimport6" );
+
+c = t.startDB( "foo" );
+var n = 2500;
+for ( var i = 0; i < n; i++ ) {
+    c.insert( { _id : i , s : "line " + i , a : [ i , { b : i * 2 } ] } );
+}
+assert.eq( n , c.count() , "setup" );
+
+t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" );
+
+var check = function( what ) {
+    assert.eq( n , c.count() , what + ": count" );
+    for ( var i = 0; i < n; i += 499 ) {
+        var doc = c.findOne( { _id : i } );
+        assert.eq( "line " + i , doc.s , what + ": doc " + i );
+        assert.eq( i * 2 , doc.a[1].b , what + ": doc " + i );
+    }
+}
+
+var options = [ [ "--numParseThreads" , "4" ] ,
+                [ "--numParseThreads" , "1" , "--batchesInFlight" , "0" ] ,
+                [ "--numParseThreads" , "0" ] ];
+for ( var i = 0; i < options.length; i++ ) {
+    c.drop();
+    var args = [ "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ].concat( options[i] );
+    t.runTool.apply( t , args );
+    check( tojson( options[i] ) );
+}
+
+// upserts go through the same pipeline and replace the existing documents in order
+c.update( {} , { $set : { s : "changed" } } , false , true );
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" , "--upsert" );
+check( "upsert" );
+
+t.stop();
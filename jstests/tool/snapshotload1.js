@@ -0,0 +1,38 @@
+// snapshotload1.js
+// Copy a running server into a new dbpath with beginSnapshot/streamSnapshot.
+
+t = new ToolTest( "snapshotload1" );
+
+var db = t.startDB( "foo" ).getDB();
+var pad = new Array( 1000 ).join( "x" );
+for ( var i = 0; i < 5000; i++ ) {
+    db.big.insert( { _id : i , a : i % 10 , pad : pad } );
+}
+db.big.ensureIndex( { a : 1 } );
+db.createCollection( "capped" , { capped : true , size : 100000 } );
+for ( var i = 0; i < 10; i++ ) {
+    db.capped.insert( { x : i } );
+}
+db.getLastError();
+
+// streamSnapshot only works in a snapshot
+assert.commandFailed( db.runCommand( { streamSnapshot : "big" } ) );
+
+resetDbpath( t.ext );
+assert.eq( 0 , t.runTool( "snapshotload" , "--from" , "127.0.0.1:" + t.port , "--dbpath" , t.ext ) ,
+           "snapshotload failed" );
+
+// the snapshot was ended, so the source takes writes
+db.big.insert( { _id : 5000 } );
+assert.eq( null , db.getLastError() );
+t.stop();
+
+t.dbpath = t.ext;
+db = t.startDB( "foo" ).getDB();
+assert.eq( 5000 , db.big.count() , "count of big" );
+assert.eq( 500 , db.big.find( { a : 3 } ).hint( { a : 1 } ).itcount() , "index on big" );
+assert.eq( 10 , db.capped.count() , "count of capped" );
+assert( db.capped.isCapped() , "capped isn't capped" );
+assert.eq( 9 , db.capped.find().sort( { $natural : -1 } ).next().x , "capped order" );
+
+t.stop();
@@ -40,6 +40,11 @@ function checkUpdate(initialDocs, query, updateobj, options) {
             // fastupdate will always upsert, so only run this test when upsert
             // is true and we expect both fast and nonfast to have the same result
             checkUpdate([ { _id: 0 } ], { _id: 1 }, { $inc : { c: 1 } }, withUpdateOptions);
+            checkUpdate([ { _id: 0 } ], { _id: 1 }, { $inc : { c: 1 }, $setOnInsert: { d: 1 } }, withUpdateOptions);
+            checkUpdate([ { _id: 0, d: 0 } ], { _id: 0 }, { $inc : { c: 1 }, $setOnInsert: { d: 1 } }, withUpdateOptions);
         }
+        // multi updates send one message per matching document
+        checkUpdate([ { _id: 0, a: 1 }, { _id: 1, a: 2 }, { _id: 2, a: 1 } ], { a: 1 },
+                    { $inc : { c: 1 } }, { upsert: withUpdateOptions.upsert, multi: true });
     });
 });
@@ -15,7 +15,14 @@
  *    limitations under the License.
  */
 
+#include <cstring>
 #include <deque>
+#include <vector>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define MONGO_BSON_VALIDATE_SSE2 1
+#endif
 
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
@@ -24,10 +31,56 @@ namespace mongo {
 
     namespace {
 
+        /**
+         * Incremental UTF-8 checker, so a string can be fed to it in pieces.  Follows the same
+         * rules as isValidUTF8() in util/text.cpp, except that it is given an explicit length
+         * (BSON strings may contain embedded NULs, which are valid).
+         */
+        class UTF8State {
+        public:
+            UTF8State() : _left( 0 ) {}
+
+            bool consume( const unsigned char* p, size_t len ) {
+                for ( const unsigned char* end = p + len; p != end; ++p ) {
+                    const unsigned char c = *p;
+                    if ( _left ) {
+                        if ( ( c & 0xC0 ) != 0x80 )
+                            return false; // should be a continuation byte
+                        _left--;
+                    }
+                    else if ( c < 0x80 ) {
+                        continue; // ASCII byte
+                    }
+                    else {
+                        if ( ( c & 0xC0 ) == 0x80 )
+                            return false; // unexpected continuation byte
+                        if ( c > 0xF4 )
+                            return false; // codepoint too large (< 0x10FFFF)
+                        if ( c == 0xC0 || c == 0xC1 )
+                            return false; // codepoints <= 0x7F shouldn't be 2 bytes
+                        _left = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+                    }
+                }
+                return true;
+            }
+
+            bool done() const { return _left == 0; }
+
+        private:
+            int _left; // how many bytes are left in the current codepoint
+        };
+
+        bool isValidUTF8Scalar( const char* s, size_t len ) {
+            UTF8State state;
+            return state.consume( reinterpret_cast<const unsigned char*>( s ), len ) &&
+                   state.done();
+        }
+
         class Buffer {
         public:
-            Buffer( const char* buffer, uint64_t maxLength )
-                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ) {
+            Buffer( const char* buffer, uint64_t maxLength, bool checkUTF8 )
+                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ),
+                  _checkUTF8( checkUTF8 ) {
             }
 
             template<typename N>
@@ -48,6 +101,9 @@ namespace mongo {
                     return Status( ErrorCodes::InvalidBSON, "no end of c-string" );
                 uint64_t len = static_cast<uint64_t>( static_cast<const char*>(x) - ( _buffer + _position ) );
 
+                if ( _checkUTF8 && !isValidUTF8Scalar( _buffer + _position, len ) )
+                    return Status( ErrorCodes::InvalidBSON, "invalid UTF-8 in c-string" );
+
                 StringData data( _buffer + _position, len );
                 _position += len + 1;
 
@@ -62,10 +118,19 @@ namespace mongo {
                 if ( !readNumber<int>( &sz ) )
                     return Status( ErrorCodes::InvalidBSON, "invalid bson" );
 
+                // The length includes the terminating NUL, anything smaller would make us
+                // walk backwards in the buffer.
+                if ( sz <= 0 )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson string length" );
+
                 if ( out ) {
                     *out = StringData( _buffer + _position, sz );
                 }
 
+                if ( _checkUTF8 && _position + sz <= _maxLength &&
+                     !isValidUTF8Scalar( _buffer + _position, sz - 1 ) )
+                    return Status( ErrorCodes::InvalidBSON, "invalid UTF-8 in string" );
+
                 if ( !skip( sz - 1 ) )
                     return Status( ErrorCodes::InvalidBSON, "invalid bson" );
 
@@ -92,6 +157,7 @@ namespace mongo {
             const char* _buffer;
             uint64_t _position;
             uint64_t _maxLength;
+            bool _checkUTF8;
         };
 
         struct ValidationState {
@@ -204,6 +270,8 @@ namespace mongo {
                 int sz;
                 if ( !buffer->readNumber<int>( &sz ) )
                     return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                if ( sz < 0 )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson bindata length" );
                 if ( !buffer->skip( 1 + sz ) )
                     return Status( ErrorCodes::InvalidBSON, "invalid bson" );
                 return Status::OK();
@@ -298,15 +366,276 @@ namespace mongo {
             return Status::OK();
         }
 
+        /**
+         * Fixed value sizes by type byte, for validateBSONFast.  One table lookup replaces the
+         * type switch for every fixed-width element, which is the vast majority of elements
+         * in typical documents.
+         */
+        const int8_t kVar = -2;  // length-prefixed or nested, needs a closer look
+        const int8_t kBad = -1;  // not a BSON type
+        const int8_t kTypeValueSize[256] = {
+            /* 0x00 */ kBad, 8, kVar, kVar, kVar, kVar, 0, 12, 1, 8, 0, kVar, kVar, kVar, kVar, kVar,
+            /* 0x10 */ 4, 8, 8, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x20 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x30 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x40 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x50 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x60 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x70 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, 0,
+            /* 0x80 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0x90 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xA0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xB0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xC0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xD0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xE0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad,
+            /* 0xF0 */ kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, kBad, 0,
+        };
+
+        /** @return pointer to the first NUL in [p, end), or NULL. */
+        inline const char* findNul( const char* p, const char* end ) {
+#if defined(MONGO_BSON_VALIDATE_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            while ( end - p >= 16 ) {
+                const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                const int mask = _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, zero ) );
+                if ( mask )
+                    return p + __builtin_ctz( mask );
+                p += 16;
+            }
+#endif
+            return static_cast<const char*>( memchr( p, 0, end - p ) );
+        }
+
+        /**
+         * Skips over runs of 16 ASCII bytes with one compare each, and only hands chunks that
+         * have a high bit set (or that continue a multibyte sequence) to UTF8State.
+         */
+        bool isValidUTF8Fast( const char* s, size_t len ) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>( s );
+            UTF8State state;
+#if defined(MONGO_BSON_VALIDATE_SSE2)
+            for ( ; len >= 16; p += 16, len -= 16 ) {
+                const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                if ( _mm_movemask_epi8( chunk ) == 0 && state.done() )
+                    continue;
+                if ( !state.consume( p, 16 ) )
+                    return false;
+            }
+#endif
+            return state.consume( p, len ) && state.done();
+        }
+
+        class FastValidator {
+        public:
+            FastValidator( const char* buffer, uint64_t maxLength, bool checkUTF8 )
+                : _buffer( buffer ), _end( buffer + maxLength ), _checkUTF8( checkUTF8 ),
+                  _depth( 0 ) {
+            }
+
+            Status validate() {
+                const char* p = _buffer;
+                if ( !beginFrame( &p, false ) )
+                    return Status( ErrorCodes::InvalidBSON,
+                                   "bson size is larger than buffer size" );
+
+                while ( true ) {
+                    if ( p >= _end )
+                        return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+
+                    const unsigned char type = static_cast<unsigned char>( *p++ );
+                    if ( type == EOO ) {
+                        Frame f = popFrame();
+                        if ( p - f.start != f.expectedSize )
+                            return Status( ErrorCodes::InvalidBSON,
+                                           "bson length doesn't match what we found" );
+                        if ( _depth == 0 )
+                            return Status::OK();
+                        if ( topFrame().isCodeWithScope ) {
+                            f = popFrame();
+                            if ( p - f.start != f.expectedSize )
+                                return Status( ErrorCodes::InvalidBSON,
+                                               "bson length for CodeWScope doesn't match what we found" );
+                            if ( _depth == 0 )
+                                return Status( ErrorCodes::InvalidBSON, "unnested CodeWScope" );
+                        }
+                        continue;
+                    }
+
+                    Status status = skipCString( &p );
+                    if ( !status.isOK() )
+                        return status;
+
+                    const int8_t valueSize = kTypeValueSize[type];
+                    if ( valueSize >= 0 ) {
+                        if ( _end - p < valueSize )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                        p += valueSize;
+                        continue;
+                    }
+                    if ( valueSize == kBad )
+                        return Status( ErrorCodes::InvalidBSON, "invalid bson type" );
+
+                    switch ( type ) {
+                    case String:
+                    case Code:
+                    case Symbol:
+                        status = skipString( &p );
+                        if ( !status.isOK() )
+                            return status;
+                        break;
+
+                    case DBRef:
+                        status = skipString( &p );
+                        if ( !status.isOK() )
+                            return status;
+                        if ( _end - p < static_cast<ptrdiff_t>( sizeof(OID) ) )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                        p += sizeof(OID);
+                        break;
+
+                    case RegEx:
+                        status = skipCString( &p );
+                        if ( !status.isOK() )
+                            return status;
+                        status = skipCString( &p );
+                        if ( !status.isOK() )
+                            return status;
+                        break;
+
+                    case BinData: {
+                        int sz;
+                        if ( !readInt( &p, &sz ) )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                        if ( sz < 0 )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson bindata length" );
+                        // subtype byte + data
+                        if ( _end - p <= sz )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                        p += 1 + sz;
+                        break;
+                    }
+
+                    case CodeWScope:
+                        if ( !beginFrame( &p, true ) )
+                            return Status( ErrorCodes::InvalidBSON, "invalid bson CodeWScope size" );
+                        status = skipString( &p );
+                        if ( !status.isOK() )
+                            return status;
+                        // fall through to the scope object
+                    case Object:
+                    case Array:
+                        if ( !beginFrame( &p, false ) )
+                            return Status( ErrorCodes::InvalidBSON,
+                                           "bson size is larger than buffer size" );
+                        break;
+
+                    default:
+                        return Status( ErrorCodes::InvalidBSON, "invalid bson type" );
+                    }
+                }
+            }
+
+        private:
+            struct Frame {
+                const char* start;
+                int expectedSize;
+                bool isCodeWithScope;
+            };
+
+            bool readInt( const char** p, int* out ) {
+                if ( _end - *p < 4 )
+                    return false;
+                memcpy( out, *p, sizeof(int) );
+                *p += 4;
+                return true;
+            }
+
+            Status skipCString( const char** p ) {
+                const char* nul = findNul( *p, _end );
+                if ( !nul )
+                    return Status( ErrorCodes::InvalidBSON, "no end of c-string" );
+                if ( _checkUTF8 && !isValidUTF8Fast( *p, nul - *p ) )
+                    return Status( ErrorCodes::InvalidBSON, "invalid UTF-8 in c-string" );
+                *p = nul + 1;
+                return Status::OK();
+            }
+
+            Status skipString( const char** p ) {
+                int sz;
+                if ( !readInt( p, &sz ) )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                if ( sz <= 0 )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson string length" );
+                if ( _end - *p < sz )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                if ( (*p)[sz - 1] != 0 )
+                    return Status( ErrorCodes::InvalidBSON, "not null terminate string" );
+                if ( _checkUTF8 && !isValidUTF8Fast( *p, sz - 1 ) )
+                    return Status( ErrorCodes::InvalidBSON, "invalid UTF-8 in string" );
+                *p += sz;
+                return Status::OK();
+            }
+
+            bool beginFrame( const char** p, bool isCodeWithScope ) {
+                Frame f;
+                f.start = *p;
+                f.isCodeWithScope = isCodeWithScope;
+                if ( !readInt( p, &f.expectedSize ) )
+                    return false;
+                if ( _depth < kInlineFrames ) {
+                    _frames[_depth] = f;
+                }
+                else {
+                    _overflowFrames.push_back( f );
+                }
+                _depth++;
+                return true;
+            }
+
+            Frame popFrame() {
+                _depth--;
+                if ( _depth < kInlineFrames ) {
+                    return _frames[_depth];
+                }
+                Frame f = _overflowFrames.back();
+                _overflowFrames.pop_back();
+                return f;
+            }
+
+            const Frame& topFrame() const {
+                return _depth <= kInlineFrames ? _frames[_depth - 1] : _overflowFrames.back();
+            }
+
+            // Enough for all but pathologically nested documents, without touching the heap.
+            static const size_t kInlineFrames = 32;
+
+            const char* const _buffer;
+            const char* const _end;
+            const bool _checkUTF8;
+            size_t _depth;
+            Frame _frames[kInlineFrames];
+            std::vector<Frame> _overflowFrames;
+        };
+
     }  // namespace
 
-    Status validateBSON( const char* originalBuffer, uint64_t maxLength ) {
+    Status validateBSON( const char* originalBuffer, uint64_t maxLength, bool checkUTF8 ) {
         if ( maxLength < 5 ) {
             return Status( ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes" );
         }
 
-        Buffer buf( originalBuffer, maxLength );
+        Buffer buf( originalBuffer, maxLength, checkUTF8 );
         return validateBSONIterative( &buf );
     }
 
+    Status validateBSONFast( const char* originalBuffer, uint64_t maxLength, bool checkUTF8 ) {
+        if ( maxLength < 5 ) {
+            return Status( ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes" );
+        }
+
+        FastValidator validator( originalBuffer, maxLength, checkUTF8 );
+        return validator.validate();
+    }
+
 }  // namespace mongo
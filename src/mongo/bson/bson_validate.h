@@ -28,8 +28,19 @@ namespace mongo {
      * @param buf - bson data
      * @param maxLength - maxLength of buffer
      *                    this is NOT the bson size, but how far we know the buffer is valid
+     * @param checkUTF8 - also reject field names and string values that are not valid UTF-8
+     *
+     * This is the straightforward element-at-a-time validator.  It is kept as the reference
+     * implementation for validateBSONFast, which must accept exactly the same inputs.
      */
-    Status validateBSON( const char* buf, uint64_t maxLength );
+    Status validateBSON( const char* buf, uint64_t maxLength, bool checkUTF8 = false );
+
+    /**
+     * Same contract as validateBSON, but classifies type bytes with a lookup table and scans
+     * for c-string terminators and non-ASCII bytes 16 bytes at a time where SSE2 is available.
+     * This is what should be used on hot paths (--objcheck, BSONObj::valid()).
+     */
+    Status validateBSONFast( const char* buf, uint64_t maxLength, bool checkUTF8 = false );
 
 }
 
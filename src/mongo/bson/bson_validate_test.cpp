@@ -17,6 +17,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/platform/random.h"
 #include "mongo/bson/bson_validate.h"
+#include "mongo/util/timer.h"
 
 namespace {
 
@@ -213,4 +214,220 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    // The tests below check validateBSONFast against the reference validateBSON.
+
+    void assertSameResult( const char* buf, uint64_t len ) {
+        for ( int checkUTF8 = 0; checkUTF8 < 2; ++checkUTF8 ) {
+            Status reference = validateBSON( buf, len, checkUTF8 );
+            Status fast = validateBSONFast( buf, len, checkUTF8 );
+            if ( reference.isOK() != fast.isOK() ) {
+                log() << "validators disagree (checkUTF8: " << checkUTF8 << "): reference "
+                      << reference.toString() << ", fast " << fast.toString() << endl;
+            }
+            ASSERT_EQUALS( reference.isOK(), fast.isOK() );
+        }
+    }
+
+    BSONObj everyTypeObject() {
+        BSONObjBuilder b;
+        b.append( "double", 1.5 );
+        b.append( "string", "a string that is longer than sixteen bytes \xc3\xa9\xe2\x82\xac" );
+        b.append( "object", BSON( "x" << 1 << "y" << BSON( "z" << "zz" ) ) );
+        b.append( "array", BSON_ARRAY( 1 << "two" << 3.0 << BSON_ARRAY( 4 ) ) );
+        b.appendBinData( "bindata", 3, BinDataGeneral, "abc" );
+        b.appendUndefined( "undefined" );
+        b.append( "oid", OID( "deadbeefdeadbeefdeadbeef" ) );
+        b.appendBool( "bool", true );
+        b.appendDate( "date", Date_t( 44 ) );
+        b.appendNull( "null" );
+        b.appendRegex( "regex", "^foo.*bar$", "i" );
+        b.appendDBRef( "dbref", "db.coll", OID( "01234567890123456789aaaa" ) );
+        b.appendCode( "code", "function() { return 1; }" );
+        b.appendSymbol( "symbol", "sym" );
+        b.appendCodeWScope( "codewscope", "function() { return x; }", BSON( "x" << 1 ) );
+        b.append( "int", 5 );
+        b.appendTimestamp( "timestamp", 1234 );
+        b.append( "long", 5LL );
+        b.appendMinKey( "minkey" );
+        b.appendMaxKey( "maxkey" );
+        b.append( "\xe2\x82\xac field name longer than sixteen bytes", 1 );
+        return b.obj();
+    }
+
+    TEST( BSONValidateFast, EveryType ) {
+        BSONObj x = everyTypeObject();
+        ASSERT_OK( validateBSON( x.objdata(), x.objsize(), true ) );
+        ASSERT_OK( validateBSONFast( x.objdata(), x.objsize(), true ) );
+    }
+
+    TEST( BSONValidateFast, EquivalentOnTruncation ) {
+        BSONObj x = everyTypeObject();
+        for ( int len = 0; len <= x.objsize(); ++len ) {
+            assertSameResult( x.objdata(), len );
+        }
+    }
+
+    TEST( BSONValidateFast, EquivalentOnSingleByteChanges ) {
+        BSONObj x = everyTypeObject();
+        scoped_array<char> buffer( new char[ x.objsize() ] );
+        const unsigned char interesting[] = { 0x00, 0x01, 0x02, 0x03, 0x05, 0x0f, 0x10, 0x13,
+                                              0x7f, 0x80, 0xbf, 0xc1, 0xe2, 0xf5, 0xff };
+        for ( int i = 0; i < x.objsize(); ++i ) {
+            for ( size_t j = 0; j < sizeof( interesting ); ++j ) {
+                memcpy( buffer.get(), x.objdata(), x.objsize() );
+                buffer[ i ] = interesting[ j ];
+                assertSameResult( buffer.get(), x.objsize() );
+            }
+        }
+    }
+
+    TEST( BSONValidateFast, FuzzEquivalence ) {
+        int64_t seed = time( 0 );
+        log() << "BSONValidateFast FuzzEquivalence random seed: " << seed << endl;
+        PseudoRandom randomSource( seed );
+
+        BSONObj original = everyTypeObject();
+        scoped_array<char> buffer( new char[ original.objsize() ] );
+        int32_t fuzzFrequencies[] = { 2, 10, 20, 100, 1000 };
+        for ( int iter = 0; iter < 2000; ++iter ) {
+            int32_t fuzzFrequency = fuzzFrequencies[ iter % 5 ];
+            memcpy( buffer.get(), original.objdata(), original.objsize() );
+            for ( int32_t byteIdx = 0; byteIdx < original.objsize(); ++byteIdx ) {
+                for ( int32_t bitIdx = 0; bitIdx < 8; ++bitIdx ) {
+                    if ( randomSource.nextInt32( fuzzFrequency ) == 0 ) {
+                        reinterpret_cast<unsigned char&>( buffer[ byteIdx ] ) ^= ( 1U << bitIdx );
+                    }
+                }
+            }
+            assertSameResult( buffer.get(), original.objsize() );
+        }
+    }
+
+    TEST( BSONValidateFast, RandomDataEquivalence ) {
+        PseudoRandom r( 17 );
+        const int size = 256;
+        char x[ size ];
+        for ( int i = 0; i < 10000; ++i ) {
+            for ( int j = 0; j < size; j++ ) {
+                x[ j ] = r.nextInt32( 255 );
+            }
+            // Give it a plausible header some of the time, so we get past the first checks.
+            if ( i % 2 ) {
+                int len = r.nextInt32( size );
+                memcpy( x, &len, sizeof( len ) );
+                x[ 4 ] = 1 + r.nextInt32( JSTypeMax );
+            }
+            assertSameResult( x, size );
+        }
+    }
+
+    TEST( BSONValidateFast, BadLengths ) {
+        BSONObj x = BSON( "s" << "abc" << "b" << BSONBinData( "ab", 2, BinDataGeneral ) );
+        scoped_array<char> buffer( new char[ x.objsize() ] );
+        // offset of the string length: 4 byte size + type + "s\0"
+        const int strLenOffset = 4 + 1 + 2;
+        const int binLenOffset = strLenOffset + 4 + 4 + 1 + 2;
+        const int badLengths[] = { 0, -1, -4, -100 };
+        for ( size_t i = 0; i < sizeof( badLengths ) / sizeof( int ); ++i ) {
+            memcpy( buffer.get(), x.objdata(), x.objsize() );
+            memcpy( buffer.get() + strLenOffset, &badLengths[ i ], sizeof( int ) );
+            ASSERT_NOT_OK( validateBSON( buffer.get(), x.objsize() ) );
+            ASSERT_NOT_OK( validateBSONFast( buffer.get(), x.objsize() ) );
+
+            if ( badLengths[ i ] < 0 ) {
+                memcpy( buffer.get(), x.objdata(), x.objsize() );
+                memcpy( buffer.get() + binLenOffset, &badLengths[ i ], sizeof( int ) );
+                ASSERT_NOT_OK( validateBSON( buffer.get(), x.objsize() ) );
+                ASSERT_NOT_OK( validateBSONFast( buffer.get(), x.objsize() ) );
+            }
+        }
+    }
+
+    TEST( BSONValidateFast, DeepNesting ) {
+        BSONObj x = BSON( "x" << 1 );
+        for ( int i = 0; i < 100; ++i ) {
+            x = BSON( "x" << x << "a" << BSON_ARRAY( i ) );
+        }
+        ASSERT_OK( validateBSONFast( x.objdata(), x.objsize() ) );
+        for ( int len = 0; len <= x.objsize(); len += 7 ) {
+            assertSameResult( x.objdata(), len );
+        }
+    }
+
+    TEST( BSONValidateFast, UTF8 ) {
+        const char* good[] = { "",
+                               "plain ascii",
+                               "\xc3\xa9",
+                               "\xe2\x82\xac",
+                               "\xf0\x9f\x98\x80",
+                               "0123456789abcde\xc3\xa9",  // straddles a 16 byte chunk
+                               "0123456789abcd\xe2\x82\xac" "0123456789abcdef" };
+        const char* bad[] = { "\x80",
+                              "\xc3",
+                              "\xc0\x80",
+                              "\xc1\xbf",
+                              "\xf5\x80\x80\x80",
+                              "\xe2\x82",
+                              "0123456789abcde\xe2\x82",
+                              "0123456789abcdef0123456789abcd\xbf" };
+
+        for ( size_t i = 0; i < sizeof( good ) / sizeof( *good ); ++i ) {
+            BSONObj x = BSON( "s" << good[ i ] << good[ i ] << 1 );
+            ASSERT_OK( validateBSON( x.objdata(), x.objsize(), true ) );
+            ASSERT_OK( validateBSONFast( x.objdata(), x.objsize(), true ) );
+        }
+        for ( size_t i = 0; i < sizeof( bad ) / sizeof( *bad ); ++i ) {
+            BSONObj value = BSON( "s" << bad[ i ] );
+            BSONObj name = BSON( bad[ i ] << 1 );
+            BSONObj regex = BSON( "r" << BSONRegEx( bad[ i ], "" ) );
+            BSONObj objs[] = { value, name, regex };
+            for ( size_t j = 0; j < sizeof( objs ) / sizeof( *objs ); ++j ) {
+                const BSONObj& x = objs[ j ];
+                // Without checkUTF8 we only look at the structure.
+                ASSERT_OK( validateBSON( x.objdata(), x.objsize() ) );
+                ASSERT_OK( validateBSONFast( x.objdata(), x.objsize() ) );
+                ASSERT_NOT_OK( validateBSON( x.objdata(), x.objsize(), true ) );
+                ASSERT_NOT_OK( validateBSONFast( x.objdata(), x.objsize(), true ) );
+            }
+        }
+    }
+
+    TEST( BSONValidateFast, Throughput ) {
+        // A batch of documents that looks like a typical insert workload.
+        BSONArrayBuilder docs;
+        for ( int i = 0; i < 1000; ++i ) {
+            docs.append( BSON( "_id" << OID::gen() <<
+                               "userId" << i <<
+                               "name" << "some user name" <<
+                               "email" << "someone@example.com" <<
+                               "created" << Date_t( i ) <<
+                               "score" << i * 1.5 <<
+                               "tags" << BSON_ARRAY( "alpha" << "beta" << "gamma" ) <<
+                               "address" << BSON( "street" << "123 Main St" <<
+                                                  "city" << "Anytown" <<
+                                                  "zip" << 12345 ) ) );
+        }
+        BSONObj batch = docs.arr();
+        const int iterations = 200;
+
+        for ( int checkUTF8 = 0; checkUTF8 < 2; ++checkUTF8 ) {
+            Timer t;
+            for ( int i = 0; i < iterations; ++i ) {
+                ASSERT_OK( validateBSON( batch.objdata(), batch.objsize(), checkUTF8 ) );
+            }
+            long long referenceMicros = t.micros();
+
+            t.reset();
+            for ( int i = 0; i < iterations; ++i ) {
+                ASSERT_OK( validateBSONFast( batch.objdata(), batch.objsize(), checkUTF8 ) );
+            }
+            long long fastMicros = t.micros();
+
+            double mb = static_cast<double>( batch.objsize() ) * iterations / ( 1024 * 1024 );
+            log() << "BSONValidateFast Throughput (checkUTF8: " << checkUTF8 << "): "
+                  << "reference " << mb * 1000000 / std::max( referenceMicros, 1LL ) << " MB/s, "
+                  << "fast " << mb * 1000000 / std::max( fastMicros, 1LL ) << " MB/s" << endl;
+        }
+    }
+
 }
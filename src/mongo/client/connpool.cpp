@@ -148,8 +148,8 @@ namespace mongo {
     }
 
     bool PoolForHost::StoredConnection::ok( time_t now ) {
-        // if connection has been idle for 30 minutes, kill it
-        return ( now - when ) < 1800;
+        // if connection has been idle for too long, kill it
+        return ( now - when ) < PoolForHost::idleTimeoutSecs;
     }
 
     void PoolForHost::createdOne( DBClientBase * base) {
@@ -164,8 +164,62 @@ namespace mongo {
         }
     }
 
+    bool PoolForHost::checkOut( scoped_lock& lk ) {
+        if ( maxInUsePerHost > 0 && _inUse >= maxInUsePerHost ) {
+            Date_t deadline = jsTime() + maxWaitMillis;
+            _waiting++;
+            while ( _inUse >= maxInUsePerHost ) {
+                Date_t now = jsTime();
+                if ( now >= deadline ||
+                     ! _returned.timed_wait( lk.boost(),
+                                             boost::posix_time::milliseconds(
+                                                     static_cast<long>( deadline - now ) ) ) ) {
+                    if ( _inUse < maxInUsePerHost )
+                        break;
+                    _waiting--;
+                    _waitTimeouts++;
+                    return false;
+                }
+            }
+            _waiting--;
+        }
+        _inUse++;
+        return true;
+    }
+
+    void PoolForHost::checkedIn() {
+        if ( _inUse > 0 )
+            _inUse--;
+        if ( _waiting > 0 )
+            _returned.notify_one();
+    }
+
+    int PoolForHost::numToWarm() const {
+        if ( _created == 0 )
+            return 0;
+        return max( 0 , minWarmPerHost - numAvailable() - _inUse );
+    }
+
+    void PoolForHost::addWarm( DBClientBase * c ) {
+        _created++;
+        _pool.push( c );
+    }
+
+    void PoolForHost::appendInfo( BSONObjBuilder& b ) const {
+        b.append( "available" , numAvailable() );
+        b.appendNumber( "created" , (long long) numCreated() );
+        b.append( "inUse" , _inUse );
+        b.append( "waiting" , _waiting );
+        b.appendNumber( "waitTimeouts" , _waitTimeouts );
+    }
+
     unsigned PoolForHost::_maxPerHost = 50;
 
+    int PoolForHost::maxInUsePerHost = 0;
+    int PoolForHost::maxWaitMillis = 5000;
+    int PoolForHost::minWarmPerHost = 0;
+    int PoolForHost::idleTimeoutSecs = 1800;
+
     // ------ DBConnectionPool ------
 
     DBConnectionPool pool;
@@ -181,9 +235,22 @@ namespace mongo {
         scoped_lock L(_mutex);
         PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
         p.initializeHostName(ident);
+        _checkOut( p , ident , L );
         return p.get( this , socketTimeout );
     }
 
+    void DBConnectionPool::_checkOut( PoolForHost& p , const string& ident , scoped_lock& lk ) {
+        uassert( 17349 , str::stream() << _name << ": timed out after " << PoolForHost::maxWaitMillis
+                                       << "ms waiting for one of the " << p.numInUse()
+                                       << " connections in use to " << ident ,
+                 p.checkOut( lk ) );
+    }
+
+    void DBConnectionPool::_checkedIn( const string& ident , double socketTimeout ) {
+        scoped_lock L(_mutex);
+        _pools[PoolKey(ident,socketTimeout)].checkedIn();
+    }
+
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
         {
             scoped_lock L(_mutex);
@@ -198,6 +265,7 @@ namespace mongo {
         }
         catch ( std::exception & ) {
             delete conn;
+            _checkedIn( host , socketTimeout );
             throw;
         }
 
@@ -212,14 +280,24 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _checkedIn( url.toString() , socketTimeout );
                 throw;
             }
             return c;
         }
 
         string errmsg;
-        c = url.connect( errmsg, socketTimeout );
-        uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
+        try {
+            c = url.connect( errmsg, socketTimeout );
+        }
+        catch ( std::exception& ) {
+            _checkedIn( url.toString() , socketTimeout );
+            throw;
+        }
+        if ( ! c ) {
+            _checkedIn( url.toString() , socketTimeout );
+            uasserted( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg );
+        }
 
         return _finishCreate( url.toString() , socketTimeout , c );
     }
@@ -232,6 +310,7 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _checkedIn( host , socketTimeout );
                 throw;
             }
             return c;
@@ -239,15 +318,43 @@ namespace mongo {
 
         string errmsg;
         ConnectionString cs = ConnectionString::parse( host , errmsg );
-        uassert( 13071 , (string)"invalid hostname [" + host + "]" + errmsg , cs.isValid() );
+        if ( ! cs.isValid() ) {
+            _checkedIn( host , socketTimeout );
+            uasserted( 13071 , (string)"invalid hostname [" + host + "]" + errmsg );
+        }
 
-        c = cs.connect( errmsg, socketTimeout );
-        if ( ! c )
+        try {
+            c = cs.connect( errmsg, socketTimeout );
+        }
+        catch ( std::exception& ) {
+            _checkedIn( host , socketTimeout );
+            throw;
+        }
+        if ( ! c ) {
+            _checkedIn( host , socketTimeout );
             throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
+        }
         return _finishCreate( host , socketTimeout , c );
     }
 
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
+        scoped_lock L(_mutex);
+        PoolForHost& p = _pools[PoolKey(host,c->getSoTimeout())];
+        p.checkedIn();
+        p.done(this,c);
+    }
+
+    void DBConnectionPool::decrementEgress(const string& host, DBClientBase *c) {
+        scoped_lock L(_mutex);
+        _pools[PoolKey(host,c->getSoTimeout())].checkedIn();
+    }
+
+    void DBConnectionPool::incrementEgress(const string& host, DBClientBase *c) {
+        scoped_lock L(_mutex);
+        _checkOut( _pools[PoolKey(host,c->getSoTimeout())] , host , L );
+    }
+
+    void DBConnectionPool::releaseIdle(const string& host, DBClientBase *c) {
         scoped_lock L(_mutex);
         _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
     }
@@ -319,6 +426,7 @@ namespace mongo {
     void DBConnectionPool::appendInfo( BSONObjBuilder& b ) {
 
         int avail = 0;
+        int inUse = 0;
         long long created = 0;
 
 
@@ -336,12 +444,12 @@ namespace mongo {
                 string s = str::stream() << i->first.ident << "::" << i->first.timeout;
 
                 BSONObjBuilder temp( bb.subobjStart( s ) );
-                temp.append( "available" , i->second.numAvailable() );
-                temp.appendNumber( "created" , (long long) i->second.numCreated() );
+                i->second.appendInfo( temp );
                 temp.done();
 
                 avail += i->second.numAvailable();
                 created += i->second.numCreated();
+                inUse += i->second.numInUse();
 
                 long long& x = createdByType[i->second.type()];
                 x += i->second.numCreated();
@@ -376,7 +484,16 @@ namespace mongo {
         }
 
         b.append( "totalAvailable" , avail );
+        b.append( "totalInUse" , inUse );
         b.appendNumber( "totalCreated" , created );
+
+        BSONObjBuilder policy( b.subobjStart( "policy" ) );
+        policy.append( "maxInUsePerHost" , PoolForHost::maxInUsePerHost );
+        policy.append( "maxWaitMillis" , PoolForHost::maxWaitMillis );
+        policy.append( "minWarmPerHost" , PoolForHost::minWarmPerHost );
+        policy.append( "idleTimeoutSecs" , PoolForHost::idleTimeoutSecs );
+        policy.append( "maxAvailablePerHost" , PoolForHost::getMaxPerHost() );
+        policy.done();
     }
 
     bool DBConnectionPool::serverNameCompare::operator()( const string& a , const string& b ) const{
@@ -456,6 +573,47 @@ namespace mongo {
                 // we don't care if there was a socket error
             }
         }
+
+        if ( PoolForHost::minWarmPerHost > 0 && ! inShutdown() )
+            _warm();
+    }
+
+    void DBConnectionPool::_warm() {
+        vector<PoolKey> toWarm;
+        {
+            scoped_lock lk( _mutex );
+            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
+                for ( int n = i->second.numToWarm(); n > 0; n-- )
+                    toWarm.push_back( i->first );
+            }
+        }
+
+        // connect outside the lock, it can take a while
+        for ( size_t i=0; i<toWarm.size(); i++ ) {
+            const PoolKey& key = toWarm[i];
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse( key.ident , errmsg );
+            if ( ! cs.isValid() )
+                continue;
+
+            DBClientBase* c = NULL;
+            try {
+                c = cs.connect( errmsg , key.timeout );
+                if ( ! c ) {
+                    LOG(1) << "couldn't warm pool for " << key.ident << causedBy( errmsg ) << endl;
+                    continue;
+                }
+                onCreate( c );
+            }
+            catch ( std::exception& e ) {
+                LOG(1) << "couldn't warm pool for " << key.ident << causedBy( e ) << endl;
+                delete c;
+                continue;
+            }
+
+            scoped_lock lk( _mutex );
+            _pools[key].addWarm( c );
+        }
     }
 
     // ------ ScopedDbConnection ------
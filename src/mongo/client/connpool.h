@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
 #include <stack>
 
 #include "mongo/util/background.h"
@@ -35,12 +36,16 @@ namespace mongo {
     class PoolForHost {
     public:
         PoolForHost()
-            : _created(0), _minValidCreationTimeMicroSec(0) {}
+            : _created(0), _minValidCreationTimeMicroSec(0),
+              _inUse(0), _waiting(0), _waitTimeouts(0) {}
 
         PoolForHost( const PoolForHost& other ) {
             verify(other._pool.size() == 0);
             _created = other._created;
             _minValidCreationTimeMicroSec = other._minValidCreationTimeMicroSec;
+            _inUse = other._inUse;
+            _waiting = other._waiting;
+            _waitTimeouts = other._waitTimeouts;
             verify( _created == 0 );
         }
 
@@ -48,6 +53,31 @@ namespace mongo {
 
         int numAvailable() const { return (int)_pool.size(); }
 
+        /** @return the number of connections handed out and not yet returned or deleted */
+        int numInUse() const { return _inUse; }
+
+        /**
+         * Counts a connection as handed out, first waiting up to maxWaitMillis for one to be
+         * returned if maxInUsePerHost are already out.
+         * @param lk the owning DBConnectionPool's lock, which is released while waiting
+         * @return false if the wait timed out
+         */
+        bool checkOut( scoped_lock& lk );
+
+        /** Counts a connection as returned or deleted, waking a thread waiting in checkOut(). */
+        void checkedIn();
+
+        /**
+         * @return the number of connections to make, so that minWarmPerHost are open.  Only
+         *     for hosts this pool has connected to before.
+         */
+        int numToWarm() const;
+
+        /** Adds a connection made to warm the pool, not handed out. */
+        void addWarm( DBClientBase * c );
+
+        void appendInfo( BSONObjBuilder& b ) const;
+
         void createdOne( DBClientBase * base );
         long long numCreated() const { return _created; }
 
@@ -86,6 +116,21 @@ namespace mongo {
 
         static void setMaxPerHost( unsigned max ) { _maxPerHost = max; }
         static unsigned getMaxPerHost() { return _maxPerHost; }
+
+        // Policies for every host, settable with setParameter (see connPoolStats).
+
+        // Most connections to a host that can be in use at once, 0 for no limit.  Threads asking
+        // for more wait for one to be returned, so that a failover doesn't open thousands.  The
+        // idle connections mongos keeps for each client thread (see
+        // releaseConnectionsAfterResponse) don't count until they are used again.
+        static int maxInUsePerHost;
+        // How long to wait for a connection when maxInUsePerHost are in use, before failing.
+        static int maxWaitMillis;
+        // Connections to keep open to each host, in use or not, made in the background.
+        static int minWarmPerHost;
+        // How long a connection can sit in the pool unused before it is closed.
+        static int idleTimeoutSecs;
+
     private:
 
         struct StoredConnection {
@@ -104,6 +149,11 @@ namespace mongo {
         uint64_t _minValidCreationTimeMicroSec;
         ConnectionString::ConnectionType _type;
 
+        int _inUse;
+        int _waiting;
+        long long _waitTimeouts;
+        boost::condition _returned;
+
         static unsigned _maxPerHost;
     };
 
@@ -151,6 +201,21 @@ namespace mongo {
 
         void release(const string& host, DBClientBase *c);
 
+        /**
+         * Call instead of release() for a connection from this pool that is being deleted, or
+         * that the caller keeps idle, so it no longer counts against maxInUsePerHost.
+         */
+        void decrementEgress(const string& host, DBClientBase *c);
+
+        /**
+         * Counts a connection from this pool, kept idle by the caller after decrementEgress(),
+         * as handed out again.  Waits like get() if maxInUsePerHost are in use.
+         */
+        void incrementEgress(const string& host, DBClientBase *c);
+
+        /** Call instead of release() for a connection kept idle after decrementEgress(). */
+        void releaseIdle(const string& host, DBClientBase *c);
+
         void addHook( DBConnectionHook * hook ); // we take ownership
         void appendInfo( BSONObjBuilder& b );
 
@@ -186,6 +251,15 @@ namespace mongo {
         
         DBClientBase* _get( const string& ident , double socketTimeout );
 
+        /** Counts a connection to p as handed out, uasserts if the wait for one times out. */
+        void _checkOut( PoolForHost& p , const string& ident , scoped_lock& lk );
+
+        /** Undoes _get()'s checkOut() when a connection couldn't be made. */
+        void _checkedIn( const string& ident , double socketTimeout );
+
+        /** Opens connections to hosts whose pools are below minWarmPerHost. */
+        void _warm();
+
         DBClientBase* _finishCreate( const string& ident , double socketTimeout, DBClientBase* conn );
         
         struct PoolKey {
@@ -309,6 +383,8 @@ namespace mongo {
             a bad state.  Destructor will do this too, but it is verbose.
         */
         void kill() {
+            if ( _conn )
+                pool.decrementEgress( _host, _conn );
             delete _conn;
             _conn = 0;
         }
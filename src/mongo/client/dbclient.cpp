@@ -31,6 +31,7 @@
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/md5.hpp"
+#include "mongo/util/net/message_compression.h"
 
 #ifdef MONGO_SSL
 // TODO: Remove references to cmdline from the client.
@@ -894,6 +895,22 @@ namespace mongo {
         }
 #endif
 
+        if ( _compressMessages ) {
+            // An old server ignores the field and we don't compress.
+            try {
+                BSONObj info;
+                if ( DBClientWithCommands::runCommand( "admin", messageCompression::isMasterRequest(), info ) &&
+                     messageCompression::negotiated( info ) ) {
+                    p->setCompressMessages( true );
+                }
+            }
+            catch ( SocketException &e ) {
+                errmsg = str::stream() << "couldn't connect to server " << _server.toString() << ": " << e.what();
+                _failed = true;
+                return false;
+            }
+        }
+
         return true;
     }
 
@@ -1441,6 +1458,7 @@ namespace mongo {
 
     AtomicUInt DBClientConnection::_numConnections;
     bool DBClientConnection::_lazyKillCursor = true;
+    bool DBClientConnection::_compressMessages = false;
 
 
     bool serverAlive( const string &uri ) {
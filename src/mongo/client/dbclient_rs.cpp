@@ -134,9 +134,9 @@ namespace mongo {
      * @param nodes the nodes to select from
      * @param readPreferenceTag the tags to use for choosing the right node
      * @param secOnly never select a primary if true
-     * @param localThresholdMillis the exclusive upper bound of ping time to be
-     *     considered as a local node. Local nodes are favored over non-local
-     *     nodes if multiple nodes matches the other criteria.
+     * @param localThresholdMillis how much slower than the fastest eligible node a node's
+     *     ping time can be for it to be considered a local node. Local nodes are favored
+     *     over non-local nodes if multiple nodes matches the other criteria.
      * @param lastHost the last host returned (mainly used for doing round-robin).
      *     Will be overwritten with the newly returned host if not empty. Should
      *     never be NULL.
@@ -155,6 +155,20 @@ namespace mongo {
                             bool* isPrimarySelected) {
         HostAndPort fallbackHost;
 
+        // Ping times are moving averages, see ReplicaSetMonitor::_checkConnection.  Measure
+        // from the fastest candidate, so that when every node is far away, reads still go to
+        // the nearest ones rather than to whichever comes last in the round-robin.
+        int fastestPingMillis = -1;
+        for (size_t x = 0; x < nodes.size(); x++) {
+            const ReplicaSetMonitor::Node& node = nodes[x];
+            if (node.ok && (!secOnly || node.okForSecondaryQueries()) &&
+                    node.matchesTag(readPreferenceTag) &&
+                    (fastestPingMillis < 0 || node.pingTimeMillis < fastestPingMillis)) {
+                fastestPingMillis = node.pingTimeMillis;
+            }
+        }
+        const int localBoundMillis = max(fastestPingMillis, 0) + localThresholdMillis;
+
         // Implicit: start from index 0 if lastHost doesn't exist anymore
         size_t nextNodeIndex = 0;
 
@@ -189,7 +203,7 @@ namespace mongo {
                 fallbackHost = node.addr;
                 *isPrimarySelected = node.ismaster;
 
-                if (node.isLocalSecondary(localThresholdMillis)) {
+                if (node.isLocalSecondary(localBoundMillis)) {
                     // found a local node.  return early.
                     LOG(2) << "dbclient_rs selecting local secondary " << fallbackHost
                                       << ", ping time: " << node.pingTimeMillis << endl;
@@ -578,6 +592,16 @@ namespace mongo {
         HostAndPort fallbackNode;
         scoped_lock lk( _lock );
 
+        // as in _selectNode, local is relative to the fastest secondary
+        int fastestPingMillis = -1;
+        for ( size_t i = 0; i < _nodes.size(); ++i ) {
+            if ( (int)i != _master && _nodes[i].okForSecondaryQueries() &&
+                 ( fastestPingMillis < 0 || _nodes[i].pingTimeMillis < fastestPingMillis ) ) {
+                fastestPingMillis = _nodes[i].pingTimeMillis;
+            }
+        }
+        const int localBoundMillis = max( fastestPingMillis , 0 ) + _localThresholdMillis;
+
         for ( size_t itNode = 0; itNode < _nodes.size(); ++itNode ) {
             _nextSlave = ( _nextSlave + 1 ) % _nodes.size();
             if ( _nextSlave != _master ) {
@@ -586,7 +610,7 @@ namespace mongo {
                     fallbackNode = _nodes[ _nextSlave ].addr;
                     if ( ! preferLocal )
                         return fallbackNode;
-                    else if ( _nodes[ _nextSlave ].isLocalSecondary( _localThresholdMillis ) ) {
+                    else if ( _nodes[ _nextSlave ].isLocalSecondary( localBoundMillis ) ) {
                         // found a local slave.  return early.
                         LOG(2) << "dbclient_rs getSlave found local secondary for queries: "
                                << _nextSlave << ", ping time: "
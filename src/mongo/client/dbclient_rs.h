@@ -142,9 +142,9 @@ namespace mongo {
          * @param nodes the nodes to select from
          * @param preference the read mode to use
          * @param tags the tags used for filtering nodes
-         * @param localThresholdMillis the exclusive upper bound of ping time to be
-         *     considered as a local node. Local nodes are favored over non-local
-         *     nodes if multiple nodes matches the other criteria.
+         * @param localThresholdMillis how much slower than the fastest eligible node a
+         *     node's ping time can be for it to be considered a local node. Local nodes are
+         *     favored over non-local nodes if multiple nodes matches the other criteria.
          * @param lastHost the host used in the last successful request. This is used for
          *     selecting a different node as much as possible, by doing a simple round
          *     robin, starting from the node next to this lastHost. This will be overwritten
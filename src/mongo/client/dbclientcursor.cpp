@@ -117,8 +117,8 @@ namespace mongo {
         return ok;
     }
 
-    void DBClientCursor::requestMore() {
-        verify( cursorId && batch.pos == batch.nReturned );
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        verify( cursorId && ( batch.pos == batch.nReturned || ! haveLimit ) );
 
         if (haveLimit) {
             nToReturn -= batch.nReturned;
@@ -130,8 +130,12 @@ namespace mongo {
         b.appendNum(nextBatchSize());
         b.appendNum(cursorId);
 
-        Message toSend;
         toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    void DBClientCursor::requestMore() {
+        Message toSend;
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -152,6 +156,53 @@ namespace mongo {
         }
     }
 
+    bool DBClientCursor::requestMoreLazy() {
+        if ( _lazyMoreConn || _client || _scopedHost.empty() || cursorId == 0 ) {
+            return false;
+        }
+        if ( haveLimit ) {
+            // what's left of the limit depends on the current batch being used up
+            if ( ! _putBack.empty() || batch.pos < batch.nReturned || batch.pos >= nToReturn ) {
+                return false;
+            }
+        }
+
+        Message toSend;
+        _assembleGetMore( toSend );
+        auto_ptr<ScopedDbConnection> conn(
+                ScopedDbConnection::getScopedDbConnection( _scopedHost ) );
+        conn->get()->say( toSend );
+        _lazyMoreConn = conn.release();
+        return true;
+    }
+
+    void DBClientCursor::requestMoreLazyFinish() {
+        verify( _lazyMoreConn );
+        scoped_ptr<ScopedDbConnection> conn( _lazyMoreConn );
+        _lazyMoreConn = NULL;
+
+        auto_ptr<Message> response(new Message());
+        if ( ! conn->get()->recv( *response ) ) {
+            conn->kill();
+            uasserted( 17348, str::stream() << "recv failed for getMore from " << _scopedHost );
+        }
+        batch.m = response;
+
+        // the whole reply has been read, so the connection can go back to the pool even if the
+        // reply is an error
+        _client = conn->get();
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _client = 0;
+            conn->done();
+            throw;
+        }
+        _client = 0;
+        conn->done();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -212,6 +263,12 @@ namespace mongo {
         if ( !_putBack.empty() )
             return true;
 
+        if ( _lazyMoreConn && batch.pos == batch.nReturned ) {
+            // before the limit check, which needs the batch the getMore was sent for
+            requestMoreLazyFinish();
+            return batch.pos < batch.nReturned;
+        }
+
         if (haveLimit && batch.pos >= nToReturn)
             return false;
 
@@ -321,6 +378,13 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _lazyMoreConn ) {
+            // the getMore's reply is still coming, so the connection can't go back to the pool
+            _lazyMoreConn->kill();
+            delete _lazyMoreConn;
+            _lazyMoreConn = NULL;
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -29,6 +29,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here 
         @see DBClientMockCursor
@@ -147,7 +148,8 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _lazyMoreConn( NULL ) {
             _finishConsInit();
         }
 
@@ -163,7 +165,8 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _lazyMoreConn(NULL) {
             _finishConsInit();
         }
 
@@ -202,6 +205,22 @@ namespace mongo {
         void initLazy( bool isRetry = false );
         bool initLazyFinish( bool& retry );
 
+        /**
+         * Sends the getMore for the batch after the current one without waiting for the reply,
+         * which more() reads once the current batch is used up.  A caller reading many cursors can
+         * have all their getMores in flight at once instead of paying a round trip per cursor.
+         * Only for cursors that were attach()ed: the request holds a pooled connection to the
+         * cursor's host until the reply is read.
+         *
+         * @return true if a getMore was sent, false if one is already out, there is nothing more
+         *         to get, the cursor has a limit and the current batch isn't used up, or the
+         *         cursor isn't attached
+         */
+        bool requestMoreLazy();
+
+        /** @return true if a requestMoreLazy() reply hasn't been read yet */
+        bool moreRequested() const { return _lazyMoreConn != NULL; }
+
         class Batch : boost::noncopyable { 
             friend class DBClientCursor;
             auto_ptr<Message> m;
@@ -262,10 +281,13 @@ namespace mongo {
         string _scopedHost;
         string _lazyHost;
         bool wasError;
+        ScopedDbConnection* _lazyMoreConn; // owned, holds the connection a requestMoreLazy() reply will come on
 
         void dataReceived() { bool retry; string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, string& lazyHost );
         void requestMore();
+        void requestMoreLazyFinish();
+        void _assembleGetMore( Message& toSend );
         void exhaustReceiveMore(); // for exhaust
 
         // Don't call from a virtual function
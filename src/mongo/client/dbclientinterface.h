@@ -1272,6 +1272,10 @@ namespace mongo {
         static void setLazyKillCursor( bool lazy ) { _lazyKillCursor = lazy; }
         static bool getLazyKillCursor() { return _lazyKillCursor; }
 
+        // Whether new connections ask the server to compress messages (--netCompression).
+        static void setCompressMessages( bool compress ) { _compressMessages = compress; }
+        static bool getCompressMessages() { return _compressMessages; }
+
         uint64_t getSockCreationMicroSec() const;
 
     protected:
@@ -1298,6 +1302,7 @@ namespace mongo {
 
         static AtomicUInt _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
+        static bool _compressMessages;
 
 #ifdef MONGO_SSL
         SSLManager* sslManager();
@@ -359,10 +359,19 @@ namespace mongo {
 
         BSONObj ret = _next;
         _next = BSONObj();
-        _advance();
+        // Don't wait here for the document after this one, more() or peek() will.  If the batch
+        // is used up, send the getMore now so it is on its way while other cursors are read.
+        if ( _cursor.get() && ! _cursor->moreInCurrentBatch() )
+            _cursor->requestMoreLazy();
         return ret;
     }
 
+    bool FilteringClientCursor::isBuffered() {
+        if ( ! _next.isEmpty() || _done || ! _cursor.get() )
+            return true;
+        return _cursor->moreInCurrentBatch() || ( _cursor->isDead() && ! _cursor->moreRequested() );
+    }
+
     BSONObj FilteringClientCursor::peek() {
         if ( _next.isEmpty() )
             _advance();
@@ -478,6 +487,7 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _heapInit = false;
 
         if( ! _qSpec.isEmpty() ){
 
@@ -1599,6 +1609,12 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        for ( int i=0; i<_numServers; i++ ) {
+            if ( _cursors[i].isBuffered() && _cursors[i].more() )
+                return true;
+        }
+
+        _requestMoreAll();
         for ( int i=0; i<_numServers; i++ ) {
             if ( _cursors[i].more() )
                 return true;
@@ -1606,47 +1622,106 @@ namespace mongo {
         return false;
     }
 
-    BSONObj ParallelSortClusteredCursor::next() {
-        BSONObj best = BSONObj();
-        int bestFrom = -1;
+    namespace {
 
-        for( int j = 0; j < _numServers; j++ ){
+        /** Orders indexes into a cursor array so that a heap has the smallest peek() on top. */
+        class PeekGreater {
+        public:
+            PeekGreater( FilteringClientCursor* cursors , const BSONObj& sortKey )
+                : _cursors( cursors ) , _sortKey( sortKey ) {
+            }
 
-            // Iterate _numServers times, starting one past the last server we used.
-            // This means we actually start at server #1, not #0, but shouldn't matter
+            bool operator()( int a , int b ) const {
+                return _cursors[a].peek().woSortOrder( _cursors[b].peek() , _sortKey , true ) > 0;
+            }
 
-            int i = ( j + _lastFrom + 1 ) % _numServers;
+        private:
+            FilteringClientCursor* _cursors;
+            BSONObj _sortKey;
+        };
 
-            if ( ! _cursors[i].more() ){
-                if( _cursors[i].rawMData() )
-                    _cursors[i].rawMData()->pcState->done = true;
-                continue;
-            }
+    } // namespace
+
+    bool ParallelSortClusteredCursor::_cursorMore( int i ) {
+        if ( _cursors[i].more() )
+            return true;
+        if( _cursors[i].rawMData() )
+            _cursors[i].rawMData()->pcState->done = true;
+        return false;
+    }
 
-            BSONObj me = _cursors[i].peek();
+    void ParallelSortClusteredCursor::_requestMoreAll() {
+        // About to wait on a shard: get the next batch of every other shard on its way too, so
+        // that the round trips overlap instead of adding up.
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _cursors[i].raw() )
+                _cursors[i].raw()->requestMoreLazy();
+        }
+    }
 
-            if ( best.isEmpty() ) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
+    BSONObj ParallelSortClusteredCursor::next() {
+        int from = -1;
+
+        if ( ! _sortKey.isEmpty() ) {
+            PeekGreater greater( _cursors , _sortKey );
+            if ( ! _heapInit ) {
+                _heapInit = true;
+                for ( int i = 0; i < _numServers; i++ ) {
+                    if ( ! _cursors[i].isBuffered() ) {
+                        _requestMoreAll();
+                        break;
+                    }
+                }
+                for ( int i = 0; i < _numServers; i++ ) {
+                    if ( _cursorMore( i ) )
+                        _heap.push_back( i );
+                }
+                make_heap( _heap.begin() , _heap.end() , greater );
             }
 
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
+            uassert( 10019 ,  "no more elements" , ! _heap.empty() );
+            pop_heap( _heap.begin() , _heap.end() , greater );
+            from = _heap.back();
+            _heap.pop_back();
+
+            // the next document is owned if it was the last of its batch, so it survives more()
+            BSONObj best = _cursors[from].next();
+            if ( ! _cursors[from].isBuffered() )
+                _requestMoreAll();
+            if ( _cursorMore( from ) ) {
+                _heap.push_back( from );
+                push_heap( _heap.begin() , _heap.end() , greater );
+            }
+
+            _lastFrom = from;
+            if( _cursors[from].rawMData() )
+                _cursors[from].rawMData()->pcState->count++;
+            return best;
+        }
 
-            best = me;
-            bestFrom = i;
+        // Iterate _numServers times, starting one past the last server we used.  Take from the
+        // first shard with a document on hand, rather than waiting on one whose getMore is out.
+        for( int j = 0; j < _numServers && from < 0; j++ ){
+            int i = ( j + _lastFrom + 1 ) % _numServers;
+            if ( _cursors[i].isBuffered() && _cursorMore( i ) )
+                from = i;
         }
 
-        _lastFrom = bestFrom;
+        if ( from < 0 ) {
+            _requestMoreAll();
+            for( int j = 0; j < _numServers && from < 0; j++ ){
+                int i = ( j + _lastFrom + 1 ) % _numServers;
+                if ( _cursorMore( i ) )
+                    from = i;
+            }
+        }
 
-        uassert( 10019 ,  "no more elements" , ! best.isEmpty() );
-        _cursors[bestFrom].next();
+        uassert( 17357 ,  "no more elements" , from >= 0 );
+        _lastFrom = from;
+        BSONObj best = _cursors[from].next();
 
-        if( _cursors[bestFrom].rawMData() )
-            _cursors[bestFrom].rawMData()->pcState->count++;
+        if( _cursors[from].rawMData() )
+            _cursors[from].rawMData()->pcState->count++;
 
         return best;
     }
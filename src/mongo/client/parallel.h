@@ -139,6 +139,12 @@ namespace mongo {
 
         BSONObj peek();
 
+        /**
+         * @return true if more() can answer without waiting on the network, because a document
+         *         is buffered or the cursor is finished
+         */
+        bool isBuffered();
+
         DBClientCursor* raw() { return _cursor.get(); }
         ParallelConnectionMetadata* rawMData(){ return _pcmData; }
 
@@ -392,6 +398,17 @@ namespace mongo {
         FilteringClientCursor * _cursors;
         int _needToSkip;
 
+        // For sorted queries, indexes into _cursors of the ones with more(), as a heap with the
+        // smallest peek() on top.  Built by the first next().
+        vector<int> _heap;
+        bool _heapInit;
+
+        /** @return _cursors[i].more(), marking the shard's state done if not */
+        bool _cursorMore( int i );
+
+        /** Sends a getMore to every shard that can take one, see DBClientCursor::requestMoreLazy */
+        void _requestMoreAll();
+
     private:
         /**
          * Setups the shard version of the connection. When using a replica
@@ -195,6 +195,8 @@ namespace mongo_test {
     public:
         void setUp() {
             _maxPoolSizePerHost = mongo::PoolForHost::getMaxPerHost();
+            _maxInUsePerHost = mongo::PoolForHost::maxInUsePerHost;
+            _maxWaitMillis = mongo::PoolForHost::maxWaitMillis;
             _dummyServer = new DummyServer(TARGET_PORT);
 
             _dummyServer->run(&dummyHandler);
@@ -219,6 +221,8 @@ namespace mongo_test {
             delete _dummyServer;
 
             mongo::PoolForHost::setMaxPerHost(_maxPoolSizePerHost);
+            mongo::PoolForHost::maxInUsePerHost = _maxInUsePerHost;
+            mongo::PoolForHost::maxWaitMillis = _maxWaitMillis;
         }
 
     protected:
@@ -282,6 +286,8 @@ namespace mongo_test {
 
         DummyServer* _dummyServer;
         uint32_t _maxPoolSizePerHost;
+        int _maxInUsePerHost;
+        int _maxWaitMillis;
     };
 
     TEST_F(DummyServerFixture, BasicScopedDbConnection) {
@@ -420,4 +426,58 @@ namespace mongo_test {
 
         conn1Again->done();
     }
+
+    TEST_F(DummyServerFixture, MaxInUsePerHost) {
+        mongo::PoolForHost::maxInUsePerHost = 2;
+        mongo::PoolForHost::maxWaitMillis = 100;
+
+        scoped_ptr<ScopedDbConnection> conn1(
+                ScopedDbConnection::getScopedDbConnection(TARGET_HOST));
+        scoped_ptr<ScopedDbConnection> conn2(
+                ScopedDbConnection::getScopedDbConnection(TARGET_HOST));
+
+        // a third waits for one of them, and gives up
+        ASSERT_THROWS(ScopedDbConnection::getScopedDbConnection(TARGET_HOST),
+                      mongo::UserException);
+
+        // returned and killed connections both make room
+        conn1->done();
+        scoped_ptr<ScopedDbConnection> conn3(
+                ScopedDbConnection::getScopedDbConnection(TARGET_HOST));
+        conn2->kill();
+        scoped_ptr<ScopedDbConnection> conn4(
+                ScopedDbConnection::getScopedDbConnection(TARGET_HOST));
+
+        conn3->done();
+        conn4->done();
+    }
+
+    TEST_F(DummyServerFixture, IdleConnectionsDontCountInUse) {
+        mongo::PoolForHost::maxInUsePerHost = 2;
+        mongo::PoolForHost::maxWaitMillis = 100;
+
+        // kept idle by its user, the way mongos keeps one per client thread
+        DBClientBase* idle = mongo::pool.get(TARGET_HOST);
+        mongo::pool.decrementEgress(TARGET_HOST, idle);
+
+        DBClientBase* conn1 = mongo::pool.get(TARGET_HOST);
+        DBClientBase* conn2 = mongo::pool.get(TARGET_HOST);
+
+        // using the idle one again waits for a slot, and gives up
+        ASSERT_THROWS(mongo::pool.incrementEgress(TARGET_HOST, idle), mongo::UserException);
+
+        mongo::pool.release(TARGET_HOST, conn1);
+        mongo::pool.incrementEgress(TARGET_HOST, idle);
+        mongo::pool.release(TARGET_HOST, idle);
+
+        // returning an idle one doesn't free a slot it doesn't hold, conn2 still holds one
+        idle = mongo::pool.get(TARGET_HOST);
+        mongo::pool.decrementEgress(TARGET_HOST, idle);
+        mongo::pool.releaseIdle(TARGET_HOST, idle);
+        conn1 = mongo::pool.get(TARGET_HOST);
+        ASSERT_THROWS(mongo::pool.get(TARGET_HOST), mongo::UserException);
+
+        mongo::pool.release(TARGET_HOST, conn1);
+        mongo::pool.release(TARGET_HOST, conn2);
+    }
 }
@@ -135,6 +135,7 @@ namespace {
         ("keyFile", po::value<string>(), "private key for cluster authentication")
         ("setParameter", po::value< std::vector<std::string> >()->composing(),
                 "Set a configurable parameter")
+        ("netCompression", "compress messages on connections to other servers, if they support it")
 #ifndef _WIN32
         ("nounixsocket", "disable listening on unix sockets")
         ("unixSocketPrefix", po::value<string>(), "alternative directory for UNIX domain sockets (defaults to /tmp)")
@@ -394,6 +395,10 @@ namespace {
             cmdLine.objcheck = false;
         }
 
+        if (params.count("netCompression")) {
+            cmdLine.netCompression = true;
+        }
+
         if (params.count("bind_ip")) {
             // passing in wildcard is the same as default behavior; remove and warn
             if ( cmdLine.bind_ip ==  "0.0.0.0" ) {
@@ -96,6 +96,7 @@ namespace mongo {
         bool moveParanoia;     // for move chunk paranoia
         double syncdelay;      // seconds between fsyncs
 
+        bool netCompression;   // --netCompression
         bool noUnixSocket;     // --nounixsocket
         bool doFork;           // --fork
         std::string socket;    // UNIX domain socket directory
@@ -187,7 +188,7 @@ namespace mongo {
         expireOplogDays(14), expireOplogHours(0), // default of 14, two weeks
         objcheck(true), defaultProfile(0),
         slowMS(100), defaultLocalThresholdMillis(15), moveParanoia( false ),
-        syncdelay(60), noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN),
+        syncdelay(60), netCompression(false), noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN),
         logAppend(false), logWithSyslog(false),
         directio(false), gdb(false), cacheSize(0), locktreeMaxMemory(0), loaderMaxMemory(0), loaderCompressTmp(true), checkpointPeriod(60), cleanerPeriod(2),
         cleanerIterations(5), lockTimeout(4000), fsRedzone(5), logDir(""), tmpDir(""), gdbPath(""),
@@ -37,6 +37,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/storage/key.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/db/storage/assert_ids.h"
 
@@ -438,7 +439,7 @@ namespace mongo {
     }
 
     bool CollectionBase::fastupdatesOk() {
-        return false;
+        return !shardingState.enabled() || !shardingState.getShardChunkManager(_ns);
     }
 
     BSONObj CollectionBase::getSimplePKFromQuery(const BSONObj &query, const BSONObj& pk) const {
@@ -606,11 +607,11 @@ namespace mongo {
             }
 
             if (!isPK) {
-                BSONObjSet idxKeys;
-                idx.getKeysFromObject(obj, idxKeys);
+                storage::KeyArray &idxKeys = storage::KeyArray::forThread();
+                idx.getKeysFromObject(obj, pk, idxKeys);
                 if (idx.unique() && doUniqueChecks) {
-                    for (BSONObjSet::const_iterator o = idxKeys.begin(); o != idxKeys.end(); ++o) {
-                        idx.uniqueCheck(*o, pk);
+                    for (size_t k = 0; k < idxKeys.size(); k++) {
+                        idx.uniqueCheck(idxKeys.key(k), pk);
                     }
                 }
                 if (idxKeys.size() > 1) {
@@ -618,12 +619,7 @@ namespace mongo {
                 }
                 // Store the keys we just generated, so we won't do it twice in
                 // the generate keys callback. See storage::generate_keys()
-                DBT_ARRAY *array = &keyArrays[i];
-                storage::dbt_array_clear_and_resize(array, idxKeys.size());
-                for (BSONObjSet::const_iterator it = idxKeys.begin(); it != idxKeys.end(); it++) {
-                    const storage::Key sKey(*it, &pk);
-                    storage::dbt_array_push(array, sKey.buf(), sKey.size());
-                }
+                idxKeys.pushTo(&keyArrays[i]);
             }
         }
 
@@ -679,8 +675,8 @@ namespace mongo {
                 del_flags[i] &= ~DB_DELETE_ANY;
             }
             if (!isPK) {
-                BSONObjSet idxKeys;
-                idx.getKeysFromObject(obj, idxKeys);
+                storage::KeyArray &idxKeys = storage::KeyArray::forThread();
+                idx.getKeysFromObject(obj, pk, idxKeys);
 
                 if (idxKeys.size() > 1) {
                     verify(isMultiKey(i));
@@ -688,12 +684,7 @@ namespace mongo {
 
                 // Store the keys we just generated, so we won't do it twice in
                 // the generate keys callback. See storage::generate_keys()
-                DBT_ARRAY *array = &keyArrays[i];
-                storage::dbt_array_clear_and_resize(array, idxKeys.size());
-                for (BSONObjSet::const_iterator it = idxKeys.begin(); it != idxKeys.end(); it++) {
-                    const storage::Key sKey(*it, &pk);
-                    storage::dbt_array_push(array, sKey.buf(), sKey.size());
-                }
+                idxKeys.pushTo(&keyArrays[i]);
             }
         }
 
@@ -846,6 +837,19 @@ namespace mongo {
         pkIdx.updatePair(pk, NULL, b.done(), flags);
     }
 
+    void CollectionBase::upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateObj,
+                                          const bool fromMigrate,
+                                          uint64_t flags) {
+        verify(!updateObj.isEmpty());
+        BSONObjBuilder b;
+        b.append("t", "up");
+        b.append("o", updateObj);
+        b.append("q", query);
+
+        IndexDetailsBase &pkIdx = getPKIndexBase();
+        pkIdx.updatePair(pk, NULL, b.done(), flags);
+    }
+
     bool CollectionBase::_allowSetMultiKeyInMSTForTests = false;
 
     // only set indexBitsChanged if true, NEVER set to false
@@ -2497,6 +2501,13 @@ namespace mongo {
         // multiKey stuff taken care of during close(), so indexBitChanged is not set
     }
 
+    void BulkLoadedCollection::insertRow(DBT *key, DBT *val) {
+        const int r = _loader->put(key, val);
+        if (r != 0) {
+            storage::handle_ydb_error(r);
+        }
+    }
+
     void BulkLoadedCollection::deleteObject(const BSONObj &pk, const BSONObj &obj, uint64_t flags) {
         uasserted( 16865, "Cannot delete from a collection under-going bulk load." );
     }
@@ -2513,6 +2524,12 @@ namespace mongo {
         uasserted( 17218, "Cannot update a collection under-going bulk load." );
     }
 
+    void BulkLoadedCollection::upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateobj,
+                                                const bool fromMigrate,
+                                                uint64_t flags) {
+        uasserted( 17352, "Cannot upsert a collection under-going bulk load." );
+    }
+
     bool BulkLoadedCollection::rebuildIndex(int i, const BSONObj &options, BSONObjBuilder &wasBuilder) {
         uasserted( 16895, "Cannot optimize a collection under-going bulk load." );
     }
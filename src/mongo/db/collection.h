@@ -199,7 +199,6 @@ namespace mongo {
                                   const bool fromMigrate,
                                   uint64_t flags, bool* indexBitChanged) = 0;
 
-        // currently an unused function
         virtual bool fastupdatesOk() = 0;
 
         virtual bool updateObjectModsOk() = 0;
@@ -211,6 +210,12 @@ namespace mongo {
                                       const bool fromMigrate,
                                       uint64_t flags) = 0;
 
+        // upsert an object in the namespace by pk, described by the query and the
+        // updateObj's $ operators
+        virtual void upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateObj,
+                                      const bool fromMigrate,
+                                      uint64_t flags) = 0;
+
         // rebuild the given index, online.
         // - if there are options, change those options in the index and update the system catalog.
         // - otherwise, send an optimize message and run hot optimize.
@@ -360,6 +365,24 @@ namespace mongo {
             _queryCache.notifyOfWriteOp();
         }
 
+        //
+        // Idle tracking - common to all collections.
+        //
+
+        // The last time CollectionMap::getCollection() returned this collection, in seconds
+        // of Listener::getElapsedTimeMillis(). CollectionMap closes the least recently used
+        // collections when too many are open.
+        long long lastUsed() const {
+            return _lastUsed.load();
+        }
+
+        void noteUsed(const long long now) {
+            // Every operation gets here, so only write when the second changes.
+            if (_lastUsed.load() != now) {
+                _lastUsed.store(now);
+            }
+        }
+
         //
         // Simple collection metadata - common to all collections.
         //
@@ -562,8 +585,8 @@ namespace mongo {
         }
 
         // @return true, if fastupdates are ok for this collection.
-        //         fastupdates are not ok for this collection if it's sharded
-        //         and the primary key does not contain the full shard key.
+        //         fastupdates are not ok for this collection if it's sharded,
+        //         since a chunk migration needs the documents a write touches.
         bool fastupdatesOk() {
             return _cd->fastupdatesOk();
         }
@@ -581,6 +604,15 @@ namespace mongo {
             _cd->updateObjectMods(pk, updateObj, fromMigrate, flags);
         }
 
+        // upsert an object in the namespace by pk, without reading it first: the
+        // updateObj's $ operators are applied to the existing object, or to the
+        // object described by query if there is none.
+        void upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateObj,
+                              const bool fromMigrate,
+                              uint64_t flags = 0) {
+            _cd->upsertObjectMods(pk, query, updateObj, fromMigrate, flags);
+        }
+
         // Rebuild indexes. Details are implementation specific. This is typically an online operation.
         //
         // @param name, name of the index to optimize. "*" means all indexes
@@ -655,6 +687,8 @@ namespace mongo {
         /* query cache (for query optimizer) */
         QueryCache _queryCache;
 
+        AtomicWord<long long> _lastUsed;
+
         // fix later
         shared_ptr<CollectionData> _cd;
     };
@@ -753,8 +787,8 @@ namespace mongo {
         bool findByPK(const BSONObj &pk, BSONObj &result) const;
 
         // @return true, if fastupdates are ok for this collection.
-        //         fastupdates are not ok for this collection if it's sharded
-        //         and the primary key does not contain the full shard key.
+        //         fastupdates are not ok for this collection if it's sharded,
+        //         since a chunk migration needs the documents a write touches.
         bool fastupdatesOk();
         bool updateObjectModsOk() {
             return true;
@@ -806,6 +840,12 @@ namespace mongo {
         virtual void updateObjectMods(const BSONObj &pk, const BSONObj &updateObj, 
                                       const bool fromMigrate,
                                       uint64_t flags);
+
+        // upsert an object in the namespace by pk, described by the query and the
+        // updateObj's $ operators
+        virtual void upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateObj,
+                                      const bool fromMigrate,
+                                      uint64_t flags);
         
         void setIndexIsMultikey(const int idxNum, bool* indexBitChanged);
 
@@ -1239,6 +1279,10 @@ namespace mongo {
 
         void insertObject(BSONObj &obj, uint64_t flags, bool* indexBitChanged);
 
+        // Put a primary key row, exactly as another node stores it, into the loader.
+        // Used by mongosnapshotload, see db/snapshot_stream.h.
+        void insertRow(DBT *key, DBT *val);
+
         void deleteObject(const BSONObj &pk, const BSONObj &obj, uint64_t flags);
 
         void updateObject(const BSONObj &pk, const BSONObj &oldObj, BSONObj &newObj,
@@ -1249,6 +1293,10 @@ namespace mongo {
                               const bool fromMigrate,
                               uint64_t flags);
 
+        void upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateobj,
+                              const bool fromMigrate,
+                              uint64_t flags);
+
         void empty();
 
         bool rebuildIndex(int i, const BSONObj &options, BSONObjBuilder &wasBuilder);
@@ -1411,6 +1459,13 @@ namespace mongo {
             _partitions[whichPartition]->updateObjectMods(pk, updateObj, fromMigrate, flags);
         }
 
+        virtual void upsertObjectMods(const BSONObj &pk, const BSONObj &query, const BSONObj &updateObj,
+                                      const bool fromMigrate,
+                                      uint64_t flags) {
+            int whichPartition = partitionWithPK(pk);
+            _partitions[whichPartition]->upsertObjectMods(pk, query, updateObj, fromMigrate, flags);
+        }
+
         virtual bool rebuildIndex(int i, const BSONObj &options, BSONObjBuilder &result);
 
         virtual void dropIndexDetails(int idxNum, bool noteNs) {
@@ -0,0 +1,139 @@
+// collection_evictor.cpp
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/collection_evictor.h"
+
+#include <algorithm>
+
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/collection.h"
+#include "mongo/db/collection_map.h"
+#include "mongo/db/databaseholder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/net/listen.h"
+
+namespace mongo {
+
+    // 0 means no limit. Each open collection holds a dictionary per index, with its file
+    // handle and some memory, which adds up in databases with very many collections.
+    MONGO_EXPORT_SERVER_PARAMETER( maxOpenCollections, int, 0 );
+
+    /**
+     * Every second, if more than maxOpenCollections collections are open, closes the least
+     * recently used ones that haven't been used for a second, with CollectionMap::evict_ns().
+     * getCollection() transparently reopens them.
+     */
+    class CollectionEvictor : public BackgroundJob {
+    public:
+        virtual string name() const { return "CollectionEvictor"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+
+            while ( ! inShutdown() ) {
+                sleepsecs( 1 );
+
+                const int maxOpen = maxOpenCollections;
+                if ( maxOpen <= 0 ) {
+                    continue;
+                }
+                const long long excess = CollectionMap::numOpen() - maxOpen;
+                if ( excess <= 0 ) {
+                    continue;
+                }
+                try {
+                    evict( excess );
+                }
+                catch ( DBException& e ) {
+                    error() << "error closing idle collections: " << e << endl;
+                }
+            }
+        }
+
+    private:
+        void evict( const long long excess ) {
+            set<string> dbs;
+            {
+                LOCK_REASON(lockReason, "collection evictor: getting list of dbs");
+                Lock::DBRead lk("local", lockReason);
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            // Collections used in the current second may be in use right now.
+            const long long usedBefore = Listener::getElapsedTimeMillis() / 1000;
+            CollectionMap::IdleCollections idle;
+            for ( set<string>::const_iterator it = dbs.begin(); it != dbs.end(); ++it ) {
+                if ( *it == "local" ) {
+                    continue;
+                }
+                LOCK_REASON(lockReason, "collection evictor: finding idle collections");
+                Client::ReadContext ctx( *it, lockReason );
+                collectionMap( *it )->getIdleCollections( usedBefore, idle );
+            }
+            if ( idle.empty() ) {
+                return;
+            }
+
+            // The least recently used ones, grouped by database.
+            std::sort( idle.begin(), idle.end() );
+            if ( static_cast<long long>( idle.size() ) > excess ) {
+                idle.resize( excess );
+            }
+            map<string, CollectionMap::IdleCollections> byDb;
+            for ( CollectionMap::IdleCollections::const_iterator it = idle.begin(); it != idle.end(); ++it ) {
+                byDb[ nsToDatabase( it->second ) ].push_back( *it );
+            }
+
+            for ( map<string, CollectionMap::IdleCollections>::const_iterator it = byDb.begin(); it != byDb.end(); ++it ) {
+                evictFromDb( it->first, it->second );
+            }
+        }
+
+        void evictFromDb( const string& db, const CollectionMap::IdleCollections& idle ) {
+            LOCK_REASON(lockReason, "collection evictor: closing idle collections");
+            Client::WriteContext ctx( db, lockReason );
+            Client::Transaction txn( DB_SERIALIZABLE );
+
+            // A ClientCursor keeps using the collection's dictionaries between getMores.
+            set<string> withCursors;
+            for ( ClientCursor::LockedIterator i; i.ok(); i.advance() ) {
+                withCursors.insert( i.current()->ns() );
+            }
+
+            CollectionMap* cm = collectionMap( db );
+            int n = 0;
+            for ( CollectionMap::IdleCollections::const_iterator it = idle.begin(); it != idle.end(); ++it ) {
+                if ( withCursors.count( it->second ) == 0 && cm->evict_ns( it->second, it->first ) ) {
+                    n++;
+                }
+            }
+            txn.commit();
+            LOG(1) << "closed " << n << " idle collections in " << db << endl;
+        }
+    };
+
+    void startCollectionEvictorBackgroundJob() {
+        CollectionEvictor* evictor = new CollectionEvictor();
+        evictor->go();
+    }
+
+}
@@ -17,26 +17,49 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/cursor.h"
 #include "mongo/db/collection.h"
 #include "mongo/db/collection_map.h"
 #include "mongo/db/json.h"
 #include "mongo/db/relock.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/storage/dictionary.h"
 #include "mongo/db/storage/env.h"
 #include "mongo/db/storage/key.h"
+#include "mongo/util/net/listen.h"
 #include "mongo/util/stringutils.h"
 
 namespace mongo {
 
+    static Counter64 openCollections;
+    static ServerStatusMetricField<Counter64> displayOpenCollections("collections.open", &openCollections);
+    static Counter64 collectionOpens;
+    static ServerStatusMetricField<Counter64> displayCollectionOpens("collections.opened", &collectionOpens);
+    static Counter64 collectionEvictions;
+    static ServerStatusMetricField<Counter64> displayCollectionEvictions("collections.evicted", &collectionEvictions);
+    // Opens of collections evict_ns() closed, which is the cost of keeping fewer open.
+    static TimerStats collectionReopenStats;
+    static ServerStatusMetricField<TimerStats> displayCollectionReopens("collections.reopened", &collectionReopenStats);
+
+    static SimpleMutex pinnedNamespacesMutex("pinnedNamespaces");
+    static StringMap<int> pinnedNamespaces;
+
+    static long long currentSecond() {
+        return Listener::getElapsedTimeMillis() / 1000;
+    }
+
     CollectionMap::CollectionMap(const string &dir, const StringData& database) :
         _dir(dir),
         _metadname(database.toString() + ".ns"),
         _database(database.toString()),
-        _openRWLock("nsOpenRWLock") {
+        _openRWLock("nsOpenRWLock"),
+        _openSnapshot(new OpenCollectionMap()) {
     }
 
     CollectionMap::~CollectionMap() {
+        openCollections.increment(-static_cast<long long>(_collections.size()));
         for (CollectionStringMap::const_iterator it = _collections.begin(); it != _collections.end(); ++it) {
             shared_ptr<Collection> cl = it->second;
             try {
@@ -89,6 +112,14 @@ namespace mongo {
         }
     }
 
+    void CollectionMap::publish_open_ns(const StringData &ns) {
+        const OpenCollectionMap &current = _openSnapshot.current();
+        CollectionStringMap::const_iterator it = _collections.find(ns);
+        _openSnapshot.replace(new OpenCollectionMap(it != _collections.end()
+                                                    ? current.set(ns, it->second.get())
+                                                    : current.erase(ns)));
+    }
+
     void CollectionMap::rollbackCreate() {
         if (!allocated()) {
             return;
@@ -164,6 +195,11 @@ namespace mongo {
         // memory.
         BSONObj nsobj = BSON("ns" << ns);
 
+        if (!_evicted.empty()) {
+            SimpleRWLock::Exclusive lk(_openRWLock);
+            _evicted.erase(ns.toString());
+        }
+
         CollectionStringMap::const_iterator it = _collections.find(ns);
         if (it != _collections.end()) {
             // Might not be in the _collections map if the ns exists but is closed.
@@ -171,8 +207,13 @@ namespace mongo {
             CollectionMapRollback &rollback = cc().txn().collectionMapRollback();
             rollback.noteNs(ns);
             shared_ptr<Collection> cl = it->second;
-            const int r = _collections.erase(ns);
-            verify(r == 1);
+            {
+                SimpleRWLock::Exclusive lk(_openRWLock);
+                const int r = _collections.erase(ns);
+                verify(r == 1);
+                publish_open_ns(ns);
+            }
+            openCollections.increment(-1);
             cl->close();
         }
 
@@ -199,6 +240,7 @@ namespace mongo {
     // also, on input, the CollectionMap must be allocated
     Collection *CollectionMap::open_ns(const StringData& ns, const bool bulkLoad) {
         verify(allocated());
+        Timer t;
         BSONObj serialized;
         BSONObj nsobj = BSON("ns" << ns);
         storage::Key sKey(nsobj, NULL);
@@ -233,6 +275,12 @@ namespace mongo {
             SimpleRWLock::Exclusive lk(_openRWLock);
             verify(!_collections[ns]);
             _collections[ns] = details;
+            publish_open_ns(ns);
+            openCollections.increment();
+            collectionOpens.increment();
+            if (_evicted.erase(ns.toString()) > 0) {
+                collectionReopenStats.record(t);
+            }
             return details.get();
         } else if (r != DB_NOTFOUND) {
             storage::handle_ydb_error(r);
@@ -253,7 +301,12 @@ namespace mongo {
         if (it != _collections.end()) {
             // TODO: Handle the case where a client tries to close a load they didn't start.
             shared_ptr<Collection> cl = it->second;
-            _collections.erase(ns);
+            {
+                SimpleRWLock::Exclusive lk(_openRWLock);
+                _collections.erase(ns);
+                publish_open_ns(ns);
+            }
+            openCollections.increment(-1);
             cl->close(aborting);
             return true;
         }
@@ -272,8 +325,11 @@ namespace mongo {
         CollectionMapRollback &rollback = cc().txn().collectionMapRollback();
         rollback.noteNs(ns);
 
+        SimpleRWLock::Exclusive lk(_openRWLock);
         verify(!_collections[ns]);
         _collections[ns] = cl;
+        publish_open_ns(ns);
+        openCollections.increment();
     }
 
     void CollectionMap::update_ns(const StringData& ns, const BSONObj &serialized, bool overwrite) {
@@ -308,8 +364,7 @@ namespace mongo {
             return NULL;
         }
 
-        SimpleRWLock::Shared lk(_openRWLock);
-        return find_ns_locked(ns);
+        return find_open_ns(ns);
     }
 
     Collection *CollectionMap::getCollection(const StringData &ns) {
@@ -318,27 +373,88 @@ namespace mongo {
             return NULL;
         }
 
-        Collection *cl = NULL;
-        {
-            // Try to find the ns in a shared lock. If it's there, we're done.
-            SimpleRWLock::Shared lk(_openRWLock);
-            cl = find_ns_locked(ns);
-        }
+        // Try to find the ns among the open ones. If it's there, we're done.
+        Collection *cl = find_open_ns(ns);
 
         if (cl == NULL) {
             // The ns doesn't exist, or it's not opened.
             cl = open_ns(ns);
         }
 
-        // Possibly validate the connection if the collection
-        // is under-going bulk load.
-        if (cl != NULL && cl->bulkLoading()) {
-            BulkLoadedCollection *bulkCl = cl->as<BulkLoadedCollection>();
-            bulkCl->validateConnectionId(cc().getConnectionId());
+        if (cl != NULL) {
+            cl->noteUsed(currentSecond());
+
+            // Possibly validate the connection if the collection
+            // is under-going bulk load.
+            if (cl->bulkLoading()) {
+                BulkLoadedCollection *bulkCl = cl->as<BulkLoadedCollection>();
+                bulkCl->validateConnectionId(cc().getConnectionId());
+            }
         }
         return cl;
     }
 
+    // Whether closing cl while it's idle is invisible to whoever uses it next. Some
+    // collections keep state in memory that can't be rebuilt from what a new transaction
+    // sees on disk: the next pk of natural order collections, the size of capped
+    // collections, a loader or a hot index. The system collections are used all the time anyway.
+    static bool evictable(const StringData &ns, const Collection &cl) {
+        return !cl.isPKHidden() && !cl.isCapped() && !cl.isPartitioned() &&
+               !cl.bulkLoading() && !cl.indexBuildInProgress() &&
+               !NamespaceString::isSystem(ns);
+    }
+
+    void CollectionMap::getIdleCollections(long long usedBefore, IdleCollections &idle) {
+        Lock::assertAtLeastReadLocked(_database);
+        SimpleRWLock::Shared lk(_openRWLock);
+        for (CollectionStringMap::const_iterator it = _collections.begin(); it != _collections.end(); ++it) {
+            const Collection &cl = *it->second;
+            const long long lastUsed = cl.lastUsed();
+            if (lastUsed < usedBefore && evictable(it->first, cl)) {
+                idle.push_back(make_pair(lastUsed, it->first));
+            }
+        }
+    }
+
+    bool CollectionMap::evict_ns(const StringData &ns, long long lastUsed) {
+        Lock::assertWriteLocked(ns);
+        Collection *cl = find_ns(ns);
+        if (cl == NULL || cl->lastUsed() != lastUsed || !evictable(ns, *cl)) {
+            return false;
+        }
+        {
+            SimpleMutex::scoped_lock lk(pinnedNamespacesMutex);
+            if (pinnedNamespaces.find(ns) != pinnedNamespaces.end()) {
+                return false;
+            }
+        }
+        TOKULOG(1) << "Closing idle collection " << ns << endl;
+        const bool closed = close_ns(ns);
+        verify(closed);
+        SimpleRWLock::Exclusive lk(_openRWLock);
+        _evicted.insert(ns.toString());
+        collectionEvictions.increment();
+        return true;
+    }
+
+    long long CollectionMap::numOpen() {
+        return openCollections.get();
+    }
+
+    void CollectionMap::pin_ns(const StringData &ns) {
+        SimpleMutex::scoped_lock lk(pinnedNamespacesMutex);
+        pinnedNamespaces[ns]++;
+    }
+
+    void CollectionMap::unpin_ns(const StringData &ns) {
+        SimpleMutex::scoped_lock lk(pinnedNamespacesMutex);
+        int &pins = pinnedNamespaces[ns];
+        verify(pins > 0);
+        if (--pins == 0) {
+            pinnedNamespaces.erase(ns);
+        }
+    }
+
     void CollectionMap::drop() {
         Lock::assertWriteLocked(_database);
         init();
@@ -24,6 +24,8 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/storage/dictionary.h"
 #include "mongo/util/concurrency/simplerwlock.h"
+#include "mongo/util/concurrency/snapshot_ptr.h"
+#include "mongo/util/immutable_string_map.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
@@ -75,23 +77,51 @@ namespace mongo {
 
         void rollbackCreate();
 
+        // Idle collections, with the time they were last used (see Collection::lastUsed()).
+        typedef vector<pair<long long, string> > IdleCollections;
+
+        // Appends the open collections that haven't been used since usedBefore and that
+        // evict_ns() would close.
+        void getIdleCollections(long long usedBefore, IdleCollections &idle);
+
+        // Closes ns with close_ns(), if it hasn't been used since lastUsed and nothing depends
+        // on it staying open. The next getCollection() reopens it.
+        // requires: the database is write locked, and no ClientCursors are open on ns.
+        // @return true if the ns was closed.
+        bool evict_ns(const StringData &ns, long long lastUsed);
+
+        // The number of collections open in all databases.
+        static long long numOpen();
+
+        // A transaction that changed ns's entry keeps it from being evicted until the
+        // transaction completes, see CollectionMapRollback.
+        static void pin_ns(const StringData &ns);
+        static void unpin_ns(const StringData &ns);
+
         typedef StringMap<shared_ptr<Collection> > CollectionStringMap;
+        typedef ImmutableStringMap<Collection *> OpenCollectionMap;
 
     private:
         int _openMetadb(bool may_create);
         void _init(bool may_create);
 
         // @return Collection object if the ns is currently open, NULL otherwise.
-        // requires: openRWLock is locked, either shared or exclusively.
-        Collection *find_ns_locked(const StringData &ns) {
-            CollectionStringMap::const_iterator it = _collections.find(ns);
-            if (it != _collections.end()) {
-                verify(it->second.get() != NULL);
-                return it->second.get();
+        // Takes no locks, see _openSnapshot.
+        Collection *find_open_ns(const StringData &ns) const {
+            SnapshotPtr<OpenCollectionMap>::Reader snapshot(_openSnapshot);
+            Collection *const *cl = snapshot->find(ns);
+            if (cl != NULL) {
+                verify(*cl != NULL);
+                return *cl;
             }
             return NULL;
         }
 
+        // Publishes a new _openSnapshot with ns's entry in _collections, or without ns if it
+        // has none.  Only the path to ns in the snapshot is copied, so this is O(log n).
+        // requires: openRWLock is locked exclusively.
+        void publish_open_ns(const StringData &ns);
+
         // @return Collection object if the ns existed and is now open, NULL otherwise.
         // called with no locks held - synchronization is done internally.
         Collection *open_ns(const StringData &ns, const bool bulkLoad = false);
@@ -100,6 +130,8 @@ namespace mongo {
         friend void beginBulkLoad(const StringData &ns, const vector<BSONObj> &indexes, const BSONObj &options);
 
         CollectionStringMap _collections;
+        // Namespaces closed by evict_ns() and not opened since, so we can tell reopens apart.
+        set<string> _evicted;
         const string _dir;
         const string _metadname;
         const string _database;
@@ -108,12 +140,16 @@ namespace mongo {
         // - May not transition _metadb from non-null to null in a DBRead lock.
         shared_ptr<storage::Dictionary> _metadb;
 
-        // It isn't necessary to hold either of these locks in a a DBWrite lock.
-
-        // This lock protects access to the _collections variable
-        // With a DBRead lock and this shared lock, one can retrieve
-        // a Collection that has already been opened
+        // This lock serializes changes to the _collections and _evicted variables. Each
+        // change to _collections is followed by publish_open_ns() before the lock is released.
+        // Collections are opened in a DBRead lock, so this is what keeps those opens apart.
         SimpleRWLock _openRWLock;
+
+        // An immutable copy of _collections, replaced every time it changes, for
+        // lookups of open collections, which happen for every operation.  Reading it
+        // doesn't write to any memory shared with other threads, unlike even a shared
+        // lock on _openRWLock. With a DBRead lock, the Collections it points to stay open.
+        SnapshotPtr<OpenCollectionMap> _openSnapshot;
     };
 
 } // namespace mongo
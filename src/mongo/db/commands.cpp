@@ -212,6 +212,39 @@ namespace mongo {
 
     extern DBConnectionPool pool;
 
+    namespace {
+        /** One of PoolForHost's policies, reported by connPoolStats. */
+        class PoolPolicyParameter : public ExportedServerParameter<int> {
+        public:
+            PoolPolicyParameter( const string& name , int* value , int min )
+                : ExportedServerParameter<int>( ServerParameterSet::getGlobal() , name , value ,
+                                                true , true ),
+                  _min( min ) {
+            }
+
+        protected:
+            virtual Status validate( const int& potentialNewValue ) {
+                if ( potentialNewValue < _min ) {
+                    return Status( ErrorCodes::BadValue ,
+                                   str::stream() << name() << " must be at least " << _min );
+                }
+                return Status::OK();
+            }
+
+        private:
+            const int _min;
+        };
+
+        PoolPolicyParameter connPoolMaxInUsePerHost( "connPoolMaxInUsePerHost" ,
+                                                     &PoolForHost::maxInUsePerHost , 0 );
+        PoolPolicyParameter connPoolMaxWaitMillis( "connPoolMaxWaitMillis" ,
+                                                   &PoolForHost::maxWaitMillis , 0 );
+        PoolPolicyParameter connPoolMinWarmPerHost( "connPoolMinWarmPerHost" ,
+                                                    &PoolForHost::minWarmPerHost , 0 );
+        PoolPolicyParameter connPoolIdleTimeoutSecs( "connPoolIdleTimeoutSecs" ,
+                                                     &PoolForHost::idleTimeoutSecs , 1 );
+    }
+
     class PoolFlushCmd : public InformationCommand {
     public:
         PoolFlushCmd() : InformationCommand( "connPoolSync" , false , "connpoolsync" ) {}
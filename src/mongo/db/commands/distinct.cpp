@@ -93,10 +93,22 @@ namespace mongo {
                     }
 
                     if ( idx.inKeyPattern( key ) ) {
-                        cursor = getBestGuessCursor( ns.c_str() ,
-                                                     BSONObj() ,
-                                                     idx.keyPattern() );
-                        if( cursor.get() ) break;
+                        shared_ptr<Cursor> c = getBestGuessCursor( ns.c_str() ,
+                                                                   BSONObj() ,
+                                                                   idx.keyPattern() );
+                        if ( !c.get() ) {
+                            continue;
+                        }
+                        // With the key leading an index, each value only needs one of its keys
+                        // read, the cursor seeks straight to the next value.
+                        if ( key == c->indexKeyPattern().firstElementFieldName() &&
+                             c->setSkipScan( 1 ) ) {
+                            cursor = c;
+                            break;
+                        }
+                        if ( !cursor.get() ) {
+                            cursor = c;
+                        }
                     }
 
                 }
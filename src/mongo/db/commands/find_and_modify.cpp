@@ -239,7 +239,8 @@ namespace mongo {
                     }
 
                     BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
-                    le.appendBool( "updatedExisting" , res.existing );
+                    if ( res.existingKnown )
+                        le.appendBool( "updatedExisting" , res.existing );
                     le.appendNumber( "n" , res.num );
                     if ( res.upserted.isSet() )
                         le.append( "upserted" , res.upserted );
@@ -0,0 +1,189 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Commands for copying a whole node at the dictionary level, see tools/snapshotload.cpp.
+ *
+ * beginSnapshot starts a read-only mvcc multi-statement transaction on the connection and
+ * reports the range of replication positions it may correspond to.  Inside it, the client lists
+ * collections, options and indexes with ordinary queries, and streams each collection's
+ * rows with streamSnapshot.  commitTransaction ends the snapshot.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/collection.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/cursor.h"
+#include "mongo/db/gtid.h"
+#include "mongo/db/repl/rs.h"
+#include "mongo/db/snapshot_stream.h"
+#include "mongo/db/storage/key.h"
+
+namespace mongo {
+
+    class SnapshotCommand : public InformationCommand {
+    public:
+        SnapshotCommand(const char *name) : InformationCommand(name) {}
+        virtual bool requiresAuth() { return true; }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::backupStart);
+            out->push_back(Privilege(AuthorizationManager::SERVER_RESOURCE_NAME, actions));
+        }
+    };
+
+    class BeginSnapshotCmd : public SnapshotCommand {
+    public:
+        BeginSnapshotCmd() : SnapshotCommand("beginSnapshot") {}
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return OPLOCK; }
+        virtual void help( stringstream& help ) const {
+            help << "begin a read-only snapshot of the whole node for streamSnapshot\n"
+                "{ beginSnapshot: 1 }\n"
+                "Returns the replication position of the snapshot: every GTID before "
+                "minUnappliedGTID is in it and none after liveGTID is. GTIDs in between may "
+                "or may not be, so replaying from minUnappliedGTID must skip those the copy "
+                "already has. End it with commitTransaction.";
+        }
+
+        virtual bool run(const string& db,
+                         BSONObj& cmdObj,
+                         int,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            uassert(17343, "transaction already exists", !cc().hasTxn());
+
+            // Nothing blocks commits while the snapshot starts, so bracket it instead.  The
+            // mins, read before, were committed before, and are visible to, the snapshot.  The
+            // last GTID handed out, read after, bounds what it can see: anything later commits
+            // after it began.  Those in between may have committed on either side of it.
+            const bool replSet = theReplSet != NULL && theReplSet->gtidManager != NULL;
+            GTID liveGTID, minLiveGTID, minUnappliedGTID;
+            if (replSet) {
+                theReplSet->gtidManager->getMins(&minLiveGTID, &minUnappliedGTID);
+            }
+
+            cc().beginClientTxn(DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY);
+
+            if (replSet) {
+                liveGTID = theReplSet->gtidManager->getLiveState();
+            }
+
+            if (replSet) {
+                BSONObjBuilder position(result.subobjStart("position"));
+                addGTIDToBSON("liveGTID", liveGTID, position);
+                addGTIDToBSON("minLiveGTID", minLiveGTID, position);
+                addGTIDToBSON("minUnappliedGTID", minUnappliedGTID, position);
+                position.done();
+            }
+            result.append("status", "snapshot began");
+            return true;
+        }
+    } beginSnapshotCmd;
+
+    /** Frames of a collection's rows, in primary key order, see snapshot_stream.h. */
+    class SnapshotRowsCursor : public Cursor {
+    public:
+        SnapshotRowsCursor(Collection *cl) : _rows(Cursor::make(cl)), _nscanned(0) {
+            nextFrame();
+        }
+        virtual bool ok() { return !_frame.isEmpty(); }
+        virtual bool advance() { nextFrame(); return ok(); }
+        virtual BSONObj current() { return _frame; }
+        // The frames read the collection's dictionaries directly.
+        virtual bool shouldDestroyOnNSDeletion() { return true; }
+        virtual bool getsetdup(const BSONObj &pk) { return false; }
+        virtual bool isMultiKey() const { return false; }
+        virtual bool modifiedKeys() const { return false; }
+        virtual string toString() const { return "SnapshotRowsCursor"; }
+        virtual long long nscanned() const { return _nscanned; }
+        virtual void explainDetails(BSONObjBuilder &) const {}
+
+    private:
+        void nextFrame() {
+            SnapshotFrameBuilder b;
+            for (; _rows->ok(); _rows->advance()) {
+                const BSONObj obj = _rows->current();
+                const storage::Key key(_rows->currPK(), NULL);
+                // A big document gets a frame of its own, so frames stay under the max
+                // message size.
+                if (b.numRows() > 0 &&
+                    b.len() + key.size() + obj.objsize() > SnapshotFrameBuilder::TARGET_FRAME_SIZE) {
+                    break;
+                }
+                b.append(static_cast<const char *>(key.buf()), key.size(),
+                         obj.objdata(), obj.objsize());
+                _nscanned++;
+            }
+            _frame = b.numRows() > 0 ? b.obj() : BSONObj();
+        }
+
+        shared_ptr<Cursor> _rows;
+        BSONObj _frame;
+        long long _nscanned;
+    };
+
+    class StreamSnapshotCmd : public SnapshotCommand {
+    public:
+        StreamSnapshotCmd() : SnapshotCommand("streamSnapshot") {}
+        virtual bool adminOnly() const { return false; }
+        virtual LockType locktype() const { return READ; }
+        // Runs in the client's snapshot transaction, so the cursor can outlive the command.
+        virtual bool needsTxn() const { return false; }
+        virtual OpSettings getOpSettings() const { return OpSettings().setBulkFetch(true); }
+        virtual void help( stringstream& help ) const {
+            help << "stream a collection's rows from the snapshot begun by beginSnapshot\n"
+                "{ streamSnapshot: <collection> }\n"
+                "Returns a cursor, iterate it with getMore.";
+        }
+
+        virtual bool run(const string& db,
+                         BSONObj& cmdObj,
+                         int,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            uassert(17344, "streamSnapshot must run inside beginSnapshot's transaction",
+                    cc().hasTxn());
+            const string ns = parseNs(db, cmdObj);
+            Collection *cl = getCollection(ns);
+            if (cl == NULL) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            shared_ptr<Cursor> cursor(new SnapshotRowsCursor(cl));
+            // Owned by the cursor manager, and killed when the snapshot ends.
+            ClientCursor *ccursor = new ClientCursor(QueryOption_NoCursorTimeout, cursor, ns,
+                                                     cmdObj.getOwned(), true);
+
+            BSONObjBuilder cursorObj(result.subobjStart("cursor"));
+            cursorObj.append("id", ccursor->cursorid());
+            cursorObj.append("ns", ns);
+            // The rows are big, let getMore fill the messages.
+            cursorObj.append("firstBatch", BSONArray());
+            cursorObj.done();
+            return true;
+        }
+    } streamSnapshotCmd;
+
+} // namespace mongo
@@ -222,6 +222,25 @@ namespace mongo {
         return ok();
     }
 
+    bool IndexCountCursor::estimateCount(long long *count) {
+        // Secondary keys have the pk appended, so a MinKey or MaxKey pk puts the search key
+        // before or after every key equal to the bound.
+        const bool isSecondary = !_cl->isPKIndex(_idx);
+        const bool startKeyInclusive = _bounds.get() == NULL || _bounds->startKeyInclusive();
+        const BSONObj &startPK = startKeyInclusive ? minKey : maxKey;
+        const BSONObj &endPK = _endKeyInclusive ? maxKey : minKey;
+        const storage::Key startSKey(_startKey, isSecondary ? &startPK : NULL);
+        const storage::Key endSKey(_endKey, isSecondary ? &endPK : NULL);
+
+        uint64_t less, equal, greater;
+        _idx.getKeyRange(startSKey, &less, &equal, &greater);
+        const uint64_t before = less + (startKeyInclusive ? 0 : equal);
+        _idx.getKeyRange(endSKey, &less, &equal, &greater);
+        const uint64_t through = less + (_endKeyInclusive ? equal : 0);
+        *count = through > before ? through - before : 0;
+        return true;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
     IndexScanCountCursor::IndexScanCountCursor( CollectionData *cl, const IndexDetails &idx ) :
@@ -232,6 +251,86 @@ namespace mongo {
         verify(forward());
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    shared_ptr<Cursor> IntersectionCursor::make(const shared_ptr<Cursor> &cursor,
+                                                const shared_ptr<Cursor> &filter) {
+        return shared_ptr<Cursor>(new IntersectionCursor(cursor, filter));
+    }
+
+    IntersectionCursor::IntersectionCursor(const shared_ptr<Cursor> &cursor,
+                                           const shared_ptr<Cursor> &filter) :
+        _cursor(cursor),
+        _filter(filter),
+        _filterName(filter->toString()),
+        _filterBounds(filter->prettyIndexBounds().getOwned()),
+        _filterNScanned(0),
+        _nFilterPKs(0),
+        _nskipped(0),
+        _filtering(true) {
+        // A small filter is done in the first batch, and filters from the first document on.
+        if (_cursor->ok()) {
+            buildFilter();
+        }
+        skipFiltered();
+    }
+
+    bool IntersectionCursor::advance() {
+        _cursor->advance();
+        // Once _cursor is exhausted there is nothing left for the rest of the filter to skip.
+        if (_filter && _cursor->ok()) {
+            buildFilter();
+        }
+        skipFiltered();
+        return ok();
+    }
+
+    void IntersectionCursor::buildFilter() {
+        killCurrentOp.checkForInterrupt();
+        for (int i = 0; i < FilterBatchKeys && _filter->ok(); ++i, _filter->advance()) {
+            if (_filterPKs.size() >= MaxFilterPKs) {
+                _filtering = false;
+                _filterPKs.clear();
+                break;
+            }
+            // Keys just outside the filter's bounds may sneak in, which only makes the filter
+            // let a few more documents through to the matcher.
+            if (_filterPKs.insert(_filter->currPK().getOwned()).second) {
+                _nFilterPKs++;
+            }
+        }
+        if (!_filtering || !_filter->ok()) {
+            _filterNScanned = _filter->nscanned();
+            _filter.reset();
+        }
+    }
+
+    void IntersectionCursor::skipFiltered() {
+        if (!_filtering || _filter) {
+            return;
+        }
+        while (_cursor->ok() && _filterPKs.count(_cursor->currPK()) == 0) {
+            _nskipped++;
+            _cursor->advance();
+        }
+    }
+
+    string IntersectionCursor::toString() const {
+        return _cursor->toString() + " intersect " + _filterName;
+    }
+
+    void IntersectionCursor::explainDetails( BSONObjBuilder& b ) const {
+        BSONObjBuilder intersect(b.subobjStart("intersect"));
+        intersect.append("cursor", _filterName);
+        intersect.append("indexBounds", _filterBounds);
+        intersect.appendNumber("nscanned", _filterNScanned);
+        intersect.appendNumber("nPKs", _nFilterPKs);
+        intersect.append("filtering", _filtering && !_filter);
+        intersect.appendNumber("nskipped", _nskipped);
+        intersect.done();
+        _cursor->explainDetails(b);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Partitioned Cursors (over the _id index)
     PartitionedCursor::PartitionedCursor(PartitionedCollection* pc, const int direction, const bool countCursor):
@@ -126,6 +126,22 @@ namespace mongo {
             return BSONObj();
         }
 
+        /**
+         * Asks the cursor to return only the first key of each distinct value of the first
+         * prefixFields fields of its index key, seeking straight past the rest.  Only valid
+         * when every key in the cursor's range matches, since skipped keys are never looked at.
+         * @return false if the cursor can't skip, in which case it iterates as before.
+         */
+        virtual bool setSkipScan(const int prefixFields) { return false; }
+
+        /**
+         * Estimates how many results the cursor returns from the dictionary's subtree
+         * statistics, without reading them.  The estimate is approximate: the statistics also
+         * count keys that aren't visible to this transaction.
+         * @return false if the cursor can't estimate its count.
+         */
+        virtual bool estimateCount(long long *count) { return false; }
+
         virtual string toString() const { return "abstract?"; }
 
         /* used for multikey index traversal to avoid sending back dups. see Matcher::matches().
@@ -270,6 +286,8 @@ namespace mongo {
         bool tailable() const { return _tailable; }
         void setTailable();
 
+        bool setSkipScan(const int prefixFields);
+
         bool modifiedKeys() const { return _multiKey; }
         bool isMultiKey() const { return _multiKey; }
 
@@ -410,6 +428,9 @@ namespace mongo {
         bool _tailable;
         bool _ok;
 
+        // If positive, advance() skips to the next value of this many leading key fields.
+        int _skipScanPrefixFields;
+
         // The current key, pk, and obj for this cursor. Keys are stored
         // in a compacted format and built into bson format, so we reuse
         // a BufBuilder to prevent a malloc/free on each row read.
@@ -504,6 +525,8 @@ namespace mongo {
 
         bool advance();
 
+        bool estimateCount(long long *count);
+
     protected:
         IndexCountCursor( CollectionData *cl, const IndexDetails &idx,
                           const BSONObj &startKey, const BSONObj &endKey,
@@ -591,6 +614,82 @@ namespace mongo {
         friend class Cursor;
     };
 
+    /**
+     * Cursor over the documents that two index scans both find, for queries that constrain
+     * fields of two different indexes.  The 'filter' scan collects primary keys, FilterBatchKeys
+     * of them per advance(), while 'cursor' is iterated as is; once the filter scan is done the
+     * documents it didn't find are skipped before they are fetched.  The filter only ever removes
+     * documents that can't match the query, so if it finds more than MaxFilterPKs it is given up
+     * on and 'cursor' is iterated as is to the end.
+     *
+     * Plans race on nscanned, where each key of an index scan also stands for the document it
+     * fetches.  Keys alone are much cheaper to scan, so nscanned() counts the documents the
+     * filter lets through plus the keys of both scans divided by KeysPerDocument.  The plain
+     * counts are in explainDetails().
+     */
+    class IntersectionCursor : public Cursor {
+    public:
+        static const size_t MaxFilterPKs = 100000;
+        static const long long KeysPerDocument = 10;
+        static const int FilterBatchKeys = 100;
+
+        static shared_ptr<Cursor> make(const shared_ptr<Cursor> &cursor,
+                                       const shared_ptr<Cursor> &filter);
+
+        virtual bool ok() { return _cursor->ok(); }
+        virtual BSONObj current() { return _cursor->current(); }
+        virtual bool advance();
+        virtual BSONObj currKey() const { return _cursor->currKey(); }
+        virtual BSONObj currPK() const { return _cursor->currPK(); }
+        virtual BSONObj indexKeyPattern() const { return _cursor->indexKeyPattern(); }
+        virtual string toString() const;
+        virtual bool getsetdup(const BSONObj &pk) { return _cursor->getsetdup(pk); }
+        virtual bool isMultiKey() const { return _cursor->isMultiKey(); }
+        virtual bool modifiedKeys() const { return _cursor->modifiedKeys(); }
+        virtual BSONObj prettyIndexBounds() const { return _cursor->prettyIndexBounds(); }
+        virtual long long nscanned() const {
+            return _cursor->nscanned() - _nskipped + ( filterNScanned() + _nskipped ) / KeysPerDocument;
+        }
+        virtual CoveredIndexMatcher *matcher() const { return _cursor->matcher(); }
+        virtual bool currentMatches( MatchDetails *details = 0 ) {
+            return _cursor->currentMatches(details);
+        }
+        virtual void setMatcher( shared_ptr< CoveredIndexMatcher > matcher ) {
+            _cursor->setMatcher(matcher);
+        }
+        const Projection::KeyOnly *keyFieldsOnly() const { return _cursor->keyFieldsOnly(); }
+        void setKeyFieldsOnly( const shared_ptr<Projection::KeyOnly> &keyFieldsOnly ) {
+            _cursor->setKeyFieldsOnly(keyFieldsOnly);
+        }
+        virtual void explainDetails( BSONObjBuilder& b ) const;
+
+    private:
+        IntersectionCursor(const shared_ptr<Cursor> &cursor, const shared_ptr<Cursor> &filter);
+
+        /** Adds up to FilterBatchKeys primary keys of the filter scan, releasing it when done. */
+        void buildFilter();
+
+        /** Advances _cursor past the documents the filter didn't find, once it is built. */
+        void skipFiltered();
+
+        long long filterNScanned() const {
+            return _filter ? _filter->nscanned() : _filterNScanned;
+        }
+
+        shared_ptr<Cursor> _cursor;
+        // The filter scan, until its primary keys are all in _filterPKs.
+        shared_ptr<Cursor> _filter;
+        // For explain.
+        const string _filterName;
+        const BSONObj _filterBounds;
+        long long _filterNScanned;
+        long long _nFilterPKs;
+        long long _nskipped;
+        // False if the filter found too many primary keys.
+        bool _filtering;
+        set<BSONObj> _filterPKs;
+    };
+
     // class for cursor over Partitioned Collection
     // This cursor assumes to be running over 
     // the primary key, which is the _id index, and
@@ -27,6 +27,7 @@
 
 #include "mongo/base/initializer.h"
 #include "mongo/db/collection.h"
+#include "mongo/db/collection_evictor.h"
 #include "mongo/db/collection_map.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
@@ -667,6 +668,7 @@ namespace mongo {
         else {
             startTTLBackgroundJob();
         }
+        startCollectionEvictorBackgroundJob();
 
 #ifndef _WIN32
         CmdLine::launchOk();
@@ -1002,6 +1004,9 @@ static void processCommandLineOptions(const std::vector<std::string>& argv) {
         if (params.count("fastupdatesIgnoreErrors")) {
             cmdLine.fastupdatesIgnoreErrors = true;
         }
+        if (cmdLine.netCompression) {
+            DBClientConnection::setCompressMessages(true);
+        }
         if (params.count("checkpointPeriod")) {
             cmdLine.checkpointPeriod = params["checkpointPeriod"].as<uint32_t>();
         }
@@ -713,7 +713,12 @@ namespace mongo {
         virtual bool slaveOverrideOk() const { return true; }
         virtual bool maintenanceOk() const { return false; }
         virtual bool adminOnly() const { return false; }
-        virtual void help( stringstream& help ) const { help << "count objects in collection"; }
+        virtual void help( stringstream& help ) const {
+            help << "count objects in collection\n"
+                    "{ count : <collection>, query : <query>, estimate : true } estimates the count from\n"
+                    "the index's statistics, without reading it, when the index answers the query exactly,\n"
+                    "or from the primary key's statistics when the query is empty";
+        }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out) {
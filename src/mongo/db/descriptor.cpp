@@ -26,13 +26,14 @@ namespace mongo {
                            const bool hashed,
                            const int hashSeed,
                            const bool sparse,
-                           const bool clustering) :
+                           const bool clustering,
+                           const int hashVersion) :
         _data(NULL), _size(serializedSize(keyPattern)), _dataOwned(new char[_size]) {
         _data = _dataOwned.get();
 
         // Create a header and write it first.
         Header h(Ordering::make(keyPattern),
-                 hashed, sparse, clustering, hashSeed, keyPattern.nFields());
+                 hashed, hashVersion, sparse, clustering, hashSeed, keyPattern.nFields());
         memcpy(_dataOwned.get(), &h, sizeof(Header));
 
         // The offsets array is based after the header. It is an array of
@@ -90,10 +91,15 @@ namespace mongo {
     }
 
     void Descriptor::fieldNames(vector<const char *> &fields) const {
+        const Header &h(*reinterpret_cast<const Header *>(_data));
+        fields.resize(h.numFields);
+        fieldNames(&fields[0]);
+    }
+
+    void Descriptor::fieldNames(const char **fields) const {
         const Header &h(*reinterpret_cast<const Header *>(_data));
         const uint32_t *const offsetsBase = reinterpret_cast<const uint32_t *>(_data + sizeof(Header));
         const char *const fieldsBase = reinterpret_cast<const char *>(offsetsBase + h.numFields);
-        fields.resize(h.numFields);
         for (uint32_t i = 0; i < h.numFields; i++) {
             fields[i] = fieldsBase + offsetsBase[i];
         }
@@ -115,19 +121,30 @@ namespace mongo {
         return storage::dbt_make(_data, _size);
     }
 
-    void Descriptor::generateKeys(const BSONObj &obj, BSONObjSet &keys) const {
+    template <class Keys>
+    void Descriptor::_generateKeys(const BSONObj &obj, Keys &keys) const {
         const Header &h(*reinterpret_cast<const Header *>(_data));
-        vector<const char *> fields;
+        verify(h.numFields <= (uint32_t) KeyGenerator::MaxFields);
+        const char *fields[KeyGenerator::MaxFields];
         fieldNames(fields);
         if (h.hashed) {
-            // If we ever add new hash versions in the future, we'll need to add
-            // a hashVersion field to the descriptor and up the descriptor version.
-            const HashVersion hashVersion = 0;
+            const HashVersion hashVersion = h.hashVersion();
             HashKeyGenerator generator(fields[0], h.hashSeed, hashVersion, h.sparse);
             generator.getKeys(obj, keys);
         } else {
-            KeyGenerator::getKeys(obj, fields, h.sparse, keys);
+            KeyGenerator::getKeys(obj, fields, h.numFields, h.sparse, keys);
         }
     }
 
+    void Descriptor::generateKeys(const BSONObj &obj, BSONObjSet &keys) const {
+        _generateKeys(obj, keys);
+    }
+
+    void Descriptor::generateKeys(const BSONObj &obj, const BSONObj *pk,
+                                  storage::KeyArray &keys) const {
+        keys.reset(pk);
+        _generateKeys(obj, keys);
+        keys.sortAndUnique(ordering());
+    }
+
 } // namespace mongo
@@ -39,7 +39,8 @@ namespace mongo {
                    const bool hashed = false,
                    const int hashSeed = 0,
                    const bool sparse = false,
-                   const bool clustering = false);
+                   const bool clustering = false,
+                   const int hashVersion = 0);
         // For interpretting a memory buffer as a descriptor.
         Descriptor(const char *data, const size_t size);
 
@@ -57,6 +58,10 @@ namespace mongo {
 
         void generateKeys(const BSONObj &obj, BSONObjSet &keys) const;
 
+        // Generates the dictionary keys for obj, each followed by pk (if non-NULL), in
+        // index order without duplicates.  keys is reset() first.
+        void generateKeys(const BSONObj &obj, const BSONObj *pk, storage::KeyArray &keys) const;
+
         BSONObj fillKeyFieldNames(const BSONObj &key) const;
 
         bool clustering() const {
@@ -68,13 +73,18 @@ namespace mongo {
 
     private:
         void fieldNames(vector<const char *> &fields) const;
+        // Fills fields, which has room for the header's numFields.
+        void fieldNames(const char **fields) const;
+
+        template <class Keys>
+        void _generateKeys(const BSONObj &obj, Keys &keys) const;
 
 #pragma pack(1)
         // Descriptor format:
         //   [
         //     4 bytes: ordering,
         //     1 byte: version,
-        //     1 byte: hashed boolean,
+        //     1 byte: hashed boolean, or since version 2, hash version + 1 (0 if not hashed)
         //     1 byte: sparse boolean,
         //     1 byte: clustering boolean,
         //     4 bytes: hash seed integer,
@@ -88,16 +98,23 @@ namespace mongo {
                 // Version 0 is kind of a fake version.
                 VERSION_0 = 0,
                 VERSION_1 = 1,
-                NEXT_VERSION = 2
+                // Hashed indexes with a hash version other than 0.  Only those are written with
+                // this version, so that older servers refuse them but can still read the rest.
+                VERSION_2 = 2,
+                NEXT_VERSION = 3
             };
-            static const int CURRENT_VERSION = (int) NEXT_VERSION - 1;
 
         public:
-            Header(const Ordering &o, char h, char s, char c, int hs, uint32_t n)
-                : ordering(o), version((char) CURRENT_VERSION), hashed(h), sparse(s), clustering(c),
+            Header(const Ordering &o, char h, int hv, char s, char c, int hs, uint32_t n)
+                : ordering(o), version((char) (h && hv != 0 ? VERSION_2 : VERSION_1)),
+                  hashed(h ? hv + 1 : 0), sparse(s), clustering(c),
                   hashSeed(hs), numFields(n) {
             }
 
+            int hashVersion() const {
+                return version >= VERSION_2 ? hashed - 1 : 0;
+            }
+
             Ordering ordering;
             char version;
             char hashed;
@@ -103,11 +103,34 @@ namespace mongo {
 
         _lastTimestamp = lastTime;
         _lastHash = lastHash;
+
+        _nextTicket = 0;
+        _ticketBase = 0;
+        _syncedTicket = 0;
     }
 
     GTIDManager::~GTIDManager() {
     }
 
+    // true if every GTID handed out as a primary is done
+    // must be called with _lock held
+    bool GTIDManager::noLiveGTIDs() const {
+        return _minLiveTicket.load() == _nextTicket;
+    }
+
+    // Brings _minLiveGTID up to date with the GTIDs noteLiveGTIDDone
+    // has finished without the lock. Every method that takes _lock
+    // calls this first, so they never see a stale minimum.
+    void GTIDManager::syncMinLive() {
+        const uint64_t ticket = _minLiveTicket.load();
+        if (ticket != _syncedTicket) {
+            _syncedTicket = ticket;
+            _minLiveGTID = GTID(_lastLiveGTID._primarySeqNo, ticket - _ticketBase);
+            // note that on a primary, which we must be, these are equivalent
+            _minUnappliedGTID = _minLiveGTID;
+        }
+    }
+
     // This function is meant to only be called on a primary,
     // it assumes that we are fully up to date and are the ones
     // getting GTIDs for transactions that will be applying
@@ -120,7 +143,15 @@ namespace mongo {
         *timestamp = curTimeMillis64();
 
         boost::unique_lock<boost::mutex> lock(_lock);
+        // If the oldest live GTID's slot would be reused, wait for it.
+        while (_nextTicket - _minLiveTicket.load() >= LIVE_RING_SIZE) {
+            lock.unlock();
+            boost::this_thread::yield();
+            lock.lock();
+        }
+        syncMinLive();
         dassert(GTID::cmp(_lastLiveGTID, _lastUnappliedGTID) == 0);
+        const bool noLive = noLiveGTIDs();
         if (_incPrimary) {
             _incPrimary = false;
             _lastLiveGTID.inc_primary();
@@ -129,13 +160,17 @@ namespace mongo {
             _lastLiveGTID.inc();
         }
 
-        if (_liveGTIDs.size() == 0) {
+        if (noLive) {
             _minLiveGTID = _lastLiveGTID;
+            // The seq may have restarted or moved on since this last
+            // handed out GTIDs, line the tickets up with it again.
+            _ticketBase = _nextTicket - _lastLiveGTID._GTSeqNo;
         }
+        dassert(_ticketBase + _lastLiveGTID._GTSeqNo == _nextTicket);
+        _nextTicket++;
 
         _lastUnappliedGTID = _lastLiveGTID;
         *gtid = _lastLiveGTID;
-        _liveGTIDs.insert(*gtid);
         _lastTimestamp = *timestamp;
         *hash = (_lastHash* 131 + *timestamp) * 17 + _selfID;
         _lastHash = *hash;
@@ -148,25 +183,44 @@ namespace mongo {
     // THIS MUST BE DONE ON A PRIMARY
     //
     void GTIDManager::noteLiveGTIDDone(const GTID& gtid) {
-        boost::unique_lock<boost::mutex> lock(_lock);
-        dassert(GTID::cmp(gtid, _minLiveGTID) >= 0);
-        dassert(_liveGTIDs.size() > 0);
-        // remove from list of GTIDs
-        _liveGTIDs.erase(gtid);
-        // if what we are removing is currently the minumum live GTID
-        // we need to update the minimum live GTID
-        if (GTID::cmp(_minLiveGTID, gtid) == 0) {
-            if (_liveGTIDs.size() == 0) {
-                _minLiveGTID = _lastLiveGTID;
-                _minLiveGTID.inc();
+        // _ticketBase only moves when nothing is live, so not while gtid is
+        const uint64_t ticket = _ticketBase + gtid._GTSeqNo;
+        _liveRing[ticket % LIVE_RING_SIZE].store(ticket + 1);
+
+        // if what we are finishing is currently the minumum live GTID
+        // we need to move the minimum past it, and past anything after
+        // it that finished first
+        uint64_t minTicket = _minLiveTicket.load();
+        bool advanced = false;
+        while (_liveRing[minTicket % LIVE_RING_SIZE].load() == minTicket + 1) {
+            if (_minLiveTicket.compareAndSwap(minTicket, minTicket + 1) != minTicket) {
+                // another thread moved it, and will check the next slot
+                break;
             }
-            else {
-                // get the minumum from _liveGTIDs and set it to _minLiveGTIDs
-                _minLiveGTID = *(_liveGTIDs.begin());
+            minTicket++;
+            advanced = true;
+        }
+        if (!advanced) {
+            return;
+        }
+
+        {
+            // Keep _minLiveGTID current when it's cheap, but never wait for it.
+            boost::unique_lock<boost::mutex> lock(_lock, boost::try_to_lock);
+            if (lock.owns_lock()) {
+                syncMinLive();
             }
-            // note that on a primary, which we must be, these are equivalent
-            _minUnappliedGTID = _minLiveGTID;
-            // notify that _minLiveGTID has changed
+        }
+        // notify that _minLiveGTID has changed
+        notifyMinLiveChanged();
+    }
+
+    // must be called without _lock held
+    void GTIDManager::notifyMinLiveChanged() {
+        // A waiter counts itself before it checks the minimum, and this
+        // counts waiters after it changed, so one of them sees the other.
+        if (_minLiveWaiters.load() > 0) {
+            boost::unique_lock<boost::mutex> lock(_minLiveMutex);
             _minLiveCond.notify_all();
         }
     }
@@ -175,19 +229,21 @@ namespace mongo {
     // This function is called on a secondary when a GTID 
     // from the primary is added and committed to the opLog
     void GTIDManager::noteGTIDAdded(const GTID& gtid, uint64_t ts, uint64_t lastHash) {
-        boost::unique_lock<boost::mutex> lock(_lock);
-        // if we are adding a GTID on a secondary, then 
-        // these values must be equal
-        dassert(GTID::cmp(_lastLiveGTID, _minLiveGTID) < 0);
-        dassert(GTID::cmp(_lastLiveGTID, gtid) < 0);
-        _lastLiveGTID = gtid;
-        _minLiveGTID = _lastLiveGTID;
-        _minLiveGTID.inc();
-
-        _lastTimestamp = ts;
-        _lastHash = lastHash;
+        {
+            boost::unique_lock<boost::mutex> lock(_lock);
+            syncMinLive();
+            // if we are adding a GTID on a secondary, then 
+            // these values must be equal
+            dassert(GTID::cmp(_lastLiveGTID, _minLiveGTID) < 0);
+            dassert(GTID::cmp(_lastLiveGTID, gtid) < 0);
+            _lastLiveGTID = gtid;
+            _minLiveGTID = _lastLiveGTID;
+            _minLiveGTID.inc();
 
-        _minLiveCond.notify_all();
+            _lastTimestamp = ts;
+            _lastHash = lastHash;
+        }
+        notifyMinLiveChanged();
     }
 
     // called when a secondary takes an unapplied GTID it has read in the oplog
@@ -195,6 +251,7 @@ namespace mongo {
     void GTIDManager::noteApplyingGTID(const GTID& gtid) {
         try {
             boost::unique_lock<boost::mutex> lock(_lock);
+            syncMinLive();
             dassert(GTID::cmp(gtid, _minUnappliedGTID) >= 0);
             dassert(GTID::cmp(gtid, _lastUnappliedGTID) > 0);
             if (_unappliedGTIDs.size() == 0) {
@@ -217,6 +274,7 @@ namespace mongo {
     void GTIDManager::noteGTIDApplied(const GTID& gtid) {
         try {
             boost::unique_lock<boost::mutex> lock(_lock);
+            syncMinLive();
             dassert(GTID::cmp(gtid, _minUnappliedGTID) >= 0);
             dassert(_unappliedGTIDs.size() > 0);
             // remove from list of GTIDs
@@ -245,6 +303,7 @@ namespace mongo {
 
     void GTIDManager::getMins(GTID* minLiveGTID, GTID* minUnappliedGTID) {
         boost::unique_lock<boost::mutex> lock(_lock);
+        syncMinLive();
         *minLiveGTID = _minLiveGTID;
         *minUnappliedGTID = _minUnappliedGTID;
     }
@@ -258,7 +317,8 @@ namespace mongo {
 
     void GTIDManager::resetManager() {
         boost::unique_lock<boost::mutex> lock(_lock);
-        dassert(_liveGTIDs.size() == 0);
+        syncMinLive();
+        dassert(noLiveGTIDs());
         // tell the GTID Manager that the next GTID
         // we get for a primary, we increment the primary
         _incPrimary = true;
@@ -283,6 +343,7 @@ namespace mongo {
         ) 
     {
         boost::unique_lock<boost::mutex> lock(_lock);
+        syncMinLive();
         *lastLiveGTID = _lastLiveGTID;
         *lastUnappliedGTID = _lastUnappliedGTID;
         *minLiveGTID = _minLiveGTID;
@@ -298,6 +359,7 @@ namespace mongo {
     // is in a state where it can become primary
     void GTIDManager::verifyReadyToBecomePrimary() {
         boost::unique_lock<boost::mutex> lock(_lock);
+        syncMinLive();
         verify(GTID::cmp(_lastLiveGTID, _lastUnappliedGTID) == 0);
         verify(GTID::cmp(_minLiveGTID, _minUnappliedGTID) == 0);
         verify(GTID::cmp(_minLiveGTID, _lastLiveGTID) > 0);
@@ -310,12 +372,15 @@ namespace mongo {
     // allows tailable cursors to know when there is some new data
     // to be read
     void GTIDManager::waitForDifferentMinLive(GTID last, uint32_t millis) {
-        boost::unique_lock<boost::mutex> lock(_lock);
-        dassert(GTID::cmp(last, _minLiveGTID) <= 0);
-        if (GTID::cmp(last, _minLiveGTID) == 0) {
+        boost::unique_lock<boost::mutex> lock(_minLiveMutex);
+        _minLiveWaiters.fetchAndAdd(1);
+        const GTID minLive = getMinLiveGTID();
+        dassert(GTID::cmp(last, minLive) <= 0);
+        if (GTID::cmp(last, minLive) == 0) {
             // wait on cond
             _minLiveCond.timed_wait(lock, boost::posix_time::milliseconds(millis));
         }
+        _minLiveWaiters.fetchAndSubtract(1);
     }
 
     // after an intial sync has happened and the oplog has been updated
@@ -325,7 +390,8 @@ namespace mongo {
     // we can proceed with replication.
     void GTIDManager::resetAfterInitialSync(GTID last, uint64_t lastTime, uint64_t lastHash) {
         boost::unique_lock<boost::mutex> lock(_lock);
-        verify(_liveGTIDs.size() == 0);
+        syncMinLive();
+        verify(noLiveGTIDs());
         verify(_unappliedGTIDs.size() == 0);
         _lastLiveGTID = last;
         _minLiveGTID = _lastLiveGTID;
@@ -346,7 +412,8 @@ namespace mongo {
 
     void GTIDManager::catchUnappliedToLive() {
         boost::unique_lock<boost::mutex> lock(_lock);
-        verify(_liveGTIDs.size() == 0);
+        syncMinLive();
+        verify(noLiveGTIDs());
         verify(_unappliedGTIDs.size() == 0);
         _lastUnappliedGTID = _lastLiveGTID;
         _minUnappliedGTID = _minLiveGTID;
@@ -20,6 +20,8 @@
 //#include "mongo/db/jsobj.h"
 #include <limits>
 
+#include "mongo/platform/atomic_word.h"
+
 namespace mongo {
 
     class BSONObjBuilder;
@@ -42,6 +44,7 @@ namespace mongo {
         void inc_primary();        
         string toString() const;
         bool isInitial() const;
+        friend class GTIDManager;
         friend class GTIDManagerTest; // for testing
     };
 
@@ -58,8 +61,11 @@ namespace mongo {
     class GTIDManager {
         boost::mutex _lock;
 
-        // notified when the min live GTID changes
+        // notified when the min live GTID changes, waiters are counted
+        // so committers only take _minLiveMutex if someone is waiting
+        boost::mutex _minLiveMutex;
         boost::condition_variable _minLiveCond;
+        AtomicUInt32 _minLiveWaiters;
 
         // when a machine newly assumes primary, we want to
         // increment the primary sequence number of the GTIDs
@@ -79,7 +85,8 @@ namespace mongo {
         GTID _lastUnappliedGTID;
 
         // the minimum live GTID
-        // on a primary, this is the minimum value in _liveGTIDs
+        // on a primary, this is the minimum live GTID handed out, brought
+        // up to date with _minLiveTicket by syncMinLive()
         // on a secondary, this is simply _nextGTID,
         GTID _minLiveGTID;
 
@@ -91,12 +98,26 @@ namespace mongo {
         // that has yet to be applied to the collections on the secondary
         GTID _minUnappliedGTID;
 
-        // set of GTIDs that are live and not committed.
+        // GTIDs that are live and not committed.
         // on a primary, these GTIDs have been handed out
         // by the GTIDManager to be used in the oplog, and
         // the GTIDManager has yet to get notification that 
         // the associated transaction to this GTID has been committed
-        GTIDSet _liveGTIDs;
+        //
+        // Every GTID handed out gets the next ticket, its seq + _ticketBase.
+        // noteLiveGTIDDone stores ticket + 1 in the ticket's slot of
+        // _liveRing, and whoever finds the slot at _minLiveTicket done moves
+        // it forward with a compare and swap, so committing transactions
+        // don't take _lock to finish.  Tickets never repeat, so a slot can't
+        // be mistaken for done.  Everything before _minLiveTicket is done,
+        // and nothing is live when it reaches _nextTicket.
+        static const uint64_t LIVE_RING_SIZE = 4096;
+        AtomicUInt64 _liveRing[LIVE_RING_SIZE];
+        AtomicUInt64 _minLiveTicket;
+        uint64_t _nextTicket;
+        uint64_t _ticketBase;
+        // _minLiveTicket when _minLiveGTID was last brought up to date
+        uint64_t _syncedTicket;
 
         // set of GTIDs committed to the opLog, but not applied
         // to the collections. On a primary, this should be empty
@@ -156,6 +177,11 @@ namespace mongo {
 
         bool rollbackNeeded(const GTID& last, uint64_t lastTime, uint64_t lastHash);
 
+        private:
+        bool noLiveGTIDs() const;
+        void syncMinLive();
+        void notifyMinLiveChanged();
+
         friend class GTIDManagerTest; // for testing
         
     };
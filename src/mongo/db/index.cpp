@@ -41,10 +41,12 @@ namespace mongo {
      *
      * Optional arguments:
      *  "seed" : int (default = 0, a seed for the hash function)
-     *  "hashVersion : int (default = 0, determines which hash function to use)
+     *  "hashVersion : int (default = 0, determines which hash function to use:
+     *                   0 for MD5, 1 for MurmurHash3, which is several times faster.
+     *                   Hashed shard keys need version 0.)
      *
      * Example use in the mongo shell:
-     * > db.foo.ensureIndex({a : "hashed"}, {seed : 3, hashVersion : 0})
+     * > db.foo.ensureIndex({a : "hashed"}, {seed : 3, hashVersion : 1})
      *
      * LIMITATION: Only works with a single field. The HashedIndex
      * constructor uses uassert to ensure that the spec has the form
@@ -76,8 +78,9 @@ namespace mongo {
             uassert( 16242, "Currently hashed indexes cannot guarantee uniqueness. Use a regular index.",
                             !unique() );
 
-            // Create a descriptor with hashed = true and the appropriate hash seed.
-            _descriptor.reset(new Descriptor(_keyPattern, true, _seed, _sparse, _clustering));
+            // Create a descriptor with hashed = true and the appropriate hash seed and version.
+            _descriptor.reset(new Descriptor(_keyPattern, true, _seed, _sparse, _clustering,
+                                             _hashVersion));
 
         }
 
@@ -160,8 +163,7 @@ namespace mongo {
     private:
         const string _hashedField;
         const HashSeed _seed;
-        // In case we have hashed indexes based on other hash functions in
-        // the future, we store a hashVersion number.
+        // Which hash function, see HashVersions.
         const HashVersion _hashVersion;
         const BSONObj _hashedNullObj;
     };
@@ -330,6 +332,11 @@ namespace mongo {
         _descriptor->generateKeys(obj, keys);
     }
 
+    void IndexDetailsBase::getKeysFromObject(const BSONObj &obj, const BSONObj &pk,
+                                             storage::KeyArray &keys) const {
+        _descriptor->generateKeys(obj, &pk, keys);
+    }
+
     IndexDetails::Suitability IndexDetails::suitability(const FieldRangeSet &queryConstraints,
                                                         const BSONObj &order) const {
         // This is a quick first pass to determine the suitability of the index.  It produces some
@@ -476,6 +483,15 @@ namespace mongo {
         }
     }
 
+    void IndexDetailsBase::getKeyRange(const storage::Key &key, uint64_t *less, uint64_t *equal, uint64_t *greater) const {
+        DBT keyDBT = key.dbt();
+        int isExact;
+        int r = db()->key_range64(db(), cc().txn().db_txn(), &keyDBT, less, equal, greater, &isExact);
+        if (r != 0) {
+            storage::handle_ydb_error(r);
+        }
+    }
+
     int IndexDetailsBase::hot_optimize_callback(void *extra, float progress) {
         struct hot_optimize_callback_extra *info =
                 reinterpret_cast<hot_optimize_callback_extra *>(extra);
@@ -665,6 +681,17 @@ namespace mongo {
         *stats = ret;
     }
     
+    void PartitionedIndexDetails::getKeyRange(const storage::Key &key, uint64_t *less, uint64_t *equal, uint64_t *greater) const {
+        *less = *equal = *greater = 0;
+        for (uint64_t i = 0; i < _pc->numPartitions(); i++) {
+            uint64_t currLess, currEqual, currGreater;
+            _pc->getPartition(i)->idx(_idxNum).getKeyRange(key, &currLess, &currEqual, &currGreater);
+            *less += currLess;
+            *equal += currEqual;
+            *greater += currGreater;
+        }
+    }
+
     // find a way to remove this eventually and have callers get
     // access to IndexDetailsBase directly somehow
     // This is a workaround to get going for now
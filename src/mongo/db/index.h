@@ -233,6 +233,9 @@ namespace mongo {
         virtual uint32_t getPageSize() const = 0;
         virtual uint32_t getReadPageSize() const = 0;
         virtual void getStat64(DB_BTREE_STAT64* stats) const = 0;
+        // Estimates the number of keys less than, equal to, and greater than the given key
+        // from the dictionary's subtree statistics, without reading the keys.
+        virtual void getKeyRange(const storage::Key &key, uint64_t *less, uint64_t *equal, uint64_t *greater) const = 0;
 
         // find a way to remove this eventually and have callers get
         // access to IndexDetailsBase directly somehow
@@ -282,6 +285,9 @@ namespace mongo {
            keys will be left empty if key not found in the object.
         */
         void getKeysFromObject(const BSONObj &obj, BSONObjSet &keys) const;
+        // Same, but each key is encoded for the dictionary and followed by pk, without
+        // building a BSONObj per key. See storage::KeyArray.
+        void getKeysFromObject(const BSONObj &obj, const BSONObj &pk, storage::KeyArray &keys) const;
         // Send an update message.
         void updatePair(const BSONObj &key, const BSONObj *pk, const BSONObj &msg, uint64_t flags);
         
@@ -332,6 +338,7 @@ namespace mongo {
         uint32_t getPageSize() const;
         uint32_t getReadPageSize() const;
         void getStat64(DB_BTREE_STAT64* stats) const;
+        void getKeyRange(const storage::Key &key, uint64_t *less, uint64_t *equal, uint64_t *greater) const;
 
         template<class Callback>
         void getKeyAfterBytes(const storage::Key &startKey, uint64_t skipLen, Callback &cb) const;    
@@ -451,6 +458,7 @@ namespace mongo {
         virtual uint32_t getPageSize() const;
         virtual uint32_t getReadPageSize() const;
         virtual void getStat64(DB_BTREE_STAT64* stats) const;
+        virtual void getKeyRange(const storage::Key &key, uint64_t *less, uint64_t *equal, uint64_t *greater) const;
 
         // find a way to remove this eventually and have callers get
         // access to IndexDetailsBase directly somehow
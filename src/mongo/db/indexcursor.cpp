@@ -170,6 +170,7 @@ namespace mongo {
         _prelock(!cc().opSettings().getJustOne() && numWanted == 0),
         _tailable(false),
         _ok(false),
+        _skipScanPrefixFields(0),
         _getf_iteration(0)
     {
         verify( _cl != NULL );
@@ -198,6 +199,7 @@ namespace mongo {
         _prelock(!cc().opSettings().getJustOne() && numWanted == 0),
         _tailable(false),
         _ok(false),
+        _skipScanPrefixFields(0),
         _getf_iteration(0)
     {
         verify( _cl != NULL );
@@ -282,6 +284,17 @@ namespace mongo {
         _endKey = cl->minUnsafeKey();
     }
 
+    bool IndexCursor::setSkipScan(const int prefixFields) {
+        // A multikey index has several keys per document, and with a matcher the first key of a
+        // prefix might not match when a later one would.
+        if ( _multiKey || _matcher || _tailable ||
+             prefixFields <= 0 || prefixFields > _idx.keyPattern().nFields() ) {
+            return false;
+        }
+        _skipScanPrefixFields = prefixFields;
+        return true;
+    }
+
     void IndexCursor::setTailable() {
         // tailable cursors may not be created over secondary indexes,
         // and they must intend to read to the end of the collection.
@@ -761,7 +774,12 @@ again:      while ( !allInclusive && ok() ) {
 
     bool IndexCursor::advance() {
         killCurrentOp.checkForInterrupt();
-        if ( ok() ) {
+        if ( ok() && _skipScanPrefixFields > 0 ) {
+            // Seek past the rest of the current key prefix, and then check if we've went out of
+            // bounds.  The seek fetches a single row, so a big prefix isn't read at all.
+            _boundsMustMatch = true;
+            skipPrefix( _currKey, _skipScanPrefixFields );
+        } else if ( ok() ) {
             // Advance one row further, and then check if we've went out of bounds.
             _advance();
         } else {
@@ -839,6 +857,9 @@ again:      while ( !allInclusive && ok() ) {
         if ( _bounds.get() && _bounds->size() > 1 ) {
             s += " multi";
         }
+        if ( _skipScanPrefixFields > 0 ) {
+            s += " skip";
+        }
         return s;
     }
     
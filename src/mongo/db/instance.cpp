@@ -532,6 +532,9 @@ namespace mongo {
         UpdateResult res = updateObjects(ns, updateobj, query, upsert, multi);
         transaction.commit();
         lastError.getSafe()->recordUpdate( res.existing , res.num , res.upserted ); // for getlasterror
+        if ( !res.existingKnown ) {
+            lastError.getSafe()->updatedExisting = LastError::NotUpdate;
+        }
     }
 
     void receivedUpdate(Message& m, CurOp& op) {
@@ -463,7 +463,7 @@ namespace mongo {
     }
 
     bool BSONObj::valid() const {
-        return validateBSON( objdata(), objsize() ).isOK();
+        return validateBSONFast( objdata(), objsize() ).isOK();
     }
 
     int BSONObj::woCompare(const BSONObj& r, const Ordering &o, bool considerFieldName) const {
@@ -675,7 +675,7 @@ namespace mongo {
         BSONElement sub;
 
         if ( p ) {
-            sub = getField( string(name, p-name) );
+            sub = getField( StringData(name, p-name) );
             name = p + 1;
         }
         else {
@@ -49,6 +49,11 @@ namespace mongo {
             *reinterpret_cast< long long * >( value() ) = n;
         }
 
+        void setDate(unsigned long long millis) {
+            verify( _element.type() == mongo::Date );
+            *reinterpret_cast< unsigned long long * >( value() ) = millis;
+        }
+
         void setInt(int n) {
             verify( _element.type() == NumberInt );
             *reinterpret_cast< int * >( value() ) = n;
@@ -15,6 +15,11 @@
 
 #include "mongo/db/json.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define MONGO_JSON_SSE2 1
+#endif
+
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/util/base64.h"
@@ -62,6 +67,9 @@ namespace mongo {
     JParse::JParse(const char* str)
         : _buf(str), _input(str), _input_end(str + strlen(str)) {}
 
+    JParse::JParse(const char* str, const char* end)
+        : _buf(str), _input(str), _input_end(end) {}
+
     Status JParse::parseError(const StringData& msg) {
         std::ostringstream ossmsg;
         ossmsg << msg;
@@ -967,12 +975,539 @@ namespace mongo {
         return true;
     }
 
+    namespace {
+
+        inline int lowestBitIndex(unsigned bits) {
+#if defined(__GNUC__)
+            return __builtin_ctz(bits);
+#else
+            int i = 0;
+            while (!(bits & 1)) {
+                bits >>= 1;
+                ++i;
+            }
+            return i;
+#endif
+        }
+
+#if defined(MONGO_JSON_SSE2)
+        inline unsigned byteMask(__m128i block, char c) {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+        }
+#endif
+
+        /**
+         * Stage one of fromjsonFast.  Finds the structural characters ({}[]:,) that are
+         * outside of strings, and the unescaped double quotes that delimit strings, 16 bytes
+         * at a time.
+         *
+         * The input is indexed lazily, a few blocks at a time, so parsing one object out of a
+         * large buffer (mongoimport --jsonArray) only touches that object.  Loads are 16 byte
+         * aligned, so they never cross a page boundary and it is safe to read a block that
+         * contains the terminating null byte.
+         */
+        class JStructuralIndex {
+        public:
+            explicit JStructuralIndex(const char* str)
+                : _str(str),
+                  _block(reinterpret_cast<const char*>(
+                          reinterpret_cast<uintptr_t>(str) & ~static_cast<uintptr_t>(15))),
+                  _end(NULL),
+                  _inString(false),
+                  _escapeNext(false),
+                  _count(0),
+                  _pos(0) {
+            }
+
+            /** @return the next structural character, or NULL at the end of input */
+            const char* next() {
+                if (_pos == _count && !fill()) {
+                    return NULL;
+                }
+                return _positions[_pos++];
+            }
+
+        private:
+            enum { kBlocksPerFill = 16 };
+
+            bool fill() {
+                _count = 0;
+                _pos = 0;
+                while (_count == 0) {
+                    if (_end != NULL) {
+                        return false;
+                    }
+                    for (int i = 0; i < kBlocksPerFill && _end == NULL; ++i) {
+                        indexBlock();
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * Computes, for the 16 bytes at _block, bitmasks (bit i is byte i) of double
+             * quotes, backslashes, structural characters and null bytes.
+             */
+            void classify(unsigned* quotes, unsigned* backslashes, unsigned* structurals,
+                          unsigned* nuls) const {
+#if defined(MONGO_JSON_SSE2)
+                const __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(_block));
+                *quotes = byteMask(block, '"');
+                *backslashes = byteMask(block, '\\');
+                *nuls = byteMask(block, '\0');
+                *structurals = byteMask(block, '{') | byteMask(block, '}') |
+                               byteMask(block, '[') | byteMask(block, ']') |
+                               byteMask(block, ':') | byteMask(block, ',');
+#else
+                // Without the aligned loads, only bytes of the input may be read: start at _str
+                // in the first block and stop at the terminator.
+                *quotes = *backslashes = *structurals = *nuls = 0;
+                for (unsigned i = _block < _str ? _str - _block : 0; i < 16; ++i) {
+                    const unsigned bit = 1U << i;
+                    switch (_block[i]) {
+                    case '"':  *quotes |= bit; break;
+                    case '\\': *backslashes |= bit; break;
+                    case '\0': *nuls |= bit; return;
+                    case '{': case '}': case '[': case ']': case ':': case ',':
+                        *structurals |= bit;
+                        break;
+                    }
+                }
+#endif
+            }
+
+            void indexBlock() {
+                unsigned quotes, backslashes, structurals, nuls;
+                classify(&quotes, &backslashes, &structurals, &nuls);
+
+                unsigned valid = 0xFFFF;
+                if (_block < _str) {
+                    // first block, ignore what comes before the input
+                    valid &= 0xFFFF << (_str - _block);
+                }
+                nuls &= valid;
+                if (nuls) {
+                    // ignore everything from the terminator on
+                    const int terminator = lowestBitIndex(nuls);
+                    valid &= (1U << terminator) - 1;
+                    _end = _block + terminator;
+                }
+                quotes &= valid;
+                backslashes &= valid;
+                structurals &= valid;
+
+                // A character is escaped if it follows an odd-length run of backslashes.  Runs
+                // are rare, so don't try to be clever about it.
+                unsigned escaped = 0;
+                if (backslashes || _escapeNext) {
+                    for (unsigned i = 0; i < 16; ++i) {
+                        const unsigned bit = 1U << i;
+                        if (_escapeNext) {
+                            escaped |= bit;
+                            _escapeNext = false;
+                        }
+                        else if (backslashes & bit) {
+                            _escapeNext = true;
+                        }
+                    }
+                }
+                quotes &= ~escaped;
+
+                // Prefix xor of the quote bits gives the bytes from an opening quote up to (but
+                // not including) its closing quote.
+                unsigned inString = quotes;
+                inString ^= inString << 1;
+                inString ^= inString << 2;
+                inString ^= inString << 4;
+                inString ^= inString << 8;
+                if (_inString) {
+                    inString = ~inString;
+                }
+                inString &= 0xFFFF;
+                _inString = (inString & 0x8000) != 0;
+
+                for (unsigned bits = (structurals & ~inString) | quotes; bits; bits &= bits - 1) {
+                    _positions[_count++] = _block + lowestBitIndex(bits);
+                }
+                _block += 16;
+            }
+
+            const char* const _str;
+            const char* _block;
+            const char* _end;
+            bool _inString;
+            bool _escapeNext;
+            const char* _positions[kBlocksPerFill * 16];
+            size_t _count;
+            size_t _pos;
+        };
+
+        bool isReservedField(const StringData& field) {
+            return field.size() > 1 && field[0] == '$' &&
+                   (field == "$oid" || field == "$binary" || field == "$date" ||
+                    field == "$timestamp" || field == "$regex" || field == "$ref" ||
+                    field == "$undefined");
+        }
+
+        /**
+         * Stage two of fromjsonFast.  Walks the structural characters found by
+         * JStructuralIndex, checking that everything between them is either whitespace or a
+         * scalar value we parse here, and builds BSON directly.  Every method returns false
+         * as soon as it sees something JParse should deal with.
+         *
+         * This follows JParse's rules exactly (whitespace, escapes, number conversion, builder
+         * calls), see the corresponding JParse methods.
+         */
+        class JFastParse {
+        public:
+            explicit JFastParse(const char* str) : _index(str), _cursor(str) {}
+
+            bool object(BSONObjBuilder& builder, int* len) {
+                const char* start = _cursor;
+                const char* lbrace = nextToken();
+                if (lbrace == NULL || *lbrace != '{') {
+                    return false;
+                }
+                if (!objectBody(lbrace, "UNUSED", builder, false)) {
+                    return false;
+                }
+                if (len) {
+                    *len = _cursor - start;
+                }
+                return true;
+            }
+
+        private:
+            /**
+             * @return the next structural character, if only whitespace comes before it,
+             * otherwise NULL.
+             */
+            const char* nextToken() {
+                const char* token = _index.next();
+                if (token == NULL) {
+                    return NULL;
+                }
+                for (const char* p = _cursor; p < token; ++p) {
+                    if (!isspace(*p)) {
+                        return NULL;
+                    }
+                }
+                _cursor = token + 1;
+                return token;
+            }
+
+            const char* skipWhitespace() const {
+                const char* p = _cursor;
+                while (isspace(*p)) {
+                    ++p;
+                }
+                return p;
+            }
+
+            /** Called with the '{' consumed. */
+            bool objectBody(const char* lbrace, const StringData& fieldName,
+                            BSONObjBuilder& builder, bool subObject) {
+                const char* token = nextToken();
+                if (token == NULL) {
+                    return false;
+                }
+                if (*token == '}') {
+                    if (subObject) {
+                        BSONObjBuilder empty(builder.subobjStart(fieldName));
+                        empty.done();
+                    }
+                    return true;
+                }
+
+                std::string field;
+                if (!quotedString(token, &field)) {
+                    return false;
+                }
+                if (isReservedField(field)) {
+                    return subObject && specialObject(lbrace, fieldName, builder);
+                }
+
+                BSONObjBuilder* objBuilder = &builder;
+                scoped_ptr<BSONObjBuilder> subObjBuilder;
+                if (subObject) {
+                    subObjBuilder.reset(new BSONObjBuilder(builder.subobjStart(fieldName)));
+                    objBuilder = subObjBuilder.get();
+                }
+
+                while (true) {
+                    token = nextToken();
+                    if (token == NULL || *token != ':') {
+                        return false;
+                    }
+                    if (!value(field, *objBuilder)) {
+                        return false;
+                    }
+                    token = nextToken();
+                    if (token == NULL) {
+                        return false;
+                    }
+                    if (*token == '}') {
+                        return true;
+                    }
+                    if (*token != ',') {
+                        return false;
+                    }
+                    token = nextToken();
+                    if (token == NULL) {
+                        return false;
+                    }
+                    field.clear();
+                    if (!quotedString(token, &field)) {
+                        return false;
+                    }
+                }
+            }
+
+            /**
+             * Extended JSON objects are rare enough that we just find where they end and let
+             * JParse do the work.
+             */
+            bool specialObject(const char* lbrace, const StringData& fieldName,
+                               BSONObjBuilder& builder) {
+                int depth = 1;
+                const char* token;
+                while (depth > 0) {
+                    token = _index.next();
+                    if (token == NULL) {
+                        return false;
+                    }
+                    switch (*token) {
+                    case '{': case '[': ++depth; break;
+                    case '}': case ']': --depth; break;
+                    }
+                }
+                JParse jparse(lbrace, token + 1);
+                Status ret = jparse.object(fieldName, builder);
+                if (!ret.isOK() || lbrace + jparse.offset() != token + 1) {
+                    return false;
+                }
+                _cursor = token + 1;
+                return true;
+            }
+
+            bool array(const StringData& fieldName, BSONObjBuilder& builder) {
+                uint32_t index(0);
+                BSONObjBuilder subBuilder(builder.subarrayStart(fieldName));
+                const char* p = skipWhitespace();
+                if (*p == ']') {
+                    return nextToken() == p;
+                }
+                while (true) {
+                    if (!value(builder.numStr(index), subBuilder)) {
+                        return false;
+                    }
+                    index++;
+                    const char* token = nextToken();
+                    if (token == NULL) {
+                        return false;
+                    }
+                    if (*token == ']') {
+                        return true;
+                    }
+                    if (*token != ',') {
+                        return false;
+                    }
+                }
+            }
+
+            bool value(const StringData& fieldName, BSONObjBuilder& builder) {
+                const char* p = skipWhitespace();
+                switch (*p) {
+                case '"': {
+                    if (nextToken() != p) {
+                        return false;
+                    }
+                    const char* close = _index.next();
+                    if (close == NULL || *close != '"') {
+                        return false;
+                    }
+                    if (!hasSpecialChars(p + 1, close)) {
+                        // common case, no copy
+                        builder.append(fieldName, StringData(p + 1, close - p - 1));
+                        _cursor = close + 1;
+                        return true;
+                    }
+                    std::string valueString;
+                    if (!unescape(p + 1, close, &valueString)) {
+                        return false;
+                    }
+                    builder.append(fieldName, valueString);
+                    _cursor = close + 1;
+                    return true;
+                }
+                case '{':
+                    return nextToken() == p && objectBody(p, fieldName, builder, true);
+                case '[':
+                    return nextToken() == p && array(fieldName, builder);
+                case 't':
+                    if (strncmp(p, "true", 4) != 0) {
+                        return false;
+                    }
+                    builder.append(fieldName, true);
+                    _cursor = p + 4;
+                    return true;
+                case 'f':
+                    if (strncmp(p, "false", 5) != 0) {
+                        return false;
+                    }
+                    builder.append(fieldName, false);
+                    _cursor = p + 5;
+                    return true;
+                case 'n':
+                    if (strncmp(p, "null", 4) != 0) {
+                        return false;
+                    }
+                    builder.appendNull(fieldName);
+                    _cursor = p + 4;
+                    return true;
+                case '-': case '+': case '.':
+                case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9':
+                    return number(p, fieldName, builder);
+                default:
+                    return false;
+                }
+            }
+
+            /** Same conversions as JParse::number. */
+            bool number(const char* p, const StringData& fieldName, BSONObjBuilder& builder) {
+                char* endptrll;
+                char* endptrd;
+                errno = 0;
+                double retd = strtod(p, &endptrd);
+                if (p == endptrd || errno == ERANGE) {
+                    return false;
+                }
+                errno = 0;
+                long long retll = strtoll(p, &endptrll, 10);
+                if (endptrll < endptrd || errno == ERANGE) {
+                    builder.append(fieldName, retd);
+                }
+                else if (retll == static_cast<int>(retll)) {
+                    builder.append(fieldName, static_cast<int>(retll));
+                }
+                else {
+                    builder.append(fieldName, retll);
+                }
+                _cursor = endptrd;
+                return true;
+            }
+
+            /** @param open the opening quote, already consumed */
+            bool quotedString(const char* open, std::string* result) {
+                if (*open != '"') {
+                    return false;
+                }
+                const char* close = _index.next();
+                if (close == NULL || *close != '"') {
+                    return false;
+                }
+                _cursor = close + 1;
+                if (!hasSpecialChars(open + 1, close)) {
+                    result->assign(open + 1, close - open - 1);
+                    return true;
+                }
+                return unescape(open + 1, close, result);
+            }
+
+            /** @return true if [p, end) has a backslash or a control character */
+            static bool hasSpecialChars(const char* p, const char* end) {
+                for (; p < end; ++p) {
+                    if (*p == '\\' || (0x00 <= *p && *p <= 0x1F)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /** Same escapes as JParse::chars. */
+            static bool unescape(const char* q, const char* end, std::string* result) {
+                result->reserve(end - q);
+                while (q < end) {
+                    if (0x00 <= *q && *q <= 0x1F) {
+                        return false;
+                    }
+                    if (*q != '\\') {
+                        result->push_back(*q++);
+                        continue;
+                    }
+                    switch (*(++q)) {
+                    case '"':  result->push_back('"');  break;
+                    case '\'': result->push_back('\''); break;
+                    case '\\': result->push_back('\\'); break;
+                    case '/':  result->push_back('/');  break;
+                    case 'b':  result->push_back('\b'); break;
+                    case 'f':  result->push_back('\f'); break;
+                    case 'n':  result->push_back('\n'); break;
+                    case 'r':  result->push_back('\r'); break;
+                    case 't':  result->push_back('\t'); break;
+                    case 'v':  result->push_back('\v'); break;
+                    case 'u': {
+                        ++q;
+                        if (end - q < 4 || !isxdigit(q[0]) || !isxdigit(q[1]) ||
+                            !isxdigit(q[2]) || !isxdigit(q[3])) {
+                            return false;
+                        }
+                        appendUTF8(fromHex(q), fromHex(q + 2), result);
+                        q += 3;
+                        break;
+                    }
+                    case 'x':
+                    case '0': case '1': case '2': case '3':
+                    case '4': case '5': case '6': case '7':
+                        return false;
+                    default:   result->push_back(*q); break;
+                    }
+                    ++q;
+                }
+                return true;
+            }
+
+            /** Same encoding as JParse::encodeUTF8. */
+            static void appendUTF8(unsigned char first, unsigned char second,
+                                   std::string* result) {
+                if (first == 0 && second < 0x80) {
+                    result->push_back(second);
+                }
+                else if (first < 0x08) {
+                    result->push_back(char( 0xc0 | (first << 2 | second >> 6) ));
+                    result->push_back(char( 0x80 | (~0xc0 & second) ));
+                }
+                else {
+                    result->push_back(char( 0xe0 | (first >> 4) ));
+                    result->push_back(char( 0x80 | (~0xc0 & (first << 2 | second >> 6) ) ));
+                    result->push_back(char( 0x80 | (~0xc0 & second) ));
+                }
+            }
+
+            JStructuralIndex _index;
+            const char* _cursor;
+        };
+
+    } // namespace
+
+    bool fromjsonFast(const char* jsonString, BSONObjBuilder& builder, int* len) {
+        JFastParse parser(jsonString);
+        return parser.object(builder, len);
+    }
+
     BSONObj fromjson(const char* jsonString, int* len) {
         MONGO_JSON_DEBUG("jsonString: " << jsonString);
         if (jsonString[0] == '\0') {
             if (len) *len = 0;
             return BSONObj();
         }
+        {
+            BSONObjBuilder builder;
+            if (fromjsonFast(jsonString, builder, len)) {
+                return builder.obj();
+            }
+        }
         JParse jparse(jsonString);
         BSONObjBuilder builder;
         Status ret = jparse.object("UNUSED", builder, false);
@@ -41,6 +41,22 @@ namespace mongo {
     /** @param len will be size of JSON object in text chars. */
     BSONObj fromjson(const char* str, int* len=NULL);
 
+    /**
+     * Fast path for fromjson.  Parses in two stages: the first finds the structural characters
+     * ({}[]:, and string quotes) in 16 byte blocks, the second walks those positions and
+     * appends directly to builder, handing extended JSON objects ({$oid: ...}, {$date: ...},
+     * etc.) to JParse.
+     *
+     * Only strict, double-quoted JSON is handled here.  Anything else (unquoted or single
+     * quoted field names, constructors such as ObjectId(...), regex literals, NaN, parse
+     * errors, ...) makes this return false, with builder in an unspecified state, and the
+     * caller should parse the input again with JParse.  Whenever this returns true the result
+     * is identical to what JParse would have produced.
+     *
+     * @param len will be size of JSON object in text chars.
+     */
+    bool fromjsonFast(const char* str, BSONObjBuilder& builder, int* len=NULL);
+
     /**
      * Parser class.  A BSONObj is constructed incrementally by passing a
      * BSONObjBuilder to the recursive parsing methods.  The grammar for the
@@ -50,6 +66,12 @@ namespace mongo {
         public:
             explicit JParse(const char*);
 
+            /**
+             * Parse [str, end) only.  The input must still be readable up to a null
+             * terminator past end, see _input_end below.
+             */
+            JParse(const char* str, const char* end);
+
             /*
              * Notation: All-uppercase symbols denote non-terminals; all other
              * symbols are literals.
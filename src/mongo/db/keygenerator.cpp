@@ -34,11 +34,10 @@ namespace mongo {
     long long int HashKeyGenerator::makeSingleKey(const BSONElement &e,
                                                   const HashSeed &seed,
                                                   const HashVersion &v) {
-        massert( 16245, "Only HashVersion 0 has been defined", v == 0 );
-        return BSONElementHasher::hash64( e , seed );
+        return BSONElementHasher::hash64( e , seed , v );
     }
 
-    void HashKeyGenerator::getKeys(const BSONObj &obj, BSONObjSet &keys) {
+    bool HashKeyGenerator::getHash(const BSONObj &obj, long long int &hash) const {
         const char *hashedFieldPtr = _hashedField;
         const BSONElement &fieldVal = obj.getFieldDottedOrArray( hashedFieldPtr );
         uassert( storage::ASSERT_IDS::CannotHashArrays,
@@ -46,29 +45,82 @@ namespace mongo {
                  fieldVal.type() != Array );
 
         if (!fieldVal.eoo()) {
-            BSONObj key = BSON("" << makeSingleKey(fieldVal, _seed, _hashVersion));
-            keys.insert(key);
+            hash = makeSingleKey(fieldVal, _seed, _hashVersion);
+            return true;
         } else if (!_sparse) {
-            BSONObj key = BSON("" << makeSingleKey(nullElt, _seed, _hashVersion));
-            keys.insert(key);
+            hash = makeSingleKey(nullElt, _seed, _hashVersion);
+            return true;
         }
+        return false;
     }
 
+    void HashKeyGenerator::getKeys(const BSONObj &obj, BSONObjSet &keys) {
+        long long int hash;
+        if (getHash(obj, hash)) {
+            keys.insert(BSON("" << hash));
+        }
+    }
+
+    void HashKeyGenerator::getKeys(const BSONObj &obj, storage::KeyArray &keys) {
+        long long int hash;
+        if (getHash(obj, hash)) {
+            BufBuilder &scratch = keys.scratch();
+            scratch.reset();
+            BSONObjBuilder b(scratch);
+            b.append("", hash);
+            keys.append(b.done());
+        }
+    }
+
+    namespace {
+
+        void addKey(BSONObjSet &keys, const BSONElement *fixed, const int nFields) {
+            BSONObjBuilder b(128);
+            for (int i = 0; i < nFields; i++) {
+                b.appendAs(fixed[i], "");
+            }
+            keys.insert(b.obj());
+        }
+
+        void addKey(storage::KeyArray &keys, const BSONElement *fixed, const int nFields) {
+            BufBuilder &scratch = keys.scratch();
+            scratch.reset();
+            BSONObjBuilder b(scratch);
+            for (int i = 0; i < nFields; i++) {
+                b.appendAs(fixed[i], "");
+            }
+            keys.append(b.done());
+        }
+
+    } // namespace
+
     void KeyGenerator::getKeys(const BSONObj &obj, BSONObjSet &keys) const {
-        vector<const char *> fieldNames(_fieldNames);
-        getKeys(obj, fieldNames, _sparse, keys);
-    }     
+        getKeys(obj, _fieldNames.empty() ? NULL : &_fieldNames[0], _fieldNames.size(), _sparse, keys);
+    }
 
-    void KeyGenerator::getKeys(const BSONObj &obj, vector<const char *> &fieldNames,
+    void KeyGenerator::getKeys(const BSONObj &obj, const char *const *fieldNames, const int nFields,
                                const bool sparse, BSONObjSet &keys) {
-        vector<BSONElement> fixed( fieldNames.size() );
-        _getKeys( fieldNames , fixed , obj, sparse, keys );
-        if ( keys.empty() && ! sparse ) {
-            BSONObjBuilder nullKey(128);
-            for (size_t i = 0; i < fieldNames.size(); i++) {
-                nullKey.appendNull("");
+        _getKeysTop(obj, fieldNames, nFields, sparse, keys);
+    }
+
+    void KeyGenerator::getKeys(const BSONObj &obj, const char *const *fieldNames, const int nFields,
+                               const bool sparse, storage::KeyArray &keys) {
+        _getKeysTop(obj, fieldNames, nFields, sparse, keys);
+    }
+
+    template <class Keys>
+    void KeyGenerator::_getKeysTop(const BSONObj &obj, const char *const *fieldNames, const int nFields,
+                                   const bool sparse, Keys &keys) {
+        uassert( 17350, mongoutils::str::stream() << "too many fields in index key: " << nFields,
+                 nFields <= MaxFields );
+        const size_t nKeysBefore = keys.size();
+        BSONElement fixed[MaxFields];
+        _getKeys( fieldNames , fixed , nFields , obj, sparse, keys );
+        if ( keys.size() == nKeysBefore && ! sparse ) {
+            for (int i = 0; i < nFields; i++) {
+                fixed[i] = nullElt;
             }
-            keys.insert( nullKey.obj() );
+            addKey(keys, fixed, nFields);
         }
     }
         
@@ -76,7 +128,8 @@ namespace mongo {
      * @param arrayNestedArray - set if the returned element is an array nested directly within arr.
      */
     BSONElement KeyGenerator::extractNextElement( const BSONObj &obj, const BSONObj &arr, const char *&field, bool &arrayNestedArray ) {
-        string firstField = mongoutils::str::before( field, '.' );
+        const char *dot = strchr( field, '.' );
+        const StringData firstField( field, dot != NULL ? dot - field : strlen( field ) );
         bool haveObjField = !obj.getField( firstField ).eoo();
         BSONElement arrField = arr.getField( firstField );
         bool haveArrField = !arrField.eoo();
@@ -99,31 +152,41 @@ namespace mongo {
         return BSONElement();
     }
         
-    void KeyGenerator::_getKeysArrEltFixed( vector<const char*> &fieldNames , vector<BSONElement> &fixed , const BSONElement &arrEntry, const bool sparse, BSONObjSet &keys, int numNotFound, const BSONElement &arrObjElt, const set< unsigned > &arrIdxs, bool mayExpandArrayUnembedded ) {
+    template <class Keys>
+    void KeyGenerator::_getKeysArrEltFixed( const char *const *fieldNames , BSONElement *fixed , const int nFields , const BSONElement &arrEntry, const bool sparse, Keys &keys, int numNotFound, const BSONElement &arrObjElt, const unsigned arrIdxs, bool mayExpandArrayUnembedded ) {
         // set up any terminal array values
-        for( set<unsigned>::const_iterator j = arrIdxs.begin(); j != arrIdxs.end(); ++j ) {
-            if ( *fieldNames[ *j ] == '\0' ) {
-                fixed[ *j ] = mayExpandArrayUnembedded ? arrEntry : arrObjElt;
+        for( int j = 0; j < nFields; ++j ) {
+            if ( ( arrIdxs & ( 1U << j ) ) && *fieldNames[ j ] == '\0' ) {
+                fixed[ j ] = mayExpandArrayUnembedded ? arrEntry : arrObjElt;
             }
         }
         // recurse
-        _getKeys( fieldNames, fixed, ( arrEntry.type() == Object ) ? arrEntry.embeddedObject() : BSONObj(), sparse, keys, numNotFound, arrObjElt.embeddedObject() );        
+        _getKeys( fieldNames, fixed, nFields, ( arrEntry.type() == Object ) ? arrEntry.embeddedObject() : BSONObj(), sparse, keys, numNotFound, arrObjElt.embeddedObject() );
     }
         
         /**
          * @param fieldNames - fields to index, may be postfixes in recursive calls
          * @param fixed - values that have already been identified for their index fields
+         * @param nFields - the number of fieldNames and fixed values
          * @param obj - object from which keys should be extracted, based on names in fieldNames
-         * @param keys - set where index keys are written
+         * @param keys - where index keys are written
          * @param numNotFound - number of index fields that have already been identified as missing
          * @param array - array from which keys should be extracted, based on names in fieldNames
          *        If obj and array are both nonempty, obj will be one of the elements of array.
          */        
-    void KeyGenerator::_getKeys( vector<const char*> fieldNames , vector<BSONElement> fixed , const BSONObj &obj, const bool sparse, BSONObjSet &keys, int numNotFound, const BSONObj &array ) {
+    template <class Keys>
+    void KeyGenerator::_getKeys( const char *const *parentFieldNames , const BSONElement *parentFixed , const int nFields , const BSONObj &obj, const bool sparse, Keys &keys, int numNotFound, const BSONObj &array ) {
+        // Each level works on its own copy, which its callers still need as it was.
+        const char *fieldNames[ MaxFields ];
+        BSONElement fixed[ MaxFields ];
+        std::copy( parentFieldNames, parentFieldNames + nFields, fieldNames );
+        std::copy( parentFixed, parentFixed + nFields, fixed );
+
         BSONElement arrElt;
-        set<unsigned> arrIdxs;
+        // bit i is set if fieldNames[ i ] leads to arrElt
+        unsigned arrIdxs = 0;
         bool mayExpandArrayUnembedded = true;
-        for( unsigned i = 0; i < fieldNames.size(); ++i ) {
+        for( int i = 0; i < nFields; ++i ) {
             if ( *fieldNames[ i ] == '\0' ) {
                 continue;
             }
@@ -140,7 +203,7 @@ namespace mongo {
                 numNotFound++;
             }
             else if ( e.type() == Array ) {
-                arrIdxs.insert( i );
+                arrIdxs |= 1U << i;
                 if ( arrElt.eoo() ) {
                     // we only expand arrays on a single path -- track the path here
                     arrElt = e;
@@ -163,25 +226,21 @@ namespace mongo {
         
         if ( arrElt.eoo() ) {
             // No array, so generate a single key.
-            if ( sparse && numNotFound == (int) fieldNames.size() ) {
+            if ( sparse && numNotFound == nFields ) {
                 return;
             }            
-            BSONObjBuilder b(128);
-            for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i ) {
-                b.appendAs( *i, "" );
-            }
-            keys.insert( b.obj() );
+            addKey( keys, fixed, nFields );
         }
         else if ( arrElt.embeddedObject().firstElement().eoo() ) {
             // Empty array, so set matching fields to undefined.
-            _getKeysArrEltFixed( fieldNames, fixed, undefinedElt, sparse, keys, numNotFound, arrElt, arrIdxs, true );
+            _getKeysArrEltFixed( fieldNames, fixed, nFields, undefinedElt, sparse, keys, numNotFound, arrElt, arrIdxs, true );
         }
         else {
             // Non empty array that can be expanded, so generate a key for each member.
             BSONObj arrObj = arrElt.embeddedObject();
             BSONObjIterator i( arrObj );
             while( i.more() ) {
-                _getKeysArrEltFixed( fieldNames, fixed, i.next(), sparse, keys, numNotFound, arrElt, arrIdxs, mayExpandArrayUnembedded );
+                _getKeysArrEltFixed( fieldNames, fixed, nFields, i.next(), sparse, keys, numNotFound, arrElt, arrIdxs, mayExpandArrayUnembedded );
             }
         }
     }
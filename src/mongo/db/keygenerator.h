@@ -22,6 +22,7 @@
 #include "mongo/pch.h"
 #include "mongo/db/hasher.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/storage/key.h"
 
 namespace mongo {
 
@@ -38,7 +39,13 @@ namespace mongo {
 
         void getKeys(const BSONObj &obj, BSONObjSet &keys);
 
+        // Appends the key to keys, encoded, see storage::KeyArray.
+        void getKeys(const BSONObj &obj, storage::KeyArray &keys);
+
     private:
+        // @return false if obj has no key (sparse index, no hashed field)
+        bool getHash(const BSONObj &obj, long long int &hash) const;
+
         static long long int makeSingleKey(const BSONElement &e,
                                            const HashSeed &seed,
                                            const HashVersion &v = 0);
@@ -52,6 +59,10 @@ namespace mongo {
     };
 
     // Generates keys for a standard index.
+    //
+    // The recursion over arrays works on copies of the field names and values found so far,
+    // kept on the stack (an index has at most MaxFields fields), so generating keys only
+    // allocates for the keys themselves, and not at all into a storage::KeyArray.
     class KeyGenerator {
     public:
         KeyGenerator(const vector<const char *> &fieldNames,
@@ -62,34 +73,49 @@ namespace mongo {
 
         void getKeys(const BSONObj &obj, BSONObjSet &keys) const;
 
-        // One-time key generating function, because the implementation modifies fieldNames.
-        static void getKeys(const BSONObj &obj, vector<const char *> &fieldNames,
+        // One-time key generating functions, for the nFields fields named in fieldNames.
+        static void getKeys(const BSONObj &obj, const char *const *fieldNames, const int nFields,
                             const bool sparse, BSONObjSet &keys);
+
+        // Appends the keys to keys, encoded, in no particular order and possibly with
+        // duplicates, see storage::KeyArray::sortAndUnique().
+        static void getKeys(const BSONObj &obj, const char *const *fieldNames, const int nFields,
+                            const bool sparse, storage::KeyArray &keys);
+
+        // Same limit as Ordering's.
+        static const int MaxFields = 32;
+
     private:
+        template <class Keys>
+        static void _getKeysTop(const BSONObj &obj, const char *const *fieldNames, const int nFields,
+                                const bool sparse, Keys &keys);
 
         /**
          * @param arrayNestedArray - set if the returned element is an array nested directly within arr.
          */
         static BSONElement extractNextElement( const BSONObj &obj, const BSONObj &arr,
                                                const char *&field, bool &arrayNestedArray );
-        
-        static void _getKeysArrEltFixed( vector<const char*> &fieldNames , vector<BSONElement> &fixed ,
-                                         const BSONElement &arrEntry, const bool sparse, BSONObjSet &keys, int numNotFound,
-                                         const BSONElement &arrObjElt, const set< unsigned > &arrIdxs,
+
+        template <class Keys>
+        static void _getKeysArrEltFixed( const char *const *fieldNames , BSONElement *fixed , const int nFields ,
+                                         const BSONElement &arrEntry, const bool sparse, Keys &keys,
+                                         int numNotFound, const BSONElement &arrObjElt, const unsigned arrIdxs,
                                          bool mayExpandArrayUnembedded );
-        
+
         /**
          * @param fieldNames - fields to index, may be postfixes in recursive calls
          * @param fixed - values that have already been identified for their index fields
+         * @param nFields - the number of fieldNames and fixed values
          * @param obj - object from which keys should be extracted, based on names in fieldNames
-         * @param keys - set where index keys are written
+         * @param keys - where index keys are written
          * @param numNotFound - number of index fields that have already been identified as missing
          * @param array - array from which keys should be extracted, based on names in fieldNames
          *        If obj and array are both nonempty, obj will be one of the elements of array.
-         */        
-        static void _getKeys( vector<const char*> fieldNames , vector<BSONElement> fixed ,
-                              const BSONObj &obj, const bool sparse, BSONObjSet &keys, int numNotFound = 0,
-                              const BSONObj &array = BSONObj() );
+         */
+        template <class Keys>
+        static void _getKeys( const char *const *fieldNames , const BSONElement *fixed , const int nFields ,
+                              const BSONObj &obj, const bool sparse, Keys &keys,
+                              int numNotFound = 0, const BSONObj &array = BSONObj() );
 
         vector<const char *> _fieldNames;
         const bool _sparse;
@@ -70,21 +70,23 @@ namespace mongo {
         }
     }
 
-    static void _logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo) {
+    // entry was built by TxnOplog before the transaction got its GTID, with placeholders
+    // for _id, ts and h that are filled in here, so only the insert happens while the
+    // GTID is live.
+    static void _logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry) {
         LOCK_REASON(lockReason, "repl: logging to oplog");
         Client::ReadContext ctx(rsoplog, lockReason);
 
-        BSONObjBuilder b;
-        addGTIDToBSON("_id", gtid, b);
-        b.appendDate("ts", timestamp);
-        b.append("h", (long long)hash);
-        b.append("a", true);
-        b.append("ops", opInfo);
+        int len;
+        char *gtidData = const_cast<char *>(entry["_id"].binData(len));
+        dassert((uint32_t) len == GTID::GTIDBinarySize());
+        gtid.serializeBinaryData(gtidData);
+        BSONElementManipulator(entry["ts"]).setDate(timestamp);
+        BSONElementManipulator(entry["h"]).setLong((long long) hash);
 
-        BSONObj bb = b.done();
         // write it to oplog
-        LOG(3) << "writing " << bb.toString(false, true) << " to master " << endl;
-        writeEntryToOplog(bb, true);
+        LOG(3) << "writing " << entry.toString(false, true) << " to master " << endl;
+        writeEntryToOplog(entry, true);
     }
 
     // assumes it is locked on entry
@@ -107,8 +109,8 @@ namespace mongo {
         replInfoDetails->insertObject(bb2, flags);
     }
     
-    void logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo) {
-        _logTransactionOps(gtid, timestamp, hash, opInfo);
+    void logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry) {
+        _logTransactionOps(gtid, timestamp, hash, entry);
     }
 
     static void updateMaxRefGTID(BSONObj refMeta, uint64_t i, PartitionedCollection* pc, GTID gtid) {
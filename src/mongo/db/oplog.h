@@ -36,7 +36,7 @@ namespace mongo {
 
     void logOp( const char *opstr, const char *ns, const BSONObj& obj, BSONObj *patt = 0, bool fromMigrate = false );
     // Write operations to the log (local.oplog.$main)
-    void logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo);
+    void logTransactionOps(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry);
     void logTransactionOpsRef(GTID gtid, uint64_t timestamp, uint64_t hash, OID& oid);
     void logOpsToOplogRef(BSONObj o);
     void deleteOplogFiles();
@@ -36,6 +36,7 @@ static const char *KEY_STR_OLD_ROW = "o";
 static const char *KEY_STR_NEW_ROW = "o2";
 static const char *KEY_STR_MODS = "m";
 static const char *KEY_STR_PK = "pk";
+static const char *KEY_STR_QUERY = "q";
 static const char *KEY_STR_COMMENT = "o";
 static const char *KEY_STR_MIGRATE = "fromMigrate";
 
@@ -44,6 +45,7 @@ static const char OP_STR_INSERT[] = "i"; // normal insert
 static const char OP_STR_CAPPED_INSERT[] = "ci"; // insert into capped collection
 static const char OP_STR_UPDATE[] = "u"; // normal update with full pre-image and full post-image
 static const char OP_STR_UPDATE_ROW_WITH_MOD[] = "ur"; // update with full pre-image and mods to generate post-image
+static const char OP_STR_UPSERT_WITH_MOD[] = "up"; // upsert with query and mods, no pre-image (fastupdates)
 static const char OP_STR_DELETE[] = "d"; // delete with full pre-image
 static const char OP_STR_CAPPED_DELETE[] = "cd"; // delete from capped collection
 static const char OP_STR_COMMENT[] = "n"; // a no-op
@@ -61,7 +63,8 @@ namespace mongo {
 
         bool invalidOpForSharding(const char *opstr) {
             return mongoutils::str::equals(opstr, OP_STR_CAPPED_INSERT) ||
-                mongoutils::str::equals(opstr, OP_STR_CAPPED_DELETE);
+                mongoutils::str::equals(opstr, OP_STR_CAPPED_DELETE) ||
+                mongoutils::str::equals(opstr, OP_STR_UPSERT_WITH_MOD);
         }
 
         static inline void appendOpType(const char *opstr, BSONObjBuilder* b) {
@@ -187,6 +190,32 @@ namespace mongo {
             }
         }
 
+        void logUpsertMods(
+            const char *ns,
+            const BSONObj &pk,
+            const BSONObj &query,
+            const BSONObj &updateobj,
+            bool fromMigrate
+            )
+        {
+            // There's no pre-image to migrate or roll back with, so fastupdatesOk()
+            // keeps these away from sharded collections.
+            if (logTxnOpsForReplication()) {
+                BSONObjBuilder b;
+                if (isLocalNs(ns)) {
+                    return;
+                }
+
+                appendOpType(OP_STR_UPSERT_WITH_MOD, &b);
+                appendNsStr(ns, &b);
+                appendMigrate(fromMigrate, &b);
+                b.append(KEY_STR_PK, pk);
+                b.append(KEY_STR_QUERY, query);
+                b.append(KEY_STR_MODS, updateobj);
+                cc().txn().logOpForReplication(b.obj());
+            }
+        }
+
         void logDelete(const char *ns, const BSONObj &row, bool fromMigrate) {
             bool logForSharding = !fromMigrate && shouldLogTxnOpForSharding(OP_STR_DELETE, ns, row);
             if (logTxnOpsForReplication() || logForSharding) {
@@ -547,6 +576,49 @@ namespace mongo {
             }
         }
 
+        static void runUpsertModsWithLock(
+            const char *ns,
+            const BSONObj &pk,
+            const BSONObj &query,
+            const BSONObj &updateobj
+            )
+        {
+            Collection *cl = getCollection(ns);
+            const uint64_t flags = Collection::NO_UNIQUE_CHECKS | Collection::NO_LOCKTREE;
+            applyUpsertModsFromOplog(cl, pk, query, updateobj, flags);
+        }
+
+        static void runUpsertModsFromOplog(const char *ns, const BSONObj &op) {
+            const char *names[] = {
+                KEY_STR_PK,
+                KEY_STR_QUERY,
+                KEY_STR_MODS
+                };
+            BSONElement fields[3];
+            op.getFields(3, names, fields);
+            const BSONObj pk = fields[0].Obj();        // must exist
+            const BSONObj query = fields[1].Obj();     // must exist
+            const BSONObj updateobj = fields[2].Obj(); // must exist
+            verify(!updateobj.isEmpty());
+
+            try {
+                LOCK_REASON(lockReason, "repl: applying upsert");
+                Client::ReadContext ctx(ns, lockReason);
+                runUpsertModsWithLock(ns, pk, query, updateobj);
+            }
+            catch (RetryWithWriteLock &e) {
+                LOCK_REASON(lockReason, "repl: applying upsert with write lock");
+                Client::WriteContext ctx(ns, lockReason);
+                runUpsertModsWithLock(ns, pk, query, updateobj);
+            }
+        }
+
+        static void rollbackUpsertModsFromOplog(const char *ns, const BSONObj &op) {
+            // Only logged with the fastupdatesReplicatedUpserts parameter on, which accepts this.
+            log() << "Cannot rollback upsert without a pre-image " << op << rsLog;
+            throw RollbackOplogException(str::stream() << "Could not rollback fastupdates upsert on ns " << ns);
+        }
+
         static void runCommandFromOplog(const char *ns, const BSONObj &op) {
             BufBuilder bb;
             BSONObjBuilder ob;
@@ -586,6 +658,10 @@ namespace mongo {
                 opCounters->gotUpdate();
                 runUpdateModsWithRowFromOplog(ns, op, false);
             }
+            else if (strcmp(opType, OP_STR_UPSERT_WITH_MOD) == 0) {
+                opCounters->gotUpdate();
+                runUpsertModsFromOplog(ns, op);
+            }
             else if (strcmp(opType, OP_STR_DELETE) == 0) {
                 opCounters->gotDelete();
                 runDeleteFromOplog(ns, op);
@@ -640,6 +716,9 @@ namespace mongo {
             else if (strcmp(opType, OP_STR_UPDATE_ROW_WITH_MOD) == 0) {
                 runUpdateModsWithRowFromOplog(ns, op, true);
             }
+            else if (strcmp(opType, OP_STR_UPSERT_WITH_MOD) == 0) {
+                rollbackUpsertModsFromOplog(ns, op);
+            }
             else if (strcmp(opType, OP_STR_DELETE) == 0) {
                 // the rollback of a delete is to do the insert
                 runInsertFromOplog(ns, op);
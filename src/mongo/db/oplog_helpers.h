@@ -39,6 +39,8 @@ namespace mongo {
 
         void logUpdateModsWithRow(const char *ns, const BSONObj &pk, const BSONObj &oldObj, const BSONObj &updateobj, bool fromMigrate);
 
+        void logUpsertMods(const char *ns, const BSONObj &pk, const BSONObj &query, const BSONObj &updateobj, bool fromMigrate);
+
         void logDelete(const char *ns, const BSONObj &row, bool fromMigrate);
 
         void logDeleteForCapped(const char *ns, const BSONObj &pk, const BSONObj &row);
@@ -45,6 +45,7 @@ namespace mongo {
         }
         shared_ptr<DBClientConnection> conn_shared() { return _conn; }
         DBClientConnection* conn() { return _conn.get(); }
+        shared_ptr<DBClientCursor> cursor_shared() { return cursor; }
         BSONObj getLastOp(const char *ns) {
             return conn()->findOne(ns, Query().sort(reverseIDObj), 0, QueryOption_SlaveOk);
         }
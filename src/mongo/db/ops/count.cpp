@@ -21,8 +21,11 @@
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/collection.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/index.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/db/query_optimizer.h"
+#include "mongo/db/storage/key.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/util/elapsed_tracker.h"
 
@@ -51,6 +54,15 @@ namespace mongo {
 
     } _countPlanPolicies;
 
+    /** Estimates the number of documents in cl from its primary key's key statistics. */
+    static long long estimateCollectionCount( Collection *cl ) {
+        // Every key is greater than MinKey, so the three counts add up to the whole dictionary.
+        const storage::Key minSKey( minKey, NULL );
+        uint64_t less, equal, greater;
+        cl->getPKIndex().getKeyRange( minSKey, &less, &equal, &greater );
+        return less + equal + greater;
+    }
+
     long long runCount( const char *ns, const BSONObj &cmd, string &err, int &errCode ) {
         Collection *cl = getCollection( ns );
         if (cl == NULL) {
@@ -62,6 +74,9 @@ namespace mongo {
         long long count = 0;
         long long skip = cmd["skip"].numberLong();
         long long limit = cmd["limit"].numberLong();
+        // The caller may accept an estimate from the dictionary's statistics, which costs a
+        // couple of tree descents instead of reading every key in the range.
+        const bool estimate = cmd["estimate"].trueValue();
 
         if ( limit < 0 ) {
             limit  = -limit;
@@ -73,9 +88,29 @@ namespace mongo {
         cc().setOpSettings(settings);
 
         Lock::assertAtLeastReadLocked(ns);
+        OpDebug &debug = cc().curop()->debug();
+        debug.nscanned = 0;
         try {
-            for (shared_ptr<Cursor> cursor = getOptimizedCursor( ns, query, BSONObj(), _countPlanPolicies );
-                 cursor->ok() ; cursor->advance() ) {
+            bool estimated = false;
+            if ( estimate && query.isEmpty() ) {
+                // The optimizer would plan a table scan, but every document has exactly one
+                // key in the primary key dictionary, so count all of its keys.
+                count = estimateCollectionCount( cl );
+                estimated = true;
+            }
+            shared_ptr<Cursor> cursor;
+            if ( !estimated ) {
+                cursor = getOptimizedCursor( ns, query, BSONObj(), _countPlanPolicies );
+                estimated = estimate && cursor->estimateCount( &count );
+            }
+            if ( estimated ) {
+                count = max( count - skip, 0LL );
+                if ( limit > 0 && count > limit ) {
+                    count = limit;
+                }
+                return count;
+            }
+            for ( ; cursor->ok() ; cursor->advance(), ++debug.nscanned ) {
                 if ( cursor->currentMatches() && !cursor->getsetdup( cursor->currPK() ) ) {
                     if ( skip > 0 ) {
                         --skip;
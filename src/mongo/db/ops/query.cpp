@@ -436,7 +436,9 @@ namespace mongo {
     }
     
     void ReorderBuildStrategy::_handleMatchNoDedup( ResultDetails* resultDetails ) {
-        _scanAndOrder->add( current( false, resultDetails ) );
+        // With returnKey() there's no document to fetch again later.
+        _scanAndOrder->add( current( false, resultDetails ),
+                            _parsedQuery.returnKey() ? BSONObj() : _cursor->currPK() );
     }
 
     int ReorderBuildStrategy::rewriteMatches() {
@@ -460,10 +462,14 @@ namespace mongo {
             fieldRangeSet = _queryOptimizerCursor->initialFieldRangeSet();
         }
         verify( fieldRangeSet );
+        // Documents may only be refetched by primary key if this transaction's reads repeat;
+        // otherwise they could be updated or deleted between the scan and fill().
+        Collection *cl = cc().txn().repeatableReads() ? getCollection( _parsedQuery.ns() ) : NULL;
         return new ScanAndOrder( _parsedQuery.getSkip(),
                                 _parsedQuery.getNumToReturn(),
                                 _parsedQuery.getOrder(),
-                                *fieldRangeSet );
+                                *fieldRangeSet,
+                                cl );
     }
 
     HybridBuildStrategy* HybridBuildStrategy::make( const ParsedQuery& parsedQuery,
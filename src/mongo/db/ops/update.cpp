@@ -31,6 +31,7 @@
 #include "mongo/db/ops/update.h"
 #include "mongo/db/ops/update_internal.h"
 #include "mongo/db/oplog_helpers.h"
+#include "mongo/db/txn_context.h"
 
 namespace mongo {
 
@@ -78,15 +79,35 @@ namespace mongo {
     ExportedServerParameter<bool> _fastupdatesIgnoreErrorsParameter(
             ServerParameterSet::getGlobal(), "fastupdatesIgnoreErrors", &cmdLine.fastupdatesIgnoreErrors, true, true);
 
+    // An upsert sent down without reading the document has no pre-image, so once it's in the
+    // oplog a rollback over it fails and the node needs a full resync. Replicated nodes only
+    // do them when told to.
+    MONGO_EXPORT_SERVER_PARAMETER(fastupdatesReplicatedUpserts, bool, false);
+
     static Counter64 fastupdatesErrors;
     static ServerStatusMetricField<Counter64> fastupdatesIgnoredErrorsDisplay("fastupdates.errors", &fastupdatesErrors);
 
+    // Applying an update message _always_ ignores errors. That is the risk you take when
+    // using --fastupdates. We will print such errors to the server's error log no more than
+    // once per 5 seconds.
+    static void noteFastupdateError(const BSONObj &obj, const BSONObj &msg, const std::exception &ex) {
+        static Timer loggingTimer;
+        if (!cmdLine.fastupdatesIgnoreErrors && loggingTimer.millisReset() > 5000) {
+            problem() << "* Failed to apply \"--fastupdate\" updateobj message! "
+                         "This means an update operation that appeared successful actually failed." << endl;
+            problem() << "* It probably should not be happening in production. To ignore these errors, "
+                         "set the server parameter fastupdatesIgnoreErrors=true" << endl;
+            problem() << "*    doc: " << obj << endl;
+            problem() << "*    updateobj: " << msg << endl;
+            problem() << "*    exception: " << ex.what() << endl;
+        }
+        fastupdatesErrors.increment(1);
+    }
+
     // Apply an update message supplied by a collection to
     // some row in an in IndexDetails (for fast ydb updates).
     //
     class ApplyUpdateMessage : public storage::UpdateCallback {
-        // @param pkQuery - the pk with field names, for proper default obj construction
-        //                  in mods.createNewFromQuery().
         BSONObj applyMods(const BSONObj &oldObj, const BSONObj &msg) {
             try {
                 // The update message is simply an update object, supplied by the user.
@@ -96,30 +117,96 @@ namespace mongo {
                 checkTooLarge(newObj);
                 return newObj;
             } catch (const std::exception &ex) {
-                // Applying an update message in this fashion _always_ ignores errors.
-                // That is the risk you take when using --fastupdates.
-                //
-                // We will print such errors to the server's error log no more than once per 5 seconds.
-                if (!cmdLine.fastupdatesIgnoreErrors && _loggingTimer.millisReset() > 5000) {
-                    problem() << "* Failed to apply \"--fastupdate\" updateobj message! "
-                                 "This means an update operation that appeared successful actually failed." << endl;
-                    problem() << "* It probably should not be happening in production. To ignore these errors, "
-                                 "set the server parameter fastupdatesIgnoreErrors=true" << endl;
-                    problem() << "*    doc: " << oldObj << endl;
-                    problem() << "*    updateobj: " << msg << endl;
-                    problem() << "*    exception: " << ex.what() << endl;
-                }
-                fastupdatesErrors.increment(1);
+                noteFastupdateError(oldObj, msg, ex);
                 return oldObj;
             }
         }
-    private:
-        Timer _loggingTimer;
+
+        // @param query - the pk with field names, for proper default obj construction
+        //                in mods.createNewFromQuery().
+        BSONObj applyModsToQuery(const BSONObj &query, const BSONObj &msg) {
+            try {
+                ModSet mods(msg);
+                const BSONObj newObj = mods.createNewFromQuery(query);
+                checkNoMods(newObj);
+                checkTooLarge(newObj);
+                return newObj;
+            } catch (const std::exception &ex) {
+                noteFastupdateError(query, msg, ex);
+                return BSONObj();
+            }
+        }
     } _storageUpdateCallback; // installed as the ydb update callback in db.cpp via set_update_callback
 
+    // With fastupdates, mods that touch no index are sent down as update messages instead of
+    // writing the new object. Errors applying them are only logged, by ApplyUpdateMessage above.
+    static bool fastupdatesOk(Collection *cl, const ModSet &mods) {
+        return cmdLine.fastupdates && cl->fastupdatesOk() && cl->updateObjectModsOk() &&
+               mods.isIndexed() <= 0 && !mods.hasDynamicArray() &&
+               !hasClusteringSecondaryKey(cl);
+    }
+
+    // An upsert by primary key can go further and not even read the document: the
+    // message applies the mods to the document if there is one and inserts the object
+    // described by the query otherwise. That object would need keys in any secondary
+    // index, so the primary key must be the only one, and the query must be nothing
+    // but the primary key, since there's no document to match the rest against.
+    static bool blindUpsertOk(Collection *cl, const BSONObj &pk, const BSONObj &query,
+                              const ModSet &mods) {
+        return !cl->isCapped() && cl->nIndexesBeingBuilt() == 1 &&
+               query.nFields() == pk.nFields() &&
+               cl->ns() != cc().bulkLoadNS() &&
+               fastupdatesOk(cl, mods);
+    }
+
+    void applyUpsertModsFromOplog(Collection *cl, const BSONObj &pk, const BSONObj &query,
+                                  const BSONObj &updateobj, uint64_t flags) {
+        ModSet mods(updateobj, cl->indexKeys());
+        if (blindUpsertOk(cl, pk, query, mods)) {
+            cl->upsertObjectMods(pk, query, updateobj, false, flags | Collection::KEYS_UNAFFECTED_HINT);
+            cl->notifyOfWriteOp();
+            return;
+        }
+
+        // Indexes or settings differ from the primary's, do what the message would have,
+        // including ignoring the mods if they can't be applied: the primary didn't read the
+        // document, so it couldn't check them.
+        BSONObj obj;
+        if (cl->findByPK(pk, obj)) {
+            BSONObj newObj;
+            try {
+                auto_ptr<ModSetState> mss = mods.prepare(obj, false);
+                newObj = mss->createNewFromMods();
+                checkTooLarge(newObj);
+            } catch (const DBException &ex) {
+                noteFastupdateError(obj, updateobj, ex);
+                return;
+            }
+            const bool modsAreIndexed = mods.isIndexed() > 0;
+            updateOneObject(cl, pk, obj, newObj, cl->updateObjectModsOk() ? updateobj : BSONObj(),
+                            false, flags | (modsAreIndexed ? 0 : Collection::KEYS_UNAFFECTED_HINT));
+        } else {
+            // The primary checked this object before logging the upsert.
+            BSONObj newObj = mods.createNewFromQuery(query);
+            checkNoMods(newObj);
+            insertOneObject(cl, newObj, flags);
+        }
+    }
+
     static void updateUsingMods(const char *ns, Collection *cl, const BSONObj &pk, const BSONObj &obj,
                                 const BSONObj &updateobj, shared_ptr<ModSet> mods, MatchDetails* details,
                                 const bool fromMigrate) {
+        if (fastupdatesOk(cl, *mods)) {
+            // The document is already read, so make sure the mods apply to it. An error
+            // the update callback ignored here would be logged, and fail every secondary.
+            auto_ptr<ModSetState> mss = mods->prepare(obj, false /* not an insertion */);
+            checkTooLarge(mss->createNewFromMods());
+            cl->updateObjectMods(pk, updateobj, fromMigrate, Collection::KEYS_UNAFFECTED_HINT);
+            cl->notifyOfWriteOp();
+            OplogHelpers::logUpdateModsWithRow(ns, pk, obj, updateobj, fromMigrate);
+            return;
+        }
+
         ModSet *useMods = mods.get();
         auto_ptr<ModSet> mymodset;
         bool hasDynamicArray = mods->hasDynamicArray();
@@ -190,6 +277,20 @@ namespace mongo {
             mods.reset(new ModSet(updateobj, cl->indexKeys()));
         }
 
+        if (upsert && isOperatorUpdate && blindUpsertOk(cl, pk, patternOrig, *mods) &&
+            (fastupdatesReplicatedUpserts || !logTxnOpsForReplication())) {
+            // The object inserted if there's no document must be valid, secondaries insert it
+            // without checking. The mods can only be checked against a document we don't read.
+            BSONObj newObj = mods->createNewFromQuery(patternOrig);
+            checkNoMods(newObj);
+            checkTooLarge(newObj);
+            cl->upsertObjectMods(pk, patternOrig, updateobj, fromMigrate, flags | Collection::KEYS_UNAFFECTED_HINT);
+            cl->notifyOfWriteOp();
+            OplogHelpers::logUpsertMods(ns, pk, patternOrig, updateobj, fromMigrate);
+            // Whether the document existed is only known once the message is applied.
+            return UpdateResult(false, true, 1, BSONObj(), false);
+        }
+
         BSONObj obj;
         ResultDetails queryResult;
         if (mods && mods->hasDynamicArray()) {
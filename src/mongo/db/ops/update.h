@@ -27,13 +27,15 @@ namespace mongo {
 
     struct UpdateResult {
         const bool existing; // if existing objects were modified
+        const bool existingKnown; // false if we don't know whether the object existed (fastupdates upsert)
         const bool mod;      // was this a $ mod
         const long long num; // how many objects touched
         OID upserted;        // if something was upserted, the new _id of the object
 
         UpdateResult(const bool e, const bool m,
-                     const unsigned long long n, const BSONObj &upsertedObj) :
-            existing(e), mod(m), num(n) {
+                     const unsigned long long n, const BSONObj &upsertedObj,
+                     const bool k = true) :
+            existing(e), existingKnown(k), mod(m), num(n) {
             upserted.clear();
             const BSONElement id = upsertedObj["_id"];
             if (!e && n == 1 && id.type() == jstOID) {
@@ -50,6 +52,10 @@ namespace mongo {
                          const bool fromMigrate,
                          uint64_t flags);
 
+    // Applies an upsert logged by OplogHelpers::logUpsertMods.
+    void applyUpsertModsFromOplog(Collection *cl, const BSONObj &pk, const BSONObj &query,
+                                  const BSONObj &updateobj, uint64_t flags);
+
     UpdateResult updateObjects(const char *ns,
                                const BSONObj &updateobj, const BSONObj &pattern,
                                const bool upsert, const bool multi,
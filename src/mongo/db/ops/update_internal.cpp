@@ -20,6 +20,7 @@
 #include "pch.h"
 
 #include <algorithm> // for max
+#include <boost/thread/tss.hpp>
 
 #include "mongo/db/field_ref.h"
 #include "mongo/db/jsobjmanipulator.h"
@@ -58,7 +59,7 @@ namespace mongo {
         return matcher->matches( toMatch.embeddedObject() );
     }
 
-    void Mod::appendIncremented( BSONBuilderBase& builder , const BSONElement& in, ModState& ms ) const {
+    void Mod::incremented( const BSONElement& in, ModState& ms ) const {
         BSONType a = in.type();
         BSONType b = elt.type();
 
@@ -82,7 +83,10 @@ namespace mongo {
                 ms.incint = elt.numberInt() + in.numberInt();
             }
         }
+    }
 
+    void Mod::appendIncremented( BSONBuilderBase& builder , const BSONElement& in, ModState& ms ) const {
+        incremented( in , ms );
         ms.appendIncValue( builder , false );
     }
 
@@ -780,7 +784,221 @@ namespace mongo {
         }
     }
 
+    bool ModSetState::canApplyInPlace() {
+        for ( ModStateHolder::iterator i = _mods.begin(); i != _mods.end(); ++i ) {
+            ModState& ms = *i->second;
+            if ( ms.dontApply ) {
+                continue;
+            }
+            const Mod& m = *ms.m;
+            if ( ms.old.eoo() ) {
+                return false;
+            }
+            switch ( m.op ) {
+            case Mod::INC:
+                if ( !ms.old.isNumber() ) {
+                    return false;
+                }
+                m.incremented( ms.old , ms );
+                if ( ms.incType != ms.old.type() ) {
+                    return false;
+                }
+                break;
+
+            case Mod::SET_ON_INSERT:
+            case Mod::SET:
+                // Objects and arrays of the same size still need _checkForAppending().
+                if ( m.elt.type() != ms.old.type() ||
+                     m.elt.valuesize() != ms.old.valuesize() ||
+                     m.elt.type() == Object || m.elt.type() == Array ) {
+                    return false;
+                }
+                break;
+
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    BSONObj ModSetState::applyModsInPlace() {
+        const BSONObj newObj = _obj.copy();
+        for ( ModStateHolder::const_iterator i = _mods.begin(); i != _mods.end(); ++i ) {
+            const ModState& ms = *i->second;
+            if ( ms.dontApply ) {
+                continue;
+            }
+            const BSONElement e( newObj.objdata() + ( ms.old.rawdata() - _obj.objdata() ) );
+            BSONElementManipulator manip( e );
+            if ( ms.op() == Mod::INC ) {
+                switch ( ms.incType ) {
+                case NumberDouble:
+                    manip.setNumber( ms.incdouble ); break;
+                case NumberLong:
+                    manip.setLong( ms.inclong ); break;
+                case NumberInt:
+                    manip.setInt( ms.incint ); break;
+                default:
+                    verify( 0 );
+                }
+            }
+            else {
+                manip.replaceTypeAndValue( ms.m->elt );
+            }
+        }
+        return newObj;
+    }
+
+    namespace {
+
+        /** A region of the old object and where the bytes that replace it are. */
+        struct Damage {
+            int offset;
+            int size;
+            int patchOffset;
+            int patchSize;
+
+            bool operator<( const Damage& other ) const {
+                return offset < other.offset;
+            }
+        };
+
+        /**
+         * Scratch space for applyModsWithDamages(), kept per thread so an update allocates
+         * nothing but the new object.
+         */
+        struct DamageBuffers {
+            BufBuilder patches;                 // the replacement elements and object sizes
+            vector<Damage> damages;
+            vector< pair<int, int> > growth;    // (offset of an object, how much it grows)
+
+            void reset() {
+                // don't hold on to the space for a huge $set forever
+                patches.reset( 64 * 1024 );
+                damages.clear();
+                growth.clear();
+            }
+        };
+
+        boost::thread_specific_ptr<DamageBuffers> damageBuffers;
+
+    }
+
+    bool ModSetState::applyModsWithDamages( BSONObj& newObj ) {
+        // First make sure every mod can be applied this way, before any apply() call.
+        for ( ModStateHolder::const_iterator i = _mods.begin(); i != _mods.end(); ++i ) {
+            const ModState& ms = *i->second;
+            if ( ms.dontApply ) {
+                continue;
+            }
+            const Mod& m = *ms.m;
+            if ( ms.old.eoo() || m.op == Mod::RENAME_FROM || m.op == Mod::RENAME_TO ||
+                 !str::equals( ms.old.fieldName(), m.shortFieldName ) ) {
+                return false;
+            }
+        }
+
+        if ( damageBuffers.get() == NULL ) {
+            damageBuffers.reset( new DamageBuffers() );
+        }
+        DamageBuffers& buffers = *damageBuffers;
+        buffers.reset();
+
+        const char* const data = _obj.objdata();
+        for ( ModStateHolder::iterator i = _mods.begin(); i != _mods.end(); ++i ) {
+            ModState& ms = *i->second;
+            if ( ms.dontApply ) {
+                continue;
+            }
+
+            // Find the objects holding the element, outermost first, to fix their sizes.
+            const size_t firstHolder = buffers.growth.size();
+            BSONObj holder = _obj;
+            bool inArray = false;
+            for ( const char* p = ms.fieldName(); ; ) {
+                buffers.growth.push_back( make_pair( (int) ( holder.objdata() - data ), 0 ) );
+                const char* dot = strchr( p, '.' );
+                if ( dot == NULL ) {
+                    break;
+                }
+                const BSONElement e = holder.getField( StringData( p, dot - p ) );
+                if ( e.type() != Object && e.type() != Array ) {
+                    return false;
+                }
+                inArray = e.type() == Array;
+                holder = e.embeddedObject();
+                p = dot + 1;
+            }
+            // Duplicate field names, or an $unset that would leave a null in an array.
+            if ( holder.getField( ms.m->shortFieldName ).rawdata() != ms.old.rawdata() ||
+                 ( ms.op() == Mod::UNSET && inArray ) ) {
+                return false;
+            }
+
+            const int start = buffers.patches.len();
+            {
+                BSONObjBuilder b( buffers.patches );
+                ms.apply( b, ms.old );
+                b.done();
+            }
+            Damage d;
+            d.offset = ms.old.rawdata() - data;
+            d.size = ms.old.size();
+            d.patchOffset = start + 4;
+            d.patchSize = buffers.patches.len() - start - 5;
+            buffers.damages.push_back( d );
+            for ( size_t h = firstHolder; h < buffers.growth.size(); ++h ) {
+                buffers.growth[h].second = d.patchSize - d.size;
+            }
+        }
+
+        // Objects holding more than one modified element grow by the sum.
+        std::sort( buffers.growth.begin(), buffers.growth.end() );
+        int newSize = _obj.objsize();
+        for ( size_t h = 0; h < buffers.growth.size(); ) {
+            const int offset = buffers.growth[h].first;
+            int growth = 0;
+            for ( ; h < buffers.growth.size() && buffers.growth[h].first == offset; ++h ) {
+                growth += buffers.growth[h].second;
+            }
+            if ( offset == 0 ) {
+                // the builder below writes the top level's size
+                newSize += growth;
+            }
+            else if ( growth != 0 ) {
+                Damage d;
+                d.offset = offset;
+                d.size = 4;
+                d.patchOffset = buffers.patches.len();
+                d.patchSize = 4;
+                buffers.patches.appendNum( *reinterpret_cast<const int*>( data + offset ) + growth );
+                buffers.damages.push_back( d );
+            }
+        }
+        std::sort( buffers.damages.begin(), buffers.damages.end() );
+
+        BSONObjBuilder b( newSize );
+        BufBuilder& bb = b.bb();
+        int pos = 4;
+        for ( vector<Damage>::const_iterator d = buffers.damages.begin(); d != buffers.damages.end(); ++d ) {
+            bb.appendBuf( data + pos, d->offset - pos );
+            bb.appendBuf( buffers.patches.buf() + d->patchOffset, d->patchSize );
+            pos = d->offset + d->size;
+        }
+        bb.appendBuf( data + pos, _obj.objsize() - 1 - pos );
+        newObj = b.obj();
+        return true;
+    }
+
     BSONObj ModSetState::createNewFromMods() {
+        if ( canApplyInPlace() ) {
+            return _newFromMods = applyModsInPlace();
+        }
+        BSONObj newObj;
+        if ( applyModsWithDamages( newObj ) ) {
+            return _newFromMods = newObj;
+        }
         BSONObjBuilder b( (int)(_obj.objsize() * 1.1) );
         createNewObjFromMods( "" , b , _obj );
         return _newFromMods = b.obj();
@@ -78,6 +78,9 @@ namespace mongo {
                 shortFieldName = fieldName;
         }
 
+        /** Computes in + elt into ms.incType and the matching ms.inc* field. */
+        void incremented( const BSONElement& in, ModState& ms ) const;
+
         void appendIncremented( BSONBuilderBase& bb , const BSONElement& in, ModState& ms ) const;
 
         bool operator<( const Mod& other ) const {
@@ -587,8 +590,32 @@ namespace mongo {
         /** @return true iff the elements aren't eoo(), are distinct, and share a field name. */
         static bool duplicateFieldName( const BSONElement& a, const BSONElement& b );
 
+        /**
+         * @return true if every mod that applies is a $inc or $set of an existing field that
+         * keeps its type and size, so the new object is _obj with those values overwritten.
+         * Computes the $inc results.
+         */
+        bool canApplyInPlace();
+
+        /** Copies _obj once and overwrites the modified values, at the offsets prepare() found. */
+        BSONObj applyModsInPlace();
+
+        /**
+         * When every mod that applies changes a field that already exists, builds the new
+         * object from _obj's bytes with only the modified elements, and the sizes of the
+         * objects holding them, replaced. Each modified element is built by the mod's
+         * apply(), as in the rebuild, but the rest of the object is copied as is.
+         * @return false, leaving newObj alone, if the object has to be rebuilt instead.
+         */
+        bool applyModsWithDamages( BSONObj& newObj );
+
     public:
 
+        /**
+         * Builds the updated object. Counter-style updates that canApplyInPlace() are done
+         * without rebuilding the object, and so are other updates of existing fields, with
+         * applyModsWithDamages(). Both keep the object's field order.
+         */
         BSONObj createNewFromMods();
 
         string toString() const;
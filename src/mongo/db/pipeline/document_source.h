@@ -599,6 +599,31 @@ namespace mongo {
         virtual intrusive_ptr<DocumentSource> getShardSource();
         virtual intrusive_ptr<DocumentSource> getRouterSource();
 
+        /**
+          Tell if this group only needs the first document of each group,
+          when grouping by the given field path and only using $first.
+
+          With its input sorted on that field, the input only needs the first
+          document with each value of the field.
+
+          @param fieldPath the field path, without the '$' prefix
+          @returns true if every other document of a group is ignored
+         */
+        bool onlyNeedsFirstOfEachGroup(const string& fieldPath) const;
+
+        /**
+          Tell if this group only needs the last document of each group,
+          when grouping by the given field path and only using $last.
+
+          With its input sorted on that field in reverse, the input only
+          needs the first document with each value of the field, which is
+          the last one in the original order.
+
+          @param fieldPath the field path, without the '$' prefix
+          @returns true if every other document of a group is ignored
+         */
+        bool onlyNeedsLastOfEachGroup(const string& fieldPath) const;
+
         static const char groupName[];
 
     protected:
@@ -643,6 +668,14 @@ namespace mongo {
 
         Document makeDocument(const GroupsType::iterator &rIter);
 
+        /*
+          Tell if this groups by the given field path and every accumulator
+          is made by the given factory.
+         */
+        bool onlyUses(const string& fieldPath,
+                      intrusive_ptr<Accumulator> (*pFactory)(
+                          const intrusive_ptr<ExpressionContext> &)) const;
+
         GroupsType::iterator groupsIterator;
     };
 
@@ -384,4 +384,29 @@ namespace mongo {
 
         return pMerger;
     }
+
+    bool DocumentSourceGroup::onlyNeedsFirstOfEachGroup(const string& fieldPath) const {
+        return onlyUses(fieldPath, AccumulatorFirst::create);
+    }
+
+    bool DocumentSourceGroup::onlyNeedsLastOfEachGroup(const string& fieldPath) const {
+        return onlyUses(fieldPath, AccumulatorLast::create);
+    }
+
+    bool DocumentSourceGroup::onlyUses(
+        const string& fieldPath,
+        intrusive_ptr<Accumulator> (*pFactory)(
+            const intrusive_ptr<ExpressionContext> &)) const {
+        ExpressionFieldPath* pIdField =
+            dynamic_cast<ExpressionFieldPath*>(pIdExpression.get());
+        if (!pIdField || pIdField->getFieldPath(false) != fieldPath)
+            return false;
+
+        for(size_t i = 0; i < vpAccumulatorFactory.size(); ++i) {
+            if (vpAccumulatorFactory[i] != pFactory)
+                return false;
+        }
+
+        return true;
+    }
 }
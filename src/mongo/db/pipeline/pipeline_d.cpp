@@ -199,6 +199,62 @@ namespace mongo {
             pCursor = pUnsortedCursor;
         }
 
+        /*
+          If the documents come out of an index sorted on the field a $group
+          groups by, and it only takes the $first of each group, the cursor
+          only needs to return the first document for each value of the field
+          and can skip the rest of them.  If it only takes the $last, the
+          same goes for the index read backwards.
+
+          $min and $max aren't done this way: they ignore null and missing
+          values, which the index puts at one end of each group, so the
+          document at that end isn't always the one they want.
+        */
+        if (initSort && pQueryObj->isEmpty() && !sources.empty()) {
+            DocumentSourceGroup* pGroup =
+                dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+            const string sortField(pSortObj->firstElementFieldName());
+            const BSONObj indexKeyPattern(pCursor->indexKeyPattern());
+            if (pGroup && sortField == indexKeyPattern.firstElementFieldName()) {
+                if (pGroup->onlyNeedsFirstOfEachGroup(sortField)) {
+                    pCursor->setSkipScan(1);
+                }
+                else if (pGroup->onlyNeedsLastOfEachGroup(sortField)) {
+                    BSONObjBuilder reverseBuilder;
+                    BSONObjIterator sortIterator(*pSortObj);
+                    while (sortIterator.more()) {
+                        BSONElement sortElement(sortIterator.next());
+                        reverseBuilder.append(sortElement.fieldName(),
+                                              -sortElement.numberInt());
+                    }
+                    shared_ptr<BSONObj> pReverseSortObj(
+                        new BSONObj(reverseBuilder.obj()));
+
+                    const BSONObj queryAndSort =
+                        BSON("$query" << *pQueryObj << "$orderby" << *pReverseSortObj);
+                    shared_ptr<ParsedQuery> pq (new ParsedQuery(
+                                fullName.c_str(), 0, 0, QueryOption_NoCursorTimeout,
+                                queryAndSort, projection));
+                    shared_ptr<Cursor> pReverseCursor(
+                        getOptimizedCursor(
+                            fullName.c_str(), *pQueryObj, *pReverseSortObj,
+                            QueryPlanSelectionPolicy::any(), pq));
+
+                    /*
+                      Without skipping, the reversed input would turn every $last
+                      into a $first, so only switch when it skips over the same
+                      index, where the two orders are exact opposites.
+                    */
+                    if (pReverseCursor.get() &&
+                        pReverseCursor->indexKeyPattern() == indexKeyPattern &&
+                        pReverseCursor->setSkipScan(1)) {
+                        pCursor = pReverseCursor;
+                        pSortObj = pReverseSortObj;
+                    }
+                }
+            }
+        }
+
         // Now add the Cursor to cursorWithContext.
         cursorWithContext->_cursor.reset
                 ( new ClientCursor( QueryOption_NoCursorTimeout, pCursor, fullName ) );
@@ -27,12 +27,16 @@
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/query_plan_selection_policy.h"
 #include "mongo/db/queryutil.h"
+#include "mongo/db/server_parameters.h"
 
 //#define DEBUGQO(x) cout << x << endl;
 #define DEBUGQO(x)
 
 namespace mongo {
 
+    // Off by default, existing deployments keep the plans they race now.
+    MONGO_EXPORT_SERVER_PARAMETER( queryIndexIntersection, bool, false );
+
     // returns an IndexDetails* for a hint, 0 if hint is $natural.
     // hint must not be eoo()
     IndexDetails* parseHint( const BSONElement& hint, Collection *cl ) {
@@ -410,6 +414,12 @@ namespace mongo {
             ++i ) {
             _qps.addCandidatePlan( *i );
         }        
+
+        // The intersection races the plans it is made of.
+        shared_ptr<QueryPlan> intersectionPlan = newIntersectionPlan( cl, plans );
+        if ( intersectionPlan ) {
+            _qps.addCandidatePlan( intersectionPlan );
+        }
         
         // Only add a table-scan plan if no helpful indexes were found.
         if (_qps.nPlans() == 0) {
@@ -511,6 +521,12 @@ namespace mongo {
         if ( str::equals( bestIndex.firstElementFieldName(), "$natural" ) ) {
             p = newPlan( cl, -1 );
         }
+        else if ( str::equals( bestIndex.firstElementFieldName(), "$intersect" ) ) {
+            p = newCachedIntersectionPlan( cl, bestIndex );
+            if ( !p ) {
+                return false;
+            }
+        }
         
         for (int i = 0; i < cl->nIndexes(); i++) {
             IndexDetails &ii = cl->idx(i);
@@ -556,6 +572,74 @@ namespace mongo {
         return ret;
     }
 
+    shared_ptr<QueryPlan> QueryPlanGenerator::newIntersectionPlan
+            ( Collection *cl, const vector<shared_ptr<QueryPlan> >& plans ) const {
+        if ( !queryIndexIntersection || plans.size() < 2 ) {
+            return shared_ptr<QueryPlan>();
+        }
+
+        // Scan an in order index if there is one, so the intersection needs no sort either.
+        shared_ptr<QueryPlan> driving = plans.front();
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = plans.begin(); i != plans.end();
+            ++i ) {
+            if ( !(*i)->scanAndOrderRequired() ) {
+                driving = *i;
+                break;
+            }
+        }
+
+        const BSONObj drivingKey = driving->indexKey();
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = plans.begin(); i != plans.end();
+            ++i ) {
+            if ( *i == driving ) {
+                continue;
+            }
+            // The filter must narrow down a field the scanned index doesn't already.
+            const char *field = (*i)->indexKey().firstElementFieldName();
+            if ( drivingKey.hasField( field ) ||
+                 _qps.frsp().frsForIndex( cl, (*i)->idxNo() ).range( field ).universal() ) {
+                continue;
+            }
+            shared_ptr<QueryPlan> ret = newPlan( cl, driving->idxNo() );
+            ret->intersectWith( *i );
+            return ret;
+        }
+        return shared_ptr<QueryPlan>();
+    }
+
+    shared_ptr<QueryPlan> QueryPlanGenerator::newCachedIntersectionPlan
+            ( Collection *cl, const BSONObj& planKey ) const {
+        if ( !queryIndexIntersection ) {
+            return shared_ptr<QueryPlan>();
+        }
+        const BSONObj keys = planKey.firstElement().embeddedObjectUserCheck();
+        const BSONObj drivingKey = keys[ "0" ].embeddedObjectUserCheck();
+        const BSONObj filterKey = keys[ "1" ].embeddedObjectUserCheck();
+        int drivingIdxNo = -1;
+        int filterIdxNo = -1;
+        for (int i = 0; i < cl->nIndexes(); i++) {
+            const BSONObj keyPattern = cl->idx(i).keyPattern();
+            if ( keyPattern.woCompare( drivingKey ) == 0 ) {
+                drivingIdxNo = i;
+            }
+            if ( keyPattern.woCompare( filterKey ) == 0 ) {
+                filterIdxNo = i;
+            }
+        }
+        if ( drivingIdxNo < 0 || filterIdxNo < 0 ) {
+            return shared_ptr<QueryPlan>();
+        }
+        shared_ptr<QueryPlan> filter = newPlan( cl, filterIdxNo );
+        shared_ptr<QueryPlan> ret = newPlan( cl, drivingIdxNo );
+        if ( filter->utility() != QueryPlan::Helpful || ret->utility() != QueryPlan::Helpful ||
+             !filter->special().empty() || !ret->special().empty() ) {
+            // Not a plan newIntersectionPlan() would make for this query.
+            return shared_ptr<QueryPlan>();
+        }
+        ret->intersectWith( filter );
+        return ret;
+    }
+
     bool QueryPlanGenerator::setUnindexedPlanIf( bool set, Collection *cl ) {
         if ( set ) {
             setSingleUnindexedPlan( cl );
@@ -676,7 +760,7 @@ namespace mongo {
     void QueryPlanSet::addCandidatePlan( const QueryPlanPtr& plan ) {
         // If _plans is nonempty, the new plan may be supplementing a recorded plan at the first
         // position of _plans.  It must not duplicate the first plan.
-        if ( nPlans() > 0 && plan->indexKey() == firstPlan()->indexKey() ) {
+        if ( nPlans() > 0 && plan->planKey() == firstPlan()->planKey() ) {
             return;
         }
         pushPlan( plan );
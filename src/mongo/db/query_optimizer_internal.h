@@ -34,6 +34,9 @@ namespace mongo {
     class QueryPlanSelectionPolicy;
     class OrRangeGenerator;
     class ParsedQuery;
+
+    // If set, queries on fields of two different indexes also race a plan intersecting them.
+    extern bool queryIndexIntersection;
     
     /**
      * Helper class for a QueryPlanRunner to cache and count matches.  One object of this type is
@@ -305,6 +308,20 @@ namespace mongo {
 
         bool addCachedPlan( Collection *cl );
 
+        /**
+         * @return a plan that scans one of 'plans' and skips the documents outside the index
+         * range of another, constraining a different field, or an empty pointer.
+         */
+        shared_ptr<QueryPlan> newIntersectionPlan( Collection *cl,
+                                                   const vector<shared_ptr<QueryPlan> >& plans ) const;
+
+        /**
+         * @return the plan recorded as { $intersect: [ <index key>, <index key> ] }, or an empty
+         * pointer if intersections are turned off or no longer helpful.
+         */
+        shared_ptr<QueryPlan> newCachedIntersectionPlan( Collection *cl,
+                                                         const BSONObj& planKey ) const;
+
         shared_ptr<QueryPlan> newPlan( Collection *cl,
                                        int idxNo,
                                        const BSONObj& min = BSONObj(),
@@ -280,10 +280,34 @@ doneCheckOrder:
                                 _direction >= 0 ? 1 : -1);
         }
 
+        if (_intersectPlan) {
+            // A limit per interval would count the documents the filter skips, so neither scan
+            // gets one.
+            const QueryPlan &filter = *_intersectPlan;
+            return IntersectionCursor::make(Cursor::make(_cl, *_index, _frv, 0,
+                                                         _direction >= 0 ? 1 : -1),
+                                            Cursor::make(_cl, *filter._index, filter._frv, 0,
+                                                         filter._direction >= 0 ? 1 : -1));
+        }
+
         return Cursor::make(_cl, *_index, _frv, independentRangesSingleIntervalLimit(),
                             _direction >= 0 ? 1 : -1);
     }
 
+    void QueryPlan::intersectWith( const shared_ptr<const QueryPlan>& filter ) {
+        verify( _index && !_index->special() && _special.empty() && !_startOrEndSpec && _frv );
+        verify( filter->_index && !filter->_index->special() && filter->_special.empty() &&
+                !filter->_startOrEndSpec && filter->_frv );
+        _intersectPlan = filter;
+    }
+
+    BSONObj QueryPlan::planKey() const {
+        if ( _intersectPlan ) {
+            return BSON( "$intersect" << BSON_ARRAY( indexKey() << _intersectPlan->indexKey() ) );
+        }
+        return indexKey();
+    }
+
     BSONObj QueryPlan::indexKey() const {
         if ( !_index )
             return BSON( "$natural" << 1 );
@@ -307,7 +331,7 @@ doneCheckOrder:
             QueryCache &qc = cl->getQueryCache();
             QueryCache::Lock::Exclusive lk(qc);
             QueryPattern queryPattern = _frs.pattern( _order );
-            CachedQueryPlan queryPlanToCache( indexKey(), nScanned, candidatePlans );
+            CachedQueryPlan queryPlanToCache( planKey(), nScanned, candidatePlans );
             qc.registerCachedQueryPlanForPattern( queryPattern, queryPlanToCache );
         }
     }
@@ -446,7 +470,7 @@ doneCheckOrder:
 
     string QueryPlan::toString() const {
         return BSON(
-                    "index" << indexKey() <<
+                    "index" << planKey() <<
                     "frv" << ( _frv ? _frv->toString() : "" ) <<
                     "order" << _order
                     ).jsonString();
@@ -92,6 +92,21 @@ namespace mongo {
         /** @return a new cursor based on this QueryPlan's index and FieldRangeSet. */
         shared_ptr<Cursor> newCursor(const bool requestCountingCursor = false) const;
 
+        /**
+         * Makes this plan skip the documents that filter's index range doesn't contain, before
+         * fetching them.  Both plans must use ordinary, non special indexes.
+         */
+        void intersectWith( const shared_ptr<const QueryPlan>& filter );
+
+        /** @return the plan whose index this plan intersects with, if any. */
+        const QueryPlan* intersectPlan() const { return _intersectPlan.get(); }
+
+        /**
+         * @return the key this plan is recorded under in the query cache: the index key, or
+         * { $intersect: [ <index key>, <filter's index key> ] } for an intersection.
+         */
+        BSONObj planKey() const;
+
         /** Register this plan as a winner for its QueryPattern, with specified 'nscanned'. */
         void registerSelf( long long nScanned, CandidatePlanCharacter candidatePlans ) const;
 
@@ -172,6 +187,7 @@ namespace mongo {
         bool _startOrEndSpec;
         shared_ptr<Projection::KeyOnly> _keyFieldsOnly;
         mutable shared_ptr<CoveredIndexMatcher> _matcher; // Lazy initialization.
+        shared_ptr<const QueryPlan> _intersectPlan;
     };
 
     std::ostream &operator<< ( std::ostream& out, const QueryPlan::Utility& utility );
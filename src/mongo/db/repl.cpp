@@ -58,6 +58,7 @@
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/base/counter.h"
+#include "mongo/util/net/message_compression.h"
 
 namespace mongo {
 
@@ -164,6 +165,7 @@ namespace mongo {
                authenticated.
             */
             appendReplicationInfo(result, 0);
+            messageCompression::negotiate(cmdObj, ClientBasic::getCurrent()->port(), result);
 
             result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
             result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
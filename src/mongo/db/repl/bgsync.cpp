@@ -17,6 +17,9 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status.h"
@@ -25,6 +28,7 @@
 #include "mongo/db/repl/rs_sync.h"
 #include "mongo/base/counter.h"
 #include "mongo/db/stats/timer_stats.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
     void incRBID();
@@ -44,6 +48,10 @@ namespace mongo {
     static Counter64 networkByteStats;
     static ServerStatusMetricField<Counter64> displayBytesRead( "repl.network.bytes",
                                                                 &networkByteStats );
+    //The bytes fetched but not yet written to the oplog
+    static Counter64 readAheadSizeGauge;
+    static ServerStatusMetricField<Counter64> displayReadAheadSize( "repl.network.readAheadBytes",
+                                                                &readAheadSizeGauge );
 
     //The count of items in the buffer
     static Counter64 bufferCountGauge;
@@ -64,9 +72,135 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    // How far ahead of the producer the fetcher reads.
+    static const size_t replReadAheadMaxBytes = 64 * 1024 * 1024;
+
+    // This is a flow control mechanism. If the producer notices that
+    // more than this many bytes of transactions are waiting for the
+    // applier, it waits until the applier gets below half of it.
+    static const size_t replBufferMaxBytes = 256 * 1024 * 1024;
+
+    OplogFetcher::OplogFetcher(const shared_ptr<DBClientConnection>& conn,
+                               const shared_ptr<DBClientCursor>& cursor,
+                               size_t maxBufferedBytes) :
+        _conn(conn),
+        _cursor(cursor),
+        _maxBufferedBytes(maxBufferedBytes),
+        _bufferedBytes(0),
+        _finished(false),
+        _stopped(false)
+    {
+    }
+
+    shared_ptr<OplogFetcher> OplogFetcher::start(OplogReader& r, size_t maxBufferedBytes) {
+        verify(r.haveCursor());
+        shared_ptr<OplogFetcher> fetcher(new OplogFetcher(r.conn_shared(), r.cursor_shared(), maxBufferedBytes));
+        // the thread holds a reference, so the fetcher outlives it
+        boost::thread t(boost::bind(&OplogFetcher::run, fetcher));
+        return fetcher;
+    }
+
+    void OplogFetcher::run() {
+        Client::initThread("rsOplogFetcher");
+        try {
+            while (true) {
+                {
+                    boost::unique_lock<boost::mutex> lock(_mutex);
+                    if (_stopped) {
+                        break;
+                    }
+                }
+                if (!_cursor->moreInCurrentBatch()) {
+                    {
+                        //record time for each getmore
+                        TimerHolder batchTimer(&getmoreReplStats);
+                        _cursor->more();
+                    }
+                    if (!_cursor->moreInCurrentBatch()) {
+                        // looping back is ok because this is a tailable cursor
+                        if (_cursor->isDead()) {
+                            break;
+                        }
+                        continue;
+                    }
+                    //increment
+                    networkByteStats.increment(_cursor->getMessage()->size());
+                }
+
+                BSONArrayBuilder b(_cursor->getMessage() ? _cursor->getMessage()->size() : 512);
+                while (_cursor->moreInCurrentBatch()) {
+                    b.append(_cursor->nextSafe());
+                    opsReadStats.increment();
+                }
+                if (!push(b.arr())) {
+                    break;
+                }
+            }
+        }
+        catch (DBException& e) {
+            log() << "replSet error fetching oplog: " << e.toString() << rsLog;
+        }
+        catch (std::exception& e2) {
+            log() << "replSet exception fetching oplog: " << e2.what() << rsLog;
+        }
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            _finished = true;
+            _cond.notify_all();
+        }
+        cc().shutdown();
+    }
+
+    bool OplogFetcher::push(const BSONObj& batch) {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        // a batch may take us over the limit, so one bigger than the limit can't wedge us
+        while (_bufferedBytes >= _maxBufferedBytes && !_stopped) {
+            _cond.wait(lock);
+        }
+        if (_stopped) {
+            return false;
+        }
+        _batches.push_back(batch);
+        _bufferedBytes += batch.objsize();
+        readAheadSizeGauge.increment(batch.objsize());
+        _cond.notify_all();
+        return true;
+    }
+
+    bool OplogFetcher::nextBatch(BSONObj& batch, int maxMillisToWait) {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        if (_batches.empty() && !_finished) {
+            _cond.timed_wait(lock, boost::posix_time::milliseconds(maxMillisToWait));
+        }
+        if (_batches.empty()) {
+            return false;
+        }
+        batch = _batches.front();
+        _batches.pop_front();
+        _bufferedBytes -= batch.objsize();
+        readAheadSizeGauge.increment(-batch.objsize());
+        _cond.notify_all();
+        return true;
+    }
+
+    bool OplogFetcher::done() {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        return _finished && _batches.empty();
+    }
+
+    void OplogFetcher::stop() {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        _stopped = true;
+        readAheadSizeGauge.increment(-_bufferedBytes);
+        _batches.clear();
+        _bufferedBytes = 0;
+        _cond.notify_all();
+    }
+
     BackgroundSync::BackgroundSync() : _opSyncShouldRun(false),
                                             _opSyncRunning(false),
                                             _currentSyncTarget(NULL),
+                                            _dequeBytes(0),
                                             _opSyncShouldExit(false),
                                             _opSyncInProgress(false),
                                             _applierShouldExit(false),
@@ -144,6 +278,8 @@ namespace mongo {
         while (1) {
             try {
                 BSONObj curr;
+                // keeps curr's buffer alive
+                BSONObj currBatch;
                 {
                     boost::unique_lock<boost::mutex> lck(_mutex);
                     // wait until we know an item has been produced
@@ -154,7 +290,8 @@ namespace mongo {
                     if (_deque.size() == 0 && _applierShouldExit) {
                         return; 
                     }
-                    curr = _deque.front();
+                    curr = _deque.front().op;
+                    currBatch = _deque.front().batch;
                 }
                 GTID currEntry = getGTIDFromOplogEntry(curr);
                 theReplSet->gtidManager->noteApplyingGTID(currEntry);
@@ -187,17 +324,14 @@ namespace mongo {
                     boost::unique_lock<boost::mutex> lck(_mutex);
                     dassert(_deque.size() > 0);
                     _deque.pop_front();
+                    _dequeBytes -= curr.objsize();
                     bufferCountGauge.increment(-1);
                     bufferSizeGauge.increment(-curr.objsize());
-                    
-                    // this is a flow control mechanism, with bad numbers
-                    // hard coded for now just to get something going.
-                    // If the opSync thread notices that we have over 20000
-                    // transactions in the queue, it waits until we get below
-                    // 10000. This is where we signal that we have gotten there
-                    // Once we have spilling of transactions working, this
-                    // logic will need to be redone
-                    if (_deque.size() == 10000) {
+
+                    // flow control, see replBufferMaxBytes. This is where
+                    // we signal that we have gotten below half
+                    if (_dequeBytes <= replBufferMaxBytes / 2 &&
+                        _dequeBytes + curr.objsize() > replBufferMaxBytes / 2) {
                         _queueCond.notify_all();
                     }
                 }
@@ -366,47 +500,57 @@ namespace mongo {
             return 2; // 2 is arbitrary, if we are going fatal, we are done
         }
 
+        // From here on the fetcher has r's connection, so we read the
+        // oplog.refs of big transactions over a second one.
+        const string hn = r.conn()->getServerAddress();
+        OplogReader refsReader(false /* doHandshake */);
+        shared_ptr<OplogFetcher> fetcher = OplogFetcher::start(r, replReadAheadMaxBytes);
+        ON_BLOCK_EXIT_OBJ(*fetcher, &OplogFetcher::stop);
+
         while (!_opSyncShouldExit) {
-            while (!_opSyncShouldExit) {
-                {
-                    // check if we should bail out
-                    boost::unique_lock<boost::mutex> lck(_mutex);
-                    if (!_opSyncShouldRun) {
-                        return 0;
-                    }
+            {
+                // check if we should bail out
+                boost::unique_lock<boost::mutex> lck(_mutex);
+                if (!_opSyncShouldRun) {
+                    return 0;
                 }
-                if (!r.moreInCurrentBatch()) {
-                    // check to see if we have a request to sync
-                    // from a specific target. If so, get out so that
-                    // we can restart the act of syncing and
-                    // do so from the correct target
-                    if (theReplSet->gotForceSync()) {
-                        return 0;
-                    }
+            }
+            // check to see if we have a request to sync
+            // from a specific target. If so, get out so that
+            // we can restart the act of syncing and
+            // do so from the correct target
+            if (theReplSet->gotForceSync()) {
+                return 0;
+            }
 
-                    verify(!theReplSet->isPrimary());
+            verify(!theReplSet->isPrimary());
 
-                    if (shouldChangeSyncTarget()) {
-                        return 0;
-                    }
-                    //record time for each getmore
-                    {
-                        TimerHolder batchTimer(&getmoreReplStats);
-                        r.more();
-                    }
-                    //increment
-                    networkByteStats.increment(r.currentBatchMessageSize());
+            if (shouldChangeSyncTarget()) {
+                return 0;
+            }
 
+            BSONObj batch;
+            if (!fetcher->nextBatch(batch, 1000)) {
+                if (fetcher->done()) {
+                    LOG(1) << "replSet end opSync pass" << rsLog;
+                    return 0;
                 }
+                continue;
+            }
 
-                if (!r.more()) {
-                    break;
+            BSONObjIterator it(batch);
+            while (it.more()) {
+                {
+                    // check if we should bail out
+                    boost::unique_lock<boost::mutex> lck(_mutex);
+                    if (!_opSyncShouldRun) {
+                        return 0;
+                    }
                 }
 
                 // This is the operation we have received from the target
                 // that we must put in our oplog with an applied field of false
-                BSONObj o = r.nextSafe().getOwned();
-                opsReadStats.increment();
+                BSONObj o = it.next().Obj();
                 LOG(3) << "replicating " << o.toString(false, true) << " from " << _currentSyncTarget->fullName() << endl;
                 uint64_t ts = o["ts"]._numberLong();
 
@@ -418,17 +562,22 @@ namespace mongo {
                     {
                         boost::unique_lock<boost::mutex> lck(_mutex);
                         if (!_opSyncShouldRun) {
-                            break;
+                            return 0;
                         }
                     }
                 }
 
+                if (o.hasElement("ref") && !refsReader.haveConnection() && !refsReader.connect(hn)) {
+                    LOG(2) << "replSet can't connect to " << hn << " to read oplog.refs" << rsLog;
+                    return 0;
+                }
+
                 {
                     Timer timer;
                     bool bigTxn = false;
                     {
                         Client::Transaction transaction(DB_SERIALIZABLE);
-                        replicateFullTransactionToOplog(o, r, &bigTxn);
+                        replicateFullTransactionToOplog(o, refsReader, &bigTxn);
                         // we are operating as a secondary. We don't have to fsync
                         transaction.commit(DB_TXN_NOSYNC);
                     }
@@ -442,17 +591,13 @@ namespace mongo {
                         if (_deque.size() == 0) {
                             _queueCond.notify_all();
                         }
-                        _deque.push_back(o);
+                        _deque.push_back(QueuedOp(batch, o));
+                        _dequeBytes += o.objsize();
                         bufferCountGauge.increment();
                         bufferSizeGauge.increment(o.objsize());
-                        // this is a flow control mechanism, with bad numbers
-                        // hard coded for now just to get something going.
-                        // If the opSync thread notices that we have over 20000
-                        // transactions in the queue, it waits until we get below
-                        // 10000. This is where we wait if we get too high
-                        // Once we have spilling of transactions working, this
-                        // logic will need to be redone
-                        if (_deque.size() > 20000) {
+                        // flow control, see replBufferMaxBytes. This is where we
+                        // wait if we get too high
+                        if (_dequeBytes > replBufferMaxBytes) {
                             _queueCond.wait(lock);
                         }
                         if (bigTxn) {
@@ -465,19 +610,7 @@ namespace mongo {
                         }
                     }
                 }
-            } // end while
-
-            if (shouldChangeSyncTarget()) {
-                return 0;
-            }
-
-            r.tailCheck();
-            if( !r.haveCursor() ) {
-                LOG(1) << "replSet end opSync pass" << rsLog;
-                return 0;
             }
-
-            // looping back is ok because this is a tailable cursor
         }
         return 0;
     }
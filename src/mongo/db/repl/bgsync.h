@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/util/queue.h"
@@ -26,6 +28,61 @@
 
 namespace mongo {
 
+    /**
+     * Reads a sync target's oplog ahead of the producer.
+     *
+     * A thread of its own iterates the tailing cursor, so the next getMore is already on the
+     * wire while the producer writes what was fetched before, instead of the producer
+     * alternating between waiting on the network and writing.  Each reply is copied into a
+     * single buffer (a BSON array of its entries) rather than one allocation per entry, and
+     * queued.  The queue is bounded by bytes, not entries, because entry sizes vary from a
+     * few bytes to megabytes.
+     */
+    class OplogFetcher : boost::noncopyable {
+    public:
+        /**
+         * Starts fetching the rest of r's tailing cursor.  The thread shares r's connection and
+         * cursor, so r must not be used to talk to the sync target afterwards.
+         */
+        static shared_ptr<OplogFetcher> start(OplogReader& r, size_t maxBufferedBytes);
+
+        /**
+         * Gets the next batch, waiting up to maxMillisToWait for one.
+         * @return false if there was none, see done()
+         */
+        bool nextBatch(BSONObj& batch, int maxMillisToWait);
+
+        /** @return true if everything was fetched: the cursor died or fetching failed */
+        bool done();
+
+        /**
+         * Tells the thread to stop and forgets what was fetched.  Does not wait for a getMore
+         * in flight to return, the thread goes away when it does.
+         */
+        void stop();
+
+    private:
+        OplogFetcher(const shared_ptr<DBClientConnection>& conn,
+                     const shared_ptr<DBClientCursor>& cursor,
+                     size_t maxBufferedBytes);
+        void run();
+        // @return false if we were stopped
+        bool push(const BSONObj& batch);
+
+        // keeps the connection alive as long as the thread uses _cursor
+        const shared_ptr<DBClientConnection> _conn;
+        const shared_ptr<DBClientCursor> _cursor;
+        const size_t _maxBufferedBytes;
+
+        // _mutex protects everything below
+        boost::mutex _mutex;
+        // signals a change in _batches, or that we are finished or stopped
+        boost::condition_variable _cond;
+        std::deque<BSONObj> _batches;
+        size_t _bufferedBytes;
+        bool _finished;
+        bool _stopped;
+    };
 
     /**
      * Lock order:
@@ -64,12 +121,20 @@ namespace mongo {
 
         const Member* _currentSyncTarget;
 
+        // An op in _deque.  The op is not owned, it points into the
+        // batch it was fetched in, which we keep alive alongside it.
+        struct QueuedOp {
+            BSONObj batch;
+            BSONObj op;
+            QueuedOp(const BSONObj& b, const BSONObj& o) : batch(b), op(o) {}
+        };
+
         // double ended queue containing the ops
         // that have been written to the oplog but yet
         // to be applied to the collections.
-        // Its size should always be equal
-        // to _queueCounter.numElems
-        std::deque<BSONObj> _deque;
+        std::deque<QueuedOp> _deque;
+        // sum of the ops' sizes in _deque, for flow control
+        size_t _dequeBytes;
 
         // these variables are relevant to shutdown
 
@@ -21,6 +21,10 @@
 
 #include "mongo/pch.h"
 #include "mongo/db/scanandorder.h"
+
+#include <algorithm>
+
+#include "mongo/db/collection.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/storage/assert_ids.h"
 #include "mongo/db/parsed_query.h"
@@ -30,7 +34,7 @@ namespace mongo {
 
     const unsigned ScanAndOrder::MaxScanAndOrderBytes = 32 * 1024 * 1024;
 
-    void ScanAndOrder::add(const BSONObj& o) {
+    void ScanAndOrder::add(const BSONObj& o, const BSONObj& pk) {
         verify( o.isValid() );
         BSONObj k;
         try {
@@ -49,14 +53,18 @@ namespace mongo {
             return;   
         }
         if ( (int) _best.size() < _limit ) {
-            _add(k, o);
+            _add(k, o, pk);
             return;
         }
-        BestMap::iterator i;
-        verify( _best.end() != _best.begin() );
-        i = _best.end();
-        i--;
-        _addIfBetter(k, o, i);
+        verify( !_best.empty() );
+        // Only a candidate strictly better than the worst one kept replaces it.
+        const Candidate &worst = _best.front();
+        if ( worst.key.woCompare(k, _order._keyPattern) > 0 ) {
+            _validateAndUpdateApproxSize( -worst.approxSize() );
+            pop_heap(_best.begin(), _best.end(), _cmp);
+            _best.pop_back();
+            _add(k, o, pk);
+        }
     }
 
     void ScanAndOrder::fill( BufBuilder& b, const ParsedQuery *parsedQuery, int& nout ) const {
@@ -72,11 +80,18 @@ namespace mongo {
             details.reset( new MatchDetails );
             details->requestElemMatchKey();
         }
-        for ( BestMap::const_iterator i = _best.begin(); i != _best.end(); i++ ) {
+        vector<Candidate> sorted( _best );
+        sort_heap( sorted.begin(), sorted.end(), _cmp );
+        for ( vector<Candidate>::const_iterator i = sorted.begin(); i != sorted.end(); i++ ) {
             n++;
             if ( n <= _startFrom )
                 continue;
-            const BSONObj& o = i->second;
+            BSONObj o = i->obj;
+            if ( i->byPK ) {
+                massert( 17353, mongoutils::str::stream() << "sort() lost the document with pk "
+                                                          << i->obj,
+                         _cl->findByPK( i->obj, o ) );
+            }
             massert( 16355, "positional operator specified, but no array match",
                      ! arrayMatcher || arrayMatcher->matches( o, details.get() ) );
             fillQueryResultFromObj( b, projection, o, details.get() );
@@ -87,21 +102,15 @@ namespace mongo {
         nout = nFilled;
     }
 
-    void ScanAndOrder::_add(const BSONObj& k, const BSONObj& o) {
-        BSONObj docToReturn = o;
-        _validateAndUpdateApproxSize( k.objsize() + docToReturn.objsize() );
-        _best.insert(make_pair(k.getOwned(),docToReturn.getOwned()));
-    }
-    
-    void ScanAndOrder::_addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i) {
-        const BSONObj& worstBestKey = i->first;
-        int cmp = worstBestKey.woCompare(k, _order._keyPattern);
-        if ( cmp > 0 ) {
-            // k is better, 'upgrade'
-            _validateAndUpdateApproxSize( -i->first.objsize() + -i->second.objsize() );
-            _best.erase(i);
-            _add(k, o);
-        }
+    void ScanAndOrder::_add(const BSONObj& k, const BSONObj& o, const BSONObj& pk) {
+        Candidate c;
+        c.key = k.getOwned();
+        c.byPK = _cl != NULL && !pk.isEmpty() && o.objsize() >= MinObjSizeToKeepByPK;
+        c.obj = c.byPK ? pk.getOwned() : o.getOwned();
+        c.seq = _nAdded++;
+        _validateAndUpdateApproxSize( c.approxSize() );
+        _best.push_back(c);
+        push_heap(_best.begin(), _best.end(), _cmp);
     }
 
     void ScanAndOrder::_validateAndUpdateApproxSize( const int approxSizeDelta ) {
@@ -67,14 +67,26 @@ namespace mongo {
         }
     }
 
-    typedef multimap<BSONObj,BSONObj,BSONObjCmp> BestMap;
+    class Collection;
+
+    /**
+     * Keeps the first _limit results in the requested order, in a heap whose top is the worst
+     * result kept so far.
+     *
+     * Given the collection being scanned, add() keeps just the primary key of a large document
+     * next to its sort key, and fill() fetches the few documents it returns by primary key.  That
+     * must happen in the transaction that scanned them, and only a transaction whose reads repeat
+     * (snapshot or serializable) is sure to see the same versions again, so callers in read
+     * committed or read uncommitted transactions must not pass the collection.
+     */
     class ScanAndOrder {
     public:
         static const unsigned MaxScanAndOrderBytes;
 
-        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs) :
-            _best( BSONObjCmp( order ) ),
-            _startFrom(startFrom), _order(order, frs) {
+        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs,
+                     Collection *cl = NULL) :
+            _cmp( order ),
+            _startFrom(startFrom), _order(order, frs), _cl(cl), _nAdded(0) {
             _limit = limit > 0 ? limit + _startFrom : 0x7fffffff;
             _approxSize = 0;
         }
@@ -82,10 +94,11 @@ namespace mongo {
         int size() const { return _best.size(); }
 
         /**
+         * @param pk the primary key of o, if o is a whole document of the collection.
          * @throw ScanAndOrderMemoryLimitExceededAssertionCode if adding would grow memory usage
          * to ScanAndOrder::MaxScanAndOrderBytes.
          */
-        void add(const BSONObj &o);
+        void add(const BSONObj &o, const BSONObj &pk = BSONObj());
 
         /* scanning complete. stick the query result in b for n objects. */
         void fill(BufBuilder& b, const ParsedQuery *query, int& nout) const;
@@ -97,9 +110,35 @@ namespace mongo {
 
     private:
 
-        void _add(const BSONObj& k, const BSONObj& o);
-
-        void _addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i);
+        struct Candidate {
+            BSONObj key;
+            BSONObj obj;    // the object to return, or its primary key if byPK
+            bool byPK;
+            long long seq;  // the order of addition, the first one added wins a tie
+            int approxSize() const { return key.objsize() + obj.objsize(); }
+        };
+
+        /** Orders candidates best first, so the heap's top is the worst one. */
+        class CandidateCmp {
+        public:
+            CandidateCmp(const BSONObj &order) : _keyCmp(order) {}
+            bool operator()(const Candidate &a, const Candidate &b) const {
+                if (_keyCmp(a.key, b.key)) {
+                    return true;
+                }
+                if (_keyCmp(b.key, a.key)) {
+                    return false;
+                }
+                return a.seq < b.seq;
+            }
+        private:
+            BSONObjCmp _keyCmp;
+        };
+
+        /** Documents smaller than this are kept whole, they cost less than a lookup later. */
+        static const int MinObjSizeToKeepByPK = 1024;
+
+        void _add(const BSONObj& k, const BSONObj& o, const BSONObj& pk);
 
         /**
          * @throw ScanAndOrderMemoryLimitExceededAssertionCode if approxSize would grow too high,
@@ -107,10 +146,13 @@ namespace mongo {
          */
         void _validateAndUpdateApproxSize( const int approxSizeDelta );
 
-        BestMap _best; // key -> full object
+        CandidateCmp _cmp;
+        vector<Candidate> _best; // heap of the best candidates, the worst one first
         int _startFrom;
         int _limit;   // max to send back.
         KeyType _order;
+        Collection *_cl;
+        long long _nAdded;
         unsigned _approxSize;
 
     };
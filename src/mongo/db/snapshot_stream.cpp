@@ -0,0 +1,77 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/snapshot_stream.h"
+
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using namespace mongoutils;
+
+    const int SnapshotFrameBuilder::TARGET_FRAME_SIZE(1024 * 1024);
+
+    void SnapshotFrameBuilder::append(const char *key, int keySize, const char *val, int valSize) {
+        _rows.appendNum(keySize);
+        _rows.appendBuf(key, keySize);
+        _rows.appendNum(valSize);
+        _rows.appendBuf(val, valSize);
+        _n++;
+    }
+
+    BSONObj SnapshotFrameBuilder::obj() const {
+        BSONObjBuilder b(_rows.len() + 64);
+        b.append("n", _n);
+        b.appendBinData("rows", _rows.len(), BinDataGeneral, _rows.buf());
+        return b.obj();
+    }
+
+    SnapshotFrameReader::SnapshotFrameReader(const BSONObj &frame) {
+        const BSONElement n = frame["n"];
+        const BSONElement rows = frame["rows"];
+        uassert(17340, str::stream() << "malformed snapshot frame: " << frame.toString(false, true),
+                n.isNumber() && n.numberInt() >= 0 && rows.type() == BinData);
+        int len;
+        _pos = rows.binData(len);
+        _end = _pos + len;
+        _numRows = _remaining = n.numberInt();
+    }
+
+    int SnapshotFrameReader::readSize() {
+        int size;
+        uassert(17341, "truncated snapshot frame", _end - _pos >= static_cast<int>(sizeof(size)));
+        memcpy(&size, _pos, sizeof(size));
+        _pos += sizeof(size);
+        uassert(17342, "truncated snapshot frame", size >= 0 && _end - _pos >= size);
+        return size;
+    }
+
+    SnapshotFrameReader::Row SnapshotFrameReader::next() {
+        verify(more());
+        Row row;
+        row.keySize = readSize();
+        row.key = _pos;
+        _pos += row.keySize;
+        row.valSize = readSize();
+        row.val = _pos;
+        _pos += row.valSize;
+        _remaining--;
+        return row;
+    }
+
+} // namespace mongo
@@ -0,0 +1,86 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * The streamSnapshot command returns a collection's primary key dictionary as a cursor over
+     * frames
+     *
+     *     { n: <number of rows>, rows: BinData }
+     *
+     * where rows is n of
+     *
+     *     int32 keySize | key | int32 valSize | val
+     *
+     * exactly as they are stored: key is the packed storage::Key of the primary key and val is
+     * the document.  mongosnapshotload puts them straight into a storage::Loader.
+     */
+    class SnapshotFrameBuilder : boost::noncopyable {
+    public:
+        /** Frames hold at most this many bytes of rows, unless one row is bigger. */
+        static const int TARGET_FRAME_SIZE;
+
+        SnapshotFrameBuilder() : _n(0) {}
+
+        void append(const char *key, int keySize, const char *val, int valSize);
+
+        int len() const { return _rows.len(); }
+        int numRows() const { return _n; }
+
+        /** @return the frame holding everything appended so far */
+        BSONObj obj() const;
+
+    private:
+        BufBuilder _rows;
+        int _n;
+    };
+
+    class SnapshotFrameReader {
+    public:
+        struct Row {
+            const char *key;
+            int keySize;
+            const char *val;
+            int valSize;
+        };
+
+        /** uasserts if frame isn't a well formed frame. frame must outlive the reader. */
+        explicit SnapshotFrameReader(const BSONObj &frame);
+
+        bool more() const { return _remaining > 0; }
+
+        /** @return the next row, which points into the frame */
+        Row next();
+
+        int numRows() const { return _numRows; }
+
+    private:
+        int readSize();
+
+        const char *_pos;
+        const char *_end;
+        int _numRows;
+        int _remaining;
+    };
+
+} // namespace mongo
@@ -98,6 +98,22 @@ namespace mongo {
             set_val(&new_val, set_extra);
         }
 
+        static void runUpsertMods(DB *db, const DBT *key, const DBT *old_val, const BSONObj& updateObj,
+                                  const BSONObj &query,
+                                  void (*set_val)(const DBT *new_val, void *set_extra),
+                                  void *set_extra) {
+            if (old_val != NULL && old_val->data != NULL) {
+                runUpdateMods(db, key, old_val, updateObj, set_val, set_extra);
+                return;
+            }
+            // No existing object, so insert the one described by the query and mods.
+            BSONObj newObj = _updateCallback->applyModsToQuery(query, updateObj);
+            if (!newObj.isEmpty()) {
+                DBT new_val = dbt_make(newObj.objdata(), newObj.objsize());
+                set_val(&new_val, set_extra);
+            }
+        }
+
         static int update_callback(DB *db, const DBT *key, const DBT *old_val, const DBT *extra,
                                    void (*set_val)(const DBT *new_val, void *set_extra),
                                    void *set_extra) {
@@ -106,10 +122,14 @@ namespace mongo {
                 verify(key != NULL && extra != NULL && extra->data != NULL);
                 const BSONObj msg(static_cast<char *>(extra->data));
                 const char* type = msg[ "t" ].valuestrsafe();
-                // right now, we only support one type of message, an updateMods
-                uassert(17313, str::stream() << "unknown type of update message, type: " << type << " message: " << msg, strcmp(type, "u") == 0);
+                // an updateMods ("u") or an upsertMods ("up"), which also carries the query
                 const BSONObj updateObj = msg["o"].Obj();
-                runUpdateMods(db, key, old_val, updateObj, set_val, set_extra);
+                if (strcmp(type, "up") == 0) {
+                    runUpsertMods(db, key, old_val, updateObj, msg["q"].Obj(), set_val, set_extra);
+                } else {
+                    uassert(17313, str::stream() << "unknown type of update message, type: " << type << " message: " << msg, strcmp(type, "u") == 0);
+                    runUpdateMods(db, key, old_val, updateObj, set_val, set_extra);
+                }
                 return 0;
             } catch (const std::exception &ex) {
                 problem() << "Caught exception in ydb update callback, ex: " << ex.what()
@@ -158,14 +178,10 @@ namespace mongo {
                 // because the one and only key is src_key
                 verify(dest_db != src_db);
 
-                // Generate keys for a secondary index.
-                BSONObjSet keys;
-                descriptor.generateKeys(obj, keys);
-                dbt_array_clear_and_resize(dest_keys, keys.size());
-                for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); i++) {
-                    const Key sKey(*i, &pk);
-                    dbt_array_push(dest_keys, sKey.buf(), sKey.size());
-                }
+                // Generate keys for a secondary index, straight into dictionary key format.
+                KeyArray &keys = KeyArray::forThread();
+                descriptor.generateKeys(obj, &pk, keys);
+                keys.pushTo(dest_keys);
                 // Set the multiKey bool if it's provided and we generated multiple keys.
                 // See CollectionBase::IndexerBase::Indexer()
                 if (dest_db->app_private != NULL && keys.size() > 1) {
@@ -34,6 +34,11 @@ namespace mongo {
             virtual BSONObj applyMods(const BSONObj &oldObj, const BSONObj &msg) {
                 msgasserted(17214, "bug: update apply callback not properly installed");
             }
+            // Builds the object an upsert message inserts when there is no old object.
+            // An empty result means nothing gets inserted.
+            virtual BSONObj applyModsToQuery(const BSONObj &query, const BSONObj &msg) {
+                msgasserted(17351, "bug: update apply callback not properly installed");
+            }
         };
 
         extern DB_ENV *env;
@@ -19,6 +19,9 @@
 
 #include "mongo/pch.h"
 
+#include <algorithm>
+#include <boost/thread/tss.hpp>
+
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/storage/key.h"
@@ -546,6 +549,81 @@ namespace mongo {
             return true;
         }
 
+        // Don't keep more than this much of a huge document's keys around afterwards.
+        static const int keyArrayMaxRetainedSize = 64 * 1024;
+
+        void KeyArray::reset(const BSONObj *pk) {
+            _b.reset(keyArrayMaxRetainedSize);
+            _keys.clear();
+            _pk = pk;
+        }
+
+        void KeyArray::append(const BSONObj &key) {
+            Entry e;
+            e.offset = _b.len();
+            KeyV1Owned keyOwned(key);
+            _b.appendBuf(keyOwned.data(), keyOwned.dataSize());
+            if (_pk != NULL) {
+                _b.appendBuf(_pk->objdata(), _pk->objsize());
+            }
+            e.size = _b.len() - e.offset;
+            _keys.push_back(e);
+        }
+
+        // Compares only the KeyV1 part, since all of a document's keys have the same pk.
+        class KeyArray::EntryLess {
+        public:
+            EntryLess(const char *base, const Ordering &ordering) :
+                _base(base), _ordering(ordering) {
+            }
+            bool operator()(const Entry &a, const Entry &b) const {
+                return KeyV1(_base + a.offset).woCompare(KeyV1(_base + b.offset), _ordering) < 0;
+            }
+        private:
+            const char *_base;
+            const Ordering &_ordering;
+        };
+
+        class KeyArray::EntryEqual {
+        public:
+            EntryEqual(const char *base, const Ordering &ordering) :
+                _base(base), _ordering(ordering) {
+            }
+            bool operator()(const Entry &a, const Entry &b) const {
+                return KeyV1(_base + a.offset).woCompare(KeyV1(_base + b.offset), _ordering) == 0;
+            }
+        private:
+            const char *_base;
+            const Ordering &_ordering;
+        };
+
+        void KeyArray::sortAndUnique(const Ordering &ordering) {
+            if (_keys.size() <= 1) {
+                return;
+            }
+            std::sort(_keys.begin(), _keys.end(), EntryLess(_b.buf(), ordering));
+            _keys.erase(std::unique(_keys.begin(), _keys.end(), EntryEqual(_b.buf(), ordering)),
+                        _keys.end());
+        }
+
+        void KeyArray::pushTo(DBT_ARRAY *array) const {
+            dbt_array_clear_and_resize(array, _keys.size());
+            for (vector<Entry>::const_iterator it = _keys.begin(); it != _keys.end(); ++it) {
+                dbt_array_push(array, _b.buf() + it->offset, it->size);
+            }
+        }
+
+        static boost::thread_specific_ptr<KeyArray> threadKeyArray;
+
+        KeyArray &KeyArray::forThread() {
+            KeyArray *keys = threadKeyArray.get();
+            if (keys == NULL) {
+                keys = new KeyArray();
+                threadKeyArray.reset(keys);
+            }
+            return *keys;
+        }
+
     } // namespace storage
 
 } // namespace mongo
@@ -261,6 +261,70 @@ namespace mongo {
             size_t _size;
         };
 
+        // The dictionary keys a document generates for one index, encoded back to back
+        // in a buffer that is kept from one document to the next.
+        //
+        // Key generators append each key as they find it (see Descriptor::generateKeys),
+        // then sortAndUnique() drops the duplicates a multikey document can produce, as a
+        // BSONObjSet would.  Once the buffers have grown to fit the documents seen, nothing
+        // is allocated, so each thread keeps one for the write path, see forThread().
+        class KeyArray : boost::noncopyable {
+        public:
+            KeyArray() : _pk(NULL) {
+            }
+
+            // Starts over, for keys followed by pk, or by nothing if pk is NULL.
+            void reset(const BSONObj *pk);
+
+            // Appends key, in dictionary key format.
+            void append(const BSONObj &key);
+
+            // Puts the keys in index order and removes duplicates.
+            void sortAndUnique(const Ordering &ordering);
+
+            size_t size() const {
+                return _keys.size();
+            }
+
+            bool empty() const {
+                return _keys.empty();
+            }
+
+            DBT dbt(size_t i) const {
+                return dbt_make(_b.buf() + _keys[i].offset, _keys[i].size);
+            }
+
+            // @return the i'th key as BSON, without the primary key
+            BSONObj key(size_t i) const {
+                return KeyV1(_b.buf() + _keys[i].offset).toBson();
+            }
+
+            // Copies every key into array.
+            void pushTo(DBT_ARRAY *array) const;
+
+            // A buffer generators may use to build a key before append()ing it.
+            BufBuilder &scratch() {
+                return _scratch;
+            }
+
+            // The calling thread's KeyArray.  Only one user at a time: whoever
+            // reset()s it must be done with the keys before generating more.
+            static KeyArray &forThread();
+
+        private:
+            struct Entry {
+                int offset;
+                int size;
+            };
+            class EntryLess;
+            class EntryEqual;
+
+            BufBuilder _b;
+            BufBuilder _scratch;
+            vector<Entry> _keys;
+            const BSONObj *_pk;
+        };
+
     } // namespace storage
 
 } // namespace mongo
@@ -22,6 +22,7 @@
 #include "mongo/base/counter.h"
 #include "mongo/bson/bsonobjiterator.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/db/collection_map.h"
 #include "mongo/db/gtid.h"
 #include "mongo/db/oplog.h"
 #include "mongo/db/repl.h"
@@ -40,7 +41,7 @@ namespace mongo {
     // to true
     static bool _logTxnOpsForReplication = false;
     static bool _logTxnOpsForSharding = false;
-    static void (*_logTxnToOplog)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo) = NULL;
+    static void (*_logTxnToOplog)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry) = NULL;
     static void (*_logTxnOpsRef)(GTID gtid, uint64_t timestamp, uint64_t hash, OID& oid) = NULL;
     static void (*_logOpsToOplogRef)(BSONObj o) = NULL;
     static bool (*_shouldLogOpForSharding)(const char *, const char *, const BSONObj &) = NULL;
@@ -63,7 +64,7 @@ namespace mongo {
         return _logTxnOpsForReplication;
     }
 
-    void setLogTxnToOplog(void (*f)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo)) {
+    void setLogTxnToOplog(void (*f)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry)) {
         _logTxnToOplog = f;
     }
 
@@ -197,6 +198,7 @@ namespace mongo {
         // this piece must be done before the _txn.commit
         try {
             if (!_txnOps.empty()) {
+                _txnOps.prepareRootCommit();
                 uint64_t timestamp = 0;
                 uint64_t hash = 0;
                 if (!_initiatingRS) {
@@ -362,6 +364,12 @@ namespace mongo {
 
     /* --------------------------------------------------------------------- */
 
+    CollectionMapRollback::~CollectionMapRollback() {
+        for (set<string>::const_iterator it = _namespaces.begin(); it != _namespaces.end(); ++it) {
+            CollectionMap::unpin_ns(*it);
+        }
+    }
+
     void CollectionMapRollback::commit() {
         // nothing to do on commit
     }
@@ -375,12 +383,16 @@ namespace mongo {
                    << _namespaces.size() + _dbs.size() << " roll items." << endl;
 
         // Promote rollback entries to parent.
-        parent._namespaces.insert(_namespaces.begin(), _namespaces.end());
+        for (set<string>::const_iterator it = _namespaces.begin(); it != _namespaces.end(); ++it) {
+            parent.noteNs(*it);
+        }
         parent._dbs.insert(_dbs.begin(), _dbs.end());
     }
 
     void CollectionMapRollback::noteNs(const StringData& ns) {
-        _namespaces.insert(ns.toString());
+        if (_namespaces.insert(ns.toString()).second) {
+            CollectionMap::pin_ns(ns);
+        }
     }
 
     void CollectionMapRollback::noteCreate(const StringData& dbname) {
@@ -480,17 +492,28 @@ namespace mongo {
         return _oid;
     }
 
+    void TxnOplog::buildOplogEntry() {
+        // The layout logTransactionOps expects: _id, ts and h are filled in once the
+        // transaction has a GTID.
+        BSONObjBuilder b(_mem_size + 128);
+        addGTIDToBSON("_id", GTID(), b);
+        b.appendDate("ts", Date_t());
+        b.append("h", 0LL);
+        b.append("a", true);
+        BSONArrayBuilder ops(b.subarrayStart("ops"));
+        for (deque<BSONObj>::iterator it = _m.begin(); it != _m.end(); it++) {
+            ops.append(*it);
+        }
+        ops.done();
+        _entry = b.obj();
+    }
+
     void TxnOplog::writeOpsDirectlyToOplog(GTID gtid, uint64_t timestamp, uint64_t hash) {
         dassert(logTxnOpsForReplication());
         dassert(_logTxnToOplog);
-        // build array of in memory ops
-        BSONArrayBuilder b;
-        for (deque<BSONObj>::iterator it = _m.begin(); it != _m.end(); it++) {
-            b.append(*it);
-        }
-        BSONArray a = b.arr();
+        dassert(!_entry.isEmpty());
         // log ops
-        _logTxnToOplog(gtid, timestamp, hash, a);
+        _logTxnToOplog(gtid, timestamp, hash, _entry);
     }
 
     void TxnOplog::writeTxnRefToOplog(GTID gtid, uint64_t timestamp, uint64_t hash) {
@@ -504,10 +527,17 @@ namespace mongo {
         _logTxnOpsRef(gtid, timestamp, hash, _oid);
     }
 
-    void TxnOplog::rootCommit(GTID gtid, uint64_t timestamp, uint64_t hash) {
+    void TxnOplog::prepareRootCommit() {
         if (_spilled) {
             // spill in memory ops if any
             spill();
+        } else {
+            buildOplogEntry();
+        }
+    }
+
+    void TxnOplog::rootCommit(GTID gtid, uint64_t timestamp, uint64_t hash) {
+        if (_spilled) {
             // log ref
             writeTxnRefToOplog(gtid, timestamp, hash);
         } else {
@@ -44,7 +44,7 @@ namespace mongo {
     void disableLogTxnOpsForSharding(void);
     bool shouldLogTxnOpForSharding(const char *opstr, const char *ns, const BSONObj &obj);
     bool shouldLogTxnUpdateOpForSharding(const char *opstr, const char *ns, const BSONObj &oldObj);
-    void setLogTxnToOplog(void (*)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONArray& opInfo));
+    void setLogTxnToOplog(void (*)(GTID gtid, uint64_t timestamp, uint64_t hash, BSONObj& entry));
     void setLogTxnRefToOplog(void (*f)(GTID gtid, uint64_t timestamp, uint64_t hash, OID& oid));
     void setLogOpsToOplogRef(void (*f)(BSONObj o));
     void setOplogInsertStats(TimerStats *oplogInsertStats, Counter64 *oplogInsertBytesStats);
@@ -87,6 +87,9 @@ namespace mongo {
     // sync with whatever is on disk in the metadb.
     class CollectionMapRollback : boost::noncopyable {
     public:
+        // Unpins the noted namespaces, see CollectionMap::pin_ns().
+        ~CollectionMapRollback();
+
         // Called after txn commit.
         void commit();
 
@@ -144,7 +147,12 @@ namespace mongo {
         // Returns true if the TxnOplog does not contain any ops
         bool empty() const;
 
-        // Commit a root txn
+        // Do the work of a root commit that doesn't need the GTID: spill the remaining ops
+        // or build the oplog entry.  Called before the GTID is assigned, so the GTID is live
+        // for as little time as possible.
+        void prepareRootCommit();
+
+        // Commit a root txn, after prepareRootCommit()
         void rootCommit(GTID gtid, uint64_t timestamp, uint64_t hash);
 
         // Commit a child txn
@@ -160,7 +168,11 @@ namespace mongo {
         // Get the OID assigned to this txn.  Assign one if not already assigned.
         OID getOid();
 
-        // writes operations directly to the oplog with a BSONArray
+        // builds the oplog entry for the in memory ops, with placeholders for the GTID,
+        // timestamp and hash
+        void buildOplogEntry();
+
+        // writes the entry built by buildOplogEntry() directly to the oplog
         void writeOpsDirectlyToOplog(GTID gtid, uint64_t timestamp, uint64_t hash);
 
         // writes a reference to the operations that exist in oplog.refs to the oplog
@@ -173,6 +185,7 @@ namespace mongo {
         bool _spilled;
         size_t _mem_size, _mem_limit;
         deque<BSONObj> _m;
+        BSONObj _entry;
         OID _oid;
         long long _seq;
         size_t _refsSize;
@@ -222,6 +235,11 @@ namespace mongo {
         bool serializable() const {
             return (_txn.flags() & DB_SERIALIZABLE) != 0;
         }
+        /** @return true iff reads repeat within this transaction, i.e. it has snapshot or
+         *          serializable isolation rather than read committed or read uncommitted. */
+        bool repeatableReads() const {
+            return (_txn.flags() & (DB_READ_COMMITTED | DB_READ_UNCOMMITTED)) == 0;
+        }
         // log an operations, represented in op, to _txnOps
         // if and when the root transaction commits, the operation
         // will be added to the opLog
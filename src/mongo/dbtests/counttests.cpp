@@ -19,6 +19,7 @@
 
 #include <boost/thread/thread.hpp>
 
+#include "mongo/db/curop.h"
 #include "mongo/db/cursor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/ops/count.h"
@@ -136,6 +137,56 @@ namespace CountTests {
         }
     };
 
+    /** An estimated count of an index range, from the index's key statistics. */
+    class EstimateRange : public Base {
+    public:
+        void run() {
+            insert( "{\"a\":\"e0\"}" );
+            insert( "{\"a\":\"e1\"}" );
+            insert( "{\"a\":\"e2\"}" );
+            insert( "{\"a\":\"e3\"}" );
+            insert( "{\"a\":\"e4\"}" );
+            string err;
+            int errCode;
+            ASSERT_EQUALS( 3, runCount( ns(), fromjson( "{\"query\":{\"a\":{\"$gte\":\"e1\",\"$lt\":\"e4\"}},"
+                                                        "\"estimate\":true}" ), err, errCode ) );
+            ASSERT_EQUALS( 4, runCount( ns(), fromjson( "{\"query\":{\"a\":{\"$gt\":\"e0\",\"$lte\":\"e4\"}},"
+                                                        "\"estimate\":true}" ), err, errCode ) );
+            ASSERT_EQUALS( 2, runCount( ns(), fromjson( "{\"query\":{\"a\":{\"$gte\":\"e1\",\"$lt\":\"e4\"}},"
+                                                        "\"estimate\":true,\"skip\":1}" ), err, errCode ) );
+            ASSERT_EQUALS( 1, runCount( ns(), fromjson( "{\"query\":{\"a\":{\"$gte\":\"e1\",\"$lt\":\"e4\"}},"
+                                                        "\"estimate\":true,\"limit\":1}" ), err, errCode ) );
+            // A query that needs a matcher is still counted by scanning.
+            ASSERT_EQUALS( 4, runCount( ns(), fromjson( "{\"query\":{\"a\":{\"$gte\":\"e1\"},\"b\":{\"$exists\":false}},"
+                                                        "\"estimate\":true}" ), err, errCode ) );
+        }
+    };
+
+    /** An estimated count of an empty query reads the primary key's statistics, not its keys. */
+    class EstimateAll : public Base {
+    public:
+        void run() {
+            insert( "{\"a\":\"e0\"}" );
+            insert( "{\"a\":\"e1\"}" );
+            insert( "{\"a\":\"e2\"}" );
+            insert( "{\"a\":\"e3\"}" );
+            insert( "{\"a\":\"e4\"}" );
+            string err;
+            int errCode;
+            OpDebug &debug = cc().curop()->debug();
+            ASSERT_EQUALS( 5, runCount( ns(), fromjson( "{\"query\":{},\"estimate\":true}" ), err, errCode ) );
+            ASSERT_EQUALS( 0, debug.nscanned );
+            ASSERT_EQUALS( 5, runCount( ns(), fromjson( "{\"estimate\":true}" ), err, errCode ) );
+            ASSERT_EQUALS( 0, debug.nscanned );
+            ASSERT_EQUALS( 3, runCount( ns(), fromjson( "{\"estimate\":true,\"skip\":2}" ), err, errCode ) );
+            ASSERT_EQUALS( 2, runCount( ns(), fromjson( "{\"estimate\":true,\"limit\":2}" ), err, errCode ) );
+            ASSERT_EQUALS( 0, debug.nscanned );
+            // Without estimate the same count scans the collection.
+            ASSERT_EQUALS( 5, runCount( ns(), fromjson( "{\"query\":{}}" ), err, errCode ) );
+            ASSERT_EQUALS( 5, debug.nscanned );
+        }
+    };
+
     /** Set a value or await an expected value. */
     class PendingValue {
     public:
@@ -202,6 +253,8 @@ namespace CountTests {
             add<Fields>();
             add<QueryFields>();
             add<IndexedRegex>();
+            add<EstimateRange>();
+            add<EstimateAll>();
         }
     } myall;
     
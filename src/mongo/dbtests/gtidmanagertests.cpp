@@ -16,8 +16,12 @@
  */
 
 #include "pch.h"
+
+#include <boost/thread/thread.hpp>
+
 #include "dbtests.h"
 #include "mongo/db/gtid.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     class GTIDManagerTest {
@@ -181,9 +185,80 @@ namespace mongo {
             ASSERT(GTID::cmp(mgr._minUnappliedGTID, gtidUnapplied4) > 0);
         }
 
+        // Committers take a GTID, sometimes get descheduled before
+        // finishing it like a transaction writing the oplog would, and
+        // finish it, while a tailable cursor waits on the min live GTID.
+        static const int nCommitters = 32;
+        static const int nPerCommitter = 20000;
+
+        static void committer(GTIDManager *mgr) {
+            GTID last;
+            uint64_t ts;
+            uint64_t hash;
+            for (int i = 0; i < nPerCommitter; i++) {
+                GTID gtid;
+                mgr->getGTIDForPrimary(&gtid, &ts, &hash);
+                ASSERT(GTID::cmp(last, gtid) < 0);
+                if (i % 16 == 0) {
+                    boost::this_thread::yield();
+                    ASSERT(GTID::cmp(mgr->getMinLiveGTID(), gtid) <= 0);
+                }
+                mgr->noteLiveGTIDDone(gtid);
+                last = gtid;
+            }
+        }
+
+        static void tailer(GTIDManager *mgr, volatile bool *done) {
+            GTID last = mgr->getMinLiveGTID();
+            while (!*done) {
+                mgr->waitForDifferentMinLive(last, 10);
+                GTID minLive = mgr->getMinLiveGTID();
+                ASSERT(GTID::cmp(last, minLive) <= 0);
+                last = minLive;
+            }
+        }
+
+        void testConcurrentGTIDs() {
+            GTID lastGTID(1, 1);
+            GTIDManager mgr(lastGTID, 0, 0, 0);
+            mgr.catchUnappliedToLive();
+            mgr.resetManager();
+            mgr.verifyReadyToBecomePrimary();
+
+            volatile bool done = false;
+            boost::thread t(boost::bind(&GTIDManagerTest::tailer, &mgr, &done));
+
+            Timer timer;
+            vector<shared_ptr<boost::thread> > committers;
+            for (int i = 0; i < nCommitters; i++) {
+                committers.push_back(shared_ptr<boost::thread>(
+                        new boost::thread(boost::bind(&GTIDManagerTest::committer, &mgr))));
+            }
+            for (int i = 0; i < nCommitters; i++) {
+                committers[i]->join();
+            }
+            const long long micros = max((long long) timer.micros(), 1LL);
+            done = true;
+            t.join();
+
+            const long long n = (long long) nCommitters * nPerCommitter;
+            LOG(1) << "GTIDManager: " << n << " GTIDs from " << nCommitters << " threads in "
+                 << micros / 1000 << "ms, " << n * 1000000 / micros << "/s" << endl;
+
+            // everything is done, so the manager is as it would be with no writes
+            ASSERT(mgr.noLiveGTIDs());
+            mgr.verifyReadyToBecomePrimary();
+            ASSERT(mgr._lastLiveGTID._primarySeqNo == 2);
+            ASSERT(mgr._lastLiveGTID._GTSeqNo == (uint64_t) n - 1);
+            GTID next = mgr._lastLiveGTID;
+            next.inc();
+            ASSERT(GTID::cmp(mgr._minLiveGTID, next) == 0);
+        }
+
         void run() {
             GTIDtest();
             testGTIDManager();
+            testConcurrentGTIDs();
         }
     };
 }
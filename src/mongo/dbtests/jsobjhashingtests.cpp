@@ -24,6 +24,7 @@
 
 namespace JsobjHashingTests {
 
+    template <HashVersion version>
     class BSONElementHashingTest {
     public:
         void run() {
@@ -31,11 +32,11 @@ namespace JsobjHashingTests {
 
             //test different oids hash to different things
             long long int oidHash = BSONElementHasher::hash64(
-                    BSONObjBuilder().genOID().obj().firstElement() , seed );
+                    BSONObjBuilder().genOID().obj().firstElement() , seed , version );
             long long int oidHash2 = BSONElementHasher::hash64(
-                    BSONObjBuilder().genOID().obj().firstElement() , seed );
+                    BSONObjBuilder().genOID().obj().firstElement() , seed , version );
             long long int oidHash3 = BSONElementHasher::hash64(
-                    BSONObjBuilder().genOID().obj().firstElement() , seed );
+                    BSONObjBuilder().genOID().obj().firstElement() , seed , version );
 
             ASSERT_NOT_EQUALS( oidHash , oidHash2 );
             ASSERT_NOT_EQUALS( oidHash , oidHash3 );
@@ -44,53 +45,53 @@ namespace JsobjHashingTests {
             //test 32-bit ints, 64-bit ints, doubles hash to same thing
             int i = 3;
             BSONObj p1 = BSON("a" << i);
-            long long int intHash = BSONElementHasher::hash64( p1.firstElement() , seed );
+            long long int intHash = BSONElementHasher::hash64( p1.firstElement() , seed , version );
 
             long long int ilong = 3;
             BSONObj p2 = BSON("a" << ilong);
-            long long int longHash = BSONElementHasher::hash64( p2.firstElement() , seed );
+            long long int longHash = BSONElementHasher::hash64( p2.firstElement() , seed , version );
 
             double d = 3.1;
             BSONObj p3 = BSON("a" << d);
-            long long int doubleHash = BSONElementHasher::hash64( p3.firstElement() , seed );
+            long long int doubleHash = BSONElementHasher::hash64( p3.firstElement() , seed , version );
 
             ASSERT_EQUALS( intHash, longHash );
             ASSERT_EQUALS( doubleHash, longHash );
 
             //test different ints don't hash to same thing
             BSONObj p4 = BSON("a" << 4);
-            long long int intHash4 = BSONElementHasher::hash64( p4.firstElement() , seed );
+            long long int intHash4 = BSONElementHasher::hash64( p4.firstElement() , seed , version );
             ASSERT_NOT_EQUALS( intHash , intHash4 );
 
             //test seed makes a difference
-            long long int intHash4Seed = BSONElementHasher::hash64( p4.firstElement() , 1 );
+            long long int intHash4Seed = BSONElementHasher::hash64( p4.firstElement() , 1 , version );
             ASSERT_NOT_EQUALS( intHash4 , intHash4Seed );
 
             //test strings hash to different things
             BSONObj p5 = BSON("a" << "3");
-            long long int stringHash = BSONElementHasher::hash64( p5.firstElement() , seed );
+            long long int stringHash = BSONElementHasher::hash64( p5.firstElement() , seed , version );
             ASSERT_NOT_EQUALS( intHash , stringHash );
 
             //test regexps and strings hash to different things
             BSONObjBuilder b;
             b.appendRegex("a","3");
-            long long int regexHash = BSONElementHasher::hash64( b.obj().firstElement() , seed );
+            long long int regexHash = BSONElementHasher::hash64( b.obj().firstElement() , seed , version );
             ASSERT_NOT_EQUALS( stringHash , regexHash );
 
             //test arrays and subobject hash to different things
             BSONObj p6 = fromjson("{a : {'0' : 0 , '1' : 1}}");
             BSONObj p7 = fromjson("{a : [0,1]}");
             ASSERT_NOT_EQUALS(
-                    BSONElementHasher::hash64( p6.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p7.firstElement() , seed )
+                    BSONElementHasher::hash64( p6.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p7.firstElement() , seed , version )
             );
 
             //testing sub-document grouping
             BSONObj p8 = fromjson("{x : {a : {}, b : 1}}");
             BSONObj p9 = fromjson("{x : {a : {b : 1}}}");
             ASSERT_NOT_EQUALS(
-                    BSONElementHasher::hash64( p8.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p9.firstElement() , seed )
+                    BSONElementHasher::hash64( p8.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p9.firstElement() , seed , version )
             );
 
             //testing codeWscope scope squashing
@@ -104,28 +105,28 @@ namespace JsobjHashingTests {
             BSONObjBuilder b3;
             b3.appendCodeWScope("a","print('this is \nsome stupider code')", BSON("a" << 3));
             ASSERT_EQUALS(
-                    BSONElementHasher::hash64( p10.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( b2.obj().firstElement() , seed )
+                    BSONElementHasher::hash64( p10.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( b2.obj().firstElement() , seed , version )
             );
             ASSERT_NOT_EQUALS(
-                    BSONElementHasher::hash64( p10.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( b3.obj().firstElement() , seed )
+                    BSONElementHasher::hash64( p10.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( b3.obj().firstElement() , seed , version )
             );
 
             //test some recursive squashing
             BSONObj p11 = fromjson("{x : {a : 3 , b : [ 3.1, {c : 3}]}}");
             BSONObj p12 = fromjson("{x : {a : 3.1 , b : [3, {c : 3.0}]}}");
             ASSERT_EQUALS(
-                    BSONElementHasher::hash64( p11.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p12.firstElement() , seed )
+                    BSONElementHasher::hash64( p11.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p12.firstElement() , seed , version )
             );
 
             //test minkey and maxkey don't hash to same thing
             BSONObj p13 = BSON("a" << MAXKEY);
             BSONObj p14 = BSON("a" << MINKEY);
             ASSERT_NOT_EQUALS(
-                    BSONElementHasher::hash64( p13.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p14.firstElement() , seed )
+                    BSONElementHasher::hash64( p13.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p14.firstElement() , seed , version )
             );
 
             //test squashing very large doubles and very small doubles
@@ -136,12 +137,12 @@ namespace JsobjHashingTests {
             BSONObj p16 = BSON("a" << smallerDouble );
             BSONObj p17 = BSON("a" << biggerDouble );
             ASSERT_NOT_EQUALS(
-                    BSONElementHasher::hash64( p15.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p16.firstElement() , seed )
+                    BSONElementHasher::hash64( p15.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p16.firstElement() , seed , version )
             );
             ASSERT_EQUALS(
-                    BSONElementHasher::hash64( p15.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p17.firstElement() , seed )
+                    BSONElementHasher::hash64( p15.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p17.firstElement() , seed , version )
             );
 
             long long minInt = std::numeric_limits<long long>::min();
@@ -149,8 +150,8 @@ namespace JsobjHashingTests {
             BSONObj p18 = BSON("a" << minInt );
             BSONObj p19 = BSON("a" << negativeDouble );
             ASSERT_EQUALS(
-                    BSONElementHasher::hash64( p18.firstElement() , seed ) ,
-                    BSONElementHasher::hash64( p19.firstElement() , seed )
+                    BSONElementHasher::hash64( p18.firstElement() , seed , version ) ,
+                    BSONElementHasher::hash64( p19.firstElement() , seed , version )
             );
 
         }
@@ -162,7 +163,8 @@ namespace JsobjHashingTests {
         }
 
         void setupTests() {
-            add< BSONElementHashingTest >();
+            add< BSONElementHashingTest<HASH_VERSION_MD5> >();
+            add< BSONElementHashingTest<HASH_VERSION_MURMUR3> >();
         }
     } myall;
 
@@ -1553,6 +1553,147 @@ namespace JsonTests {
 
     } // namespace FromJsonTests
 
+    namespace FastParseTests {
+
+        /**
+         * Checks that fromjsonFast either declines the input or produces exactly what JParse
+         * produces.
+         */
+        void checkAgainstJParse( const string& json, bool expectFast ) {
+            BSONObjBuilder fastBuilder;
+            int fastLen = -1;
+            bool fast = fromjsonFast( json.c_str(), fastBuilder, &fastLen );
+            ASSERT_EQUALS( expectFast, fast );
+            if ( !fast ) {
+                return;
+            }
+            JParse jparse( json.c_str() );
+            BSONObjBuilder jparseBuilder;
+            ASSERT_OK( jparse.object( "UNUSED", jparseBuilder, false ) );
+            BSONObj fastObj = fastBuilder.obj();
+            BSONObj jparseObj = jparseBuilder.obj();
+            ASSERT_EQUALS( jparse.offset(), fastLen );
+            ASSERT_EQUALS( jparseObj.objsize(), fastObj.objsize() );
+            ASSERT( memcmp( jparseObj.objdata(), fastObj.objdata(), fastObj.objsize() ) == 0 );
+        }
+
+        class Handled {
+        public:
+            void run() {
+                const char* cases[] = {
+                    "{}",
+                    " \n\t{ } ",
+                    "{ \"a\" : 1 , \"b\" : \"x\" }",
+                    "{ \"a\" : [], \"b\" : [ ], \"c\" : [ 1, 2.5, -3, 2147483648 ] }",
+                    "{ \"a\" : { \"b\" : { \"c\" : [ {}, [], true, false, null ] } } }",
+                    "{ \"a\" : -Infinity, \"b\" : +5, \"c\" : .5, \"d\" : 0x1F, \"e\" : 1e5 }",
+                    "{ \"a\" : \"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\v \\q\" }",
+                    "{ \"a\" : \"\\u0041\\u00e9\\u20ac\\u0000\" }",
+                    "{ \"\\\"{}[]:,\" : \"{}[]:, a value long enough to span several blocks\" }",
+                    "{ \"a\" : { \"$oid\" : \"deadbeefdeadbeefdeadbeef\" } }",
+                    "{ \"a\" : { \"$date\" : 123 }, \"b\" : 2 }",
+                    "{ \"a\" : { \"$timestamp\" : { \"t\" : 1, \"i\" : 2 } } }",
+                    "{ \"a\" : { \"$regex\" : \"x{\", \"$options\" : \"i\" } }",
+                    "{ \"a\" : { \"$binary\" : \"YWJj\", \"$type\" : \"00\" } }",
+                    "{ \"a\" : { \"$ref\" : \"c\", \"$id\" : ObjectId( \"deadbeefdeadbeefdeadbeef\" ) } }",
+                    "{ \"a\" : { \"$undefined\" : true } }",
+                    "{ \"a\" : { \"$set\" : 1 } }",
+                    "{ \"a\" : 1 } trailing text is not looked at",
+                };
+                for ( size_t i = 0; i < sizeof( cases ) / sizeof( *cases ); ++i ) {
+                    // Vary alignment, the first stage reads aligned 16 byte blocks.
+                    for ( int pad = 0; pad < 16; ++pad ) {
+                        checkAgainstJParse( string( pad, ' ' ) + cases[ i ], true );
+                    }
+                }
+            }
+        };
+
+        class FallsBack {
+        public:
+            void run() {
+                const char* cases[] = {
+                    "",
+                    "[ 1 ]",
+                    "{ a : 1 }",
+                    "{ 'a' : 1 }",
+                    "{ \"a\" : 'x' }",
+                    "{ \"a\" : NaN }",
+                    "{ \"a\" : Infinity }",
+                    "{ \"a\" : undefined }",
+                    "{ \"a\" : ObjectId( \"deadbeefdeadbeefdeadbeef\" ) }",
+                    "{ \"a\" : new Date( 5 ) }",
+                    "{ \"a\" : /x/i }",
+                    "{ \"$oid\" : \"deadbeefdeadbeefdeadbeef\" }",
+                    "{ \"a\" : { \"$date\" : \"x\" } }",
+                    "{ \"a\" : \"\\x41\" }",
+                    "{ \"a\" : \"\\1\" }",
+                    "{ \"a\" : \"\\u004\" }",
+                    "{ \"a\" : \"\x1f\" }",
+                    "{ \"a\" : 1e400 }",
+                    "{ \"a\" : truex }",
+                    "{ \"a\" : 1",
+                    "{ \"a\" 1 }",
+                    "{ \"a\" : 1 \"b\" : 2 }",
+                    "{ \"a\" : [ 1, ] }",
+                    "{ \"a\" : [ 1 2 ] }",
+                    "{ \"a\" : 1, }",
+                    "{ \"a\" : \"unterminated }",
+                };
+                for ( size_t i = 0; i < sizeof( cases ) / sizeof( *cases ); ++i ) {
+                    checkAgainstJParse( cases[ i ], false );
+                }
+            }
+        };
+
+        class RoundTrip {
+        public:
+            void run() {
+                BSONObjBuilder b;
+                b.append( "int", 5 );
+                b.append( "long", 1LL << 40 );
+                b.append( "double", 2.5 );
+                b.append( "string", "\" \\ / \b \f \n \r \t \x01 {}[]:, \xe2\x82\xac" );
+                b.append( "oid", OID( "deadbeefdeadbeefdeadbeef" ) );
+                b.appendDate( "date", Date_t( 1257829200000LL ) );
+                b.appendTimestamp( "ts", 1000ULL * 5, 7 );
+                b.appendRegex( "regex", "ab\"c/", "i" );
+                b.appendBinData( "bin", 3, BinDataGeneral, "abc" );
+                b.appendNull( "null" );
+                b.append( "bool", true );
+                b.append( "obj", BSON( "a" << BSON_ARRAY( 1 << BSON( "b" << "c" ) ) ) );
+                BSONObj o = b.obj();
+                string json = o.jsonString( Strict );
+                checkAgainstJParse( json, true );
+                ASSERT_EQUALS( o, fromjson( json ) );
+            }
+        };
+
+        /**
+         * Mutates valid JSON and checks that fromjsonFast never disagrees with JParse.
+         */
+        class Mutations {
+        public:
+            void run() {
+                string json = fromjson( "{ \"a\" : 1, \"b\" : [ \"x\\\"y\", { \"c\" : null } ],"
+                                        " \"d\" : { \"$oid\" : \"deadbeefdeadbeefdeadbeef\" } }" )
+                              .jsonString( Strict );
+                const char replacements[] = "{}[]:,\"\\ a1'";
+                for ( size_t i = 0; i < json.size(); ++i ) {
+                    for ( size_t j = 0; j < sizeof( replacements ) - 1; ++j ) {
+                        string mutated = json;
+                        mutated[ i ] = replacements[ j ];
+                        BSONObjBuilder unused;
+                        checkAgainstJParse( mutated,
+                                            fromjsonFast( mutated.c_str(), unused ) );
+                    }
+                    checkAgainstJParse( json.substr( 0, i ), false );
+                }
+            }
+        };
+
+    } // namespace FastParseTests
+
     class All : public Suite {
     public:
         All() : Suite( "json" ) {
@@ -1691,6 +1832,10 @@ namespace JsonTests {
             add< FromJsonTests::EmbeddedDatesFormat3 >();
             add< FromJsonTests::NullString >();
             add< FromJsonTests::NullFieldUnquoted >();
+            add< FastParseTests::Handled >();
+            add< FastParseTests::FallsBack >();
+            add< FastParseTests::RoundTrip >();
+            add< FastParseTests::Mutations >();
         }
     } myall;
 
@@ -64,6 +64,19 @@ namespace NamespaceTests {
             }
             void _getKeysFromObject( const BSONObj &obj, BSONObjSet &keys ) {
                 idx().getKeysFromObject( obj, keys );
+
+                // The write path generates the same keys, already encoded.
+                storage::KeyArray encoded;
+                idx().getKeysFromObject( obj, BSON( "" << 1 ), encoded );
+                BSONObjSet decoded;
+                for ( size_t i = 0; i < encoded.size(); ++i ) {
+                    decoded.insert( encoded.key( i ) );
+                }
+                ASSERT_EQUALS( keys.size(), encoded.size() );
+                ASSERT_EQUALS( keys.size(), decoded.size() );
+                for ( BSONObjSet::const_iterator i = keys.begin(), j = decoded.begin(); i != keys.end(); ++i, ++j ) {
+                    assertEquals( *i, *j );
+                }
             }
             BSONObj aDotB() const {
                 BSONObjBuilder k;
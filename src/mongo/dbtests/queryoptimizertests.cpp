@@ -1389,6 +1389,47 @@ namespace QueryOptimizerTests {
             }
         };
 
+        /** A query on fields of two indexes races a plan intersecting them, when enabled. */
+        class IntersectionPlan : public Base {
+        public:
+            IntersectionPlan() : _old( queryIndexIntersection ) {
+                queryIndexIntersection = true;
+            }
+            ~IntersectionPlan() {
+                queryIndexIntersection = _old;
+            }
+            void run() {
+                ensureIndex( ns(), BSON( "a" << 1 ), false, "a_1" );
+                ensureIndex( ns(), BSON( "b" << 1 ), false, "b_1" );
+                for ( int i = 0; i < 100; ++i ) {
+                    BSONObj o = BSON( "_id" << i << "a" << i % 10 << "b" << i % 7 );
+                    insertObject( ns(), o );
+                }
+                BSONObj query = BSON( "a" << 3 << "b" << 4 );
+
+                shared_ptr<QueryPlanSet> qps = makeQps( query );
+                ASSERT_EQUALS( 3, qps->nPlans() );
+                shared_ptr<QueryPlan> plan = qps->plans()[ 2 ];
+                ASSERT( plan->intersectPlan() );
+                ASSERT_EQUALS( fromjson( "{$intersect:[{a:1},{b:1}]}" ), plan->planKey() );
+
+                // Only _id 53 has a:3 and b:4, the other a:3 documents aren't fetched.
+                shared_ptr<Cursor> c = plan->newCursor();
+                ASSERT( c->ok() );
+                ASSERT_EQUALS( 53, c->current()[ "_id" ].numberInt() );
+                ASSERT( !c->advance() );
+
+                // A recorded intersection is used again.
+                plan->registerSelf( 1, CandidatePlanCharacter( true, false ) );
+                qps = makeQps( query );
+                ASSERT( qps->usingCachedPlan() );
+                ASSERT_EQUALS( 1, qps->nPlans() );
+                ASSERT( qps->firstPlan()->intersectPlan() );
+            }
+        private:
+            bool _old;
+        };
+
         /** Special plans are only selected when allowed. */
         class AllowSpecial : public Base {
         public:
@@ -1693,6 +1734,7 @@ namespace QueryOptimizerTests {
             add<QueryPlanSetTests::PossiblePlans>();
             add<QueryPlanSetTests::AvoidUnhelpfulRecordedPlan>();
             add<QueryPlanSetTests::AvoidDisallowedRecordedPlan>();
+            add<QueryPlanSetTests::IntersectionPlan>();
             // TokuMX: no geo
             //add<QueryPlanSetTests::AllowSpecial>();
             add<MultiPlanScannerTests::ToString>();
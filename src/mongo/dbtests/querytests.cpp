@@ -1446,8 +1446,9 @@ namespace QueryTests {
         
         class TestableScanAndOrder : public ScanAndOrder {
         public:
-            TestableScanAndOrder(int startFrom, int limit, BSONObj order, const FieldRangeSet &frs)
-            : ScanAndOrder( startFrom, limit, order, frs ) {
+            TestableScanAndOrder(int startFrom, int limit, BSONObj order, const FieldRangeSet &frs,
+                                 Collection *cl = NULL)
+            : ScanAndOrder( startFrom, limit, order, frs, cl ) {
             }
             unsigned approxSize() const { return ScanAndOrder::approxSize(); }
         };
@@ -1500,6 +1501,36 @@ namespace QueryTests {
                 assertNumFilled( 1, t );
             }
         };
+
+        /** Large documents are kept by primary key and fetched again by fill(). */
+        class FetchByPK : public QueryTests::Base {
+        public:
+            void run() {
+                const string big( 2000, 'x' );
+                for ( int i = 0; i < 10; ++i ) {
+                    insert( BSON( "_id" << i << "a" << 10 - i << "big" << big ) );
+                }
+                Collection *cl = getCollection( ns() );
+                FieldRangeSet frs( ns(), BSONObj(), true, true );
+                Testable t( 1, 2, BSON( "a" << 1 ), frs, cl );
+                for ( shared_ptr<Cursor> c( BasicCursor::make( cl ) ); c->ok(); c->advance() ) {
+                    t.add( c->current(), c->currPK() );
+                }
+                ASSERT_EQUALS( 3, t.size() );
+                ASSERT( t.approxSize() < big.size() );
+
+                BufBuilder bb;
+                int nout;
+                t.fill( bb, 0, nout );
+                ASSERT_EQUALS( 2, nout );
+                BSONObj first( bb.buf() );
+                BSONObj second( bb.buf() + first.objsize() );
+                ASSERT_EQUALS( 2, first[ "a" ].numberInt() );
+                ASSERT_EQUALS( 8, first[ "_id" ].numberInt() );
+                ASSERT_EQUALS( big, first[ "big" ].String() );
+                ASSERT_EQUALS( 3, second[ "a" ].numberInt() );
+            }
+        };
         
     } // namespace ScanAndOrderTests
 
@@ -1569,6 +1600,7 @@ namespace QueryTests {
             
             add< ScanAndOrderTests::Unlimited >();
             add< ScanAndOrderTests::LimitOne >();
+            add< ScanAndOrderTests::FetchByPK >();
         }
     } myall;
 
@@ -584,6 +584,26 @@ namespace mongo_test {
         ASSERT(!host.empty());
     }
 
+    TEST(ReplSetMonitorReadPref, NearestAllFar) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[1].addr;
+
+        // none is within the threshold, but a is the nearest
+        nodes[0].pingTimeMillis = 100;
+        nodes[1].pingTimeMillis = 300;
+        nodes[2].pingTimeMillis = 200;
+
+        bool isPrimarySelected = false;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_Nearest, &tags, 15, &lastHost,
+            &isPrimarySelected);
+
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("a", host.host());
+    }
+
     TEST(ReplSetMonitorReadPref, PriOnlyWithTagsNoMatch) {
         vector<ReplicaSetMonitor::Node> nodes =
                 NodeSetFixtures::getThreeMemberWithTags();
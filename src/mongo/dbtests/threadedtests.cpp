@@ -33,6 +33,9 @@
 #include "dbtests.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/snapshot_ptr.h"
+#include "mongo/util/immutable_string_map.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo { 
     void testNonGreedy();
@@ -920,6 +923,85 @@ namespace ThreadedTests {
 
     };
 
+    // Looks up namespaces the way CollectionMap::getCollection() used to, in a shared lock.
+    class LockedNsLookup {
+    public:
+        LockedNsLookup() : _lock( "LockedNsLookup" ) {}
+        static const char *name() { return "SimpleRWLock"; }
+        void add( const string &ns, int *value ) {
+            SimpleRWLock::Exclusive lk( _lock );
+            _map[ ns ] = value;
+        }
+        int *find( const StringData &ns ) {
+            SimpleRWLock::Shared lk( _lock );
+            StringMap<int *>::const_iterator it = _map.find( ns );
+            return it == _map.end() ? NULL : it->second;
+        }
+    private:
+        SimpleRWLock _lock;
+        StringMap<int *> _map;
+    };
+
+    // Looks up namespaces the way CollectionMap::getCollection() does, in a SnapshotPtr.
+    class SnapshotNsLookup {
+    public:
+        SnapshotNsLookup() : _map( new ImmutableStringMap<int *>() ) {}
+        static const char *name() { return "SnapshotPtr"; }
+        void add( const string &ns, int *value ) {
+            _map.replace( new ImmutableStringMap<int *>( _map.current().set( ns, value ) ) );
+        }
+        int *find( const StringData &ns ) {
+            SnapshotPtr< ImmutableStringMap<int *> >::Reader r( _map );
+            int *const *p = r->find( ns );
+            return p == NULL ? NULL : *p;
+        }
+    private:
+        SnapshotPtr< ImmutableStringMap<int *> > _map;
+    };
+
+    // Namespace lookups from many threads at once, as every operation does one.  Reports the
+    // total throughput, which should grow with the number of cores for SnapshotPtr.
+    template <class Lookup>
+    class NsLookupScalability : public ThreadedTest<64> {
+    public:
+        NsLookupScalability() : _lookups( 0 ), _misses( 0 ) {}
+    private:
+        enum { NNamespaces = 100, Millis = 500 };
+        Lookup _lookup;
+        vector<string> _namespaces;
+        int _values[ NNamespaces ];
+        AtomicWord<long long> _lookups;
+        AtomicWord<long long> _misses;
+
+        virtual void setup() {
+            for ( int i = 0; i < NNamespaces; i++ ) {
+                _namespaces.push_back( str::stream() << "test.collection" << i );
+                _lookup.add( _namespaces.back(), &_values[ i ] );
+            }
+        }
+        virtual void subthread( int x ) {
+            long long lookups = 0;
+            long long misses = 0;
+            Timer t;
+            while ( t.millis() < Millis ) {
+                for ( int i = 0; i < 1000; i++ ) {
+                    const int n = ( x + i ) % NNamespaces;
+                    if ( _lookup.find( _namespaces[ n ] ) != &_values[ n ] ) {
+                        misses++;
+                    }
+                }
+                lookups += 1000;
+            }
+            _lookups.fetchAndAdd( lookups );
+            _misses.fetchAndAdd( misses );
+        }
+        virtual void validate() {
+            ASSERT_EQUALS( 0, _misses.load() );
+            log() << Lookup::name() << ": " << _lookups.load() * 1000 / Millis
+                  << " ns lookups/sec with " << nthreads << " threads" << endl;
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "threading" ) { }
@@ -956,6 +1038,8 @@ namespace ThreadedTests {
 
             add< MongoMutexTest >();
             add< TicketHolderWaits >();
+            add< NsLookupScalability<LockedNsLookup> >();
+            add< NsLookupScalability<SnapshotNsLookup> >();
         }
     } myall;
 }
@@ -1791,6 +1791,52 @@ namespace UpdateTests {
             }
         };
 
+        // $inc and $set that keep the field's type and size patch a copy of the object,
+        // which keeps its field order. Anything else rebuilds it in field name order.
+        class inPlace : public Base {
+        public:
+            void run() {
+                BSONObj in = fromjson( "{z:1,y:{b:2.5,a:'abc'},x:[1,2],w:true}" );
+                test( fromjson( "{$inc:{z:1,'y.b':1}}" ) , in ,
+                      fromjson( "{z:2,y:{b:3.5,a:'abc'},x:[1,2],w:true}" ) );
+                test( fromjson( "{$set:{'y.a':'xyz','x.1':7,w:false}}" ) , in ,
+                      fromjson( "{z:1,y:{b:2.5,a:'xyz'},x:[1,7],w:false}" ) );
+                test( fromjson( "{$inc:{z:1},$setOnInsert:{v:1}}" ) , in ,
+                      fromjson( "{z:2,y:{b:2.5,a:'abc'},x:[1,2],w:true}" ) );
+                // the input object is left alone
+                ASSERT_EQUALS( fromjson( "{z:1,y:{b:2.5,a:'abc'},x:[1,2],w:true}" ) , in );
+
+                // new fields get the object rebuilt
+                test( fromjson( "{$inc:{z:1,v:1}}" ) , in ,
+                      fromjson( "{v:1,w:true,x:[1,2],y:{b:2.5,a:'abc'},z:2}" ) );
+            }
+        };
+
+        class withDamages : public Base {
+        public:
+            void run() {
+                BSONObj in = fromjson( "{z:1,y:{b:2.5,a:'abc'},x:[1,2],w:true}" );
+                // type or size changes of existing fields
+                test( fromjson( "{$inc:{z:1.5}}" ) , in ,
+                      fromjson( "{z:2.5,y:{b:2.5,a:'abc'},x:[1,2],w:true}" ) );
+                test( BSON( "$inc" << BSON( "z" << 2147483647 ) ) , in ,
+                      BSON( "z" << 2147483648LL << "y" << BSON( "b" << 2.5 << "a" << "abc" ) <<
+                            "x" << BSON_ARRAY( 1 << 2 ) << "w" << true ) );
+                test( fromjson( "{$set:{'y.a':'ab','x.1':{c:[3]}}}" ) , in ,
+                      fromjson( "{z:1,y:{b:2.5,a:'ab'},x:[1,{c:[3]}],w:true}" ) );
+                test( fromjson( "{$unset:{'y.b':1},$set:{w:'abc'}}" ) , in ,
+                      fromjson( "{z:1,y:{a:'abc'},x:[1,2],w:'abc'}" ) );
+                test( fromjson( "{$inc:{z:1},$push:{x:3}}" ) , in ,
+                      fromjson( "{z:2,y:{b:2.5,a:'abc'},x:[1,2,3],w:true}" ) );
+                // the input object is left alone
+                ASSERT_EQUALS( fromjson( "{z:1,y:{b:2.5,a:'abc'},x:[1,2],w:true}" ) , in );
+
+                // an $unset in an array leaves a null, so the object is rebuilt
+                test( fromjson( "{$unset:{'x.0':1}}" ) , in ,
+                      fromjson( "{w:true,x:[null,2],y:{b:2.5,a:'abc'},z:1}" ) );
+            }
+        };
+
         class PositionalWithoutElemMatchKey {
         public:
             void run() {
@@ -2215,6 +2261,8 @@ namespace UpdateTests {
             add< ModSetTests::inc2 >();
             add< ModSetTests::set1 >();
             add< ModSetTests::push1 >();
+            add< ModSetTests::inPlace >();
+            add< ModSetTests::withDamages >();
 
             add< ModSetTests::PositionalWithoutElemMatchKey >();
             add< ModSetTests::PositionalWithoutNestedElemMatchKey >();
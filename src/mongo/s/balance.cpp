@@ -19,6 +19,8 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
 #include "mongo/db/cmdline.h"
@@ -26,6 +28,7 @@
 #include "mongo/s/chunk.h"
 #include "mongo/s/config.h"
 #include "mongo/s/config_server_checker_service.h"
+#include "mongo/s/field_parser.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/server.h"
 #include "mongo/s/shard.h"
@@ -45,75 +48,105 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
-    int Balancer::_moveChunks( const vector<CandidateChunkPtr>* candidateChunks ) {
-        int movedCount = 0;
-
-        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+    int Balancer::_moveChunk( const CandidateChunk& chunkInfo ) {
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
                 verify( cm );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
                 if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
-
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
-                }
-
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to), res)) {
-                    movedCount++;
-                    continue;
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return 0;
                 }
+            }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to), res)) {
+                return 1;
+            }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
 
-                    log() << "forcing a split because migrate failed for size reasons" << endl;
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
 
-                    res = BSONObj();
-                    c->singleSplit( true , res );
-                    log() << "forced split results: " << res << endl;
+                log() << "forcing a split because migrate failed for size reasons" << endl;
 
-                    if ( ! res["ok"].trueValue() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+                res = BSONObj();
+                c->singleSplit( true , res );
+                log() << "forced split results: " << res << endl;
 
+                if ( ! res["ok"].trueValue() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we increment moveCount so we do another round right away
+                    return 1;
                 }
+
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
+
+        return 0;
+    }
+
+    void Balancer::_moveChunkThread( const CandidateChunk* chunkInfo, int* moved ) {
+        setThreadName( "BalancerMigrate" );
+        try {
+            *moved = _moveChunk( *chunkInfo );
+        }
+        catch ( std::exception& e ) {
+            warning() << "could not move chunk " << chunkInfo->chunk.toString() << causedBy( e ) << endl;
+        }
+    }
+
+    int Balancer::_moveChunks( const vector<CandidateChunkPtr>* candidateChunks, bool concurrently ) {
+        int movedCount = 0;
+
+        if ( ! concurrently || candidateChunks->size() < 2 ) {
+            for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+                movedCount += _moveChunk( *it->get() );
             }
+            return movedCount;
         }
 
+        // The candidates don't share shards or collections (see BalancerPolicy::balanceConcurrent), so their
+        // migrations don't wait on each other.
+        LOG(1) << "running " << candidateChunks->size() << " migrations concurrently" << endl;
+        vector<int> moved( candidateChunks->size(), 0 );
+        boost::thread_group threads;
+        for ( size_t i = 0; i < candidateChunks->size(); i++ ) {
+            threads.create_thread( boost::bind( &Balancer::_moveChunkThread, this,
+                                                (*candidateChunks)[i].get(), &moved[i] ) );
+        }
+        threads.join_all();
+
+        for ( size_t i = 0; i < moved.size(); i++ ) {
+            movedCount += moved[i];
+        }
         return movedCount;
     }
 
@@ -183,7 +216,10 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    int maxMigrations,
+                                    int maxShardLoad,
+                                    vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
         //
@@ -238,7 +274,8 @@ namespace mongo {
                                                   s.isDraining(),
                                                   status.hasOpsQueued(),
                                                   s.tags(),
-                                                  status.mongoVersion()
+                                                  status.mongoVersion(),
+                                                  status.load()
                                                   );
         }
 
@@ -246,12 +283,19 @@ namespace mongo {
 
         //
         // 3. For each collection, check if the balancing policy recommends moving anything around.
+        // When migrations run concurrently, the policy looks at all collections at once, after
+        // the loop, so their distributions are kept until then.
         //
 
+        vector< shared_ptr<ShardToChunksMap> > allShardToChunks;
+        vector< shared_ptr<DistributionStatus> > allStatus;
+        map<string, DistributionStatus*> distributions;
+
         for (vector<string>::const_iterator it = collections.begin(); it != collections.end(); ++it ) {
             const string& ns = *it;
 
-            map< string,vector<BSONObj> > shardToChunksMap;
+            shared_ptr<ShardToChunksMap> shardToChunksPtr( new ShardToChunksMap() );
+            ShardToChunksMap& shardToChunksMap = *shardToChunksPtr;
             cursor = conn.query(ChunkType::ConfigNS,
                                 QUERY(ChunkType::ns(ns)).sort(ChunkType::min()));
 
@@ -276,7 +320,8 @@ namespace mongo {
                 shardToChunksMap[s.getName()].size();
             }
 
-            DistributionStatus status( shardInfo, shardToChunksMap );
+            shared_ptr<DistributionStatus> statusPtr( new DistributionStatus( shardInfo, shardToChunksMap ) );
+            DistributionStatus& status = *statusPtr;
 
             // load tags
             conn.ensureIndex(TagsType::ConfigNS,
@@ -350,9 +395,25 @@ namespace mongo {
                 continue;
             }
 
+            if ( maxMigrations > 1 ) {
+                allShardToChunks.push_back( shardToChunksPtr );
+                allStatus.push_back( statusPtr );
+                distributions[ns] = statusPtr.get();
+                continue;
+            }
+
             CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
             if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
         }
+
+        if ( ! distributions.empty() ) {
+            vector<MigrateInfo*> migrations;
+            _policy->balanceConcurrent( distributions, _balancedLastTime,
+                                        maxMigrations, maxShardLoad, &migrations );
+            for ( unsigned i = 0; i < migrations.size(); i++ ) {
+                candidateChunks->push_back( CandidateChunkPtr( migrations[i] ) );
+            }
+        }
     }
 
     bool Balancer::_init() {
@@ -440,6 +501,18 @@ namespace mongo {
 
                 sleepTime = balancerConfig[SettingsType::shortBalancerSleep()].trueValue() ? 30 :
                                                                                              6;
+
+                int maxMigrations;
+                int maxShardLoad;
+                if ( FieldParser::extractNumber( balancerConfig, SettingsType::maxConcurrentMigrations,
+                                                 &maxMigrations ) == FieldParser::FIELD_INVALID ||
+                     maxMigrations < 1 ) {
+                    maxMigrations = 1;
+                }
+                if ( FieldParser::extractNumber( balancerConfig, SettingsType::migrationMaxShardLoad,
+                                                 &maxShardLoad ) == FieldParser::FIELD_INVALID ) {
+                    maxShardLoad = 0;
+                }
                 
                 uassert( 13258 , "oids broken after resetting!" , _checkOIDs() );
 
@@ -467,13 +540,13 @@ namespace mongo {
                     LOG(1) << "*** start balancing round" << endl;
 
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , maxMigrations , maxShardLoad , &candidateChunks );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
                     }
                     else {
-                        _balancedLastTime = _moveChunks(&candidateChunks);
+                        _balancedLastTime = _moveChunks( &candidateChunks , maxMigrations > 1 );
                     }
                     
                     LOG(1) << "*** end of balancing round" << endl;
@@ -35,6 +35,9 @@ namespace mongo {
      * The balancer does act continuously but in "rounds". At a given round, it would decide if there is an imbalance by
      * checking the difference in chunks between the most and least loaded shards. It would issue a request for a chunk
      * migration per round, if it found so.
+     *
+     * If the balancer settings allow more than one concurrent migration (_maxConcurrentMigrations), a round instead
+     * picks up to that many migrations between disjoint pairs of shards, and runs them at the same time.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -77,17 +80,34 @@ namespace mongo {
          * be moved.
          *
          * @param conn is the connection with the config server(s)
+         * @param maxMigrations if more than 1, candidates are chosen with BalancerPolicy::balanceConcurrent and can
+         *        be moved concurrently
+         * @param maxShardLoad shards busier than this aren't used for concurrent migrations, 0 is unlimited
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
          */
-        void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
+        void _doBalanceRound( DBClientBase& conn,
+                              int maxMigrations,
+                              int maxShardLoad,
+                              vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests, one at a time or, for candidates that don't share shards, all at once.
          *
          * @param candidateChunks possible chunks to move
+         * @param concurrently true to run all the migrations at the same time
          * @return number of chunks effectively moved
          */
-        int _moveChunks( const vector<CandidateChunkPtr>* candidateChunks );
+        int _moveChunks( const vector<CandidateChunkPtr>* candidateChunks, bool concurrently );
+
+        /**
+         * Issues one chunk migration request, and splits or marks the chunk as jumbo if it was too big to move.
+         *
+         * @return 1 if the chunk was moved or marked as jumbo, 0 otherwise
+         */
+        int _moveChunk( const CandidateChunk& chunkInfo );
+
+        /** Body of the threads of a concurrent round, runs _moveChunk and stores its result in moved. */
+        void _moveChunkThread( const CandidateChunk* chunkInfo, int* moved );
 
         /**
          * Marks this balancer as being live on the config server(s).
@@ -92,6 +92,11 @@ namespace mongo {
                 LOG(1) << i->first << " has writebacks queued." << endl;
                 continue;
             }
+
+            if ( isExcluded( i->first ) ) {
+                LOG(1) << i->first << " is busy with another migration." << endl;
+                continue;
+            }
             
             if ( ! i->second.hasTag( tag ) ) {
                 LOG(1) << i->first << " doesn't have right tag" << endl;
@@ -121,6 +126,9 @@ namespace mongo {
                 // we can't move stuff off anyway
                 continue;
             }
+
+            if ( isExcluded( i->first ) )
+                continue;
             
             unsigned myChunks = numberOfChunksInShardWithTag( i->first, tag );
             if ( myChunks <= maxChunks )
@@ -245,6 +253,9 @@ namespace mongo {
                 
                 if ( distribution.numberOfChunksInShard( shard ) == 0 )
                     continue;
+
+                if ( distribution.isExcluded( shard ) )
+                    continue;
                 
                 // now we know we need to move to chunks off this shard
                 // we will if we are allowed
@@ -294,6 +305,9 @@ namespace mongo {
             for ( set<string>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
                 string shard = *i;
                 const ShardInfo& info = distribution.shardInfo( shard );
+
+                if ( distribution.isExcluded( shard ) )
+                    continue;
                 
                 const vector<BSONObj>& chunks = distribution.getChunks( shard );
                 for ( unsigned j = 0; j < chunks.size(); j++ ) {
@@ -406,24 +420,79 @@ namespace mongo {
         return NULL;
     }
 
+    void BalancerPolicy::balanceConcurrent( const map<string, DistributionStatus*>& distributions,
+                                            int balancedLastTime,
+                                            int maxMigrations,
+                                            int maxShardLoad,
+                                            vector<MigrateInfo*>* migrations ) {
+        verify( migrations );
+
+        // shards that are too busy, or that a move picked already
+        set<string> busy;
+        if ( maxShardLoad > 0 ) {
+            for ( map<string, DistributionStatus*>::const_iterator i = distributions.begin();
+                  i != distributions.end();
+                  ++i ) {
+                const set<string>& shards = i->second->shards();
+                for ( set<string>::const_iterator j = shards.begin(); j != shards.end(); ++j ) {
+                    if ( i->second->shardInfo( *j ).getLoad() > maxShardLoad &&
+                         busy.insert( *j ).second ) {
+                        log() << "not migrating chunks to or from " << *j
+                              << " this round, its load is "
+                              << i->second->shardInfo( *j ).getLoad() << endl;
+                    }
+                }
+            }
+        }
+
+        // randomize the order in which we balance the collections, for the same reason as tags
+        vector<string> namespaces;
+        for ( map<string, DistributionStatus*>::const_iterator i = distributions.begin();
+              i != distributions.end();
+              ++i )
+            namespaces.push_back( i->first );
+        std::random_shuffle( namespaces.begin(), namespaces.end() );
+
+        for ( unsigned i = 0; i < namespaces.size(); i++ ) {
+            if ( migrations->size() >= static_cast<size_t>( maxMigrations ) )
+                break;
+
+            const string& ns = namespaces[i];
+            DistributionStatus* distribution = distributions.find( ns )->second;
+            for ( set<string>::const_iterator j = busy.begin(); j != busy.end(); ++j )
+                distribution->excludeShard( *j );
+
+            MigrateInfo* m = balance( ns, *distribution, balancedLastTime );
+            if ( ! m )
+                continue;
+
+            busy.insert( m->from );
+            busy.insert( m->to );
+            migrations->push_back( m );
+        }
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining, bool opsQueued,
                           const set<string>& tags,
-                          const string& mongoVersion )
+                          const string& mongoVersion,
+                          int load )
         : _maxSize( maxSize ),
           _currSize( currSize ),
           _draining( draining ),
           _hasOpsQueued( opsQueued ),
           _tags( tags ),
-          _mongoVersion( mongoVersion ) {
+          _mongoVersion( mongoVersion ),
+          _load( load ) {
     }
 
     ShardInfo::ShardInfo()
         : _maxSize( 0 ), 
           _currSize( 0 ),
           _draining( false ),
-          _hasOpsQueued( false ) {
+          _hasOpsQueued( false ),
+          _load( 0 ) {
     }
 
     void ShardInfo::addTag( const string& tag ) {
@@ -456,6 +525,7 @@ namespace mongo {
                 ss << *i << ",";
         }
         ss << " version: " << _mongoVersion;
+        ss << " load: " << _load;
         return ss.str();
     }
 
@@ -59,7 +59,8 @@ namespace mongo {
         ShardInfo( long long maxSize, long long currSize, 
                    bool draining, bool opsQueued, 
                    const set<string>& tags = set<string>(),
-                   const string& _mongoVersion = string("") );
+                   const string& _mongoVersion = string(""),
+                   int load = 0 );
 
         void addTag( const string& tag );
 
@@ -90,6 +91,9 @@ namespace mongo {
 
         string getMongoVersion() const { return _mongoVersion; }
 
+        /** @return operations running or queued on the shard when it was last polled */
+        int getLoad() const { return _load; }
+
         string toString() const;
         
     private:
@@ -99,6 +103,7 @@ namespace mongo {
         bool _hasOpsQueued;
         set<string> _tags;
         string _mongoVersion;
+        int _load;
     };
     
     struct MigrateInfo {
@@ -128,6 +133,15 @@ namespace mongo {
          */
         bool addTagRange( const TagRange& range );
 
+        /**
+         * Keeps shard out of any move BalancerPolicy::balance suggests, as donor or receiver.
+         * Used to pick moves that don't conflict with ones already scheduled.
+         */
+        void excludeShard( const string& shard ) { _excludedShards.insert( shard ); }
+
+        /** @return true if excludeShard was called for shard */
+        bool isExcluded( const string& shard ) const { return _excludedShards.count( shard ) > 0; }
+
         // ---- these methods might be better suiting in BalancerPolicy
         
         /**
@@ -178,6 +192,7 @@ namespace mongo {
         map<BSONObj,TagRange> _tagRanges;
         set<string> _allTags;
         set<string> _shards;
+        set<string> _excludedShards;
     };
 
     class BalancerPolicy {
@@ -198,6 +213,25 @@ namespace mongo {
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
 
+        /**
+         * Picks moves, across collections, that can all run at the same time.  A shard donates or
+         * receives one chunk at a time, and a migration holds its collection's distributed lock,
+         * so no two of the moves share a shard or a collection.  Shards with a load (see
+         * ShardInfo::getLoad) above maxShardLoad aren't used, so that migrations don't pile onto
+         * shards that are already busy.
+         *
+         * @param distributions one per collection, by namespace.  Shards are excluded from them
+         *        as moves are picked.
+         * @param maxMigrations the most moves to return
+         * @param maxShardLoad 0 for no limit
+         * @param migrations (OUT) the moves; caller owns the MigrateInfo instances
+         */
+        static void balanceConcurrent( const map<string, DistributionStatus*>& distributions,
+                                       int balancedLastTime,
+                                       int maxMigrations,
+                                       int maxShardLoad,
+                                       vector<MigrateInfo*>* migrations );
+
     private:
         static bool _isJumbo( const BSONObj& chunk );
     };
@@ -381,6 +381,93 @@ namespace mongo {
             ASSERT( !m );
         }
 
+        /**
+         * Three collections spread the same way over four shards, two full and two empty.  Only
+         * two moves can run at once, one off each full shard, and they must be of different
+         * collections.
+         */
+        TEST( BalancerPolicyTests, ConcurrentDisjoint ) {
+            ShardToChunksMap chunks[3];
+            for ( int i = 0; i < 3; i++ ) {
+                addShard( chunks[i], 10 , false );
+                addShard( chunks[i], 10 , false );
+                addShard( chunks[i], 0 , false );
+                addShard( chunks[i], 0 , true );
+            }
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 30, false, false );
+            shards["shard1"] = ShardInfo( 0, 30, false, false );
+            shards["shard2"] = ShardInfo( 0, 0, false, false );
+            shards["shard3"] = ShardInfo( 0, 0, false, false );
+
+            DistributionStatus d0( shards, chunks[0] );
+            DistributionStatus d1( shards, chunks[1] );
+            DistributionStatus d2( shards, chunks[2] );
+            map<string, DistributionStatus*> distributions;
+            distributions["ns0"] = &d0;
+            distributions["ns1"] = &d1;
+            distributions["ns2"] = &d2;
+
+            vector<MigrateInfo*> migrations;
+            BalancerPolicy::balanceConcurrent( distributions, 0, 10, 0, &migrations );
+            ASSERT_EQUALS( 2U , migrations.size() );
+
+            set<string> used;
+            set<string> namespaces;
+            for ( unsigned i = 0; i < migrations.size(); i++ ) {
+                ASSERT( used.insert( migrations[i]->from ).second );
+                ASSERT( used.insert( migrations[i]->to ).second );
+                ASSERT( namespaces.insert( migrations[i]->ns ).second );
+                delete migrations[i];
+            }
+            ASSERT_EQUALS( 4U , used.size() );
+        }
+
+        /**
+         * Same as above, with one of the full shards too busy to take part.  The other full shard
+         * still gets balanced.
+         */
+        TEST( BalancerPolicyTests, ConcurrentLoadLimit ) {
+            ShardToChunksMap chunks[2];
+            for ( int i = 0; i < 2; i++ ) {
+                addShard( chunks[i], 10 , false );
+                addShard( chunks[i], 10 , false );
+                addShard( chunks[i], 0 , false );
+                addShard( chunks[i], 0 , true );
+            }
+
+            ShardInfoMap shards;
+            // ShardInfo(maxSize, currSize, draining, opsQueued, tags, mongoVersion, load)
+            shards["shard0"] = ShardInfo( 0, 20, false, false, set<string>(), "", 100 );
+            shards["shard1"] = ShardInfo( 0, 20, false, false, set<string>(), "", 5 );
+            shards["shard2"] = ShardInfo( 0, 0, false, false );
+            shards["shard3"] = ShardInfo( 0, 0, false, false );
+
+            DistributionStatus d0( shards, chunks[0] );
+            DistributionStatus d1( shards, chunks[1] );
+            map<string, DistributionStatus*> distributions;
+            distributions["ns0"] = &d0;
+            distributions["ns1"] = &d1;
+
+            vector<MigrateInfo*> migrations;
+            BalancerPolicy::balanceConcurrent( distributions, 0, 10, 10, &migrations );
+            ASSERT_EQUALS( 1U , migrations.size() );
+            ASSERT_EQUALS( "shard1" , migrations[0]->from );
+            ASSERT_NOT_EQUALS( "shard0" , migrations[0]->to );
+            delete migrations[0];
+
+            // the limit on the number of migrations
+            DistributionStatus e0( shards, chunks[0] );
+            DistributionStatus e1( shards, chunks[1] );
+            distributions["ns0"] = &e0;
+            distributions["ns1"] = &e1;
+            migrations.clear();
+            BalancerPolicy::balanceConcurrent( distributions, 0, 1, 0, &migrations );
+            ASSERT_EQUALS( 1U , migrations.size() );
+            delete migrations[0];
+        }
+
         // Note: Only in 2.2, 2.4 has utility class
         class PseudoRandom {
         public:
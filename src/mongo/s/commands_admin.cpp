@@ -26,6 +26,7 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/namespacestring.h"
 #include "mongo/db/stats/counters.h"
 
@@ -41,6 +42,7 @@
 #include "mongo/s/writeback_listener.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/stringutils.h"
@@ -532,6 +534,14 @@ namespace mongo {
                     BSONObj currentKey = idx["key"].embeddedObject();
                     // Check 2.i. and 2.ii.
                     if ( ! idx["sparse"].trueValue() && proposedKey.isPrefixOf( currentKey ) ) {
+                        if ( idx["hashVersion"].numberInt() != HASH_VERSION_MD5 ) {
+                            errmsg = str::stream() << "can't shard collection " << ns << " on "
+                                                   << currentKey << ", hashed shard keys need"
+                                                   << " an index with hashVersion "
+                                                   << HASH_VERSION_MD5;
+                            conn->done();
+                            return false;
+                        }
                         BSONElement ce = cmdObj["clustering"];
                         if (idx["clustering"].trueValue()) {
                             if (ce.ok() && !ce.trueValue()) {
@@ -1370,6 +1380,7 @@ namespace mongo {
             virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
                 result.appendBool("ismaster", true );
                 result.append("msg", "isdbgrid");
+                messageCompression::negotiate(cmdObj, ClientBasic::getCurrent()->port(), result);
                 result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
                 result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
                 result.appendDate("localTime", jsTime());
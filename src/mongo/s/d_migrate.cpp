@@ -91,6 +91,10 @@ using namespace std;
 namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(migrateUniqueChecks, bool, true);
+    // Connections over which the recipient clones a chunk, each reading a sub-range of it.
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCloneConnections, int, 4);
+    // Whether the recipient bulk loads a chunk into a collection it doesn't have yet.
+    MONGO_EXPORT_SERVER_PARAMETER(migrateBulkLoad, bool, true);
 
     bool findShardKeyIndexPattern_locked( const string& ns,
                                           const BSONObj& shardKeyPattern,
@@ -476,6 +480,59 @@ namespace mongo {
             return cursorid;
         }
 
+        /**
+         * Like startCloneTransaction, but for a recipient that clones over several connections:
+         * the chunk is cut at cmdobj's splitKeys, and we open a cursor for each sub-range.
+         * Each cursor needs a transaction of its own to be read in parallel, and they are all
+         * begun under the same write lock as the migratelog, so they see the same snapshot.
+         *
+         * Appends cursors: [{id, ns}, ...] to result.
+         */
+        bool startParallelCloneTransactions(const BSONObj &cmdobj, string &errmsg, BSONObjBuilder &result) {
+            string ns(cmdobj["ns"].String());
+            LOCK_REASON(lockReason, "sharding: starting parallel clone transactions for migrate");
+            Client::WriteContext ctx(ns, lockReason);
+            massert(17354, "can't _migrateStartCloneTransaction with active snapshot", !_snapshotTaken);
+
+            Collection *cl = getCollection(ns);
+            if (cl == NULL) {
+                errmsg = "collection not found, should be impossible";
+                return false;
+            }
+
+            const IndexDetails *idx = cl->findIndexByPrefix(cmdobj["keyPattern"].Obj(), true);
+            if (idx == NULL) {
+                errmsg = mongoutils::str::stream() << "can't find index for " << cmdobj["keyPattern"].Obj() << " in _migrateStartCloneTransaction";
+                return false;
+            }
+
+            KeyPattern kp(idx->keyPattern());
+            vector<BSONObj> bounds;
+            bounds.push_back(KeyPattern::toKeyFormat(kp.extendRangeBound(cmdobj["min"].Obj(), false)));
+            BSONForEach(splitKey, cmdobj["splitKeys"].Obj()) {
+                bounds.push_back(KeyPattern::toKeyFormat(kp.extendRangeBound(splitKey.Obj(), false)));
+            }
+            bounds.push_back(KeyPattern::toKeyFormat(kp.extendRangeBound(cmdobj["max"].Obj(), false)));
+
+            enableLogTxnOpsForSharding(mongo::shouldLogOpForSharding,
+                                       mongo::shouldLogUpdateOpForSharding,
+                                       mongo::startObjForMigrateLog,
+                                       mongo::writeObjToMigrateLog,
+                                       mongo::writeObjToMigrateLogRef);
+            _snapshotTaken = true;
+
+            BSONArrayBuilder cursors(result.subarrayStart("cursors"));
+            for (size_t i = 0; i + 1 < bounds.size(); i++) {
+                Client::Transaction txn(DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY);
+                ClientCursor::Holder ccPointer(new ClientCursor(0, IndexCursor::make(cl, *idx, bounds[i], bounds[i + 1], false, 1), ns, cmdobj.getOwned()));
+                cursors.append(BSON("id" << ccPointer->cursorid() << "ns" << ns));
+                cc().swapTransactionStack(ccPointer->transactions);
+                ccPointer.release();
+            }
+            cursors.done();
+            return true;
+        }
+
         /**
          * Get the BSONs that belong to the chunk migrated in shard key order.
          *
@@ -692,6 +749,10 @@ namespace mongo {
             out->push_back(Privilege(AuthorizationManager::SERVER_RESOURCE_NAME, actions));
         }
         bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            if (cmdObj.hasField("splitKeys")) {
+                return migrateFromStatus.startParallelCloneTransactions(cmdObj, errmsg, result);
+            }
+
             CursorId id = migrateFromStatus.startCloneTransaction(cmdObj, errmsg, result);
             if (id == 0) {
                 return false;
@@ -1436,6 +1497,125 @@ namespace mongo {
        commend to "commit"
     */
 
+    /**
+     * Reads the sub-range cursors of a parallel clone (see startParallelCloneTransactions),
+     * each over a connection and thread of its own, into a queue of batches that the migrate
+     * thread inserts from.  Reading on the donor and the transfer then overlap with each other
+     * and with our inserts, instead of taking turns with them.
+     */
+    class ParallelCloneFetcher : boost::noncopyable {
+    public:
+        ParallelCloneFetcher(const string &from, const string &ns, size_t maxBufferedBytes)
+                : _from(from), _ns(ns), _maxBufferedBytes(maxBufferedBytes),
+                  _mutex("ParallelCloneFetcher"), _bufferedBytes(0), _running(0), _stopped(false) {}
+
+        ~ParallelCloneFetcher() {
+            {
+                scoped_lock l(_mutex);
+                _stopped = true;
+                _cond.notify_all();
+            }
+            _threads.join_all();
+        }
+
+        void start(const vector<long long> &cursorIds) {
+            for (vector<long long>::const_iterator it = cursorIds.begin(); it != cursorIds.end(); ++it) {
+                scoped_lock l(_mutex);
+                _running++;
+                _threads.create_thread(boost::bind(&ParallelCloneFetcher::fetch, this, *it));
+            }
+        }
+
+        /**
+         * Gets the next batch, an array of documents, from whichever cursor has one.
+         * @return false once all the cursors are exhausted.  uasserts if one of them failed.
+         */
+        bool next(BSONObj &batch) {
+            scoped_lock l(_mutex);
+            while (_batches.empty() && _running > 0 && _error.empty()) {
+                _cond.wait(l.boost());
+            }
+            uassert(17347, mongoutils::str::stream() << "parallel clone failed: " << _error,
+                    _error.empty());
+            if (_batches.empty()) {
+                return false;
+            }
+            batch = _batches.front();
+            _batches.pop_front();
+            _bufferedBytes -= batch.objsize();
+            _cond.notify_all();
+            return true;
+        }
+
+    private:
+        void fetch(long long cursorId) {
+            Client::initThread("migrateCloneFetcher");
+            if (!noauth) {
+                cc().getAuthorizationManager()->grantInternalAuthorization("_migrateCloneFetcher");
+            }
+            string error;
+            try {
+                scoped_ptr<ScopedDbConnection> conn(ScopedDbConnection::getScopedDbConnection(_from));
+                {
+                    // if we stop early, the destructor kills the cursor on the donor
+                    DBClientCursor cursor(conn->get(), _ns, cursorId, 0, 0);
+                    while (cursor.more()) {
+                        BSONArrayBuilder a;
+                        while (cursor.moreInCurrentBatch()) {
+                            a.append(cursor.nextSafe());
+                        }
+                        if (!push(a.arr())) {
+                            break;
+                        }
+                    }
+                }
+                conn->done();
+            }
+            catch (std::exception &e) {
+                error = e.what();
+            }
+            {
+                scoped_lock l(_mutex);
+                if (!error.empty() && _error.empty()) {
+                    _error = error;
+                }
+                _running--;
+                _cond.notify_all();
+            }
+            cc().shutdown();
+        }
+
+        // @return false if we were stopped
+        bool push(const BSONObj &batch) {
+            scoped_lock l(_mutex);
+            // one batch may take us over the limit, so a big one can't wedge us
+            while (_bufferedBytes >= _maxBufferedBytes && !_stopped) {
+                _cond.wait(l.boost());
+            }
+            if (_stopped) {
+                return false;
+            }
+            _batches.push_back(batch);
+            _bufferedBytes += batch.objsize();
+            _cond.notify_all();
+            return true;
+        }
+
+        const string _from;
+        const string _ns;
+        const size_t _maxBufferedBytes;
+        boost::thread_group _threads;
+
+        // _mutex protects everything below
+        mongo::mutex _mutex;
+        boost::condition _cond;
+        deque<BSONObj> _batches;
+        size_t _bufferedBytes;
+        int _running;
+        bool _stopped;
+        string _error;
+    };
+
     class MigrateStatus {
         long long _lastAppliedMigrateLogID;
 
@@ -1653,11 +1833,11 @@ namespace mongo {
          * We may need to handle RetryWithWriteLock inside this code, so it is factored out of _go
          * below.
          */
-        void lockedMigrateInsertFirstBatch(const BSONObj &firstBatch, uint64_t insertFlags) {
+        void lockedMigrateInsertArray(const BSONObj &arr, uint64_t insertFlags) {
             Client::Transaction txn(DB_SERIALIZABLE);
             Collection *cl = getCollection(ns);
             massert(17318, "collection must exist during migration", cl);
-            for (BSONObjIterator it(firstBatch); it.more(); ++it) {
+            for (BSONObjIterator it(arr); it.more(); ++it) {
                 BSONObj obj = (*it).Obj();
                 insertOneObject(cl, obj, insertFlags);
                 OplogHelpers::logInsert(ns.c_str(), obj, true);
@@ -1707,6 +1887,98 @@ namespace mongo {
             return thisTime != 0;
         }
 
+        /**
+         * Asks the donor for split points that cut the chunk into migrateCloneConnections
+         * sub-ranges of about the same size, to clone in parallel.
+         * Leaves splitKeys empty if we should clone over one connection.
+         */
+        void getCloneSplitKeys(DBClientBase &conn, vector<BSONObj> &splitKeys) {
+            if (migrateCloneConnections <= 1) {
+                return;
+            }
+            BSONObj res;
+            // splitVector returns points about 8MB apart, which we merge into the sub-ranges
+            if (!conn.runCommand("admin", BSON("splitVector" << ns <<
+                                               "keyPattern" << shardKeyPattern <<
+                                               "min" << min <<
+                                               "max" << max <<
+                                               "maxChunkSizeBytes" << 16 * 1024 * 1024), res)) {
+                warning() << "splitVector failed, cloning " << ns << " over one connection: " << res << migrateLog;
+                return;
+            }
+            vector<BSONElement> points = res["splitKeys"].Array();
+            const size_t nPoints = points.size();
+            const size_t nRanges = std::min(nPoints + 1, static_cast<size_t>(migrateCloneConnections));
+            for (size_t i = 1; i < nRanges; i++) {
+                splitKeys.push_back(points[i * (nPoints + 1) / nRanges - 1].Obj().getOwned());
+            }
+        }
+
+        /**
+         * If the collection doesn't exist here yet, we create it in a bulk load, clone into the
+         * loader instead of maintaining every index row by row, and apply the mods with normal
+         * writes once the load is committed.  The load is logged like the beginLoad and
+         * commitLoad commands, so secondaries load it the same way.
+         *
+         * @return false if we can't, and should create the collection and clone normally
+         */
+        bool beginCloneLoad(DBClientBase &conn) {
+            if (!migrateBulkLoad || NamespaceString::isSystem(ns)) {
+                return false;
+            }
+            {
+                LOCK_REASON(lockReason, "sharding: checking whether to bulk load for migrate");
+                Client::ReadContext ctx(ns, lockReason);
+                if (getCollection(ns) != NULL) {
+                    return false;
+                }
+            }
+
+            const string dbname = nsToDatabase(ns);
+            BSONObj entry = conn.findOne(dbname + ".system.namespaces", BSON("name" << ns));
+            BSONObj options = entry["options"].isABSONObj() ? entry["options"].Obj().getOwned() : BSONObj();
+            if (options["capped"].trueValue() || options["natural"].trueValue() ||
+                options["partitioned"].trueValue()) {
+                return false;
+            }
+
+            vector<BSONObj> indexes;
+            auto_ptr<DBClientCursor> indexCursor = conn.getIndexes(ns);
+            while (indexCursor->more()) {
+                indexes.push_back(indexCursor->nextSafe().getOwned());
+            }
+
+            cc().beginClientLoad(ns, indexes, options);
+            BSONObjBuilder cmd;
+            cmd.append("beginLoad", 1);
+            cmd.append("ns", nsToCollectionSubstring(ns));
+            cmd.append("indexes", indexes);
+            cmd.append("options", options);
+            OplogHelpers::logCommand((dbname + ".$cmd").c_str(), cmd.done());
+            return true;
+        }
+
+        void commitCloneLoad() {
+            const string cmdns = nsToDatabase(ns) + ".$cmd";
+            OplogHelpers::logCommand(cmdns.c_str(), BSON("commitLoad" << 1));
+            cc().commitClientLoad();
+        }
+
+        // Aborts the load begun by beginCloneLoad if we fail before committing it.
+        class CloneLoadAborter : boost::noncopyable {
+        public:
+            ~CloneLoadAborter() {
+                if (cc().loadInProgress()) {
+                    try {
+                        cc().abortClientLoad();
+                    }
+                    catch (DBException &e) {
+                        warning() << "failed to abort bulk load for migrate: " << e.toString() << migrateLog;
+                    }
+                }
+            }
+        };
+
         void go() {
             try {
                 _go();
@@ -1743,7 +2015,30 @@ namespace mongo {
             ScopedDbConnection& conn = *connPtr;
             conn->getLastError(); // just test connection
 
+            bool hasNewCloneCommands;
             {
+                BSONObj res;
+                if (!conn->runCommand("admin", BSON("listCommands" << 1), res)) {
+                    state = FAIL;
+                    errmsg = mongoutils::str::stream() << "listCommands failed: " << res.toString();
+                    error() << errmsg << migrateLog;
+                    conn.done();
+                    return;
+                }
+                BSONObj cmds = res["commands"].Obj();
+                hasNewCloneCommands = cmds.hasField("_migrateStartCloneTransaction");
+            }
+
+            CloneLoadAborter loadAborter;
+            // the old clone path upserts, which a bulk load can't do
+            const bool bulkLoad = hasNewCloneCommands && beginCloneLoad(conn.conn());
+            if (bulkLoad) {
+                // 0, 1 and 2: the load created the collection and its indexes, empty
+                log() << "bulk loading " << ns << " for migration" << migrateLog;
+                timing.done(1);
+                timing.done(2);
+            }
+            else {
                 // 0. copy system.namespaces entry if collection doesn't already exist
                 LOCK_REASON(lockReason, "sharding: creating collection and indexes for migrate");
                 Client::WriteContext ctx( ns, lockReason );
@@ -1778,7 +2073,7 @@ namespace mongo {
             }
 
 
-            {
+            if (!bulkLoad) {
                 // 2. delete any data already in range
                 LOCK_REASON(lockReason, "sharding: deleting old documents before migrate");
                 Client::ReadContext ctx(ns, lockReason);
@@ -1810,22 +2105,19 @@ namespace mongo {
 
                 BSONObj res;
 
-                if (!conn->runCommand("admin", BSON("listCommands" << 1), res)) {
-                    state = FAIL;
-                    errmsg = mongoutils::str::stream() << "listCommands failed: " << res.toString();
-                    error() << errmsg << migrateLog;
-                    conn.done();
-                    return;
-                }
-                BSONObj cmds = res["commands"].Obj();
-                bool hasNewCloneCommands = cmds.hasField("_migrateStartCloneTransaction");
-
                 if (hasNewCloneCommands) {
-                    if (!conn->runCommand("admin", BSON("_migrateStartCloneTransaction" << 1 <<
-                                                        "ns" << ns <<
-                                                        "keyPattern" << shardKeyPattern <<
-                                                        "min" << min <<
-                                                        "max" << max), res)) {
+                    BSONObjBuilder startCmd;
+                    startCmd << "_migrateStartCloneTransaction" << 1 <<
+                                "ns" << ns <<
+                                "keyPattern" << shardKeyPattern <<
+                                "min" << min <<
+                                "max" << max;
+                    vector<BSONObj> splitKeys;
+                    getCloneSplitKeys(conn.conn(), splitKeys);
+                    if (!splitKeys.empty()) {
+                        startCmd.append("splitKeys", splitKeys);
+                    }
+                    if (!conn->runCommand("admin", startCmd.done(), res)) {
                         state = FAIL;
                         errmsg = mongoutils::str::stream() << "_migrateStartCloneTransaction failed: " << res.toString();
                         error() << errmsg << migrateLog;
@@ -1833,50 +2125,80 @@ namespace mongo {
                         return;
                     }
 
-                    BSONObj cursorObj = res["cursor"].Obj();
-                    massert(17225, mongoutils::str::stream() << "expected cursor ns " << ns << ", got " << cursorObj["ns"].Stringdata(),
-                            cursorObj["ns"].Stringdata() == ns);
-
                     uint64_t insertFlags = Collection::NO_LOCKTREE;
                     if (!migrateUniqueChecks) {
                         insertFlags |= Collection::NO_UNIQUE_CHECKS;
                     }
 
                     LOCK_REASON(lockReason, "sharding: cloning documents on recipient for migrate");
-                    try {
-                        Client::ReadContext ctx(ns, lockReason);
-                        CounterResetter<long long> numClonedResetter(numCloned);
-                        CounterResetter<long long> clonedBytesResetter(clonedBytes);
-
-                        lockedMigrateInsertFirstBatch(cursorObj["firstBatch"].Obj(), insertFlags);
-
-                        numClonedResetter.setDone();
-                        clonedBytesResetter.setDone();
-                    } catch (RetryWithWriteLock) {
-                        Client::WriteContext ctx(ns, lockReason);
-
-                        lockedMigrateInsertFirstBatch(cursorObj["firstBatch"].Obj(), insertFlags);
-                    }
+                    if (res["cursors"].type() == Array) {
+                        // A donor that knows splitKeys gave us a cursor per sub-range.
+                        vector<long long> cursorIds;
+                        BSONForEach(cursorElt, res["cursors"].Obj()) {
+                            BSONObj cursorObj = cursorElt.Obj();
+                            massert(17225, mongoutils::str::stream() << "expected cursor ns " << ns << ", got " << cursorObj["ns"].Stringdata(),
+                                    cursorObj["ns"].Stringdata() == ns);
+                            cursorIds.push_back(cursorObj["id"].Long());
+                        }
+                        ParallelCloneFetcher fetcher(from, ns, 64 * 1024 * 1024);
+                        fetcher.start(cursorIds);
+                        BSONObj batch;
+                        while (fetcher.next(batch)) {
+                            try {
+                                Client::ReadContext ctx(ns, lockReason);
+                                CounterResetter<long long> numClonedResetter(numCloned);
+                                CounterResetter<long long> clonedBytesResetter(clonedBytes);
+
+                                lockedMigrateInsertArray(batch, insertFlags);
+
+                                numClonedResetter.setDone();
+                                clonedBytesResetter.setDone();
+                            } catch (RetryWithWriteLock) {
+                                Client::WriteContext ctx(ns, lockReason);
+
+                                lockedMigrateInsertArray(batch, insertFlags);
+                            }
+                        }
+                    } else {
+                        BSONObj cursorObj = res["cursor"].Obj();
+                        massert(17355, mongoutils::str::stream() << "expected cursor ns " << ns << ", got " << cursorObj["ns"].Stringdata(),
+                                cursorObj["ns"].Stringdata() == ns);
 
-                    for (DBClientCursor cursor(conn.get(), ns, cursorObj["id"].Long(), 0, 0);
-                         cursor.more(); ) {
                         try {
                             Client::ReadContext ctx(ns, lockReason);
                             CounterResetter<long long> numClonedResetter(numCloned);
                             CounterResetter<long long> clonedBytesResetter(clonedBytes);
-                            DBClientCursor::BatchResetter br(cursor);
-                            DBClientCursorBatchIterator iter(cursor);
 
-                            lockedMigrateInsertBatch(iter, insertFlags);
+                            lockedMigrateInsertArray(cursorObj["firstBatch"].Obj(), insertFlags);
 
                             numClonedResetter.setDone();
                             clonedBytesResetter.setDone();
-                            br.setDone();
                         } catch (RetryWithWriteLock) {
                             Client::WriteContext ctx(ns, lockReason);
-                            DBClientCursorBatchIterator iter(cursor);
 
-                            lockedMigrateInsertBatch(iter, insertFlags);
+                            lockedMigrateInsertArray(cursorObj["firstBatch"].Obj(), insertFlags);
+                        }
+
+                        for (DBClientCursor cursor(conn.get(), ns, cursorObj["id"].Long(), 0, 0);
+                             cursor.more(); ) {
+                            try {
+                                Client::ReadContext ctx(ns, lockReason);
+                                CounterResetter<long long> numClonedResetter(numCloned);
+                                CounterResetter<long long> clonedBytesResetter(clonedBytes);
+                                DBClientCursor::BatchResetter br(cursor);
+                                DBClientCursorBatchIterator iter(cursor);
+
+                                lockedMigrateInsertBatch(iter, insertFlags);
+
+                                numClonedResetter.setDone();
+                                clonedBytesResetter.setDone();
+                                br.setDone();
+                            } catch (RetryWithWriteLock) {
+                                Client::WriteContext ctx(ns, lockReason);
+                                DBClientCursorBatchIterator iter(cursor);
+
+                                lockedMigrateInsertBatch(iter, insertFlags);
+                            }
                         }
                     }
                 } else {
@@ -1917,6 +2239,10 @@ namespace mongo {
                     }
                 }
 
+                if (bulkLoad) {
+                    commitCloneLoad();
+                }
+
                 timing.done(3);
             }
 
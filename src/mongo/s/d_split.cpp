@@ -189,9 +189,20 @@ namespace mongo {
         }
     } cmdCheckShardingIndex;
 
+    /**
+     * Finds split points with get_key_after_bytes, which estimates how far to skip from the
+     * subtree sizes in the fractal tree's internal nodes, so each point costs time proportional to
+     * the depth of the tree rather than to the size of the chunk.
+     *
+     * get_key_after_bytes counts bytes of the index, not of the documents.  For a clustering index
+     * that's about the same thing, for other indexes the chunk size is scaled by
+     * indexBytesPerDocByte, the ratio of the index's size to the collection's, so the points are
+     * only as good as that average.
+     */
     class SplitVectorFinder {
         Collection *_cl;
         const IndexDetails* _idx;
+        double _indexBytesPerDocByte;
         KeyPattern _chunkPattern;
         Ordering _ordering;
         storage::Key _chunkMin, _chunkMax;
@@ -257,7 +268,7 @@ namespace mongo {
                 // middle of them, we fall back to just using a cursor from this point forward.
                 if (!_idx->isIdIndex()) {
                     _chunkMin.reset(*endKey, endPK);
-                    _justSkipped += skipped;
+                    _justSkipped += skipped / _indexBytesPerDocByte;
                 }
                 _useCursor = true;
                 return;
@@ -304,10 +315,12 @@ namespace mongo {
         }
 
       public:
-        SplitVectorFinder(Collection *cl, const IndexDetails* idx, const BSONObj &chunkPattern, const BSONObj &min, const BSONObj &max,
+        SplitVectorFinder(Collection *cl, const IndexDetails* idx, double indexBytesPerDocByte,
+                          const BSONObj &chunkPattern, const BSONObj &min, const BSONObj &max,
                           vector<BSONObj> &splitPoints)
                 : _cl(cl),
                   _idx(idx),
+                  _indexBytesPerDocByte(indexBytesPerDocByte),
                   _chunkPattern(chunkPattern.getOwned()),
                   _ordering(Ordering::make(_idx->keyPattern())),
                   _chunkMin(min, _idx->isIdIndex() ? NULL : &minKey),
@@ -353,7 +366,7 @@ namespace mongo {
             massert(17237, "bug: failed to dynamically cast IndexDetails to IndexDetailsBase", idxBase != NULL);
             {
                 IsTooBigCallback cb(*this);
-                idxBase->getKeyAfterBytes(_chunkMin, maxChunkSize, cb);
+                idxBase->getKeyAfterBytes(_chunkMin, maxChunkSize * _indexBytesPerDocByte, cb);
             }
             if (!_chunkTooBig) {
                 return;
@@ -378,7 +391,7 @@ namespace mongo {
                         _useCursor = false;
                     }
                     else {
-                        idxBase->getKeyAfterBytes(_chunkMin, targetChunkSize, cb);
+                        idxBase->getKeyAfterBytes(_chunkMin, targetChunkSize * _indexBytesPerDocByte, cb);
                     }
                 }
             }
@@ -399,6 +412,8 @@ namespace mongo {
                  "  \n"
                  "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
                  "  'force' will produce one split point even if data is small; defaults to false\n"
+                 "  Split points are estimated from the index's tree unless 'exact: true' is given,\n"
+                 "  which scans the whole chunk\n"
                  "NOTE: This command may take a while to run";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -497,11 +512,24 @@ namespace mongo {
                 }
             }
 
-            if (!forceMedianSplit && idx->clustering()) {
-                SplitVectorFinder finder(cl, idx, keyPattern, min, max, splitKeys);
+            bool exact = jsobj["exact"].trueValue();
+            double indexBytesPerDocByte = 1.0;
+            if (!forceMedianSplit && !exact && !idx->clustering()) {
+                const uint64_t docBytes = cl->getPKIndex().getStats().dataSize;
+                const uint64_t indexBytes = idx->getStats().dataSize;
+                if (docBytes > 0 && indexBytes > 0) {
+                    indexBytesPerDocByte = (double) indexBytes / docBytes;
+                } else {
+                    // nothing to estimate from
+                    exact = true;
+                }
+            }
+
+            if (!forceMedianSplit && !exact) {
+                SplitVectorFinder finder(cl, idx, indexBytesPerDocByte, keyPattern, min, max, splitKeys);
                 finder.find(maxChunkSize, maxSplitPoints);
             } else {
-                // Haven't implemented a better version using get_key_after_bytes yet, do the slow thing
+                // Exact, or a forced median split: walk the chunk, adding up document sizes
                 CollectionData::Stats stats;
                 cl->fillCollectionStats(stats, NULL, 1);
                 const long long recCount = stats.count;
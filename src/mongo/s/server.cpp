@@ -288,6 +288,8 @@ static bool runMongosServer( bool doUpgrade ) {
     // Mongos shouldn't lazily kill cursors, otherwise we can end up with extras from migration
     DBClientConnection::setLazyKillCursor( false );
 
+    DBClientConnection::setCompressMessages( cmdLine.netCompression );
+
     ReplicaSetMonitor::setConfigChangeHook( boost::bind( &ConfigServer::replicaSetChange , &configServer , _1 ) );
 
     if ( ! configServer.init( configdbs ) ) {
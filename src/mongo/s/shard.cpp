@@ -410,6 +410,8 @@ namespace mongo {
         _hasOpsQueued = obj["writeBacksQueued"].Bool();
         _writeLock = 0; // TODO
         _mongoVersion = obj["version"].String();
+        _load = obj.getFieldDotted("globalLock.activeClients.total").numberInt() +
+                obj.getFieldDotted("globalLock.currentQueue.total").numberInt();
     }
 
     void ShardingConnectionHook::onCreate( DBClientBase * conn ) {
@@ -187,6 +187,7 @@ namespace mongo {
             ss << "shard: " << _shard 
                << " dataSize: " << _dataSize
                << " writeLock: " << _writeLock
+               << " load: " << _load
                << " version: " << _mongoVersion;
             return ss.str();
         }
@@ -211,12 +212,18 @@ namespace mongo {
             return _mongoVersion;
         }
 
+        /** @return operations running or waiting for a lock, from serverStatus.globalLock */
+        int load() const {
+            return _load;
+        }
+
     private:
         Shard _shard;
         long long _dataSize;
         bool _hasOpsQueued;  // true if 'writebacks' are pending
         double _writeLock;
         string _mongoVersion;
+        int _load;
     };
 
     class ChunkManager;
@@ -152,7 +152,7 @@ namespace mongo {
                         delete ss->avail;
                     }
                     else
-                        release( addr , ss->avail );
+                        shardConnectionPool.releaseIdle( addr , ss->avail );
                     ss->avail = 0;
                 }
                 if ( fromDestructor ) delete ss;
@@ -167,9 +167,19 @@ namespace mongo {
 
             auto_ptr<DBClientBase> c; // Handles cleanup if there's an exception thrown
             if ( s->avail ) {
+                // Idle connections kept here don't count against the pool's in-use limit, so
+                // count it again, or leave it here if the wait for a slot times out.
+                shardConnectionPool.incrementEgress( addr , s->avail );
                 c.reset( s->avail );
                 s->avail = 0;
-                shardConnectionPool.onHandedOut( c.get() ); // May throw an exception
+                try {
+                    shardConnectionPool.onHandedOut( c.get() ); // May throw an exception
+                }
+                catch ( std::exception& ) {
+                    // Undo the incrementEgress() above, the connection is deleted.
+                    shardConnectionPool.decrementEgress( addr , c.get() );
+                    throw;
+                }
             } else {
                 c.reset( shardConnectionPool.get( addr ) );
                 s->created++; // After, so failed creation doesn't get counted
@@ -216,6 +226,9 @@ namespace mongo {
             // used - as thread local variables. This means that threads won't be able to
             // see the s->avail connection of other threads.
 
+            // Idle until get() hands it out again, so it doesn't hold a slot of the pool's
+            // in-use limit meanwhile.
+            shardConnectionPool.decrementEgress( addr , conn );
             s->avail = conn;
         }
 
@@ -251,6 +264,8 @@ namespace mongo {
                     if( ! s->avail ) {
                         s->avail = shardConnectionPool.get( sconnString );
                         s->created++; // After, so failed creation doesn't get counted
+                        // Kept idle for get(), see done().
+                        shardConnectionPool.decrementEgress( sconnString , s->avail );
                     }
 
                     versionManager.checkShardVersionCB( s->avail, ns, false, 1 );
@@ -429,6 +444,7 @@ namespace mongo {
     void ShardConnection::kill() {
         if ( _conn ) {
             if( versionManager.isVersionableCB( _conn ) ) versionManager.resetShardVersionCB( _conn );
+            shardConnectionPool.decrementEgress( _addr , _conn );
             delete _conn;
             _conn = 0;
             _finishedInit = true;
@@ -31,6 +31,8 @@ namespace mongo {
     const BSONField<BSONObj> SettingsType::balancerActiveWindow("activeWindow");
     const BSONField<bool> SettingsType::shortBalancerSleep("_nosleep");
     const BSONField<bool> SettingsType::secondaryThrottle("_secondaryThrottle");
+    const BSONField<int> SettingsType::maxConcurrentMigrations("_maxConcurrentMigrations", 1);
+    const BSONField<int> SettingsType::migrationMaxShardLoad("_migrationMaxShardLoad", 0);
 
     SettingsType::SettingsType() {
         clear();
@@ -84,6 +86,15 @@ namespace mongo {
                     return false;
                 }
             }
+            if (_isMaxConcurrentMigrationsSet && !(_maxConcurrentMigrations > 0)) {
+                *errMsg = stream() << maxConcurrentMigrations.name() <<
+                                      " must be greater than zero";
+                return false;
+            }
+            if (_isMigrationMaxShardLoadSet && _migrationMaxShardLoad < 0) {
+                *errMsg = stream() << migrationMaxShardLoad.name() << " can't be negative";
+                return false;
+            }
             return true;
         }
         else {
@@ -103,6 +114,12 @@ namespace mongo {
         }
         if (_isShortBalancerSleepSet) builder.append(shortBalancerSleep(), _shortBalancerSleep);
         if (_isSecondaryThrottleSet) builder.append(secondaryThrottle(), _secondaryThrottle);
+        if (_isMaxConcurrentMigrationsSet) {
+            builder.append(maxConcurrentMigrations(), _maxConcurrentMigrations);
+        }
+        if (_isMigrationMaxShardLoadSet) {
+            builder.append(migrationMaxShardLoad(), _migrationMaxShardLoad);
+        }
 
         return builder.obj();
     }
@@ -139,6 +156,16 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isSecondaryThrottleSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extractNumber(source, maxConcurrentMigrations,
+                                                &_maxConcurrentMigrations, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isMaxConcurrentMigrationsSet = fieldState == FieldParser::FIELD_SET;
+
+        fieldState = FieldParser::extractNumber(source, migrationMaxShardLoad,
+                                                &_migrationMaxShardLoad, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isMigrationMaxShardLoadSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -162,6 +189,12 @@ namespace mongo {
         _secondaryThrottle = false;
         _isSecondaryThrottleSet = false;
 
+        _maxConcurrentMigrations = 1;
+        _isMaxConcurrentMigrationsSet = false;
+
+        _migrationMaxShardLoad = 0;
+        _isMigrationMaxShardLoadSet = false;
+
     }
 
     void SettingsType::cloneTo(SettingsType* other) const {
@@ -185,6 +218,12 @@ namespace mongo {
         other->_secondaryThrottle = _secondaryThrottle;
         other->_isSecondaryThrottleSet = _isSecondaryThrottleSet;
 
+        other->_maxConcurrentMigrations = _maxConcurrentMigrations;
+        other->_isMaxConcurrentMigrationsSet = _isMaxConcurrentMigrationsSet;
+
+        other->_migrationMaxShardLoad = _migrationMaxShardLoad;
+        other->_isMigrationMaxShardLoadSet = _isMigrationMaxShardLoadSet;
+
     }
 
     std::string SettingsType::toString() const {
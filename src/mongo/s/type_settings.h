@@ -63,6 +63,8 @@ namespace mongo {
         static const BSONField<BSONObj> balancerActiveWindow;
         static const BSONField<bool> shortBalancerSleep;
         static const BSONField<bool> secondaryThrottle;
+        static const BSONField<int> maxConcurrentMigrations;
+        static const BSONField<int> migrationMaxShardLoad;
 
         //
         // settings type methods
@@ -229,6 +231,48 @@ namespace mongo {
                 return secondaryThrottle.getDefault();
             }
         }
+        void setMaxConcurrentMigrations(int maxConcurrentMigrations) {
+            _maxConcurrentMigrations = maxConcurrentMigrations;
+            _isMaxConcurrentMigrationsSet = true;
+        }
+
+        void unsetMaxConcurrentMigrations() { _isMaxConcurrentMigrationsSet = false; }
+
+        bool isMaxConcurrentMigrationsSet() const {
+            return _isMaxConcurrentMigrationsSet || maxConcurrentMigrations.hasDefault();
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        int getMaxConcurrentMigrations() const {
+            if (_isMaxConcurrentMigrationsSet) {
+                return _maxConcurrentMigrations;
+            } else {
+                dassert(maxConcurrentMigrations.hasDefault());
+                return maxConcurrentMigrations.getDefault();
+            }
+        }
+        void setMigrationMaxShardLoad(int migrationMaxShardLoad) {
+            _migrationMaxShardLoad = migrationMaxShardLoad;
+            _isMigrationMaxShardLoadSet = true;
+        }
+
+        void unsetMigrationMaxShardLoad() { _isMigrationMaxShardLoadSet = false; }
+
+        bool isMigrationMaxShardLoadSet() const {
+            return _isMigrationMaxShardLoadSet || migrationMaxShardLoad.hasDefault();
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        int getMigrationMaxShardLoad() const {
+            if (_isMigrationMaxShardLoadSet) {
+                return _migrationMaxShardLoad;
+            } else {
+                dassert(migrationMaxShardLoad.hasDefault());
+                return migrationMaxShardLoad.getDefault();
+            }
+        }
 
     private:
         // Convention: (M)andatory, (O)ptional, (S)pecial rule.
@@ -252,6 +296,13 @@ namespace mongo {
 
         bool _secondaryThrottle;         // (O)  only migrate chunks as fast as at least
         bool _isSecondaryThrottleSet;    // one secondary can keep up with
+
+        int _maxConcurrentMigrations;    // (O)  how many migrations, between disjoint pairs
+        bool _isMaxConcurrentMigrationsSet; // of shards, a balancing round may run at once
+
+        int _migrationMaxShardLoad;      // (O)  with concurrent migrations, shards with more
+        bool _isMigrationMaxShardLoadSet; // active and queued operations than this are left
+                                         // out of the round; 0 is unlimited
     };
 
 } // namespace mongo
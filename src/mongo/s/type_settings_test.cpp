@@ -83,7 +83,9 @@ namespace {
                            SettingsType::balancerActiveWindow(BSON("start" << "23:00" <<
                                                                    "stop" << "6:00" )) <<
                            SettingsType::shortBalancerSleep(true) <<
-                           SettingsType::secondaryThrottle(true));
+                           SettingsType::secondaryThrottle(true) <<
+                           SettingsType::maxConcurrentMigrations(3) <<
+                           SettingsType::migrationMaxShardLoad(50));
         ASSERT(settings.parseBSON(objBalancer, &errMsg));
         ASSERT_EQUALS(errMsg, "");
         ASSERT_TRUE(settings.isValid(NULL));
@@ -93,6 +95,21 @@ namespace {
                                                                "stop" << "6:00" ));
         ASSERT_EQUALS(settings.getShortBalancerSleep(), true);
         ASSERT_EQUALS(settings.getSecondaryThrottle(), true);
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 3);
+        ASSERT_EQUALS(settings.getMigrationMaxShardLoad(), 50);
+    }
+
+    TEST(Validity, MigrationDefaults) {
+        SettingsType settings;
+        string errMsg;
+        ASSERT(settings.parseBSON(BSON(SettingsType::key("balancer")), &errMsg));
+        ASSERT_TRUE(settings.isValid(NULL));
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 1);
+        ASSERT_EQUALS(settings.getMigrationMaxShardLoad(), 0);
+
+        ASSERT(settings.parseBSON(BSON(SettingsType::key("balancer") <<
+                                       SettingsType::maxConcurrentMigrations(0)), &errMsg));
+        ASSERT_FALSE(settings.isValid(NULL));
     }
 
     TEST(Validity, BadType) {
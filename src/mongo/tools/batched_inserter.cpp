@@ -0,0 +1,171 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/batched_inserter.h"
+
+#include "mongo/client/dbclientinterface.h"
+
+namespace mongo {
+
+    const size_t BatchedInserter::MAX_BATCH_DOCS(1000);
+    const int BatchedInserter::MAX_BATCH_BYTES(1024 * 1024 * 8);
+
+    BatchedInserter::BatchedInserter(DBClientBase& conn, const string& ns, int batchesInFlight,
+                                     bool continueOnError, const BatchCallback& afterBatch,
+                                     const InsertCheck& check)
+        : _conn(conn),
+          _ns(ns),
+          _continueOnError(continueOnError),
+          _afterBatch(afterBatch),
+          _check(check),
+          _currentBytes(0),
+          // BlockingQueue::push waits while size + 1 >= max, so leave room for one more
+          _queue(std::max(batchesInFlight, 0) + 1),
+          _mutex("BatchedInserter"),
+          _queued(0),
+          _sent(0) {
+        if (batchesInFlight > 0) {
+            _thread.reset(new boost::thread(boost::bind(&BatchedInserter::run, this)));
+        }
+    }
+
+    BatchedInserter::~BatchedInserter() {
+        finish();
+    }
+
+    void BatchedInserter::insert(const BSONObj& obj) {
+        if (failed()) {
+            return;
+        }
+        if (!_current.empty() && _currentBytes + obj.objsize() > MAX_BATCH_BYTES) {
+            queueBatch(false);
+        }
+        _current.push_back(obj.getOwned());
+        _currentBytes += obj.objsize();
+        if (_current.size() >= MAX_BATCH_DOCS) {
+            queueBatch(false);
+        }
+    }
+
+    void BatchedInserter::flush() {
+        queueBatch(false);
+        if (_thread) {
+            mongo::mutex::scoped_lock lk(_mutex);
+            while (_sent < _queued) {
+                _allSent.wait(lk.boost());
+            }
+        }
+    }
+
+    void BatchedInserter::finish() {
+        flush();
+        if (_thread) {
+            queueBatch(true);
+            _thread->join();
+            _thread.reset();
+        }
+    }
+
+    void BatchedInserter::queueBatch(bool stop) {
+        if (_current.empty() && !stop) {
+            return;
+        }
+        if (!_thread) {
+            sendBatch(_current);
+        }
+        else {
+            Batch batch;
+            batch.docs.swap(_current);
+            batch.stop = stop;
+            {
+                mongo::mutex::scoped_lock lk(_mutex);
+                _queued++;
+            }
+            _queue.push(batch);
+        }
+        _current.clear();
+        _currentBytes = 0;
+    }
+
+    void BatchedInserter::sendBatch(const vector<BSONObj>& docs) {
+        if (docs.empty() || failed()) {
+            return;
+        }
+        try {
+            if (_check) {
+                if (!sendChecked(docs)) {
+                    if (_continueOnError && docs.size() > 1) {
+                        // Nothing in the batch went in, find the documents that can't.
+                        for (size_t i = 0; i < docs.size(); i++) {
+                            if (!sendChecked(vector<BSONObj>(1, docs[i]))) {
+                                _numErrors.addAndFetch(1);
+                            }
+                        }
+                    }
+                    else {
+                        _numErrors.addAndFetch(1);
+                        if (!_continueOnError) {
+                            _failed.store(1);
+                        }
+                    }
+                }
+                if (_afterBatch) {
+                    _afterBatch(_conn, _numSent.load());
+                }
+                return;
+            }
+            _conn.insert(_ns, docs, _continueOnError ? InsertOption_ContinueOnError : 0);
+            const long long numSent = _numSent.addAndFetch(docs.size());
+            if (_afterBatch) {
+                _afterBatch(_conn, numSent);
+            }
+        }
+        catch (std::exception& e) {
+            error() << "error inserting into " << _ns << ": " << e.what() << endl;
+            _numErrors.addAndFetch(1);
+            if (!_continueOnError) {
+                _failed.store(1);
+            }
+        }
+    }
+
+    bool BatchedInserter::sendChecked(const vector<BSONObj>& docs) {
+        _conn.insert(_ns, docs);
+        if (!_check(_conn)) {
+            return false;
+        }
+        _numSent.addAndFetch(docs.size());
+        return true;
+    }
+
+    void BatchedInserter::run() {
+        while (true) {
+            Batch batch = _queue.blockingPop();
+            sendBatch(batch.docs);
+            {
+                mongo::mutex::scoped_lock lk(_mutex);
+                _sent++;
+                _allSent.notify_all();
+            }
+            if (batch.stop) {
+                return;
+            }
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,122 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/queue.h"
+
+namespace mongo {
+
+    class DBClientBase;
+
+    /**
+       BatchedInserter sends documents for one collection as batched inserts.  insert() only
+       queues the document, a background thread sends full batches, so the caller can read and
+       parse the next batches while earlier ones are on the wire.
+
+       Every insert goes over the one connection passed in, which is what a RemoteLoader
+       requires.  Nothing else may use that connection until flush() or finish() returns.
+       To write several collections at once, use one BatchedInserter and connection for each.
+
+       With batchesInFlight == 0 there is no background thread and each batch is sent from
+       insert() itself, which is what a DBDirectClient needs.
+
+       Inserts are fire-and-forget.  With an InsertCheck, usually a getLastError call, each
+       batch is sent without ContinueOnError, so the server applies it all or nothing, and is
+       checked before the next one.  A failed batch is sent again one document at a time, so
+       only the bad documents are lost, and those are left out of numSent().
+     */
+    class BatchedInserter : boost::noncopyable {
+    public:
+        /** Called on the sending thread after each batch, with the number of documents sent so far. */
+        typedef boost::function<void (DBClientBase& conn, long long numSent)> BatchCallback;
+
+        /** Called on the sending thread after each insert message, @return false if it failed. */
+        typedef boost::function<bool (DBClientBase& conn)> InsertCheck;
+
+        BatchedInserter(DBClientBase& conn, const string& ns, int batchesInFlight,
+                        bool continueOnError, const BatchCallback& afterBatch = BatchCallback(),
+                        const InsertCheck& check = InsertCheck());
+
+        /** Calls finish() if nobody has. */
+        ~BatchedInserter();
+
+        /** Queues a copy of obj, blocking if batchesInFlight batches are already waiting. */
+        void insert(const BSONObj& obj);
+
+        /** Sends any partial batch and waits until everything queued has been sent. */
+        void flush();
+
+        /** flush()es and stops the sending thread. */
+        void finish();
+
+        /** @return true once a batch failed without continueOnError, after which inserts are dropped */
+        bool failed() const { return _failed.load(); }
+
+        /** @return number of inserts that failed, batches or, once resent, single documents */
+        int numErrors() const { return _numErrors.load(); }
+
+        /** @return number of documents sent so far */
+        long long numSent() const { return _numSent.load(); }
+
+        static const size_t MAX_BATCH_DOCS;
+        static const int MAX_BATCH_BYTES;
+
+    private:
+        struct Batch {
+            vector<BSONObj> docs;
+            bool stop;
+        };
+
+        void queueBatch(bool stop);
+        void sendBatch(const vector<BSONObj>& docs);
+        bool sendChecked(const vector<BSONObj>& docs);
+        void run();
+
+        DBClientBase& _conn;
+        const string _ns;
+        const bool _continueOnError;
+        BatchCallback _afterBatch;
+        InsertCheck _check;
+
+        vector<BSONObj> _current;
+        int _currentBytes;
+
+        BlockingQueue<Batch> _queue;
+        boost::scoped_ptr<boost::thread> _thread;
+
+        // _queued and _sent count batches, flush() waits for them to match
+        mongo::mutex _mutex;
+        boost::condition _allSent;
+        long long _queued;
+        long long _sent;
+
+        AtomicUInt32 _failed;
+        AtomicUInt32 _numErrors;
+        AtomicInt64 _numSent;
+    };
+
+} // namespace mongo
@@ -42,7 +42,7 @@ public:
         ("type" , po::value<string>()->default_value("json") , "type of output: json,debug" )
         ;
         add_hidden_options()
-        ("file" , po::value<string>() , ".bson file" )
+        ("file" , po::value<string>() , ".bson or .bsonz file" )
         ;
         addPositionArg( "file" , 1 );
         _noconnection = true;
@@ -0,0 +1,157 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/compressed_bson.h"
+
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/lzblock.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using namespace mongoutils;
+
+    namespace {
+        const char kMagic[4] = { 'B', 'S', 'Z', '\xff' };
+        const unsigned kVersion = 1;
+        const size_t kBlockHeaderSize = 12;
+
+        // Blocks are whole objects, so a bit over one max size object at most.
+        const unsigned kMaxRawBlockSize = BSONObjMaxUserSize * 2;
+
+        void putUInt32(char* p, unsigned v) {
+            for (int i = 0; i < 4; i++) {
+                p[i] = static_cast<char>(v >> (8 * i));
+            }
+        }
+
+        unsigned getUInt32(const char* p) {
+            unsigned v = 0;
+            for (int i = 0; i < 4; i++) {
+                v |= static_cast<unsigned>(static_cast<unsigned char>(p[i])) << (8 * i);
+            }
+            return v;
+        }
+
+        unsigned checksum(const char* data, size_t len) {
+            unsigned h;
+            MurmurHash3_x86_32(data, len, 0, &h);
+            return h;
+        }
+    }
+
+    const size_t CompressedBSONWriter::TARGET_BLOCK_SIZE(1024 * 1024);
+
+    CompressedBSONWriter::CompressedBSONWriter(FILE* out)
+        : _out(out), _mutex("CompressedBSONWriter") {
+        char header[8];
+        memcpy(header, kMagic, 4);
+        putUInt32(header + 4, kVersion);
+        write(header, sizeof(header));
+    }
+
+    void CompressedBSONWriter::writeBlock(const char* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        verify(len <= kMaxRawBlockSize);
+        std::vector<char> block(kBlockHeaderSize + lzblock::maxCompressedLength(len));
+        size_t stored = lzblock::compress(data, len, &block[kBlockHeaderSize]);
+        if (stored >= len) {
+            memcpy(&block[kBlockHeaderSize], data, len);
+            stored = len;
+        }
+        putUInt32(&block[0], len);
+        putUInt32(&block[4], stored);
+        putUInt32(&block[8], checksum(data, len));
+
+        mongo::mutex::scoped_lock lk(_mutex);
+        write(&block[0], kBlockHeaderSize + stored);
+    }
+
+    void CompressedBSONWriter::finish() {
+        char end[kBlockHeaderSize];
+        memset(end, 0, sizeof(end));
+        mongo::mutex::scoped_lock lk(_mutex);
+        write(end, sizeof(end));
+    }
+
+    void CompressedBSONWriter::write(const char* data, size_t len) {
+        while (len) {
+            size_t ret = fwrite(data, 1, len, _out);
+            uassert(17332, errnoWithPrefix("couldn't write to file"), ret);
+            data += ret;
+            len -= ret;
+        }
+    }
+
+    bool CompressedBSONReader::isCompressedHeader(const char* first4) {
+        return memcmp(first4, kMagic, 4) == 0;
+    }
+
+    CompressedBSONReader::CompressedBSONReader(FILE* in) : _in(in), _bytesRead(0) {
+        char header[8];
+        read(header, sizeof(header));
+        uassert(17333, "not a compressed BSON file", isCompressedHeader(header));
+        const unsigned version = getUInt32(header + 4);
+        uassert(17334, str::stream() << "unsupported compressed BSON file version " << version,
+                version == kVersion);
+    }
+
+    bool CompressedBSONReader::nextBlock(std::vector<char>* block) {
+        char header[kBlockHeaderSize];
+        read(header, sizeof(header));
+        const unsigned rawLength = getUInt32(header);
+        const unsigned storedLength = getUInt32(header + 4);
+        const unsigned sum = getUInt32(header + 8);
+        if (rawLength == 0) {
+            return false;
+        }
+        uassert(17335, str::stream() << "invalid compressed BSON block lengths " << rawLength
+                                     << " " << storedLength,
+                rawLength <= kMaxRawBlockSize && storedLength <= rawLength);
+
+        block->resize(rawLength);
+        if (storedLength == rawLength) {
+            read(&(*block)[0], rawLength);
+        }
+        else {
+            _stored.resize(storedLength);
+            read(&_stored[0], storedLength);
+            size_t len;
+            uassert(17336, "corrupt compressed BSON block",
+                    lzblock::uncompress(&_stored[0], storedLength, &(*block)[0], rawLength, &len) &&
+                    len == rawLength);
+        }
+        uassert(17337, "compressed BSON block checksum mismatch",
+                checksum(&(*block)[0], rawLength) == sum);
+        return true;
+    }
+
+    void CompressedBSONReader::read(char* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        size_t amt = fread(data, 1, len, _in);
+        uassert(17338, "unexpected end of compressed BSON file", amt == len);
+        _bytesRead += len;
+    }
+
+} // namespace mongo
@@ -0,0 +1,89 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+       mongodump --compress writes .bsonz files.  They start with an 8 byte header, "BSZ\xff"
+       then a little endian version number, followed by blocks of
+
+           uint32 rawLength | uint32 storedLength | uint32 checksum | stored bytes
+
+       The raw bytes of a block are whole BSON objects.  They are stored lzblock-compressed,
+       or as is if that wouldn't be smaller (storedLength == rawLength).  checksum is
+       MurmurHash3 of the raw bytes.  A block with rawLength 0 ends the file, so a truncated
+       dump is noticed.
+
+       Blocks don't depend on each other and may be written in any order, which lets
+       mongodump write ranges of one collection from several threads into the same file.
+     */
+    class CompressedBSONWriter : boost::noncopyable {
+    public:
+        /** Raw block size writers should aim for. */
+        static const size_t TARGET_BLOCK_SIZE;
+
+        /** Writes the header to out, which must stay open until after finish(). */
+        explicit CompressedBSONWriter(FILE* out);
+
+        /** Compresses data[0, len), which must hold whole objects, and appends it as a block. Thread safe. */
+        void writeBlock(const char* data, size_t len);
+
+        /** Writes the end of file block. */
+        void finish();
+
+    private:
+        void write(const char* data, size_t len);
+
+        FILE* _out;
+        mongo::mutex _mutex;
+    };
+
+    class CompressedBSONReader : boost::noncopyable {
+    public:
+        /** @return true if the file starting with these 4 bytes is a .bsonz file */
+        static bool isCompressedHeader(const char* first4);
+
+        /** Reads and checks the header, in must be positioned at the start of the file. */
+        explicit CompressedBSONReader(FILE* in);
+
+        /**
+         * Reads the next block's raw bytes into block.  uasserts if the file is corrupt or
+         * truncated.
+         * @return false once the end of file block is reached
+         */
+        bool nextBlock(std::vector<char>* block);
+
+        /** @return how many bytes of the file have been read */
+        unsigned long long bytesRead() const { return _bytesRead; }
+
+    private:
+        void read(char* data, size_t len);
+
+        FILE* _in;
+        unsigned long long _bytesRead;
+        std::vector<char> _stored;
+    };
+
+} // namespace mongo
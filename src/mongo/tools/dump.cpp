@@ -20,15 +20,20 @@
 #include "mongo/pch.h"
 
 #include <fcntl.h>
+#include <deque>
 #include <map>
 #include <fstream>
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/base/initializer.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/tools/compressed_bson.h"
 #include "mongo/tools/tool.h"
 
 using namespace mongo;
@@ -36,22 +41,98 @@ using namespace mongo;
 namespace po = boost::program_options;
 
 class Dump : public Tool {
-    class FilePtr : boost::noncopyable {
+    /**
+     * One output file.  Ranges of a collection are dumped by different threads, each appends
+     * blocks of whole objects, so the objects in a file are only ordered within a range.
+     */
+    class OutputFile : boost::noncopyable {
     public:
-        /*implicit*/ FilePtr(FILE* f) : _f(f) {}
-        ~FilePtr() { fclose(_f); }
-        operator FILE*() { return _f; }
+        OutputFile(FILE* f, bool ownsFile, bool compress, const string& ns,
+                   unsigned long long expectedObjects)
+            : _file(f), _ownsFile(ownsFile), _ns(ns), _mutex("Dump::OutputFile"),
+              _progress(expectedObjects), _rangesLeft(1) {
+            if (compress) {
+                _compressed.reset(new CompressedBSONWriter(f));
+            }
+            _progress.setName(ns);
+            _progress.setUnits("objects");
+        }
+
+        ~OutputFile() {
+            if (_ownsFile) {
+                fclose(_file);
+            }
+        }
+
+        void appendBlock(const char* data, size_t len, int numObjects) {
+            if (_compressed) {
+                // compress outside the lock
+                _compressed->writeBlock(data, len);
+            }
+            mongo::mutex::scoped_lock lk(_mutex);
+            if (!_compressed) {
+                size_t written = 0;
+                while (written < len) {
+                    size_t ret = fwrite( data + written, 1, len - written, _file );
+                    uassert(14035, errnoWithPrefix("couldn't write to file"), ret);
+                    written += ret;
+                }
+            }
+            _progress.hit(numObjects);
+        }
+
+        void setNumRanges(unsigned n) { _rangesLeft.store(n); }
+
+        /** @return true if that was the last range, and the file is complete */
+        bool rangeDone() {
+            if (_rangesLeft.subtractAndFetch(1) != 0) {
+                return false;
+            }
+            if (_compressed) {
+                _compressed->finish();
+            }
+            fflush(_file);
+            log() << "\t\t " << _progress.done() << " objects from " << _ns << endl;
+            return true;
+        }
+
     private:
-        FILE* _f;
+        FILE* _file;
+        bool _ownsFile;
+        const string _ns;
+        scoped_ptr<CompressedBSONWriter> _compressed;
+        mongo::mutex _mutex;
+        ProgressMeter _progress;
+        AtomicUInt32 _rangesLeft;
+    };
+
+    /**
+     * A collection to dump, or once prepareCollection() has split it, one range of it.
+     * Ranges are [min, max) on _id, an empty bound is open.
+     */
+    struct DumpTask {
+        string ns;
+        boost::filesystem::path file; // empty for stdout
+        bool split;                   // whether prepareCollection() may split this
+        shared_ptr<OutputFile> out;   // set once prepared
+        BSONObj min;
+        BSONObj max;
     };
+
 public:
-    Dump() : Tool( "dump" , ALL , "" , "" , true ) {
+    Dump() : Tool( "dump" , ALL , "" , "" , true ),
+             _compress(false), _numThreads(1), _rangeSize(0),
+             _tasksMutex("Dump::_tasksMutex"), _preparing(0) {
         add_options()
         ("out,o", po::value<string>()->default_value("dump"), "output directory or \"-\" for stdout")
         ("query,q", po::value<string>() , "json query" )
         ("oplog", "Use oplog for point-in-time snapshotting" )
         ("repair", "try to recover a crashed database" )
         ("forceTableScan", "deprecated" )
+        ("compress", "write compressed .bsonz files, which mongorestore and bsondump read like .bson" )
+        ("numThreads", po::value<int>()->default_value(4), "number of connections dumping collections at once" )
+        ("rangeSizeMB", po::value<int>(), "split collections bigger than this into ranges of _id that are dumped at once; "
+                                          "each range is read in its own snapshot, so a split collection isn't dumped as of a single point in time" )
         ;
     }
 
@@ -68,70 +149,211 @@ public:
         out << "Export MongoDB data to BSON files.\n" << endl;
     }
 
-    // This is a functor that writes a BSONObj to a file
+    // This is a functor that collects BSONObjs into blocks for an OutputFile
     struct Writer {
-        Writer(FILE* out, ProgressMeter* m) :_out(out), _m(m) {}
+        Writer(OutputFile* out) : _out(out), _num(0) {}
 
         void operator () (const BSONObj& obj) {
-            size_t toWrite = obj.objsize();
-            size_t written = 0;
-
-            while (toWrite) {
-                size_t ret = fwrite( obj.objdata()+written, 1, toWrite, _out );
-                uassert(14035, errnoWithPrefix("couldn't write to file"), ret);
-                toWrite -= ret;
-                written += ret;
+            _buf.appendBuf(obj.objdata(), obj.objsize());
+            _num++;
+            if (static_cast<size_t>(_buf.len()) >= CompressedBSONWriter::TARGET_BLOCK_SIZE) {
+                flush();
             }
+        }
 
-            // if there's a progress bar, hit it
-            if (_m) {
-                _m->hit();
+        void flush() {
+            if (_num) {
+                _out->appendBlock(_buf.buf(), _buf.len(), _num);
+                _buf.reset();
+                _num = 0;
             }
         }
 
-        FILE* _out;
-        ProgressMeter* _m;
+        OutputFile* _out;
+        BufBuilder _buf;
+        int _num;
     };
 
-    void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
+    void doRange( DBClientBase& connBase, const DumpTask& task ) {
         Query q = _query;
+        if (!task.min.isEmpty() || !task.max.isEmpty()) {
+            q.hint(BSON("_id" << 1));
+            if (!task.min.isEmpty()) {
+                q.minKey(task.min);
+            }
+            if (!task.max.isEmpty()) {
+                q.maxKey(task.max);
+            }
+        }
 
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
-        if (startsWith(coll.c_str(), "local.oplog.")) {
+        if (startsWith(task.ns.c_str(), "local.oplog.")) {
             queryOptions |= QueryOption_OplogReplay;
         }
-        
-        DBClientBase& connBase = conn(true);
-        Writer writer(out, m);
+
+        Writer writer(task.out.get());
 
         // use low-latency "exhaust" mode if going over the network
         if (!_usingMongos && typeid(connBase) == typeid(DBClientConnection&)) {
             DBClientConnection& conn = static_cast<DBClientConnection&>(connBase);
-            boost::function<void(const BSONObj&)> castedWriter(writer); // needed for overload resolution
-            conn.query( castedWriter, coll.c_str() , q , NULL, queryOptions | QueryOption_Exhaust);
+            boost::function<void(const BSONObj&)> castedWriter(boost::ref(writer)); // needed for overload resolution
+            conn.query( castedWriter, task.ns.c_str() , q , NULL, queryOptions | QueryOption_Exhaust);
         }
         else {
             //This branch should only be taken with DBDirectClient or mongos which doesn't support exhaust mode
-            scoped_ptr<DBClientCursor> cursor(connBase.query( coll.c_str() , q , 0 , 0 , 0 , queryOptions ));
+            scoped_ptr<DBClientCursor> cursor(connBase.query( task.ns.c_str() , q , 0 , 0 , 0 , queryOptions ));
             while ( cursor->more() ) {
                 writer(cursor->next());
             }
         }
+        writer.flush();
     }
 
-    void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
-        log() << "\t" << coll << " to " << outputFile.string() << endl;
+    /**
+     * Opens the output for task and, if the collection is big enough, splits it into ranges.
+     * @return the ranges, task's own range first
+     */
+    vector<DumpTask> prepareCollection( DBClientBase& c, const DumpTask& task ) {
+        const unsigned long long count = c.count(task.ns.c_str(), BSONObj(), QueryOption_SlaveOk);
+
+        FILE* f = stdout;
+        if (!task.file.empty()) {
+            log() << "\t" << task.ns << " to " << task.file.string() << endl;
+            f = fopen(task.file.string().c_str(), "wb");
+            uassert(10262, errnoWithPrefix("couldn't open file"), f);
+        }
+
+        DumpTask range = task;
+        range.out.reset(new OutputFile(f, !task.file.empty(), _compress, task.ns, count));
+        vector<DumpTask> ranges;
+        ranges.push_back(range);
+
+        if (task.split && _numThreads > 1 && _rangeSize > 0 && !_usingMongos) {
+            BSONObj res;
+            // A collection without an _id index can't be split, and that's fine.
+            // splitVector aims for half full chunks, hence the doubling.
+            if (c.runCommand(nsToDatabase(task.ns),
+                             BSON("splitVector" << task.ns << "keyPattern" << BSON("_id" << 1) <<
+                                  "maxChunkSizeBytes" << 2 * _rangeSize),
+                             res, QueryOption_SlaveOk)) {
+                vector<BSONElement> splitKeys = res["splitKeys"].Array();
+                for (vector<BSONElement>::const_iterator it = splitKeys.begin(); it != splitKeys.end(); ++it) {
+                    BSONObj key = BSON("_id" << it->Obj().firstElement());
+                    ranges.back().max = key;
+                    ranges.push_back(range);
+                    ranges.back().min = key;
+                }
+                if (ranges.size() > 1) {
+                    LOG(1) << "\tdumping " << task.ns << " in " << ranges.size() << " ranges" << endl;
+                }
+            }
+            else {
+                LOG(1) << "\tnot splitting " << task.ns << ": " << res << endl;
+            }
+        }
+        range.out->setNumRanges(ranges.size());
+        return ranges;
+    }
+
+    bool nextTask( DumpTask* task ) {
+        mongo::mutex::scoped_lock lk(_tasksMutex);
+        // someone preparing a collection may be about to add ranges
+        while (_tasks.empty() && _preparing > 0) {
+            _tasksChanged.wait(lk.boost());
+        }
+        if (_tasks.empty()) {
+            return false;
+        }
+        *task = _tasks.front();
+        _tasks.pop_front();
+        if (!task->out) {
+            _preparing++;
+        }
+        return true;
+    }
+
+    void addRanges( const vector<DumpTask>& ranges ) {
+        mongo::mutex::scoped_lock lk(_tasksMutex);
+        // ahead of the other collections, so a split collection's file is finished sooner
+        _tasks.insert(_tasks.begin(), ranges.begin(), ranges.end());
+        _preparing--;
+        _tasksChanged.notify_all();
+    }
+
+    void dumpTasks( DBClientBase& c ) {
+        DumpTask task;
+        while (nextTask(&task)) {
+            try {
+                if (!task.out) {
+                    vector<DumpTask> ranges;
+                    try {
+                        ranges = prepareCollection(c, task);
+                    }
+                    catch (...) {
+                        addRanges(ranges);
+                        throw;
+                    }
+                    task = ranges.front();
+                    addRanges(vector<DumpTask>(ranges.begin() + 1, ranges.end()));
+                }
+                doRange(c, task);
+                task.out->rangeDone();
+            }
+            catch (DBException& e) {
+                error() << "error dumping " << task.ns << ": " << e.toString() << endl;
+                _numFailed.addAndFetch(1);
+            }
+        }
+    }
+
+    void dumpThread() {
+        try {
+            scoped_ptr<DBClientBase> c(newConnection());
+            dumpTasks(*c);
+        }
+        catch (DBException& e) {
+            error() << "assertion: " << e.toString() << endl;
+            _numFailed.addAndFetch(1);
+        }
+    }
 
-        FilePtr f (fopen(outputFile.string().c_str(), "wb"));
-        uassert(10262, errnoWithPrefix("couldn't open file"), f);
+    /** Dumps everything in _tasks, in parallel unless there's just one thread. */
+    void dumpAll() {
+        if (_numThreads <= 1 || _tasks.size() == 0) {
+            dumpTasks(conn(true));
+            return;
+        }
+        vector<shared_ptr<boost::thread> > threads;
+        for (int i = 0; i < _numThreads; i++) {
+            threads.push_back(shared_ptr<boost::thread>(
+                    new boost::thread(boost::bind(&Dump::dumpThread, this))));
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->join();
+        }
+    }
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
-        m.setName("Collection File Writing Progress");
-        m.setUnits("objects");
+    void addCollection( const string& coll , const boost::filesystem::path& outputFile , bool split ) {
+        DumpTask task;
+        task.ns = coll;
+        task.file = outputFile;
+        task.split = split;
+        _tasks.push_back(task);
+    }
 
-        doCollection(coll, f, &m);
+    /** Dumps coll right away over conn(), in one range. */
+    void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
+        DumpTask task;
+        task.ns = coll;
+        task.file = outputFile;
+        task.split = false;
+        task = prepareCollection(conn(true), task).front();
+        doRange(conn(true), task);
+        task.out->rangeDone();
+    }
 
-        log() << "\t\t " << m.done() << " objects" << endl;
+    string bsonExtension() const {
+        return _compress ? ".bsonz" : ".bson";
     }
 
     void writeMetadataFile( const string coll, boost::filesystem::path outputFile, 
@@ -169,7 +391,7 @@ public:
 
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, stdout, NULL);
+        writeCollectionFile( coll, boost::filesystem::path() );
     }
 
     void go( const string db , const boost::filesystem::path outdir ) {
@@ -220,7 +442,7 @@ public:
             
             if (nsToCollectionSubstring(name) == "system.indexes") {
               // Create system.indexes.bson for compatibility with pre 2.2 mongorestore
-              writeCollectionFile( name.c_str() , outdir / ( filename + ".bson" ) );
+              writeCollectionFile( name.c_str() , outdir / ( filename + bsonExtension() ) );
               // Don't dump indexes as *.metadata.json
               continue;
             }
@@ -234,7 +456,8 @@ public:
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
             string name = *it;
             const string filename = name.substr( db.size() + 1 );
-            writeCollectionFile( name , outdir / ( filename + ".bson" ) );
+            // the data is dumped by dumpAll(), along with every other database's
+            addCollection( name , outdir / ( filename + bsonExtension() ) , true );
             writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
         }
 
@@ -274,6 +497,25 @@ public:
                 _query = fromjson( q );
         }
 
+        _compress = hasParam("compress");
+        _numThreads = getParam("numThreads", 4);
+        // Off by default: each range gets its own snapshot.
+        if (hasParam("rangeSizeMB")) {
+            _rangeSize = getParam("rangeSizeMB", 0) * 1024LL * 1024;
+            if (_rangeSize <= 0) {
+                log() << "rangeSizeMB must be positive" << endl;
+                return -1;
+            }
+        }
+        if (_numThreads < 1) {
+            log() << "numThreads must be positive" << endl;
+            return -1;
+        }
+        if (hasParam("dbpath")) {
+            // A DBDirectClient can only be used from this thread.
+            _numThreads = 1;
+        }
+
         string opLogName = "";
         unsigned long long opLogStart = 0;
         if (hasParam("oplog")) {
@@ -361,20 +603,32 @@ public:
             go( db , root / db );
         }
 
+        dumpAll();
+
         if (!opLogName.empty()) {
             BSONObjBuilder b;
             b.appendDate("$gt", opLogStart);
 
             _query = BSON("ts" << b.obj());
 
-            writeCollectionFile( opLogName , root / "oplog.bson" );
+            writeCollectionFile( opLogName , root / ( "oplog" + bsonExtension() ) );
         }
 
-        return 0;
+        return _numFailed.load() ? -1 : 0;
     }
 
     bool _usingMongos;
     BSONObj _query;
+    bool _compress;
+    int _numThreads;
+    long long _rangeSize;
+
+    // Collections not yet started, and ranges of started collections not yet dumped
+    std::deque<DumpTask> _tasks;
+    mongo::mutex _tasksMutex;
+    boost::condition _tasksChanged;
+    int _preparing;
+    AtomicUInt32 _numFailed;
 };
 
 int main( int argc , char ** argv, char ** envp ) {
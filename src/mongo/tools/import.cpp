@@ -20,16 +20,23 @@
 #include "mongo/pch.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/tools/batched_inserter.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/text.h"
 #include "mongo/base/initializer.h"
 #include "mongo/client/remote_loader.h"
 
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/condition.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace mongo;
 using std::string;
@@ -52,6 +59,79 @@ class Import : public Tool {
     vector<string> _upsertFields;
     static const int BUF_SIZE;
 
+    /*
+     * JSON imports (one document per line) run as a pipeline: the main thread reads lines,
+     * several parse threads turn them into BSON, and one insert thread puts them back in file
+     * order and hands them to a BatchedInserter, which sends batches from yet another thread.
+     */
+    struct ParseJob {
+        long long seq;  // -1 tells a parse thread to exit
+        string line;
+    };
+
+    struct ParsedDoc {
+        long long seq;  // -1 once all parse threads have exited
+        BSONObj obj;
+        string error;   // if non-empty, parsing failed and line holds the input
+        string line;
+    };
+
+    static size_t parseJobSize(const ParseJob& job) {
+        return job.line.size() + 1;
+    }
+
+    static size_t parsedDocSize(const ParsedDoc& doc) {
+        return doc.obj.objsize() + doc.line.size() + doc.error.size();
+    }
+
+    /*
+     * Bounds the bytes of parsed documents the insert thread holds, in its queue or waiting
+     * for their turn.  Parse threads wait here before handing a document over, except with the
+     * one the insert thread needs next: parse threads holding later documents could otherwise
+     * fill the window and wait forever.
+     */
+    class ParsedWindow : boost::noncopyable {
+    public:
+        explicit ParsedWindow(size_t maxBytes) :
+            _mutex("Import::ParsedWindow"), _maxBytes(maxBytes), _bytes(0), _nextSeq(0) {
+        }
+
+        /** Waits until the parsed document doc fits. */
+        void enter(const ParsedDoc& doc) {
+            const size_t size = parsedDocSize(doc);
+            mongo::mutex::scoped_lock lk(_mutex);
+            while (doc.seq != _nextSeq && _bytes + size > _maxBytes) {
+                _left.wait(lk.boost());
+            }
+            _bytes += size;
+        }
+
+        /** The insert thread is done with doc, the next in file order. */
+        void leave(const ParsedDoc& doc) {
+            mongo::mutex::scoped_lock lk(_mutex);
+            _bytes -= parsedDocSize(doc);
+            _nextSeq = doc.seq + 1;
+            _left.notify_all();
+        }
+
+    private:
+        mongo::mutex _mutex;
+        boost::condition _left;
+        const size_t _maxBytes;
+        size_t _bytes;
+        long long _nextSeq;
+    };
+
+    int _numParseThreads;
+    int _batchesInFlight;
+    AtomicUInt32 _stopPipeline;
+
+    // Counters shared by the serial loop and the insert thread, only one of them runs.
+    int _num;
+    int _errors;
+    int _lastNumChecked;
+    int _batchesChecked;
+
     void csvTokenizeRow(const string& row, vector<string>& tokens) {
         bool inQuotes = false;
         bool prevWasQuote = false;
@@ -169,6 +249,199 @@ class Import : public Tool {
         return len;
     }
 
+    void parseThread(BlockingQueue<ParseJob>* toParse, BlockingQueue<ParsedDoc>* parsed,
+                     ParsedWindow* window) {
+        while (true) {
+            ParseJob job = toParse->blockingPop();
+            if (job.seq < 0) {
+                return;
+            }
+            ParsedDoc doc;
+            doc.seq = job.seq;
+            try {
+                doc.obj = parseJSONLine(&job.line[0]);
+            }
+            catch (std::exception& e) {
+                doc.error = e.what();
+                doc.line.swap(job.line);
+            }
+            window->enter(doc);
+            parsed->push(doc);
+        }
+    }
+
+    void insertThread(BlockingQueue<ParsedDoc>* parsed, ParsedWindow* window, const string& ns) {
+        BatchedInserter inserter(conn(), ns, _batchesInFlight, !hasParam("stopOnError"),
+                                 boost::bind(&Import::checkBatch, this, _2));
+        // Parse threads finish out of order, hold on to documents until their turn comes.
+        std::map<long long, ParsedDoc> pending;
+        long long nextSeq = 0;
+        while (true) {
+            ParsedDoc doc = parsed->blockingPop();
+            if (doc.seq < 0) {
+                break;
+            }
+            pending[doc.seq] = doc;
+            for (std::map<long long, ParsedDoc>::iterator it = pending.find(nextSeq);
+                 it != pending.end();
+                 it = pending.find(++nextSeq)) {
+                if (inserter.failed()) {
+                    _stopPipeline.store(1);
+                }
+                if (!_stopPipeline.load()) {
+                    handleParsed(it->second, ns, inserter);
+                }
+                window->leave(it->second);
+                pending.erase(it);
+            }
+        }
+        inserter.finish();
+        _num += inserter.numSent();
+        _errors += inserter.numErrors();
+    }
+
+    void handleParsed(const ParsedDoc& doc, const string& ns, BatchedInserter& inserter) {
+        if (!doc.error.empty()) {
+            log() << "exception:" << doc.error << endl;
+            log() << doc.line << endl;
+            _errors++;
+            if (hasParam("stopOnError")) {
+                _stopPipeline.store(1);
+            }
+            return;
+        }
+        if (!_doimport) {
+            _num++;
+            return;
+        }
+        if (_upsert) {
+            // upserts are sent one at a time from this thread, nothing goes through the inserter
+            try {
+                insertOrUpsert(ns, doc.obj);
+            }
+            catch (std::exception& e) {
+                log() << "exception:" << e.what() << endl;
+                _errors++;
+                if (hasParam("stopOnError")) {
+                    _stopPipeline.store(1);
+                }
+            }
+            _num++;
+            return;
+        }
+        inserter.insert(doc.obj);
+    }
+
+    /** Runs on the inserter's thread after each batch. */
+    void checkBatch(long long numSent) {
+        if (_batchesChecked < 10) {
+            // As with single inserts, check the first few batches.
+            checkLastError();
+            _batchesChecked++;
+            _lastNumChecked = numSent - 1;
+        }
+    }
+
+    /** Runs the JSON pipeline described above until the input is exhausted */
+    void runJSONPipeline(istream* in, const string& ns, ProgressMeter& pm, time_t start) {
+        // push() waits while size + item >= max, so a full BUF_SIZE line must still fit
+        BlockingQueue<ParseJob> toParse(2 * BUF_SIZE, &parseJobSize);
+        // The window bounds the parsed queue together with the insert thread's reorder map.
+        BlockingQueue<ParsedDoc> parsed;
+        ParsedWindow window(2 * BUF_SIZE);
+
+        boost::thread inserter(boost::bind(&Import::insertThread, this, &parsed, &window, ns));
+        vector<boost::shared_ptr<boost::thread> > parsers;
+        for (int i = 0; i < _numParseThreads; i++) {
+            parsers.push_back(boost::shared_ptr<boost::thread>(
+                    new boost::thread(boost::bind(&Import::parseThread, this, &toParse, &parsed, &window))));
+        }
+
+        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
+        long long seq = 0;
+        // _errors belongs to the insert thread until it exits
+        int readErrors = 0;
+        while (in->rdstate() == 0 && !_stopPipeline.load()) {
+            char* line = buffer.get();
+            int len;
+            try {
+                len = getLine(in, line);
+            }
+            catch (std::exception& e) {
+                log() << "exception:" << e.what() << endl;
+                readErrors++;
+                if (hasParam("stopOnError")) {
+                    break;
+                }
+                continue;
+            }
+            line += len;
+            if (line[0] == '\0') {
+                continue;
+            }
+            ParseJob job;
+            job.seq = seq++;
+            job.line = line;
+            len += job.line.size();
+            toParse.push(job);
+
+            if (pm.hit(len + 1)) {
+                log() << "\t\t\t" << seq << "\t" << ( seq / std::max<time_t>( time(0) - start, 1 ) ) << "/second" << endl;
+            }
+        }
+
+        ParseJob done;
+        done.seq = -1;
+        for (size_t i = 0; i < parsers.size(); i++) {
+            toParse.push(done);
+        }
+        for (size_t i = 0; i < parsers.size(); i++) {
+            parsers[i]->join();
+        }
+        ParsedDoc allParsed;
+        allParsed.seq = -1;
+        parsed.push(allParsed);
+        inserter.join();
+        _errors += readErrors;
+    }
+
+    BSONObj parseJSONLine(char* line) {
+        // Strip out trailing whitespace
+        char * end = ( line + strlen( line ) ) - 1;
+        while ( end >= line && isspace(*end) ) {
+            *end = 0;
+            end--;
+        }
+        try {
+            return fromjson( line );
+        } catch ( MsgAssertionException& e ) {
+            uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
+        }
+        return BSONObj(); // not reached
+    }
+
+    void insertOrUpsert(const string& ns, const BSONObj& o) {
+        bool doUpsert = _upsert;
+        BSONObjBuilder b;
+        if (_upsert) {
+            for (vector<string>::const_iterator it=_upsertFields.begin(), end=_upsertFields.end(); it!=end; ++it) {
+                BSONElement e = o.getFieldDotted(it->c_str());
+                if (e.eoo()) {
+                    doUpsert = false;
+                    break;
+                }
+                b.appendAs(e, *it);
+            }
+        }
+
+        if (doUpsert) {
+            conn().update(ns, Query(b.obj()), o, true);
+        }
+        else {
+            conn().insert( ns.c_str() , o );
+        }
+    }
+
     /*
      * Parses one object from the input file.  This usually corresponds to one line in the input
      * file, unless the file is a CSV and contains a newline within a quoted string entry.
@@ -187,17 +460,7 @@ class Import : public Tool {
         numBytesRead += strlen( line );
 
         if (_type == JSON) {
-            // Strip out trailing whitespace
-            char * end = ( line + strlen( line ) ) - 1;
-            while ( end >= line && isspace(*end) ) {
-                *end = 0;
-                end--;
-            }
-            try {
-                o = fromjson( line );
-            } catch ( MsgAssertionException& e ) {
-                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
-            }
+            o = parseJSONLine(line);
             return true;
         }
 
@@ -281,6 +544,8 @@ public:
         ("upsertFields", po::value<string>(), "comma-separated fields for the query part of the upsert. You should make sure this is indexed" )
         ("stopOnError", "stop importing at first error rather than continuing" )
         ("jsonArray", "load a json array, not one item per line. Currently limited to 16MB." )
+        ("numParseThreads", po::value<int>(), "number of threads parsing JSON documents while another sends batched inserts; 0 parses and inserts one document at a time (default 2)" )
+        ("batchesInFlight", po::value<int>(), "number of insert batches to read ahead while the previous one is sent (default 4)" )
         ;
         add_hidden_options()
         ("noimport", "don't actually import. useful for benchmarking parser" )
@@ -292,6 +557,8 @@ public:
         _upsert = false;
         _doimport = true;
         _jsonArray = false;
+        _numParseThreads = 2;
+        _batchesInFlight = 4;
     }
     ;
     virtual void printExtraHelp( ostream & out ) {
@@ -418,12 +685,25 @@ public:
             _jsonArray = true;
         }
 
+        _numParseThreads = getParam("numParseThreads", _numParseThreads);
+        _batchesInFlight = getParam("batchesInFlight", _batchesInFlight);
+        if (_numParseThreads < 0 || _batchesInFlight < 0) {
+            error() << "numParseThreads and batchesInFlight must be non-negative" << endl;
+            return -1;
+        }
+        if (usingDirectClient()) {
+            // A DBDirectClient can only be used from this thread.
+            _numParseThreads = 0;
+        }
+
         time_t start = time(0);
         LOG(1) << "filesize: " << fileSize << endl;
         ProgressMeter pm( fileSize );
-        int num = 0;
-        int lastNumChecked = num;
-        int errors = 0;
+        _num = 0;
+        _lastNumChecked = 0;
+        _errors = 0;
+        _batchesChecked = 0;
+        _stopPipeline.store(0);
         lastErrorFailures = 0;
         int len = 0;
         // buffer and line are only used when parsing a jsonArray
@@ -437,7 +717,11 @@ public:
             NamespaceString n(ns);
             loader.reset(new RemoteLoader(conn(), n.db, n.coll, vector<BSONObj>(), BSONObj()));
         }
-        while ( _jsonArray || in->rdstate() == 0 ) {
+        const bool pipelined = _type == JSON && !_jsonArray && _numParseThreads > 0;
+        if (pipelined) {
+            runJSONPipeline(in, ns, pm, start);
+        }
+        while ( !pipelined && ( _jsonArray || in->rdstate() == 0 ) ) {
             try {
                 BSONObj o;
                 if (_jsonArray) {
@@ -464,47 +748,29 @@ public:
                     _headerLine = false;
                 }
                 else if (_doimport) {
-                    bool doUpsert = _upsert;
-                    BSONObjBuilder b;
-                    if (_upsert) {
-                        for (vector<string>::const_iterator it=_upsertFields.begin(), end=_upsertFields.end(); it!=end; ++it) {
-                            BSONElement e = o.getFieldDotted(it->c_str());
-                            if (e.eoo()) {
-                                doUpsert = false;
-                                break;
-                            }
-                            b.appendAs(e, *it);
-                        }
-                    }
-
-                    if (doUpsert) {
-                        conn().update(ns, Query(b.obj()), o, true);
-                    }
-                    else {
-                        conn().insert( ns.c_str() , o );
-                    }
+                    insertOrUpsert(ns, o);
 
-                    if( num < 10 ) { 
+                    if( _num < 10 ) { 
                         // we absolutely want to check the first and last op of the batch. we do 
                         // a few more as that won't be too time expensive.
                         checkLastError();
-                        lastNumChecked = num;
+                        _lastNumChecked = _num;
                     }
                 }
 
-                num++;
+                _num++;
             }
             catch ( std::exception& e ) {
                 log() << "exception:" << e.what() << endl;
                 log() << line << endl;
-                errors++;
+                _errors++;
 
                 if (hasParam("stopOnError") || _jsonArray)
                     break;
             }
 
             if ( pm.hit( len + 1 ) ) {
-                log() << "\t\t\t" << num << "\t" << ( num / ( time(0) - start ) ) << "/second" << endl;
+                log() << "\t\t\t" << _num << "\t" << ( _num / ( time(0) - start ) ) << "/second" << endl;
             }
         }
         if (loader) {
@@ -513,21 +779,21 @@ public:
 
         // this is for two reasons: to wait for all operations to reach the server and be processed, and this will wait until all data reaches the server,
         // and secondly to check if there were an error (on the last op)
-        if( lastNumChecked+1 != num ) { // avoid redundant log message if already reported above
-            log() << "check " << lastNumChecked << " " << num << endl;
+        if( _lastNumChecked+1 != _num ) { // avoid redundant log message if already reported above
+            log() << "check " << _lastNumChecked << " " << _num << endl;
             checkLastError();
         }
 
-        bool hadErrors = lastErrorFailures || errors;
+        bool hadErrors = lastErrorFailures || _errors;
 
         // the message is vague on lastErrorFailures as we don't call it on every single operation. 
         // so if we have a lastErrorFailure there might be more than just what has been counted.
-        log() << (lastErrorFailures ? "tried to import " : "imported ") << ( num - headerRows ) << " objects" << endl;
+        log() << (lastErrorFailures ? "tried to import " : "imported ") << ( _num - headerRows ) << " objects" << endl;
 
         if ( !hadErrors )
             return 0;
 
-        error() << "encountered " << (lastErrorFailures?"at least ":"") << lastErrorFailures+errors <<  " error(s)" << ( lastErrorFailures+errors == 1 ? "" : "s" ) << endl;
+        error() << "encountered " << (lastErrorFailures?"at least ":"") << lastErrorFailures+_errors <<  " error(s)" << ( lastErrorFailures+_errors == 1 ? "" : "s" ) << endl;
         return -1;
     }
 };
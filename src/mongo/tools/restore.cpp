@@ -24,6 +24,8 @@
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
 #include <fcntl.h>
 #include <fstream>
 #include <set>
@@ -35,6 +37,9 @@
 #include "mongo/db/json.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/remote_loader.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/tools/batched_inserter.h"
+#include "mongo/util/timer.h"
 
 using namespace mongo;
 
@@ -48,14 +53,42 @@ public:
     bool _restoreIndexes;
     int _w;
     bool _doBulkLoad;
-    string _curns;
-    string _curdb;
-    string _curcoll;
-    set<string> _users; // For restoring users with --drop
+    int _numParallelCollections;
+    int _batchesInFlight;
+
+    // A .bson file found by drillDown(), restored later by restoreCollection()
+    struct CollectionJob {
+        boost::filesystem::path file;
+        string ns;
+        string oldCollName; // Name of the collection that was dumped from
+        unsigned long long fileSize;
+
+        bool operator<(const CollectionJob& other) const {
+            // Biggest first, so a large collection doesn't start after everything else is done
+            return fileSize > other.fileSize;
+        }
+    };
+    vector<CollectionJob> _jobs;
+    mongo::mutex _jobsMutex;
+    size_t _nextJob;
+    AtomicInt64 _numRestored;
+    AtomicUInt32 _numFailedJobs;
+
+    // The collection restoreCollection() is writing to, and the connection it writes over
+    struct Target {
+        DBClientBase* conn;
+        string ns;
+        string db;
+        string coll;
+        set<string> users; // For restoring users with --drop
+        long long numUpdated; // Users replaced in place instead of inserted
+        BatchedInserter* inserter;
+    };
 
     Restore() : BSONTool( "restore" ),
         _drop(false), _restoreOptions(false), _restoreIndexes(false),
-        _w(0), _doBulkLoad(false) {
+        _w(0), _doBulkLoad(false), _numParallelCollections(1), _batchesInFlight(0),
+        _jobsMutex("Restore::_jobsMutex"), _nextJob(0) {
         // Default values set here will show up in help text, but will supercede any default value
         // used when calling getParam below.
         add_options()
@@ -67,6 +100,8 @@ public:
         ("noIndexRestore" , "don't restore indexes")
         ("w" , po::value<int>()->default_value(0) , "minimum number of replicas per write. WARNING, setting w > 1 prevents the bulk load optimization." )
         ("noLoader", "don't use bulk loader")
+        ("numParallelCollections", po::value<int>()->default_value(4), "number of collections to restore at once, each over its own connection")
+        ("batchesInFlight", po::value<int>()->default_value(4), "number of insert batches per collection to read ahead while the previous one is sent")
         ;
         add_hidden_options()
         ("dir", po::value<string>()->default_value("dump"), "directory to restore from")
@@ -115,23 +150,95 @@ public:
         if (hasParam( "oplogLimit" )) {
             log() << "warning: --oplogLimit is deprecated in TokuMX" << endl;
         }
+        // Make sure default values set here stay in sync with the ones set in the constructor above.
+        _numParallelCollections = getParam( "numParallelCollections" , 4 );
+        _batchesInFlight = getParam( "batchesInFlight" , 4 );
+        if (_numParallelCollections < 1 || _batchesInFlight < 0) {
+            error() << "--numParallelCollections must be positive and --batchesInFlight non-negative" << endl;
+            return -1;
+        }
+        if (usingDirectClient()) {
+            // A DBDirectClient can only be used from this thread.
+            _numParallelCollections = 1;
+            _batchesInFlight = 0;
+        }
 
         /* If _db is not "" then the user specified a db name to restore as.
          *
          * In that case we better be given either a root directory that
-         * contains only .bson files or a single .bson file  (a db).
+         * contains only .bson (or .bsonz) files or a single .bson file  (a db).
          *
          * In the case where a collection name is specified we better be
          * given either a root directory that contains only a single
          * .bson file, or a single .bson file itself (a collection).
          */
         drillDown(root, _db != "", _coll != "", true);
+
+        Timer t;
+        restoreCollections();
+        log() << "restored " << _numRestored.load() << " objects in " << _jobs.size()
+              << " collections in " << t.seconds() << " seconds ("
+              << (_numRestored.load() * 1000000 / std::max<unsigned long long>(t.micros(), 1)) << "/second)" << endl;
+
         string err = conn().getLastError(_db == "" ? "admin" : _db);
         if (!err.empty()) {
             error() << err;
         }
 
-        return EXIT_CLEAN;
+        return _numFailedJobs.load() ? -1 : EXIT_CLEAN;
+    }
+
+    void restoreCollections() {
+        const size_t numThreads = std::min(static_cast<size_t>(_numParallelCollections), _jobs.size());
+        if (numThreads <= 1) {
+            for (vector<CollectionJob>::const_iterator it = _jobs.begin(); it != _jobs.end(); ++it) {
+                restoreCollection(conn(), *it);
+            }
+            return;
+        }
+
+        std::stable_sort(_jobs.begin(), _jobs.end());
+        vector<boost::shared_ptr<boost::thread> > threads;
+        for (size_t i = 0; i < numThreads; i++) {
+            threads.push_back(boost::shared_ptr<boost::thread>(
+                    new boost::thread(boost::bind(&Restore::restoreThread, this))));
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->join();
+        }
+    }
+
+    void restoreThread() {
+        try {
+            scoped_ptr<DBClientBase> c(newConnection());
+            while (true) {
+                CollectionJob job;
+                {
+                    mongo::mutex::scoped_lock lk(_jobsMutex);
+                    if (_nextJob == _jobs.size()) {
+                        return;
+                    }
+                    job = _jobs[_nextJob++];
+                }
+                try {
+                    restoreCollection(*c, job);
+                }
+                catch (DBException& e) {
+                    error() << "failed to restore " << job.ns << ": " << e.toString() << endl;
+                    _numFailedJobs.addAndFetch(1);
+                }
+            }
+        }
+        catch (DBException& e) {
+            error() << "assertion: " << e.toString() << endl;
+            _numFailedJobs.addAndFetch(1);
+        }
+    }
+
+    /** @return true if p is a dump of collection collName, compressed or not */
+    static bool isDumpFileOf( const boost::filesystem::path& p, const string& collName ) {
+        const string leaf = p.leaf().string();
+        return leaf == collName + ".bson" || leaf == collName + ".bsonz";
     }
 
     void drillDown( boost::filesystem::path root, bool use_db, bool use_coll, bool top_level=false ) {
@@ -167,11 +274,11 @@ public:
                 }
 
                 // don't insert oplog
-                if (top_level && !use_db && p.leaf() == "oplog.bson")
+                if (top_level && !use_db && isDumpFileOf(p, "oplog"))
                     continue;
 
                 // Only restore indexes from a corresponding .metadata.json file.
-                if ( p.leaf() != "system.indexes.bson" ) {
+                if ( !isDumpFileOf(p, "system.indexes") ) {
                     drillDown(p, use_db, use_coll);
                 }
             }
@@ -185,15 +292,14 @@ public:
         }
 
         if ( ! ( endsWith( root.string().c_str() , ".bson" ) ||
+                 endsWith( root.string().c_str() , ".bsonz" ) ||
                  endsWith( root.string().c_str() , ".bin" ) ) ) {
             error() << "don't know what to do with file [" << root.string() << "]" << endl;
             return;
         }
 
-        log() << root.string() << endl;
-
-        if ( root.leaf() == "system.profile.bson" ) {
-            log() << "\t skipping" << endl;
+        if ( isDumpFileOf(root, "system.profile") ) {
+            log() << root.string() << "\t skipping" << endl;
             return;
         }
 
@@ -209,28 +315,48 @@ public:
 
         verify( ns.size() );
 
-        string oldCollName = root.leaf().string(); // Name of the collection that was dumped from
-        oldCollName = oldCollName.substr( 0 , oldCollName.find_last_of( "." ) );
+        CollectionJob job;
+        job.file = root;
+        job.oldCollName = root.leaf().string();
+        job.oldCollName = job.oldCollName.substr( 0 , job.oldCollName.find_last_of( "." ) );
         if (use_coll) {
             ns += "." + _coll;
         }
         else {
-            ns += "." + oldCollName;
+            ns += "." + job.oldCollName;
         }
+        job.ns = ns;
+        job.fileSize = boost::filesystem::file_size( root );
+        _jobs.push_back(job);
+    }
+
+    void restoreCollection( DBClientBase& c, const CollectionJob& job ) {
+        const boost::filesystem::path& root = job.file;
+        const string& ns = job.ns;
+        const string& oldCollName = job.oldCollName;
 
-        log() << "\tgoing into namespace [" << ns << "]" << endl;
+        log() << root.string() << "\tgoing into namespace [" << ns << "]" << endl;
+
+        Target t;
+        t.conn = &c;
+        t.ns = ns;
+        NamespaceString nss(ns);
+        t.db = nss.db;
+        t.coll = nss.coll;
+        t.numUpdated = 0;
+        t.inserter = NULL;
 
         if ( _drop ) {
-            if (root.leaf() != "system.users.bson" ) {
-                log() << "\t dropping" << endl;
-                conn().dropCollection( ns );
+            if (!isDumpFileOf(root, "system.users") ) {
+                log() << "\t dropping " << ns << endl;
+                c.dropCollection( ns );
             } else {
                 // Create map of the users currently in the DB
                 BSONObj fields = BSON("user" << 1);
-                scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
+                scoped_ptr<DBClientCursor> cursor(c.query(ns, Query(), 0, 0, &fields));
                 while (cursor->more()) {
                     BSONObj user = cursor->next();
-                    _users.insert(user["user"].String());
+                    t.users.insert(user["user"].String());
                 }
             }
         }
@@ -249,15 +375,10 @@ public:
             }
         }
 
-        _curns = ns.c_str();
-        NamespaceString nss(_curns);
-        _curdb = nss.db;
-        _curcoll = nss.coll;
-
         // If drop is not used, warn if the collection exists.
         if (!_drop) {
-            scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces",
-                                                            Query(BSON("name" << ns))));
+            scoped_ptr<DBClientCursor> cursor(c.query(t.db + ".system.namespaces",
+                                                      Query(BSON("name" << ns))));
             if (cursor->more()) {
                 // collection already exists show warning
                 warning() << "Restoring to " << ns << " without dropping. Restored data "
@@ -271,66 +392,94 @@ public:
             const vector<BSONElement> indexElements = metadataObject["indexes"].Array();
             for (vector<BSONElement>::const_iterator it = indexElements.begin(); it != indexElements.end(); ++it) {
                 // Need to make sure the ns field gets updated to
-                // the proper _curdb + _curns value, if we're
+                // the proper db and collection names, if we're
                 // restoring to a different database.
-                const BSONObj indexObj = renameIndexNs(it->Obj());
+                const BSONObj indexObj = renameIndexNs(t, it->Obj());
                 indexes.push_back(indexObj);
             }
         }
         const BSONObj options = _restoreOptions && metadataObject.hasField("options") ?
                                 metadataObject["options"].Obj() : BSONObj();
 
+        const BatchedInserter::InsertCheck check = boost::bind(&Restore::checkInsert, this, _1, t.db);
+
         if (_doBulkLoad) {
-            RemoteLoader loader(conn(), _curdb, _curcoll, indexes, options);
-            processFile( root );
+            RemoteLoader loader(c, t.db, t.coll, indexes, options);
+            {
+                BatchedInserter inserter(c, ns, _batchesInFlight, true,
+                                         BatchedInserter::BatchCallback(), check);
+                t.inserter = &inserter;
+                processFile( root, boost::bind(&Restore::insertObject, this, boost::ref(t), _1) );
+                inserter.finish();
+                t.inserter = NULL;
+                _numRestored.addAndFetch(inserter.numSent() + t.numUpdated);
+            }
             BSONObj res;
             bool ok = loader.commit(&res);
             if (!ok) {
-                error() << "Error committing load for " << _curdb << "." << _curcoll << ": " << res << endl;
+                error() << "Error committing load for " << ns << ": " << res << endl;
             }
         } else {
             // No bulk load. Create collection and indexes manually.
             if (!options.isEmpty()) {
-                createCollectionWithOptions(options);
+                createCollectionWithOptions(t, options);
             }
             // Build indexes last - it's a little faster.
-            processFile( root );
+            {
+                BatchedInserter inserter(c, ns, _batchesInFlight, true,
+                                         BatchedInserter::BatchCallback(), check);
+                t.inserter = &inserter;
+                processFile( root, boost::bind(&Restore::insertObject, this, boost::ref(t), _1) );
+                inserter.finish();
+                t.inserter = NULL;
+                _numRestored.addAndFetch(inserter.numSent() + t.numUpdated);
+            }
             for (vector<BSONObj>::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                createIndex(*it);
+                createIndex(t, *it);
             }
         }
 
-        if (_drop && root.leaf() == "system.users.bson") {
+        if (_drop && isDumpFileOf(root, "system.users")) {
             // Delete any users that used to exist but weren't in the dump file
-            for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
+            for (set<string>::iterator it = t.users.begin(); it != t.users.end(); ++it) {
                 BSONObj userMatch = BSON("user" << *it);
-                conn().remove(ns, Query(userMatch));
+                c.remove(ns, Query(userMatch));
             }
-            _users.clear();
         }
     }
 
     virtual void gotObject( const BSONObj& obj ) {
-        StringData collstr = nsToCollectionSubstring(_curns);
+        // restoreCollection() hands objects to insertObject() instead
+        verify( false );
+    }
+
+    void insertObject( Target& t, const BSONObj& obj ) {
+        StringData collstr = nsToCollectionSubstring(t.ns);
         massert( 16910, "Shouldn't be inserting into system.indexes directly",
                         collstr != "system.indexes" );
-        if (_drop && collstr == "system.users" && _users.count(obj["user"].String())) {
+        if (_drop && collstr == "system.users" && t.users.count(obj["user"].String())) {
             // Since system collections can't be dropped, we have to manually
             // replace the contents of the system.users collection
             BSONObj userMatch = BSON("user" << obj["user"].String());
-            conn().update(_curns, Query(userMatch), obj);
-            _users.erase(obj["user"].String());
+            // the inserter shares the connection, wait for it to be idle
+            t.inserter->flush();
+            t.conn->update(t.ns, Query(userMatch), obj);
+            t.users.erase(obj["user"].String());
+            t.numUpdated++;
         } else {
-            conn().insert( _curns , obj );
+            t.inserter->insert( obj );
+        }
+    }
 
-            // wait for insert to propagate to "w" nodes (doesn't warn if w used without replset)
-            if ( _w > 0 ) {
-                string err = conn().getLastError(_curdb, false, false, _w);
-                if (!err.empty()) {
-                    error() << err << endl;
-                }
-            }
+    /** @return false if the last insert over c failed, after waiting for it to reach "w" nodes */
+    bool checkInsert( DBClientBase& c, const string& db ) {
+        string err = c.getLastError(db, false, false, _w);
+        if (err.empty()) {
+            return true;
         }
+        error() << err << endl;
+        // With "norepl" the insert went in, there are just no replicas to wait for.
+        return err == "norepl";
     }
 
 private:
@@ -369,14 +518,14 @@ private:
         return nfields == obj2.nFields();
     }
 
-    void createCollectionWithOptions(BSONObj obj) {
+    void createCollectionWithOptions(const Target& t, BSONObj obj) {
         BSONObjIterator i(obj);
 
         // Rebuild obj as a command object for the "create" command.
         // - {create: <name>} comes first, where <name> is the new name for the collection
         // - elements with type Undefined get skipped over
         BSONObjBuilder bo;
-        bo.append("create", _curcoll);
+        bo.append("create", t.coll);
         while (i.more()) {
             BSONElement e = i.next();
 
@@ -385,7 +534,7 @@ private:
             }
 
             if (e.type() == Undefined) {
-                log() << _curns << ": skipping undefined field: " << e.fieldName() << endl;
+                log() << t.ns << ": skipping undefined field: " << e.fieldName() << endl;
                 continue;
             }
 
@@ -394,14 +543,14 @@ private:
         obj = bo.obj();
 
         BSONObj fields = BSON("options" << 1);
-        scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces", Query(BSON("name" << _curns)), 0, 0, &fields));
+        scoped_ptr<DBClientCursor> cursor(t.conn->query(t.db + ".system.namespaces", Query(BSON("name" << t.ns)), 0, 0, &fields));
 
         bool createColl = true;
         if (cursor->more()) {
             createColl = false;
             BSONObj nsObj = cursor->next();
             if (!nsObj.hasField("options") || !optionsSame(obj, nsObj["options"].Obj())) {
-                    log() << "WARNING: collection " << _curns << " exists with different options than are in the metadata.json file and not using --drop. Options in the metadata file will be ignored." << endl;
+                    log() << "WARNING: collection " << t.ns << " exists with different options than are in the metadata.json file and not using --drop. Options in the metadata file will be ignored." << endl;
             }
         }
 
@@ -410,21 +559,20 @@ private:
         }
 
         BSONObj info;
-        if (!conn().runCommand(_curdb, obj, info)) {
-            uasserted(15936, "Creating collection " + _curns + " failed. Errmsg: " + info["errmsg"].String());
+        if (!t.conn->runCommand(t.db, obj, info)) {
+            uasserted(15936, "Creating collection " + t.ns + " failed. Errmsg: " + info["errmsg"].String());
         } else {
-            log() << "\tCreated collection " << _curns << " with options: " << obj.jsonString() << endl;
+            log() << "\tCreated collection " << t.ns << " with options: " << obj.jsonString() << endl;
         }
     }
 
-    BSONObj renameIndexNs(const BSONObj &orig) {
+    BSONObj renameIndexNs(const Target& t, const BSONObj &orig) {
         BSONObjBuilder bo;
         BSONObjIterator i(orig);
         while ( i.more() ) {
             BSONElement e = i.next();
             if (strcmp(e.fieldName(), "ns") == 0) {
-                string s = _curdb + "." + _curcoll;
-                bo.append("ns", s);
+                bo.append("ns", t.ns);
             }
             else if (strcmp(e.fieldName(), "v") != 0) { // Remove index version number
                 bo.append(e);
@@ -435,12 +583,12 @@ private:
 
     /* We must handle if the dbname or collection name is different at restore time than what was dumped.
      */
-    void createIndex(BSONObj indexObj) {
+    void createIndex(const Target& t, BSONObj indexObj) {
         LOG(0) << "\tCreating index: " << indexObj << endl;
-        conn().insert( _curdb + ".system.indexes" ,  indexObj );
+        t.conn->insert( t.db + ".system.indexes" ,  indexObj );
 
         // We're stricter about errors for indexes than for regular data
-        BSONObj err = conn().getLastErrorDetailed(_curdb, false, false, _w);
+        BSONObj err = t.conn->getLastErrorDetailed(t.db, false, false, _w);
 
         if (err.hasField("err") && !err["err"].isNull()) {
             if (err["err"].str() == "norepl" && _w > 1) {
@@ -0,0 +1,255 @@
+// snapshotload.cpp
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include <boost/program_options.hpp>
+
+#include "mongo/tools/tool.h"
+
+#include "mongo/base/error_codes.h"
+#include "mongo/base/initializer.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/client.h"
+#include "mongo/db/collection.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespacestring.h"
+#include "mongo/db/ops/insert.h"
+#include "mongo/db/snapshot_stream.h"
+#include "mongo/db/storage/dbt.h"
+#include "mongo/util/password.h"
+#include "mongo/util/timer.h"
+
+using namespace mongo;
+
+namespace po = boost::program_options;
+
+/**
+ * Copies a running node into a new, offline data directory: takes a snapshot of the source
+ * with beginSnapshot, streams every collection's rows with streamSnapshot, and puts them
+ * into the local collections with the bulk loader, which builds the secondary indexes.
+ */
+class SnapshotLoad : public Tool {
+    string _rpass;
+    string _rauthenticationDatabase;
+    string _rauthenticationMechanism;
+
+    long long _nRows;
+    long long _nBytes;
+
+public:
+    SnapshotLoad() : Tool("snapshotload", LOCAL_SERVER, "", "", false), _nRows(0), _nBytes(0) {
+        add_options()
+        ("from", po::value<string>() , "host to copy from" )
+        ("ruser", po::value<string>(), "username on source host if auth required" )
+        ("rpass", new PasswordValue( &_rpass ), "password on source host" )
+        ("rauthenticationDatabase",
+         po::value<string>(&_rauthenticationDatabase)->default_value("admin"),
+         "user source on source host (defaults to \"admin\")" )
+        ("rauthenticationMechanism",
+         po::value<string>(&_rauthenticationMechanism)->default_value("MONGODB-CR"),
+         "authentication mechanism on source host")
+        ;
+    }
+
+    virtual void printExtraHelp(ostream& out) {
+        out << "Copy a snapshot of a running server into an empty --dbpath.\n" << endl;
+    }
+
+    int run() {
+        if (!hasParam("from") || !hasParam("dbpath")) {
+            log() << "need to specify --from and --dbpath" << endl;
+            return -1;
+        }
+
+        DBClientConnection src;
+        string errmsg;
+        if (!src.connect(getParam("from"), errmsg)) {
+            error() << "couldn't connect to " << getParam("from") << ": " << errmsg << endl;
+            return -1;
+        }
+        if (hasParam("ruser")) {
+            if (!hasParam("rpass")) {
+                log() << "if using auth on source, must specify both --ruser and --rpass" << endl;
+                return -1;
+            }
+            try {
+                src.auth(BSON("user" << getParam("ruser") <<
+                              "userSource" << _rauthenticationDatabase <<
+                              "pwd" << _rpass <<
+                              "mechanism" << _rauthenticationMechanism));
+            } catch (DBException &e) {
+                if (e.getCode() == ErrorCodes::AuthenticationFailed) {
+                    error() << "error authenticating to " << _rauthenticationDatabase << " on source: "
+                            << e.what() << endl;
+                    return -1;
+                }
+                throw;
+            }
+        }
+
+        // listDatabases can't run in the snapshot.  A database created after this is missed,
+        // one dropped after it is found empty.
+        const list<string> dbs = src.getDatabaseNames();
+
+        BSONObj res;
+        if (!src.runCommand("admin", BSON("beginSnapshot" << 1), res)) {
+            error() << "couldn't begin snapshot on source: " << res << endl;
+            return -1;
+        }
+        if (res["position"].isABSONObj()) {
+            // Ops from minUnappliedGTID through liveGTID may already be in the copy.
+            log() << "snapshot position: " << res["position"].Obj() << endl;
+        }
+
+        Timer t;
+        for (list<string>::const_iterator it = dbs.begin(); it != dbs.end(); ++it) {
+            copyDatabase(src, *it);
+        }
+
+        if (!src.runCommand("admin", BSON("commitTransaction" << 1), res)) {
+            warning() << "couldn't end snapshot on source: " << res << endl;
+        }
+
+        const int secs = max(t.seconds(), 1);
+        log() << "loaded " << _nRows << " rows, " << _nBytes / (1024 * 1024) << "MB in "
+              << t.seconds() << " seconds (" << _nBytes / (1024 * 1024) / secs << "MB/s)" << endl;
+        return 0;
+    }
+
+private:
+    static bool shouldCopy(const string &db, const StringData &ns) {
+        const StringData coll = nsToCollectionSubstring(ns);
+        if (!NamespaceString::normal(ns) || coll == "system.indexes" ||
+            coll == "system.namespaces" || coll == "system.profile") {
+            return false;
+        }
+        if (db == "local") {
+            // Just what's needed to resume replication from the snapshot.
+            return coll == "oplog.rs" || coll == "oplog.refs" || coll == "replInfo" ||
+                    coll == "system.replset";
+        }
+        return true;
+    }
+
+    void copyDatabase(DBClientConnection &src, const string &db) {
+        vector<BSONObj> collections;
+        {
+            auto_ptr<DBClientCursor> c = src.query(db + ".system.namespaces", Query());
+            while (c->more()) {
+                BSONObj coll = c->nextSafe();
+                if (shouldCopy(db, coll["name"].valuestrsafe())) {
+                    collections.push_back(coll.getOwned());
+                }
+            }
+        }
+        map<string, vector<BSONObj> > indexes;
+        {
+            auto_ptr<DBClientCursor> c = src.query(db + ".system.indexes", Query());
+            while (c->more()) {
+                BSONObj idx = c->nextSafe();
+                indexes[idx["ns"].valuestrsafe()].push_back(idx.getOwned());
+            }
+        }
+
+        for (vector<BSONObj>::const_iterator it = collections.begin(); it != collections.end(); ++it) {
+            const string ns = (*it)["name"].String();
+            copyCollection(src, ns, (*it).getObjectField("options"), indexes[ns]);
+        }
+    }
+
+    void copyCollection(DBClientConnection &src, const string &ns, const BSONObj &options,
+                        const vector<BSONObj> &indexes) {
+        BSONObj res;
+        if (!src.runCommand(nsToDatabase(ns), BSON("streamSnapshot" << nsToCollectionSubstring(ns)), res)) {
+            // dropped since we listed it
+            warning() << "not copying " << ns << ": " << res << endl;
+            return;
+        }
+        const BSONObj cursorObj = res["cursor"].Obj();
+        auto_ptr<DBClientCursor> frames = src.getMore(cursorObj["ns"].String(),
+                                                      cursorObj["id"].numberLong());
+        uassert(17346, "couldn't read " + ns + " from the snapshot", frames.get() != NULL);
+
+        // Capped and partitioned collections can't be bulk loaded, and the rows of a capped
+        // collection are keyed on this node's insertion order, so they are inserted as documents.
+        const bool bulkLoad = nsToDatabaseSubstring(ns) != "local" &&
+                !NamespaceString::isSystem(ns) &&
+                !options["capped"].trueValue() &&
+                !options["natural"].trueValue() &&
+                !options["partitioned"].trueValue();
+
+        log() << "copying " << ns << (bulkLoad ? "" : " without the bulk loader") << endl;
+        long long n = 0;
+
+        Client::Transaction txn(DB_SERIALIZABLE);
+        LOCK_REASON(lockReason, "snapshotload: loading collection");
+        Client::WriteContext ctx(ns, lockReason);
+
+        if (bulkLoad) {
+            beginBulkLoad(ns, indexes, options);
+            BulkLoadedCollection *cl = getCollection(ns)->as<BulkLoadedCollection>();
+            while (frames->more()) {
+                SnapshotFrameReader reader(frames->nextSafe());
+                while (reader.more()) {
+                    const SnapshotFrameReader::Row row = reader.next();
+                    DBT key = storage::dbt_make(row.key, row.keySize);
+                    DBT val = storage::dbt_make(row.val, row.valSize);
+                    cl->insertRow(&key, &val);
+                    noteRow(row);
+                    n++;
+                }
+            }
+            commitBulkLoad(ns);
+        }
+        else {
+            string errmsg;
+            userCreateNS(ns, options, errmsg, false);
+            Collection *cl = getCollection(ns);
+            massert(17345, mongoutils::str::stream() << "couldn't create " << ns << ": " << errmsg, cl != NULL);
+            while (frames->more()) {
+                SnapshotFrameReader reader(frames->nextSafe());
+                while (reader.more()) {
+                    const SnapshotFrameReader::Row row = reader.next();
+                    BSONObj obj(row.val);
+                    insertOneObject(cl, obj);
+                    noteRow(row);
+                    n++;
+                }
+            }
+            const string indexNs = getSisterNS(ns, "system.indexes");
+            for (vector<BSONObj>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                insertObject(indexNs.c_str(), *it, 0, false);
+            }
+        }
+
+        txn.commit();
+        log() << "\t" << n << " rows" << endl;
+    }
+
+    void noteRow(const SnapshotFrameReader::Row &row) {
+        _nRows++;
+        _nBytes += row.keySize + row.valSize;
+    }
+};
+
+int main( int argc , char** argv, char **envp ) {
+    mongo::runGlobalInitializersOrDie(argc, argv, envp);
+    SnapshotLoad t;
+    return t.main( argc , argv );
+}
@@ -32,7 +32,9 @@
 #include "mongo/db/txn_complete_hooks.h"
 #include "mongo/db/storage/env.h"
 #include "mongo/platform/posix_fadvise.h"
+#include "mongo/tools/compressed_bson.h"
 #include "mongo/util/password.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/version.h"
 
 using namespace std;
@@ -432,10 +434,32 @@ namespace mongo {
             return;
         }
 
-        _conn->auth( BSON( saslCommandPrincipalSourceFieldName << getAuthenticationDatabase() <<
-                           saslCommandPrincipalFieldName << _username <<
-                           saslCommandPasswordFieldName << _password  <<
-                           saslCommandMechanismFieldName << _authenticationMechanism ) );
+        authConn( _conn );
+    }
+
+    void Tool::authConn( DBClientBase* conn ) {
+        conn->auth( BSON( saslCommandPrincipalSourceFieldName << getAuthenticationDatabase() <<
+                          saslCommandPrincipalFieldName << _username <<
+                          saslCommandPasswordFieldName << _password  <<
+                          saslCommandMechanismFieldName << _authenticationMechanism ) );
+    }
+
+    DBClientBase* Tool::newConnection() {
+        verify( !usingDirectClient() && !_noconnection );
+
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse( _host , errmsg );
+        uassert( 17330, str::stream() << "invalid hostname [" << _host << "] " << errmsg,
+                 cs.isValid() );
+
+        auto_ptr<DBClientBase> c( cs.connect( errmsg ) );
+        uassert( 17331, str::stream() << "couldn't connect to [" << _host << "] " << errmsg,
+                 c.get() );
+
+        if ( !_username.empty() ) {
+            authConn( c.get() );
+        }
+        return c.release();
     }
 
     BSONTool::BSONTool( const char * name, DBAccess access , bool objcheck )
@@ -461,22 +485,53 @@ namespace mongo {
         return doRun();
     }
 
+    bool BSONTool::handleObject( const BSONObj& o, const ObjectSink& sink ) {
+        if ( _objcheck && ! o.valid() ) {
+            cerr << "INVALID OBJECT - going try and pring out " << endl;
+            cerr << "size: " << o.objsize() << endl;
+            BSONObjIterator i(o);
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                try {
+                    e.validate();
+                }
+                catch ( ... ) {
+                    cerr << "\t\t NEXT ONE IS INVALID" << endl;
+                }
+                cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
+                cerr << "\t " << e << endl;
+            }
+        }
+
+        if ( _matcher.get() == 0 || _matcher->matches( o ) ) {
+            sink( o );
+            return true;
+        }
+        return false;
+    }
+
     long long BSONTool::processFile( const boost::filesystem::path& root ) {
         _fileName = root.string();
+        return processFile( root, boost::bind( &BSONTool::gotObject, this, _1 ) );
+    }
+
+    long long BSONTool::processFile( const boost::filesystem::path& root, const ObjectSink& sink ) {
+        const string fileName = root.string();
 
         unsigned long long fileLength = file_size( root );
 
         if ( fileLength == 0 ) {
-            out() << "file " << _fileName << " empty, skipping" << endl;
+            out() << "file " << fileName << " empty, skipping" << endl;
             return 0;
         }
 
 
-        FILE* file = fopen( _fileName.c_str() , "rb" );
+        FILE* file = fopen( fileName.c_str() , "rb" );
         if ( ! file ) {
-            log() << "error opening file: " << _fileName << " " << errnoWithDescription() << endl;
+            log() << "error opening file: " << fileName << " " << errnoWithDescription() << endl;
             return 0;
         }
+        ON_BLOCK_EXIT(fclose, file);
 
 #ifdef POSIX_FADV_SEQUENTIAL
         posix_fadvise(fileno(file), 0, fileLength, POSIX_FADV_SEQUENTIAL);
@@ -494,52 +549,64 @@ namespace mongo {
 
         ProgressMeter m( fileLength );
         m.setUnits( "bytes" );
-
-        while ( read < fileLength ) {
-            size_t amt = fread(buf, 1, 4, file);
-            verify( amt == 4 );
-
-            int size = ((int*)buf)[0];
-            uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
-
-            amt = fread(buf+4, 1, size-4, file);
-            verify( amt == (size_t)( size - 4 ) );
-
-            BSONObj o( buf );
-            if ( _objcheck && ! o.valid() ) {
-                cerr << "INVALID OBJECT - going try and pring out " << endl;
-                cerr << "size: " << size << endl;
-                BSONObjIterator i(o);
-                while ( i.more() ) {
-                    BSONElement e = i.next();
-                    try {
-                        e.validate();
-                    }
-                    catch ( ... ) {
-                        cerr << "\t\t NEXT ONE IS INVALID" << endl;
-                    }
-                    cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
-                    cerr << "\t " << e << endl;
+        m.setName( root.leaf().string() );
+
+        size_t amt = fread(buf, 1, 4, file);
+        verify( amt == 4 );
+        if ( CompressedBSONReader::isCompressedHeader( buf ) ) {
+            // .bsonz from mongodump --compress, see compressed_bson.h
+            verify( fseek( file, 0, SEEK_SET ) == 0 );
+            CompressedBSONReader reader( file );
+            vector<char> block;
+            while ( reader.nextBlock( &block ) ) {
+                size_t pos = 0;
+                while ( pos < block.size() ) {
+                    uassert( 17339, "truncated object in compressed BSON block" , block.size() - pos >= 5 );
+                    int size;
+                    memcpy( &size, &block[pos], 4 );
+                    uassert( 17356 , str::stream() << "invalid object size: " << size ,
+                             size >= 5 && static_cast<size_t>(size) <= block.size() - pos );
+
+                    BSONObj o( &block[pos] );
+                    if ( handleObject( o, sink ) )
+                        processed++;
+                    pos += size;
+                    num++;
                 }
+                m.hit( reader.bytesRead() - read );
+                read = reader.bytesRead();
             }
+            // the end block
+            m.hit( reader.bytesRead() - read );
+        }
+        else {
+            while ( true ) {
+                int size = ((int*)buf)[0];
+                uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
 
-            if ( _matcher.get() == 0 || _matcher->matches( o ) ) {
-                gotObject( o );
-                processed++;
-            }
+                amt = fread(buf+4, 1, size-4, file);
+                verify( amt == (size_t)( size - 4 ) );
 
-            read += o.objsize();
-            num++;
+                BSONObj o( buf );
+                if ( handleObject( o, sink ) )
+                    processed++;
 
-            m.hit( o.objsize() );
-        }
+                read += o.objsize();
+                num++;
 
-        fclose( file );
+                m.hit( o.objsize() );
+
+                if ( read >= fileLength )
+                    break;
+                amt = fread(buf, 1, 4, file);
+                verify( amt == 4 );
+            }
+        }
 
         uassert( 10265 ,  "counts don't match" , m.done() == fileLength );
-        (_usesstdout ? cout : cerr ) << m.hits() << " objects found" << endl;
+        (_usesstdout ? cout : cerr ) << num << " objects found in " << fileName << endl;
         if ( _matcher.get() )
-            (_usesstdout ? cout : cerr ) << processed << " objects processed" << endl;
+            (_usesstdout ? cout : cerr ) << processed << " objects processed in " << fileName << endl;
         return processed;
     }
 
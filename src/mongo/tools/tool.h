@@ -20,6 +20,7 @@
 
 #include <string>
 
+#include <boost/function.hpp>
 #include <boost/program_options.hpp>
 
 #if defined(_WIN32)
@@ -106,6 +107,16 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * Opens another connection to the server conn() talks to and authenticates it the same
+         * way, for tools that write from several threads.  Not available with --dbpath.
+         * The caller owns the returned connection.
+         */
+        mongo::DBClientBase* newConnection();
+
+        /** @return true if conn() is a direct client on a --dbpath, not a connection to a server */
+        bool usingDirectClient() { return hasParam( "dbpath" ); }
+
         string _name;
 
         string _db;
@@ -144,6 +155,7 @@ namespace mongo {
 
     private:
         void auth();
+        void authConn( DBClientBase* conn );
     };
 
     class BSONTool : public Tool {
@@ -160,6 +172,17 @@ namespace mongo {
 
         long long processFile( const boost::filesystem::path& file );
 
+        typedef boost::function<void (const BSONObj&)> ObjectSink;
+
+        /**
+         * Like processFile( file ) but hands objects to sink instead of gotObject(), and doesn't
+         * touch any per-tool state, so several threads may each process their own file.
+         */
+        long long processFile( const boost::filesystem::path& file, const ObjectSink& sink );
+
+    private:
+        /** Checks o if asked to and passes it on if it matches --filter, @return true if passed on */
+        bool handleObject( const BSONObj& o, const ObjectSink& sink );
     };
 
 }
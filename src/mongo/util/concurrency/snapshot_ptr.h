@@ -0,0 +1,260 @@
+// @file snapshot_ptr.h
+
+/*    Copyright (C) 2013 Tokutek Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
+#include <boost/thread/tss.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    using boost::thread_specific_ptr;
+    using std::list;
+
+    /**
+     * SnapshotPtr holds an immutable T that is only ever replaced as a whole, for data that is
+     * read much more often than it changes.
+     *
+     * Readers look at the current version through a Reader, which takes no lock and writes no
+     * memory shared with other threads: each thread announces the version it is reading in a slot
+     * of its own (a hazard pointer), the same way PartitionedCounter keeps a sum per thread.
+     * replace() publishes a new version and deletes the old versions no thread announces, so
+     * there is at most one old version per reading thread left over.
+     *
+     * A thread's slots are found by the SnapshotPtr's id, not its address, since a SnapshotPtr
+     * may be destroyed (with its database) and a new one built at the same address while other
+     * threads still have slots for the old one.  Those are deleted when their thread exits or
+     * next makes a slot.
+     *
+     * Calls to replace() must be serialized by the caller.  A thread may only have one Reader at
+     * a time on a given SnapshotPtr, and none may be left when the SnapshotPtr is destroyed.
+     */
+    template<typename T>
+    class SnapshotPtr : boost::noncopyable {
+        class ThreadState;
+
+      public:
+        /** Takes ownership of initial, which must not be NULL. */
+        explicit SnapshotPtr(T *initial);
+        ~SnapshotPtr();
+
+        class Reader : boost::noncopyable {
+          public:
+            explicit Reader(const SnapshotPtr &sp);
+            ~Reader();
+
+            const T &operator*() const { return *_p; }
+            const T *operator->() const { return _p; }
+
+          private:
+            ThreadState &_ts;
+            const T *_p;
+        };
+
+        /**
+         * Makes next, which this takes ownership of, the current version, and deletes the old
+         * versions no Reader is using any more.
+         */
+        void replace(T *next);
+
+        /** The current version, for whoever calls replace(), which can't race with it. */
+        const T &current() const { return *_current.load(); }
+
+      private:
+        class ThreadStateData : boost::noncopyable {
+            // NULL once the SnapshotPtr is destroyed.  Protected by registryMutex().
+            const SnapshotPtr *_sp;
+            AtomicWord<const T *> _reading;
+          public:
+            ThreadStateData(const SnapshotPtr *sp) : _sp(sp), _reading(NULL) {}
+            friend class SnapshotPtr;
+        };
+        class ThreadState : public ThreadStateData {
+            char _pad[64 - sizeof(ThreadStateData)];
+          public:
+            ThreadState(const SnapshotPtr *sp) : ThreadStateData(sp) {}
+        };
+
+        /** One thread's ThreadStates, by SnapshotPtr id.  Deleted when the thread exits. */
+        class ThreadStateMap : boost::noncopyable {
+          public:
+            ThreadStateMap() : _lastId(0), _last(NULL) {}
+            ~ThreadStateMap();
+            /** Deletes the states of destroyed SnapshotPtrs.  Requires registryMutex(). */
+            void pruneOrphans();
+
+            std::map<unsigned long long, ThreadState *> _states;
+            // The last one looked up, as a thread mostly reads the same SnapshotPtr over again.
+            unsigned long long _lastId;
+            ThreadState *_last;
+        };
+        typedef typename std::map<unsigned long long, ThreadState *>::iterator map_iterator;
+
+        // Never destroyed, so threads exiting after static destructors ran can still use them.
+        // Protects every _threadStates list and ThreadState::_sp of this type.
+        static SimpleMutex &registryMutex() {
+            static SimpleMutex *m = new SimpleMutex("SnapshotPtr");
+            return *m;
+        }
+        static thread_specific_ptr<ThreadStateMap> &threadStateMaps() {
+            static thread_specific_ptr<ThreadStateMap> *maps = new thread_specific_ptr<ThreadStateMap>();
+            return *maps;
+        }
+        static unsigned long long nextId() {
+            static unsigned long long id = 0;
+            SimpleMutex::scoped_lock lk(registryMutex());
+            return ++id;
+        }
+
+        ThreadState& ts() const;
+
+        const unsigned long long _id;
+        AtomicWord<const T *> _current;
+        mutable list<ThreadState *> _threadStates;
+        typedef typename list<ThreadState *>::iterator states_iterator;
+        std::vector<const T *> _retired;
+    };
+
+    template<typename T>
+    SnapshotPtr<T>::ThreadStateMap::~ThreadStateMap() {
+        SimpleMutex::scoped_lock lk(registryMutex());
+        for (map_iterator it = _states.begin(); it != _states.end(); ++it) {
+            ThreadState *ts = it->second;
+            if (ts->_sp != NULL) {
+                ts->_sp->_threadStates.remove(ts);
+            }
+            delete ts;
+        }
+    }
+
+    template<typename T>
+    void SnapshotPtr<T>::ThreadStateMap::pruneOrphans() {
+        for (map_iterator it = _states.begin(); it != _states.end(); ) {
+            if (it->second->_sp == NULL) {
+                if (it->second == _last) {
+                    _last = NULL;
+                    _lastId = 0;
+                }
+                delete it->second;
+                _states.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    template<typename T>
+    SnapshotPtr<T>::SnapshotPtr(T *initial) : _id(nextId()), _current(initial) {
+        verify(initial != NULL);
+    }
+
+    template<typename T>
+    SnapshotPtr<T>::~SnapshotPtr() {
+        {
+            // The other threads' states for us are deleted by those threads, see
+            // ThreadStateMap.  No other SnapshotPtr gets our id, so they're never used again.
+            SimpleMutex::scoped_lock lk(registryMutex());
+            for (states_iterator it = _threadStates.begin(); it != _threadStates.end(); ++it) {
+                dassert((*it)->_reading.load() == NULL);
+                (*it)->_sp = NULL;
+            }
+        }
+        for (typename std::vector<const T *>::const_iterator it = _retired.begin(); it != _retired.end(); ++it) {
+            delete *it;
+        }
+        delete _current.load();
+    }
+
+    template<typename T>
+    typename SnapshotPtr<T>::ThreadState& SnapshotPtr<T>::ts() const {
+        ThreadStateMap *m = threadStateMaps().get();
+        if (m == NULL) {
+            m = new ThreadStateMap();
+            threadStateMaps().reset(m);
+        }
+        if (m->_lastId == _id) {
+            return *m->_last;
+        }
+        map_iterator it = m->_states.find(_id);
+        if (it == m->_states.end()) {
+            ThreadState *ts = new ThreadState(this);
+            SimpleMutex::scoped_lock lk(registryMutex());
+            m->pruneOrphans();
+            _threadStates.push_back(ts);
+            it = m->_states.insert(std::make_pair(_id, ts)).first;
+        }
+        m->_lastId = _id;
+        m->_last = it->second;
+        return *it->second;
+    }
+
+    template<typename T>
+    SnapshotPtr<T>::Reader::Reader(const SnapshotPtr &sp) : _ts(sp.ts()), _p(sp._current.load()) {
+        dassert(_ts._reading.load() == NULL);
+        // Announce the version we're about to read, then make sure it's still current.  If it
+        // is, replace() retired it after our announcement, so it will see it and keep it.
+        while (true) {
+            _ts._reading.store(_p);
+            const T *p = sp._current.load();
+            if (p == _p) {
+                break;
+            }
+            _p = p;
+        }
+    }
+
+    template<typename T>
+    SnapshotPtr<T>::Reader::~Reader() {
+        _ts._reading.store(NULL);
+    }
+
+    template<typename T>
+    void SnapshotPtr<T>::replace(T *next) {
+        verify(next != NULL);
+        const T *old = _current.swap(next);
+
+        _retired.push_back(old);
+        std::vector<const T *> reading;
+        {
+            SimpleMutex::scoped_lock lk(registryMutex());
+            for (states_iterator it = _threadStates.begin(); it != _threadStates.end(); ++it) {
+                const T *p = (*it)->_reading.load();
+                if (p != NULL) {
+                    reading.push_back(p);
+                }
+            }
+        }
+        std::vector<const T *> stillReading;
+        for (typename std::vector<const T *>::const_iterator it = _retired.begin(); it != _retired.end(); ++it) {
+            if (std::find(reading.begin(), reading.end(), *it) != reading.end()) {
+                stillReading.push_back(*it);
+            } else {
+                delete *it;
+            }
+        }
+        _retired.swap(stillReading);
+    }
+
+} // namespace mongo
@@ -0,0 +1,151 @@
+/*    Copyright (C) 2013 Tokutek Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/ref.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/snapshot_ptr.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+
+    using namespace mongo;
+
+    // Counts live instances, to check that old versions get deleted.
+    class Version {
+      public:
+        static AtomicWord<int> live;
+        explicit Version(int v) : _v(v), _check(v) { live.fetchAndAdd(1); }
+        ~Version() { _check = -1; live.fetchAndSubtract(1); }
+        int get() const { return _v; }
+        bool ok() const { return _check == _v; }
+      private:
+        const int _v;
+        volatile int _check;
+    };
+    AtomicWord<int> Version::live;
+
+    TEST(SnapshotPtrTest, ReadAndReplace) {
+        {
+            SnapshotPtr<Version> sp(new Version(1));
+            {
+                SnapshotPtr<Version>::Reader r(sp);
+                ASSERT_EQUALS(1, r->get());
+            }
+            sp.replace(new Version(2));
+            ASSERT_EQUALS(1, Version::live.load());
+            ASSERT_EQUALS(2, sp.current().get());
+            SnapshotPtr<Version>::Reader r(sp);
+            ASSERT_EQUALS(2, (*r).get());
+        }
+        ASSERT_EQUALS(0, Version::live.load());
+    }
+
+    TEST(SnapshotPtrTest, ReaderKeepsItsVersion) {
+        SnapshotPtr<Version> sp(new Version(1));
+        {
+            SnapshotPtr<Version>::Reader r(sp);
+            sp.replace(new Version(2));
+            sp.replace(new Version(3));
+            // 1 is being read, 2 was never read
+            ASSERT_EQUALS(2, Version::live.load());
+            ASSERT_EQUALS(1, r->get());
+            ASSERT(r->ok());
+        }
+        sp.replace(new Version(4));
+        ASSERT_EQUALS(1, Version::live.load());
+    }
+
+    static void readThread(SnapshotPtr<Version>& sp, volatile bool& running, AtomicWord<int>& bad) {
+        int last = 0;
+        while (running) {
+            SnapshotPtr<Version>::Reader r(sp);
+            // versions only go forward, and are never deleted under us
+            if (!r->ok() || r->get() < last) {
+                bad.fetchAndAdd(1);
+            }
+            last = r->get();
+        }
+    }
+
+    TEST(SnapshotPtrTest, Threading) {
+        static const int NTHREADS = 8;
+        static const int NVERSIONS = 20000;
+        {
+            SnapshotPtr<Version> sp(new Version(0));
+            volatile bool running = true;
+            AtomicWord<int> bad;
+            boost::thread_group group;
+            for (int i = 0; i < NTHREADS; ++i) {
+                group.add_thread(new boost::thread(readThread, boost::ref(sp), boost::ref(running), boost::ref(bad)));
+            }
+            for (int v = 1; v <= NVERSIONS; ++v) {
+                sp.replace(new Version(v));
+                // at most one old version per reader is left over
+                ASSERT_LESS_THAN_OR_EQUALS(Version::live.load(), NTHREADS + 1);
+            }
+            running = false;
+            group.join_all();
+            ASSERT_EQUALS(0, bad.load());
+        }
+        ASSERT_EQUALS(0, Version::live.load());
+    }
+
+    // Steps of SameAddress, each thread waits for the other's.
+    static AtomicWord<int> step;
+
+    static void waitFor(int s) {
+        while (step.load() != s) {
+            boost::this_thread::yield();
+        }
+    }
+
+    static void readOldThenNew(SnapshotPtr<Version> *sp) {
+        {
+            SnapshotPtr<Version>::Reader r(*sp);
+        }
+        step.store(1);
+        waitFor(2);
+        SnapshotPtr<Version>::Reader r(*sp);
+        step.store(3);
+        waitFor(4);
+        ASSERT(r->ok());
+    }
+
+    TEST(SnapshotPtrTest, SameAddress) {
+        // A new SnapshotPtr in the place of a destroyed one, like a CollectionMap of a database
+        // that was closed and opened again, doesn't get the old one's slots.
+        boost::aligned_storage<sizeof(SnapshotPtr<Version>)>::type storage;
+        SnapshotPtr<Version> *sp = new (&storage) SnapshotPtr<Version>(new Version(0));
+        boost::thread reader(readOldThenNew, sp);
+        waitFor(1);
+        sp->~SnapshotPtr<Version>();
+        sp = new (&storage) SnapshotPtr<Version>(new Version(0));
+        step.store(2);
+        waitFor(3);
+        sp->replace(new Version(1));
+        // the reader's version is kept
+        ASSERT_EQUALS(2, Version::live.load());
+        step.store(4);
+        reader.join();
+        sp->~SnapshotPtr<Version>();
+        ASSERT_EQUALS(0, Version::live.load());
+    }
+
+} // namespace
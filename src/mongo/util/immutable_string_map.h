@@ -0,0 +1,199 @@
+// @file immutable_string_map.h
+
+/*    Copyright (C) 2013 Tokutek Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * A map from strings to V that is never changed in place: set() and erase() return a new
+     * map, which shares all but the O(log n) nodes on the changed key's path with the old one.
+     * So a new version of a big map, for a SnapshotPtr, costs about as much as a lookup.
+     *
+     * It is a hash trie: a branch picks one of 16 children with the next 4 bits of the key's
+     * hash, and a leaf holds a few entries.  Lookups only follow plain pointers, so they are
+     * safe for any number of threads, as long as the map they start from stays alive.
+     */
+    template<typename V>
+    class ImmutableStringMap {
+      public:
+        ImmutableStringMap() : _size(0) {}
+
+        /** @return the value for key, or NULL if there is none. */
+        const V *find(const StringData &key) const {
+            const unsigned long long h = hash(key);
+            const Node *node = _root.get();
+            for (int depth = 0; node != NULL && !node->isLeaf(); ++depth) {
+                node = node->children[childIndex(h, depth)].get();
+            }
+            if (node != NULL) {
+                for (typename std::vector<Entry>::const_iterator it = node->entries.begin();
+                     it != node->entries.end(); ++it) {
+                    if (it->hash == h && StringData(it->key) == key) {
+                        return &it->value;
+                    }
+                }
+            }
+            return NULL;
+        }
+
+        /** @return a copy of this map with key set to value. */
+        ImmutableStringMap set(const StringData &key, const V &value) const {
+            bool added = false;
+            const Entry e(hash(key), key.toString(), value);
+            NodePtr root = set(_root, 0, e, &added);
+            return ImmutableStringMap(root, _size + (added ? 1 : 0));
+        }
+
+        /** @return a copy of this map without key. */
+        ImmutableStringMap erase(const StringData &key) const {
+            bool removed = false;
+            NodePtr root = erase(_root, 0, hash(key), key, &removed);
+            return ImmutableStringMap(root, _size - (removed ? 1 : 0));
+        }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+      private:
+        static const int kBits = 4;
+        static const int kFanout = 1 << kBits;
+        // Past this depth the hash is used up, and leaves hold all the keys that collide.
+        static const int kMaxDepth = 64 / kBits;
+        static const size_t kMaxLeafEntries = 8;
+
+        struct Entry {
+            Entry(unsigned long long h, const std::string &k, const V &v) : hash(h), key(k), value(v) {}
+            unsigned long long hash;
+            std::string key;
+            V value;
+        };
+
+        struct Node;
+        typedef shared_ptr<const Node> NodePtr;
+
+        // A branch has kFanout children (some NULL) and no entries, a leaf has entries only.
+        struct Node {
+            bool isLeaf() const { return children.empty(); }
+            std::vector<NodePtr> children;
+            std::vector<Entry> entries;
+        };
+
+        ImmutableStringMap(const NodePtr &root, size_t size) : _root(root), _size(size) {}
+
+        static unsigned long long hash(const StringData &key) {
+            // StringMapDefaultHash mostly differs in its low bits, spread them out.
+            unsigned long long h = StringMapDefaultHash()(key);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        static int childIndex(unsigned long long h, int depth) {
+            return static_cast<int>((h >> (depth * kBits)) & (kFanout - 1));
+        }
+
+        static NodePtr set(const NodePtr &node, int depth, const Entry &e, bool *added) {
+            if (node == NULL) {
+                shared_ptr<Node> leaf(new Node());
+                leaf->entries.push_back(e);
+                *added = true;
+                return leaf;
+            }
+            if (!node->isLeaf()) {
+                shared_ptr<Node> branch(new Node(*node));
+                NodePtr &child = branch->children[childIndex(e.hash, depth)];
+                child = set(child, depth + 1, e, added);
+                return branch;
+            }
+            shared_ptr<Node> leaf(new Node(*node));
+            for (typename std::vector<Entry>::iterator it = leaf->entries.begin();
+                 it != leaf->entries.end(); ++it) {
+                if (it->hash == e.hash && it->key == e.key) {
+                    it->value = e.value;
+                    return leaf;
+                }
+            }
+            *added = true;
+            leaf->entries.push_back(e);
+            if (leaf->entries.size() <= kMaxLeafEntries || depth >= kMaxDepth) {
+                return leaf;
+            }
+            // Split the full leaf.  The new nodes aren't shared yet, but building them through
+            // set() keeps this simple, and it only happens once per kMaxLeafEntries adds.
+            shared_ptr<Node> branch(new Node());
+            branch->children.resize(kFanout);
+            for (typename std::vector<Entry>::const_iterator it = leaf->entries.begin();
+                 it != leaf->entries.end(); ++it) {
+                NodePtr &child = branch->children[childIndex(it->hash, depth)];
+                bool ignored;
+                child = set(child, depth + 1, *it, &ignored);
+            }
+            return branch;
+        }
+
+        static NodePtr erase(const NodePtr &node, int depth, unsigned long long h,
+                             const StringData &key, bool *removed) {
+            if (node == NULL) {
+                return node;
+            }
+            if (!node->isLeaf()) {
+                const int i = childIndex(h, depth);
+                NodePtr child = erase(node->children[i], depth + 1, h, key, removed);
+                if (!*removed) {
+                    return node;
+                }
+                shared_ptr<Node> branch(new Node(*node));
+                branch->children[i] = child;
+                for (int j = 0; j < kFanout; ++j) {
+                    if (branch->children[j] != NULL) {
+                        return branch;
+                    }
+                }
+                return NodePtr();
+            }
+            for (size_t j = 0; j < node->entries.size(); ++j) {
+                const Entry &e = node->entries[j];
+                if (e.hash == h && StringData(e.key) == key) {
+                    *removed = true;
+                    if (node->entries.size() == 1) {
+                        return NodePtr();
+                    }
+                    shared_ptr<Node> leaf(new Node(*node));
+                    leaf->entries.erase(leaf->entries.begin() + j);
+                    return leaf;
+                }
+            }
+            return node;
+        }
+
+        NodePtr _root;
+        size_t _size;
+    };
+
+} // namespace mongo
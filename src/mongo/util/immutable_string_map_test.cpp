@@ -0,0 +1,95 @@
+// immutable_string_map_test.cpp
+
+/*    Copyright (C) 2013 Tokutek Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/util/immutable_string_map.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+    using namespace mongo;
+
+    typedef ImmutableStringMap<int> Map;
+
+    static string key(int i) {
+        return mongoutils::str::stream() << "db.coll" << i;
+    }
+
+    TEST(ImmutableStringMapTest, Empty) {
+        Map m;
+        ASSERT(m.empty());
+        ASSERT(m.find("a") == NULL);
+        ASSERT(m.erase("a").empty());
+    }
+
+    TEST(ImmutableStringMapTest, SetFindErase) {
+        Map m = Map().set("a", 1).set("b", 2);
+        ASSERT_EQUALS(2U, m.size());
+        ASSERT_EQUALS(1, *m.find("a"));
+        ASSERT_EQUALS(2, *m.find("b"));
+        ASSERT(m.find("c") == NULL);
+
+        m = m.set("a", 3);
+        ASSERT_EQUALS(2U, m.size());
+        ASSERT_EQUALS(3, *m.find("a"));
+
+        m = m.erase("a");
+        ASSERT_EQUALS(1U, m.size());
+        ASSERT(m.find("a") == NULL);
+        ASSERT_EQUALS(2, *m.find("b"));
+        ASSERT_EQUALS(1U, m.erase("c").size());
+    }
+
+    TEST(ImmutableStringMapTest, OldVersionsDontChange) {
+        Map m0;
+        Map m1 = m0.set("a", 1);
+        Map m2 = m1.set("a", 2);
+        Map m3 = m2.erase("a");
+        ASSERT(m0.find("a") == NULL);
+        ASSERT_EQUALS(1, *m1.find("a"));
+        ASSERT_EQUALS(2, *m2.find("a"));
+        ASSERT(m3.find("a") == NULL);
+    }
+
+    TEST(ImmutableStringMapTest, Many) {
+        static const int N = 20000;
+        Map m;
+        for (int i = 0; i < N; ++i) {
+            m = m.set(key(i), i);
+        }
+        Map full = m;
+        ASSERT_EQUALS(static_cast<size_t>(N), m.size());
+        for (int i = 0; i < N; i += 2) {
+            m = m.erase(key(i));
+        }
+        ASSERT_EQUALS(static_cast<size_t>(N / 2), m.size());
+        for (int i = 0; i < N; ++i) {
+            ASSERT_EQUALS(i, *full.find(key(i)));
+            if (i % 2 == 0) {
+                ASSERT(m.find(key(i)) == NULL);
+            } else {
+                ASSERT_EQUALS(i, *m.find(key(i)));
+            }
+        }
+        for (int i = 1; i < N; i += 2) {
+            m = m.erase(key(i));
+        }
+        ASSERT(m.empty());
+        ASSERT(m.find(key(1)) == NULL);
+    }
+
+} // namespace
@@ -0,0 +1,224 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/util/lzblock.h"
+
+#include <cstring>
+
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+namespace lzblock {
+
+    namespace {
+
+        const size_t kMinMatch = 4;
+        const size_t kMaxOffset = 65535;
+        const int kHashLog = 13;
+        const size_t kRunMask = 15;
+
+        // Don't look for matches this close to the end, so the 4-byte reads never run past it.
+        const size_t kEndMargin = 8;
+
+        inline uint32_t read32(const unsigned char* p) {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint32_t hash4(uint32_t v) {
+            return (v * 2654435761U) >> (32 - kHashLog);
+        }
+
+        /** Writes the continuation bytes for a length whose nibble was 15. */
+        inline unsigned char* writeLength(unsigned char* op, size_t len) {
+            while (len >= 255) {
+                *op++ = 255;
+                len -= 255;
+            }
+            *op++ = static_cast<unsigned char>(len);
+            return op;
+        }
+
+        inline unsigned char* writeSequence(unsigned char* op,
+                                            const unsigned char* literals, size_t literalLength,
+                                            size_t offset, size_t matchLength) {
+            unsigned char* token = op++;
+            const size_t matchCode = matchLength - kMinMatch;
+            *token = static_cast<unsigned char>(
+                    ((literalLength < kRunMask ? literalLength : kRunMask) << 4) |
+                    (matchCode < kRunMask ? matchCode : kRunMask));
+            if (literalLength >= kRunMask) {
+                op = writeLength(op, literalLength - kRunMask);
+            }
+            memcpy(op, literals, literalLength);
+            op += literalLength;
+            *op++ = static_cast<unsigned char>(offset);
+            *op++ = static_cast<unsigned char>(offset >> 8);
+            if (matchCode >= kRunMask) {
+                op = writeLength(op, matchCode - kRunMask);
+            }
+            return op;
+        }
+
+        inline unsigned char* writeLastLiterals(unsigned char* op,
+                                                const unsigned char* literals, size_t literalLength) {
+            *op++ = static_cast<unsigned char>(
+                    (literalLength < kRunMask ? literalLength : kRunMask) << 4);
+            if (literalLength >= kRunMask) {
+                op = writeLength(op, literalLength - kRunMask);
+            }
+            memcpy(op, literals, literalLength);
+            return op + literalLength;
+        }
+
+        /** Reads the continuation bytes of a length, @return false if src runs out first */
+        inline bool readLength(const unsigned char** ip, const unsigned char* end, size_t* len) {
+            unsigned char b;
+            do {
+                if (*ip >= end) {
+                    return false;
+                }
+                b = *(*ip)++;
+                *len += b;
+            } while (b == 255);
+            return true;
+        }
+
+    } // namespace
+
+    size_t maxCompressedLength(size_t len) {
+        // literals only: the token plus one length byte per 255 literals
+        return len + len / 255 + 16;
+    }
+
+    size_t compress(const char* src, size_t len, char* dst) {
+        const unsigned char* const base = reinterpret_cast<const unsigned char*>(src);
+        const unsigned char* const end = base + len;
+        const unsigned char* ip = base;
+        const unsigned char* anchor = base;
+        unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+
+        if (len > kEndMargin + kMinMatch) {
+            // Positions are relative to base, 0 is fine as "empty" since it's checked anyway.
+            uint32_t table[1 << kHashLog];
+            memset(table, 0, sizeof(table));
+
+            const unsigned char* const matchLimit = end - kEndMargin;
+            // Skip ahead faster through data that isn't compressing.
+            unsigned misses = 0;
+            ip++;
+            while (ip < matchLimit) {
+                const uint32_t seq = read32(ip);
+                const uint32_t h = hash4(seq);
+                const unsigned char* ref = base + table[h];
+                table[h] = static_cast<uint32_t>(ip - base);
+
+                if (ref >= ip || static_cast<size_t>(ip - ref) > kMaxOffset || read32(ref) != seq) {
+                    ip += 1 + (misses++ >> 6);
+                    continue;
+                }
+                misses = 0;
+
+                // Extend backwards over literals we were about to emit, then forwards.
+                while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                    ip--;
+                    ref--;
+                }
+                const unsigned char* m = ip + kMinMatch;
+                const unsigned char* r = ref + kMinMatch;
+                while (m < end && *m == *r) {
+                    m++;
+                    r++;
+                }
+
+                op = writeSequence(op, anchor, ip - anchor, ip - ref, m - ip);
+                ip = m;
+                anchor = ip;
+                if (ip - 2 >= base && ip < matchLimit) {
+                    table[hash4(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+                }
+            }
+        }
+
+        op = writeLastLiterals(op, anchor, end - anchor);
+        return op - reinterpret_cast<unsigned char*>(dst);
+    }
+
+    bool uncompress(const char* src, size_t len, char* dst, size_t dstCapacity,
+                    size_t* uncompressedLength) {
+        const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+        const unsigned char* const iend = ip + len;
+        char* op = dst;
+        char* const oend = dst + dstCapacity;
+
+        while (true) {
+            if (ip >= iend) {
+                return false;
+            }
+            const unsigned token = *ip++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == kRunMask && !readLength(&ip, iend, &literalLength)) {
+                return false;
+            }
+            if (static_cast<size_t>(iend - ip) < literalLength ||
+                static_cast<size_t>(oend - op) < literalLength) {
+                return false;
+            }
+            memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            if (ip == iend) {
+                *uncompressedLength = op - dst;
+                return true;
+            }
+
+            if (iend - ip < 2) {
+                return false;
+            }
+            const size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+                return false;
+            }
+
+            size_t matchLength = token & kRunMask;
+            if (matchLength == kRunMask && !readLength(&ip, iend, &matchLength)) {
+                return false;
+            }
+            matchLength += kMinMatch;
+            if (static_cast<size_t>(oend - op) < matchLength) {
+                return false;
+            }
+
+            const char* match = op - offset;
+            if (offset >= matchLength) {
+                memcpy(op, match, matchLength);
+                op += matchLength;
+            }
+            else {
+                // Overlapping, this is how runs are encoded, copy forwards one byte at a time.
+                for (size_t i = 0; i < matchLength; i++) {
+                    *op++ = *match++;
+                }
+            }
+        }
+    }
+
+} // namespace lzblock
+} // namespace mongo
@@ -0,0 +1,55 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace mongo {
+
+    /**
+     * A small, fast LZ77 block codec, for data that is compressed once and moved around in
+     * bulk (dump files, the wire).  It trades ratio for speed: hash-chained matches only, no
+     * entropy coding.  BSON typically compresses 3-10x, mostly from repeated field names.
+     *
+     * A compressed block is a sequence of
+     *     token | [literal length bytes] | literals | offset (2 bytes LE) | [match length bytes]
+     * where the token's high nibble is the literal length and its low nibble the match
+     * length minus 4, with 15 meaning "add the following bytes until one isn't 255".
+     * The last sequence is literals only.  Blocks don't record their uncompressed length,
+     * callers frame them.
+     */
+    namespace lzblock {
+
+        /** @return the most compress() can write for an input of len bytes */
+        size_t maxCompressedLength(size_t len);
+
+        /**
+         * Compresses src[0, len) into dst, which must have room for maxCompressedLength(len).
+         * @return the compressed length
+         */
+        size_t compress(const char* src, size_t len, char* dst);
+
+        /**
+         * Uncompresses src[0, len) into dst[0, dstCapacity).  Safe on any input.
+         * @return false if src is not a valid block or uncompresses to more than dstCapacity
+         */
+        bool uncompress(const char* src, size_t len, char* dst, size_t dstCapacity,
+                        size_t* uncompressedLength);
+
+    } // namespace lzblock
+
+} // namespace mongo
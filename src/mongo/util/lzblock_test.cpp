@@ -0,0 +1,179 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/unittest/unittest.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/lzblock.h"
+#include "mongo/util/timer.h"
+
+namespace {
+
+    using namespace mongo;
+    using std::string;
+    using std::vector;
+
+    string compress(const string& s) {
+        vector<char> buf(lzblock::maxCompressedLength(s.size()));
+        size_t len = lzblock::compress(s.data(), s.size(), &buf[0]);
+        ASSERT_LESS_THAN_OR_EQUALS(len, buf.size());
+        return string(&buf[0], len);
+    }
+
+    void assertRoundTrip(const string& s) {
+        const string c = compress(s);
+        vector<char> out(s.size() + 1);
+        size_t len = 0;
+        ASSERT(lzblock::uncompress(c.data(), c.size(), &out[0], out.size(), &len));
+        ASSERT_EQUALS(s.size(), len);
+        ASSERT(string(&out[0], len) == s);
+
+        // Exactly enough room is fine, one byte short is not.
+        ASSERT(lzblock::uncompress(c.data(), c.size(), &out[0], s.size(), &len));
+        if (!s.empty()) {
+            ASSERT_FALSE(lzblock::uncompress(c.data(), c.size(), &out[0], s.size() - 1, &len));
+        }
+    }
+
+    string randomBytes(size_t n, unsigned alphabet) {
+        string s(n, '\0');
+        for (size_t i = 0; i < n; i++) {
+            s[i] = static_cast<char>(rand() % alphabet);
+        }
+        return s;
+    }
+
+    /** Concatenated BSON documents that look like a typical collection. */
+    string bsonStream(int n) {
+        string s;
+        for (int i = 0; i < n; i++) {
+            BSONObj o = BSON("_id" << OID::gen() << "name" << "user" << "email" << "someone@example.com"
+                             << "age" << (i % 80) << "score" << i * 1.5
+                             << "tags" << BSON_ARRAY("a" << "b" << "c"));
+            s.append(o.objdata(), o.objsize());
+        }
+        return s;
+    }
+
+    TEST(LZBlock, Empty) {
+        assertRoundTrip("");
+    }
+
+    TEST(LZBlock, ShortInputs) {
+        srand(1);
+        for (size_t n = 1; n < 100; n++) {
+            assertRoundTrip(randomBytes(n, 256));
+            assertRoundTrip(randomBytes(n, 2));
+            assertRoundTrip(string(n, 'x'));
+        }
+    }
+
+    TEST(LZBlock, Runs) {
+        // Overlapping matches, and lengths around the 15 and 255 boundaries.
+        for (size_t n = 10; n < 600; n += 7) {
+            assertRoundTrip(string(n, 'a'));
+            assertRoundTrip(string(n, 'a') + randomBytes(n, 256) + string(n, 'b'));
+        }
+        assertRoundTrip(string(1 << 20, '\0'));
+        ASSERT_LESS_THAN(compress(string(1 << 20, '\0')).size(), 5000U);
+    }
+
+    TEST(LZBlock, LongLiterals) {
+        srand(2);
+        for (size_t n = 200; n < 70000; n = n * 3 / 2) {
+            string s = randomBytes(n, 256);
+            assertRoundTrip(s);
+            ASSERT_LESS_THAN_OR_EQUALS(compress(s).size(), lzblock::maxCompressedLength(n));
+        }
+    }
+
+    TEST(LZBlock, FarMatches) {
+        // Repeats further apart than the largest offset can't be matches but must still round trip.
+        srand(3);
+        string chunk = randomBytes(70000, 256);
+        assertRoundTrip(chunk + chunk);
+        string near = randomBytes(65000, 256);
+        string s = near + near;
+        assertRoundTrip(s);
+        ASSERT_LESS_THAN(compress(s).size(), 70000U);
+    }
+
+    TEST(LZBlock, BSON) {
+        string s = bsonStream(5000);
+        assertRoundTrip(s);
+        string c = compress(s);
+        log() << "bson: " << s.size() << " -> " << c.size() << " bytes" << endl;
+        ASSERT_LESS_THAN(c.size() * 2, s.size());
+    }
+
+    TEST(LZBlock, Corrupt) {
+        // Any input must fail cleanly or produce at most dstCapacity bytes.
+        srand(4);
+        const string s = bsonStream(200);
+        const string c = compress(s);
+        vector<char> out(s.size());
+        size_t len;
+        for (size_t cut = 0; cut < c.size(); cut += 13) {
+            lzblock::uncompress(c.data(), cut, &out[0], out.size(), &len);
+        }
+        for (int i = 0; i < 20000; i++) {
+            string bad = c;
+            int changes = 1 + rand() % 4;
+            for (int j = 0; j < changes; j++) {
+                bad[rand() % bad.size()] = static_cast<char>(rand());
+            }
+            if (lzblock::uncompress(bad.data(), bad.size(), &out[0], out.size(), &len)) {
+                ASSERT_LESS_THAN_OR_EQUALS(len, out.size());
+            }
+        }
+        for (int i = 0; i < 2000; i++) {
+            string bad = randomBytes(rand() % 500, 256);
+            if (lzblock::uncompress(bad.data(), bad.size(), &out[0], out.size(), &len)) {
+                ASSERT_LESS_THAN_OR_EQUALS(len, out.size());
+            }
+        }
+    }
+
+    TEST(LZBlock, Throughput) {
+        const string s = bsonStream(20000);
+        vector<char> c(lzblock::maxCompressedLength(s.size()));
+        vector<char> out(s.size());
+        const int iters = 20;
+
+        Timer t;
+        size_t clen = 0;
+        for (int i = 0; i < iters; i++) {
+            clen = lzblock::compress(s.data(), s.size(), &c[0]);
+        }
+        long long compressMicros = std::max(t.micros(), 1ULL);
+
+        t.reset();
+        size_t len = 0;
+        for (int i = 0; i < iters; i++) {
+            ASSERT(lzblock::uncompress(&c[0], clen, &out[0], out.size(), &len));
+        }
+        long long uncompressMicros = std::max(t.micros(), 1ULL);
+
+        log() << "lzblock: ratio " << double(s.size()) / clen
+              << ", compress " << (double(s.size()) * iters / compressMicros) << " MB/s"
+              << ", uncompress " << (double(s.size()) * iters / uncompressMicros) << " MB/s" << endl;
+    }
+
+} // namespace
@@ -0,0 +1,161 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/lzblock.h"
+
+namespace mongo {
+
+    namespace messageCompression {
+
+        const char lzblockName[] = "lzblock";
+
+        namespace {
+
+            const char LZBLOCK_ID = 1;
+
+            // originalOpCode, uncompressedSize, compressorId
+            const int PREFIX_SIZE = 4 + 4 + 1;
+
+            struct Stats {
+                AtomicUInt64 messagesIn;
+                AtomicUInt64 bytesIn;
+                AtomicUInt64 bytesInUncompressed;
+                AtomicUInt64 messagesOut;
+                AtomicUInt64 bytesOut;
+                AtomicUInt64 bytesOutUncompressed;
+            } stats;
+
+            bool hasLZBlock(const BSONElement &e) {
+                if (e.type() != Array) {
+                    return false;
+                }
+                BSONForEach(codec, e.Obj()) {
+                    if (codec.type() == String && codec.valuestr() == StringData(lzblockName)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        } // namespace
+
+        bool compress(const Message &m, Message &out) {
+            const MsgData *md = m.singleData();
+            if (md->len < MIN_COMPRESS_SIZE || md->operation() == dbCompressed) {
+                return false;
+            }
+            const int bodyLen = md->len - MsgDataHeaderSize;
+            const size_t maxLen = MsgDataHeaderSize + PREFIX_SIZE + lzblock::maxCompressedLength(bodyLen);
+            MsgData *c = reinterpret_cast<MsgData *>(malloc(maxLen));
+            verify(c);
+
+            char *p = c->_data;
+            // the whole opcode int, including _flags and _version
+            memcpy(p, &md->_operation, 4);
+            memcpy(p + 4, &bodyLen, 4);
+            p[8] = LZBLOCK_ID;
+            const size_t compressedLen = lzblock::compress(md->_data, bodyLen, p + PREFIX_SIZE);
+            if (PREFIX_SIZE + compressedLen >= static_cast<size_t>(bodyLen)) {
+                // incompressible
+                free(c);
+                return false;
+            }
+
+            // copies the id and responseTo
+            memcpy(c, md, MsgDataHeaderSize);
+            c->len = MsgDataHeaderSize + PREFIX_SIZE + compressedLen;
+            c->setOperation(dbCompressed);
+            out.setData(c, true);
+
+            stats.messagesOut.fetchAndAdd(1);
+            stats.bytesOut.fetchAndAdd(c->len);
+            stats.bytesOutUncompressed.fetchAndAdd(md->len);
+            return true;
+        }
+
+        bool uncompress(const MsgData *md, Message &out) {
+            dassert(md->operation() == dbCompressed);
+            if (md->len < MsgDataHeaderSize + PREFIX_SIZE) {
+                return false;
+            }
+            int originalOpCode;
+            int size;
+            memcpy(&originalOpCode, md->_data, 4);
+            memcpy(&size, md->_data + 4, 4);
+            if (md->_data[8] != LZBLOCK_ID || size < 0 || size > MaxMessageSizeBytes - MsgDataHeaderSize) {
+                return false;
+            }
+
+            MsgData *u = reinterpret_cast<MsgData *>(malloc(max<size_t>(sizeof(MsgData), MsgDataHeaderSize + size)));
+            verify(u);
+            size_t uncompressedLen;
+            if (!lzblock::uncompress(md->_data + PREFIX_SIZE, md->len - MsgDataHeaderSize - PREFIX_SIZE,
+                                     u->_data, size, &uncompressedLen) ||
+                uncompressedLen != static_cast<size_t>(size)) {
+                free(u);
+                return false;
+            }
+            memcpy(u, md, MsgDataHeaderSize);
+            u->len = MsgDataHeaderSize + size;
+            memcpy(&u->_operation, &originalOpCode, 4);
+            if (u->operation() == dbCompressed) {
+                free(u);
+                return false;
+            }
+            out.setData(u, true);
+
+            stats.messagesIn.fetchAndAdd(1);
+            stats.bytesIn.fetchAndAdd(md->len);
+            stats.bytesInUncompressed.fetchAndAdd(u->len);
+            return true;
+        }
+
+        void negotiate(const BSONObj &cmdObj, AbstractMessagingPort *port, BSONObjBuilder &result) {
+            // Only real connections, not DBDirectClient.
+            MessagingPort *mp = dynamic_cast<MessagingPort *>(port);
+            if (mp != NULL && hasLZBlock(cmdObj["compression"])) {
+                mp->setCompressMessages(true);
+                result.append("compression", BSON_ARRAY(lzblockName));
+            }
+        }
+
+        BSONObj isMasterRequest() {
+            return BSON("isMaster" << 1 << "compression" << BSON_ARRAY(lzblockName));
+        }
+
+        bool negotiated(const BSONObj &isMasterResponse) {
+            return hasLZBlock(isMasterResponse["compression"]);
+        }
+
+        void appendStats(BSONObjBuilder &b) {
+            BSONObjBuilder lz(b.subobjStart(lzblockName));
+            lz.appendNumber("messagesIn", static_cast<long long>(stats.messagesIn.load()));
+            lz.appendNumber("bytesIn", static_cast<long long>(stats.bytesIn.load()));
+            lz.appendNumber("bytesInUncompressed", static_cast<long long>(stats.bytesInUncompressed.load()));
+            lz.appendNumber("messagesOut", static_cast<long long>(stats.messagesOut.load()));
+            lz.appendNumber("bytesOut", static_cast<long long>(stats.bytesOut.load()));
+            lz.appendNumber("bytesOutUncompressed", static_cast<long long>(stats.bytesOutUncompressed.load()));
+            lz.done();
+        }
+
+    } // namespace messageCompression
+
+} // namespace mongo
@@ -0,0 +1,77 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    /**
+     * Compression of messages on the wire, for links that are bandwidth bound (replica set
+     * members in other datacenters, mongos to shards).
+     *
+     * A compressed message has opcode dbCompressed and the body
+     *     int originalOpCode | int uncompressedSize | char compressorId | compressed body
+     * where the compressed body is the original message without its header, compressed with
+     * lzblock.  The header's id and responseTo are the original message's.
+     *
+     * It is negotiated per connection: a client that wants it (--netCompression) sends
+     * compression: ["lzblock"] in an isMaster when it connects, and a server that can do it
+     * answers with the same field.  From then on, both ends compress the messages they send.
+     * Old servers ignore the field, and so never see a compressed message.
+     */
+    namespace messageCompression {
+
+        /** The name of the only codec, in isMaster. */
+        extern const char lzblockName[];
+
+        /** Messages smaller than this aren't worth compressing. */
+        const int MIN_COMPRESS_SIZE = 512;
+
+        /**
+         * Compresses m into out, if it is big enough and compresses.  m must be a single
+         * buffer, see Message::concat().
+         * @return false if m should be sent as it is
+         */
+        bool compress(const Message &m, Message &out);
+
+        /**
+         * Uncompresses a dbCompressed message into out.
+         * @return false if md is not a valid compressed message
+         */
+        bool uncompress(const MsgData *md, Message &out);
+
+        /**
+         * The server's side of the negotiation: if the isMaster cmdObj asked for a codec we
+         * have, answers in result and compresses what is sent on port from now on.
+         */
+        void negotiate(const BSONObj &cmdObj, AbstractMessagingPort *port, BSONObjBuilder &result);
+
+        /** @return the isMaster command that asks for compression */
+        BSONObj isMasterRequest();
+
+        /** @return true if an isMaster response agreed to compression */
+        bool negotiated(const BSONObj &isMasterResponse);
+
+        /** Adds message counts and bytes before and after compression, for serverStatus. */
+        void appendStats(BSONObjBuilder &b);
+
+    } // namespace messageCompression
+
+} // namespace mongo
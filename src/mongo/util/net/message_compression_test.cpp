@@ -0,0 +1,155 @@
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/unittest/unittest.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "mongo/db/cmdline.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/net/message_compression.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    CmdLine cmdLine;
+
+    bool inShutdown() {
+        return false;
+    }
+
+} // namespace mongo
+
+namespace {
+
+    using namespace mongo;
+    using std::string;
+
+    string repetitiveBody(int nDocs) {
+        string s;
+        for (int i = 0; i < nDocs; i++) {
+            BSONObj o = BSON("_id" << i << "name" << "some name" << "value" << i * 2.5);
+            s.append(o.objdata(), o.objsize());
+        }
+        return s;
+    }
+
+    string randomBody(size_t n) {
+        string s(n, '\0');
+        for (size_t i = 0; i < n; i++) {
+            s[i] = static_cast<char>(rand());
+        }
+        return s;
+    }
+
+    void makeMessage(const string &body, Message &m) {
+        m.setData(dbInsert, body.data(), body.size());
+        m.header()->id = 12345;
+        m.header()->responseTo = 678;
+    }
+
+    string bytes(const Message &m) {
+        return string(reinterpret_cast<const char *>(m.singleData()), m.size());
+    }
+
+    TEST(MessageCompressionTest, RoundTrip) {
+        Message m;
+        makeMessage(repetitiveBody(1000), m);
+        Message c;
+        ASSERT(messageCompression::compress(m, c));
+        ASSERT_EQUALS(dbCompressed, c.operation());
+        ASSERT_LESS_THAN(c.size() * 3, m.size());
+        ASSERT_EQUALS(12345U, static_cast<unsigned>(c.header()->id));
+        ASSERT_EQUALS(678U, static_cast<unsigned>(c.header()->responseTo));
+
+        Message u;
+        ASSERT(messageCompression::uncompress(c.singleData(), u));
+        ASSERT_EQUALS(dbInsert, u.operation());
+        ASSERT(bytes(u) == bytes(m));
+    }
+
+    TEST(MessageCompressionTest, NotWorthIt) {
+        Message small;
+        makeMessage(repetitiveBody(2), small);
+        ASSERT_LESS_THAN(small.size(), messageCompression::MIN_COMPRESS_SIZE);
+        Message c;
+        ASSERT_FALSE(messageCompression::compress(small, c));
+        ASSERT(c.empty());
+
+        Message random;
+        makeMessage(randomBody(100000), random);
+        ASSERT_FALSE(messageCompression::compress(random, c));
+        ASSERT(c.empty());
+    }
+
+    TEST(MessageCompressionTest, InvalidMessages) {
+        Message m;
+        makeMessage(repetitiveBody(1000), m);
+        Message c;
+        ASSERT(messageCompression::compress(m, c));
+        const string good = bytes(c);
+        const int uncompressedSizeOffset = MsgDataHeaderSize + 4;
+        const int compressorIdOffset = MsgDataHeaderSize + 8;
+
+        string bad = good;
+        // claims to be bigger than it is
+        int size;
+        memcpy(&size, &bad[uncompressedSizeOffset], 4);
+        size++;
+        memcpy(&bad[uncompressedSizeOffset], &size, 4);
+        Message u;
+        ASSERT_FALSE(messageCompression::uncompress(reinterpret_cast<const MsgData *>(bad.data()), u));
+        ASSERT(u.empty());
+
+        bad = good;
+        bad[compressorIdOffset] = 42;
+        ASSERT_FALSE(messageCompression::uncompress(reinterpret_cast<const MsgData *>(bad.data()), u));
+
+        // truncated
+        bad = good.substr(0, good.size() - 10);
+        reinterpret_cast<MsgData *>(&bad[0])->len = bad.size();
+        ASSERT_FALSE(messageCompression::uncompress(reinterpret_cast<const MsgData *>(bad.data()), u));
+
+        bad = good.substr(0, MsgDataHeaderSize + 4);
+        reinterpret_cast<MsgData *>(&bad[0])->len = bad.size();
+        ASSERT_FALSE(messageCompression::uncompress(reinterpret_cast<const MsgData *>(bad.data()), u));
+        ASSERT(u.empty());
+    }
+
+    TEST(MessageCompressionTest, Negotiation) {
+        const BSONObj request = messageCompression::isMasterRequest();
+        ASSERT(request.hasField("isMaster"));
+
+        MessagingPort port;
+        ASSERT_FALSE(port.compressMessages());
+        BSONObjBuilder b;
+        messageCompression::negotiate(request, &port, b);
+        const BSONObj response = b.obj();
+        ASSERT(port.compressMessages());
+        ASSERT(messageCompression::negotiated(response));
+
+        // old clients and old servers
+        MessagingPort oldPort;
+        BSONObjBuilder old;
+        messageCompression::negotiate(BSON("isMaster" << 1), &oldPort, old);
+        ASSERT_FALSE(oldPort.compressMessages());
+        ASSERT_FALSE(messageCompression::negotiated(old.obj()));
+        ASSERT_FALSE(messageCompression::negotiated(BSON("ismaster" << true)));
+        ASSERT_FALSE(messageCompression::negotiated(BSON("compression" << BSON_ARRAY("zlib"))));
+    }
+
+} // namespace
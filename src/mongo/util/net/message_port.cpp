@@ -22,6 +22,7 @@
 #include <time.h>
 
 #include "message.h"
+#include "message_compression.h"
 #include "message_port.h"
 #include "listen.h"
 
@@ -126,18 +127,18 @@ namespace mongo {
     }
 
     MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+        : psock( new Socket( fd , remote ) ) , _compressMessages(false), piggyBackData(0) {
         ports.insert(this);
     }
 
     MessagingPort::MessagingPort( double timeout, int ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+        : psock( new Socket( timeout, ll ) ), _compressMessages(false) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ), _compressMessages( false ), piggyBackData( 0 ) {
         ports.insert(this);
     }
 
@@ -201,6 +202,15 @@ again:
 
             psock->recv( p, left );
 
+            if ( md->operation() == dbCompressed ) {
+                // md is freed by the guard
+                if ( !messageCompression::uncompress( md, m ) ) {
+                    LOG(0) << "recv(): invalid compressed message from " << remote() << endl;
+                    return false;
+                }
+                return true;
+            }
+
             guard.Dismiss();
             m.setData(md, true);
             return true;
@@ -257,20 +267,29 @@ again:
         toSend.header()->id = nextMessageId();
         toSend.header()->responseTo = responseTo;
 
+        Message compressed;
+        Message *out = &toSend;
+        if ( _compressMessages && toSend.size() >= messageCompression::MIN_COMPRESS_SIZE ) {
+            toSend.concat();
+            if ( messageCompression::compress( toSend, compressed ) ) {
+                out = &compressed;
+            }
+        }
+
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header()->len ) > 1300 ) {
+            if ( ( piggyBackData->len() + out->header()->len ) > 1300 ) {
                 // won't fit in a packet - so just send it off
                 piggyBackData->flush();
             }
             else {
-                piggyBackData->append( toSend );
+                piggyBackData->append( *out );
                 piggyBackData->flush();
                 return;
             }
         }
 
-        toSend.send( *this, "say" );
+        out->send( *this, "say" );
     }
 
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
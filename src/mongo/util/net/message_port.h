@@ -119,7 +119,16 @@ namespace mongo {
             return psock->getSockCreationMicroSec();
         }
 
+        /**
+         * Compress the messages sent on this port that are worth it, see message_compression.h.
+         * Set on both ends once they agree to it.  recv() always accepts compressed messages.
+         */
+        void setCompressMessages(bool compress) { _compressMessages = compress; }
+        bool compressMessages() const { return _compressMessages; }
+
     private:
+
+        bool _compressMessages;
         
         PiggyBackData * piggyBackData;
         